@@ -0,0 +1,24 @@
+# daobench.pro - DAO benchmarks against a seeded SQLite stand-in
+#
+# Built with the rest of Project.pro (it links the data layer library);
+# run ./daobench or make check from its build directory.
+#
+# DAOBENCH_SIZES picks the datasets (orders; a tenth as many clients),
+# default 1000,100000. The full baseline is 1000,100000,1000000,10000000.
+# Results go to DAOBENCH_OUTPUT (default daobench.json).
+
+QT = core sql concurrent testlib
+
+CONFIG += c++17 console testcase exceptions
+CONFIG -= app_bundle
+
+TARGET = daobench
+TEMPLATE = app
+
+include(../../datalayer.pri)
+
+SOURCES += \
+    tst_daobench.cpp
+
+OBJECTS_DIR = build/obj
+MOC_DIR = build/moc
@@ -0,0 +1,468 @@
+// tst_daobench.cpp
+//
+// Times every ClientDAO, CommandDAO and CommandStatistics operation on
+// synthetic SQLite datasets and writes the figures as JSON:
+//
+//   {"driver": "QSQLITE", "results": [{"dataset": 100000, "operation":
+//    "CommandDAO::readCommand", "iterations": 200, "p50Us": 41.2, "p99Us": 97.0,
+//    "meanUs": 45.8, "opsPerSec": 21834.1, "rowsPerSec": 21834.1}, ...]}
+//
+// The query cache is cleared before every call so each figure is a real
+// database round trip. Datasets are seeded once per run in a temporary
+// directory; a dataset of N orders has N / 10 clients.
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QRandomGenerator>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <functional>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+#include "connection.h"
+#include "schemamigrator.h"
+#include "querycache.h"
+#include "clients.h"
+#include "commands.h"
+
+namespace {
+
+const QStringList Surnames = {"Martin", "Bernard", "Dubois", "Thomas", "Robert", "Richard",
+                              "Petit", "Durand", "Leroy", "Moreau", "Simon", "Laurent"};
+const QStringList Cities = {"Tunis", "Sfax", "Sousse", "Bizerte", "Gabes", "Nabeul",
+                            "Monastir", "Kairouan", "Ariana", "Mahdia"};
+const QStringList PaymentMethods = {"Cash", "Credit Card", "Debit Card", "PayPal",
+                                    "Bank Transfer", "Check", "Mobile Payment"};
+
+// Point operations run this many times
+const int PointIterations = 200;
+// Rows per seeding transaction
+const int SeedBatch = 50000;
+
+struct Dataset {
+    int orders = 0;
+    int clients = 0;
+    QString path;
+    bool seeded = false;
+};
+
+} // namespace
+
+class DaoBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void clientDao_data();
+    void clientDao();
+    void commandDao_data();
+    void commandDao();
+    void commandStatistics_data();
+    void commandStatistics();
+
+private:
+    QTemporaryDir workDir;
+    QList<int> sizes;
+    QHash<int, Dataset> datasets;
+    QJsonArray results;
+    QRandomGenerator rng;
+    int currentRows = 0;
+
+    void addDatasetRows();
+    const Dataset& useDataset(int orders);
+    bool seed(Dataset& dataset, QString& error);
+    // call(i) runs one operation and returns the rows it read or wrote
+    void measure(const QString& operation, int iterations, const std::function<int(int)>& call);
+    static int scanIterations(int rows);
+
+    int randomClientId(const Dataset& dataset) { return 1 + int(rng.bounded(quint32(dataset.clients))); }
+    int randomCommandId(const Dataset& dataset) { return 1 + int(rng.bounded(quint32(dataset.orders))); }
+};
+
+void DaoBench::initTestCase()
+{
+    QVERIFY2(QSqlDatabase::isDriverAvailable("QSQLITE"), "QSQLITE driver not available");
+    QVERIFY(workDir.isValid());
+
+    QString list = qEnvironmentVariable("DAOBENCH_SIZES", "1000,100000");
+    for (const QString& part : list.split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        int rows = part.trimmed().toInt(&ok);
+        if (ok && rows > 0) {
+            sizes.append(rows);
+        }
+    }
+    QVERIFY2(!sizes.isEmpty(), "DAOBENCH_SIZES has no usable size");
+}
+
+void DaoBench::cleanupTestCase()
+{
+    QJsonObject report;
+    report["driver"] = "QSQLITE";
+    report["qtVersion"] = QString(qVersion());
+    report["generatedAt"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["results"] = results;
+
+    QString path = qEnvironmentVariable("DAOBENCH_OUTPUT", "daobench.json");
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        file.write(QJsonDocument(report).toJson());
+        qInfo() << "Benchmark results written to" << QFileInfo(file).absoluteFilePath();
+    } else {
+        qWarning() << "Cannot write" << path << ":" << file.errorString();
+    }
+
+    Connection::getInstance().closeConnection();
+}
+
+void DaoBench::addDatasetRows()
+{
+    QTest::addColumn<int>("orders");
+    for (int rows : sizes) {
+        QString name = rows >= 1000000 ? QString("%1M").arg(rows / 1000000)
+                       : rows >= 1000  ? QString("%1k").arg(rows / 1000)
+                                       : QString::number(rows);
+        QTest::newRow(qPrintable(name)) << rows;
+    }
+}
+
+const Dataset& DaoBench::useDataset(int orders)
+{
+    Dataset& dataset = datasets[orders];
+    if (dataset.path.isEmpty()) {
+        dataset.orders = orders;
+        dataset.clients = qMax(10, orders / 10);
+        dataset.path = workDir.filePath(QString("dataset_%1.sqlite").arg(orders));
+    }
+
+    Connection& conn = Connection::getInstance();
+    if (currentRows != orders) {
+        if (!conn.openDatabase("QSQLITE", dataset.path)) {
+            QTest::qFail("Cannot open the SQLite stand-in", __FILE__, __LINE__);
+            return dataset;
+        }
+        // Settings a local deployment would use
+        QSqlQuery pragma(conn.getDatabase());
+        pragma.exec("PRAGMA journal_mode=WAL");
+        pragma.exec("PRAGMA synchronous=NORMAL");
+        pragma.exec("PRAGMA foreign_keys=ON");
+        QueryCache::instance().clear();
+        currentRows = orders;
+    }
+
+    if (!dataset.seeded) {
+        QString error;
+        QElapsedTimer timer;
+        timer.start();
+        if (!seed(dataset, error)) {
+            QTest::qFail(qPrintable("Seeding failed: " + error), __FILE__, __LINE__);
+            return dataset;
+        }
+        qInfo() << "Seeded" << dataset.clients << "clients and" << dataset.orders << "orders in"
+                << timer.elapsed() << "ms";
+        dataset.seeded = true;
+    }
+    return dataset;
+}
+
+bool DaoBench::seed(Dataset& dataset, QString& error)
+{
+    QSqlDatabase db = Connection::getInstance().getDatabase();
+    SchemaMigrator migrator(db);
+    if (!migrator.migrate()) {
+        error = migrator.report();
+        return false;
+    }
+
+    // Same data for every run
+    QRandomGenerator seedRng(20240101u + quint32(dataset.orders));
+
+    QSqlQuery insertClient(db);
+    insertClient.prepare("INSERT INTO CLIENTS (ID, NAME, EMAIL, CITY, POSTAL, ADDRESS) VALUES (?, ?, ?, ?, ?, ?)");
+    db.transaction();
+    for (int id = 1; id <= dataset.clients; ++id) {
+        QString surname = Surnames.at(int(seedRng.bounded(quint32(Surnames.size()))));
+        insertClient.bindValue(0, id);
+        insertClient.bindValue(1, QString("%1 %2").arg(surname).arg(id));
+        insertClient.bindValue(2, QString("client%1@example.com").arg(id));
+        insertClient.bindValue(3, Cities.at(int(seedRng.bounded(quint32(Cities.size())))));
+        insertClient.bindValue(4, QString::number(1000 + seedRng.bounded(9000)));
+        insertClient.bindValue(5, QString("%1 Rue de la Republique").arg(seedRng.bounded(200) + 1));
+        if (!insertClient.exec()) {
+            error = insertClient.lastError().text();
+            db.rollback();
+            return false;
+        }
+        if (id % SeedBatch == 0) {
+            db.commit();
+            db.transaction();
+        }
+    }
+    db.commit();
+
+    // Orders spread over the last three years
+    QDateTime now = QDateTime::currentDateTime();
+    quint32 spanSecs = 3u * 365 * 24 * 3600;
+    QSqlQuery insertCommand(db);
+    insertCommand.prepare("INSERT INTO COMMANDS (COMMAND_ID, CLIENT_ID, COMMAND_DATE, TOTAL, PAYMENT_METHOD, "
+                          "DELIVERY_ADDRESS) VALUES (?, ?, ?, ? / 100.0, ?, ?)");
+    db.transaction();
+    for (int id = 1; id <= dataset.orders; ++id) {
+        insertCommand.bindValue(0, id);
+        insertCommand.bindValue(1, 1 + int(seedRng.bounded(quint32(dataset.clients))));
+        insertCommand.bindValue(2, now.addSecs(-qint64(seedRng.bounded(spanSecs))));
+        insertCommand.bindValue(3, qint64(100 + seedRng.bounded(200000)));   // Cents
+        insertCommand.bindValue(4, PaymentMethods.at(int(seedRng.bounded(quint32(PaymentMethods.size())))));
+        insertCommand.bindValue(5, QString("%1 Avenue Habib Bourguiba").arg(seedRng.bounded(500) + 1));
+        if (!insertCommand.exec()) {
+            error = insertCommand.lastError().text();
+            db.rollback();
+            return false;
+        }
+        if (id % SeedBatch == 0) {
+            db.commit();
+            db.transaction();
+        }
+    }
+    db.commit();
+
+    QSqlQuery analyze(db);
+    analyze.exec("ANALYZE");
+    return true;
+}
+
+int DaoBench::scanIterations(int rows)
+{
+    // Enough samples for a p99 on small sets without hours on 10M rows
+    return qBound(3, 2000000 / qMax(1, rows), 50);
+}
+
+void DaoBench::measure(const QString& operation, int iterations, const std::function<int(int)>& call)
+{
+    QVector<qint64> samples;
+    samples.reserve(iterations);
+    qint64 totalRows = 0;
+    QElapsedTimer timer;
+
+    for (int i = 0; i < iterations; ++i) {
+        QueryCache::instance().clear();
+        timer.start();
+        totalRows += call(i);
+        samples.append(timer.nsecsElapsed());
+    }
+
+    std::sort(samples.begin(), samples.end());
+    qint64 totalNs = std::accumulate(samples.cbegin(), samples.cend(), qint64(0));
+    auto percentile = [&samples](double p) {
+        int index = qBound(0, int(std::ceil(p * samples.size())) - 1, int(samples.size()) - 1);
+        return samples.at(index) / 1000.0;
+    };
+    double seconds = totalNs / 1e9;
+
+    QJsonObject result;
+    result["dataset"] = currentRows;
+    result["operation"] = operation;
+    result["iterations"] = iterations;
+    result["p50Us"] = percentile(0.50);
+    result["p99Us"] = percentile(0.99);
+    result["meanUs"] = totalNs / 1000.0 / qMax(1, iterations);
+    result["opsPerSec"] = seconds > 0 ? iterations / seconds : 0.0;
+    result["rowsPerSec"] = seconds > 0 ? totalRows / seconds : 0.0;
+    results.append(result);
+
+    qInfo().noquote() << QString("%1 rows  %2  p50 %3 us  p99 %4 us  %5 ops/s")
+                             .arg(currentRows, 9).arg(operation, -42)
+                             .arg(result["p50Us"].toDouble(), 0, 'f', 1)
+                             .arg(result["p99Us"].toDouble(), 0, 'f', 1)
+                             .arg(result["opsPerSec"].toDouble(), 0, 'f', 1);
+}
+
+void DaoBench::clientDao_data()
+{
+    addDatasetRows();
+}
+
+void DaoBench::clientDao()
+{
+    QFETCH(int, orders);
+    const Dataset& dataset = useDataset(orders);
+    ClientDAO dao;
+
+    QList<int> created;
+    measure("ClientDAO::createClient", PointIterations, [&](int i) {
+        int id = 0;
+        bool ok = dao.createClient(Client(QString("Bench Client %1").arg(i),
+                                          QString("bench%1.%2@example.com").arg(orders).arg(i),
+                                          "Tunis", "1000", "1 Rue du Lac"), &id);
+        if (ok) {
+            created.append(id);
+        }
+        return ok ? 1 : 0;
+    });
+    QCOMPARE(created.size(), PointIterations);
+
+    measure("ClientDAO::readClient", PointIterations, [&](int) {
+        return dao.readClient(randomClientId(dataset)).id > 0 ? 1 : 0;
+    });
+    measure("ClientDAO::updateClient", created.size(), [&](int i) {
+        Client client = dao.readClient(created.at(i));
+        client.city = "Sfax";
+        return dao.updateClient(client) ? 1 : 0;
+    });
+    measure("ClientDAO::readAllClients", scanIterations(dataset.clients), [&](int) {
+        return int(dao.readAllClients().size());
+    });
+    measure("ClientDAO::searchClientsByName", scanIterations(dataset.clients), [&](int i) {
+        return int(dao.searchClientsByName(Surnames.at(i % Surnames.size())).size());
+    });
+    measure("ClientDAO::searchClientsByEmail", scanIterations(dataset.clients), [&](int) {
+        return int(dao.searchClientsByEmail(QString("client%1@").arg(randomClientId(dataset))).size());
+    });
+    measure("ClientDAO::searchClientsByCity", scanIterations(dataset.clients), [&](int i) {
+        return int(dao.searchClientsByCity(Cities.at(i % Cities.size())).size());
+    });
+    measure("ClientDAO::emailExists", PointIterations, [&](int) {
+        return dao.emailExists(QString("client%1@example.com").arg(randomClientId(dataset))) ? 1 : 0;
+    });
+    measure("ClientDAO::getClientCount", PointIterations, [&](int) {
+        return dao.getClientCount() > 0 ? 1 : 0;
+    });
+    measure("ClientDAO::deleteClient", created.size(), [&](int i) {
+        return dao.deleteClient(created.at(i)) ? 1 : 0;
+    });
+}
+
+void DaoBench::commandDao_data()
+{
+    addDatasetRows();
+}
+
+void DaoBench::commandDao()
+{
+    QFETCH(int, orders);
+    const Dataset& dataset = useDataset(orders);
+    CommandDAO dao;
+
+    QList<int> created;
+    measure("CommandDAO::createCommand", PointIterations, [&](int i) {
+        Command command(randomClientId(dataset), Money::fromCents(1000 + i),
+                        PaymentMethods.at(i % PaymentMethods.size()), "2 Rue du Lac");
+        int id = 0;
+        bool ok = dao.createCommand(command, &id);
+        if (ok) {
+            created.append(id);
+        }
+        return ok ? 1 : 0;
+    });
+    QCOMPARE(created.size(), PointIterations);
+
+    measure("CommandDAO::readCommand", PointIterations, [&](int) {
+        return dao.readCommand(randomCommandId(dataset)).commandId > 0 ? 1 : 0;
+    });
+    measure("CommandDAO::updateCommand", created.size(), [&](int i) {
+        Command command = dao.readCommand(created.at(i));
+        command.total = Money::fromCents(5000 + i);
+        return dao.updateCommand(command) ? 1 : 0;
+    });
+    measure("CommandDAO::readAllCommands", scanIterations(dataset.orders), [&](int) {
+        return int(dao.readAllCommands().size());
+    });
+    measure("CommandDAO::readCommandsByClient", PointIterations, [&](int) {
+        return int(dao.readCommandsByClient(randomClientId(dataset)).size());
+    });
+    measure("CommandDAO::searchCommandsByDate", PointIterations, [&](int) {
+        QDate start = QDate::currentDate().addDays(-int(rng.bounded(1000)));
+        return int(dao.searchCommandsByDate(start, start.addDays(7)).size());
+    });
+    measure("CommandDAO::searchCommandsByPaymentMethod", scanIterations(dataset.orders), [&](int i) {
+        return int(dao.searchCommandsByPaymentMethod(PaymentMethods.at(i % PaymentMethods.size())).size());
+    });
+    measure("CommandDAO::searchCommandsByTotalRange", PointIterations, [&](int) {
+        qint64 low = 100 + rng.bounded(199000);
+        return int(dao.searchCommandsByTotalRange(Money::fromCents(low), Money::fromCents(low + 1000)).size());
+    });
+    measure("CommandDAO::searchCommandsByClient", scanIterations(dataset.orders), [&](int) {
+        return int(dao.searchCommandsByClient(QString(" %1").arg(randomClientId(dataset))).size());
+    });
+    measure("CommandDAO::commandExists", PointIterations, [&](int) {
+        return dao.commandExists(randomCommandId(dataset)) ? 1 : 0;
+    });
+    measure("CommandDAO::getCommandCount", PointIterations, [&](int) {
+        return dao.getCommandCount() > 0 ? 1 : 0;
+    });
+    measure("CommandDAO::getCommandCountByClient", PointIterations, [&](int) {
+        return dao.getCommandCountByClient(randomClientId(dataset));
+    });
+    measure("CommandDAO::getCommandCountsByClient", scanIterations(dataset.orders), [&](int) {
+        return int(dao.getCommandCountsByClient().size());
+    });
+    measure("CommandDAO::getTotalSales", scanIterations(dataset.orders), [&](int) {
+        return dao.getTotalSales().isNegative() ? 0 : 1;
+    });
+    measure("CommandDAO::getTotalSalesByClient", PointIterations, [&](int) {
+        return dao.getTotalSalesByClient(randomClientId(dataset)).isNegative() ? 0 : 1;
+    });
+    measure("CommandDAO::getPaymentMethods", PointIterations, [&](int) {
+        return int(dao.getPaymentMethods().size());
+    });
+    measure("CommandDAO::readTopCommands", PointIterations, [&](int) {
+        return int(dao.readTopCommands(10).size());
+    });
+    measure("CommandDAO::getCommandsWithClientInfo", scanIterations(dataset.orders), [&](int) {
+        return int(dao.getCommandsWithClientInfo().size());
+    });
+    measure("CommandDAO::getCommandWithClientInfo", PointIterations, [&](int) {
+        return dao.getCommandWithClientInfo(randomCommandId(dataset)).commandId > 0 ? 1 : 0;
+    });
+    measure("CommandDAO::deleteCommand", created.size(), [&](int i) {
+        return dao.deleteCommand(created.at(i)) ? 1 : 0;
+    });
+}
+
+void DaoBench::commandStatistics_data()
+{
+    addDatasetRows();
+}
+
+void DaoBench::commandStatistics()
+{
+    QFETCH(int, orders);
+    const Dataset& dataset = useDataset(orders);
+    CommandDAO dao;
+    CommandStatistics statistics(&dao);
+
+    measure("CommandStatistics::getOverallStatistics", scanIterations(dataset.orders), [&](int) {
+        return statistics.getOverallStatistics().totalCommands;
+    });
+    measure("CommandStatistics::getClientStatistics", PointIterations, [&](int) {
+        return statistics.getClientStatistics(randomClientId(dataset)).totalCommands;
+    });
+    measure("CommandStatistics::getPaymentMethodStats", scanIterations(dataset.orders), [&](int) {
+        return int(statistics.getPaymentMethodStats().size());
+    });
+    measure("CommandStatistics::getDailySales", scanIterations(dataset.orders), [&](int) {
+        QDate end = QDate::currentDate();
+        return int(statistics.getDailySales(end.addDays(-30), end).size());
+    });
+    measure("CommandStatistics::getMonthlySales", scanIterations(dataset.orders), [&](int) {
+        QDate end = QDate::currentDate();
+        return int(statistics.getMonthlySales(end.addYears(-1), end).size());
+    });
+    measure("CommandStatistics::getTopClientsByTotal", scanIterations(dataset.orders), [&](int) {
+        return int(statistics.getTopClientsByTotal(10).size());
+    });
+}
+
+QTEST_GUILESS_MAIN(DaoBench)
+#include "tst_daobench.moc"
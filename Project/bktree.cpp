@@ -0,0 +1,140 @@
+// bktree.cpp
+#include "bktree.h"
+#include <QVarLengthArray>
+#include <algorithm>
+
+void BKTree::clear()
+{
+    nodes.clear();
+    nodeByTerm.clear();
+    liveTerms = 0;
+}
+
+void BKTree::insert(const QString& term, int id)
+{
+    if (term.isEmpty()) {
+        return;
+    }
+
+    auto existing = nodeByTerm.constFind(term);
+    if (existing != nodeByTerm.constEnd()) {
+        Node& node = nodes[*existing];
+        if (!node.ids.contains(id)) {
+            if (node.ids.isEmpty()) {
+                liveTerms++;
+            }
+            node.ids.append(id);
+        }
+        return;
+    }
+
+    Node node;
+    node.term = term;
+    node.ids.append(id);
+    int newIndex = nodes.size();
+
+    // Walk down along the edge matching the distance to each node
+    int current = 0;
+    while (!nodes.isEmpty()) {
+        int d = distance(term, nodes.at(current).term);
+        int next = -1;
+        for (const auto& child : nodes.at(current).children) {
+            if (child.first == d) {
+                next = child.second;
+                break;
+            }
+        }
+        if (next < 0) {
+            nodes[current].children.append(qMakePair(d, newIndex));
+            break;
+        }
+        current = next;
+    }
+
+    nodes.append(node);
+    nodeByTerm.insert(term, newIndex);
+    liveTerms++;
+}
+
+void BKTree::remove(const QString& term, int id)
+{
+    auto it = nodeByTerm.constFind(term);
+    if (it == nodeByTerm.constEnd()) {
+        return;
+    }
+
+    Node& node = nodes[*it];
+    if (node.ids.removeOne(id) && node.ids.isEmpty()) {
+        liveTerms--;
+    }
+}
+
+QList<BKTree::Match> BKTree::nearest(const QString& term, int k, int maxDistance) const
+{
+    QList<Match> matches;
+    if (nodes.isEmpty() || k <= 0 || maxDistance < 0) {
+        return matches;
+    }
+
+    auto closer = [](const Match& a, const Match& b) {
+        return a.distance == b.distance ? a.term < b.term : a.distance < b.distance;
+    };
+
+    // Radius shrinks to the k-th best distance once k matches are known
+    int radius = maxDistance;
+    QVector<int> pending;
+    pending.append(0);
+
+    while (!pending.isEmpty()) {
+        const Node& node = nodes.at(pending.takeLast());
+        int d = distance(term, node.term);
+
+        if (d <= radius && !node.ids.isEmpty()) {
+            Match match{node.term, d, node.ids};
+            matches.insert(std::lower_bound(matches.begin(), matches.end(), match, closer), match);
+            if (matches.size() > k) {
+                matches.removeLast();
+            }
+            if (matches.size() == k) {
+                radius = qMin(radius, matches.last().distance);
+            }
+        }
+
+        for (const auto& child : node.children) {
+            if (child.first >= d - radius && child.first <= d + radius) {
+                pending.append(child.second);
+            }
+        }
+    }
+
+    return matches;
+}
+
+int BKTree::distance(const QString& a, const QString& b)
+{
+    if (a.size() < b.size()) {
+        return distance(b, a);
+    }
+    if (b.isEmpty()) {
+        return a.size();
+    }
+
+    // Two rows of the edit-distance table, sized by the shorter string
+    QVarLengthArray<int, 64> previous(b.size() + 1);
+    QVarLengthArray<int, 64> current(b.size() + 1);
+    for (int j = 0; j <= b.size(); ++j) {
+        previous[j] = j;
+    }
+
+    for (int i = 1; i <= a.size(); ++i) {
+        current[0] = i;
+        QChar ca = a.at(i - 1);
+        for (int j = 1; j <= b.size(); ++j) {
+            int cost = ca == b.at(j - 1) ? 0 : 1;
+            current[j] = qMin(qMin(previous[j] + 1, current[j - 1] + 1), previous[j - 1] + cost);
+        }
+        std::swap(previous, current);
+    }
+
+    return previous[b.size()];
+}
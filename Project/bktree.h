@@ -0,0 +1,52 @@
+// bktree.h
+#ifndef BKTREE_H
+#define BKTREE_H
+
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QHash>
+#include <QPair>
+
+// Burkhard-Keller tree over strings with Levenshtein distance.
+//
+// Each node stores one distinct term plus the ids that carry it; children
+// are keyed by their distance to the parent. The triangle inequality lets
+// a lookup skip every subtree whose edge lies outside [d - r, d + r], so a
+// typo search only measures a small part of the terms.
+//
+// Removing an id leaves the node in place as a routing node; it is no
+// longer reported once its id list is empty.
+class BKTree
+{
+public:
+    struct Match {
+        QString term;
+        int distance;
+        QList<int> ids;
+    };
+
+    void clear();
+    void insert(const QString& term, int id);
+    void remove(const QString& term, int id);
+
+    // Up to k live terms within maxDistance, closest first (ties by term)
+    QList<Match> nearest(const QString& term, int k, int maxDistance) const;
+
+    int size() const { return liveTerms; }
+
+    static int distance(const QString& a, const QString& b);
+
+private:
+    struct Node {
+        QString term;
+        QList<int> ids;
+        QVector<QPair<int, int>> children;   // (distance, node index)
+    };
+
+    QVector<Node> nodes;
+    QHash<QString, int> nodeByTerm;
+    int liveTerms = 0;
+};
+
+#endif // BKTREE_H
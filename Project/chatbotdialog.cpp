@@ -11,12 +11,17 @@
 #include <QGraphicsOpacityEffect>
 #include <QCompleter>
 #include <QMessageBox>
+#include <algorithm>
 
 ChatbotDialog::ChatbotDialog(QWidget *parent) :
     QDialog(parent),
     ui(new Ui::ChatbotDialog),
     m_clientManager(nullptr),
-    m_commandManager(nullptr)
+    m_commandManager(nullptr),
+    m_columnStore(nullptr),
+    m_statisticsCache(nullptr),
+    m_completer(nullptr),
+    m_completionModel(nullptr)
 {
     ui->setupUi(this);
     setWindowTitle("🤖 Enhanced Client Management Assistant");
@@ -127,16 +132,67 @@ void ChatbotDialog::setupSuggestions()
 
 void ChatbotDialog::setupAutoCompleter()
 {
-    QStringList commands;
-    commands << "show all clients" << "find client" << "find email" << "clients in"
-             << "commands for" << "commands from" << "total sales" << "count clients"
-             << "count commands" << "help" << "clear" << "export" << "statistics"
-             << "recent orders" << "top clients" << "monthly revenue";
+    m_commandPhrases << "show all clients" << "find client" << "find email" << "clients in"
+                     << "commands for" << "commands from" << "total sales" << "count clients"
+                     << "count commands" << "help" << "clear" << "export" << "statistics"
+                     << "recent orders" << "top clients" << "monthly revenue";
+
+    // The list is rebuilt on each edit, so the completer shows it unfiltered
+    m_completionModel = new QStringListModel(m_commandPhrases, this);
+    m_completer = new QCompleter(m_completionModel, this);
+    m_completer->setCaseSensitivity(Qt::CaseInsensitive);
+    m_completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    ui->inputLineEdit->setCompleter(m_completer);
+
+    connect(ui->inputLineEdit, &QLineEdit::textEdited, this, [this](const QString &text) {
+        updateCompletions(text);
+        m_completer->complete();
+    });
+}
+
+void ChatbotDialog::updateCompletions(const QString &text)
+{
+    // After a command that takes a client, complete the client itself
+    static const QList<QPair<QString, ClientSearchIndex::Field>> entityCommands = {
+        {"find client ", ClientSearchIndex::NameField},
+        {"find email ", ClientSearchIndex::EmailField},
+        {"clients in ", ClientSearchIndex::CityField},
+        {"commands for ", ClientSearchIndex::NameField},
+        {"orders for ", ClientSearchIndex::NameField}
+    };
+
+    QStringList proposals;
+    ClientSearchIndex *index = m_clientManager ? m_clientManager->getDAO()->getSearchIndex() : nullptr;
+
+    if (index && index->isReady()) {
+        for (const auto &command : entityCommands) {
+            if (!text.startsWith(command.first, Qt::CaseInsensitive)) {
+                continue;
+            }
+
+            // Several clients share a city, so ask for more and drop repeats
+            QString head = text.left(command.first.size());
+            for (const ClientSearchIndex::Completion &completion :
+                 index->complete(command.second, text.mid(command.first.size()), 20)) {
+                QString proposal = head + completion.text;
+                if (!proposals.contains(proposal)) {
+                    proposals << proposal;
+                }
+                if (proposals.size() == 8) {
+                    break;
+                }
+            }
+            m_completionModel->setStringList(proposals);
+            return;
+        }
+    }
 
-    QCompleter* completer = new QCompleter(commands, this);
-    completer->setCaseSensitivity(Qt::CaseInsensitive);
-    completer->setFilterMode(Qt::MatchContains);
-    ui->inputLineEdit->setCompleter(completer);
+    for (const QString &phrase : m_commandPhrases) {
+        if (phrase.contains(text.trimmed(), Qt::CaseInsensitive)) {
+            proposals << phrase;
+        }
+    }
+    m_completionModel->setStringList(proposals);
 }
 
 void ChatbotDialog::setManagers(ClientManager* clientManager, CommandManager* commandManager)
@@ -175,15 +231,13 @@ void ChatbotDialog::showQuickStats()
 {
     if (!hasClientManager() || !hasCommandManager()) return;
 
-    int clientCount = m_clientManager->getDAO()->getClientCount();
-    int commandCount = m_commandManager->getDAO()->getCommandCount();
-    double totalSales = m_commandManager->getDAO()->getTotalSales();
+    CommandStatistics::Statistics stats = currentStatistics();
 
     addMessageWithAnimation("📊 <b>Quick Statistics:</b>");
     addMessageWithAnimation(QString("   👥 %1 clients | 📦 %2 orders | 💰 $%3 total sales")
-                                .arg(clientCount)
-                                .arg(commandCount)
-                                .arg(QString::number(totalSales, 'f', 2)));
+                                .arg(stats.totalClients)
+                                .arg(stats.totalCommands)
+                                .arg(stats.totalSales.toString()));
 }
 
 void ChatbotDialog::onInputChanged(const QString &text)
@@ -218,6 +272,15 @@ bool ChatbotDialog::hasCommandManager() const
     return m_commandManager != nullptr;
 }
 
+CommandStatistics::Statistics ChatbotDialog::currentStatistics()
+{
+    if (m_statisticsCache) {
+        return m_statisticsCache->snapshot();
+    }
+    CommandStatistics statistics(m_commandManager->getDAO());
+    return statistics.getOverallStatistics();
+}
+
 void ChatbotDialog::on_sendButton_clicked()
 {
     QString query = ui->inputLineEdit->text().trimmed();
@@ -397,23 +460,37 @@ void ChatbotDialog::showDetailedStatistics()
     addMessageWithAnimation("📊 <b>Detailed Business Statistics</b>");
     addMessageWithAnimation("═══════════════════════════════════");
 
+    CommandStatistics::Statistics stats = currentStatistics();
+
     // Client stats
-    int clientCount = m_clientManager->getDAO()->getClientCount();
+    int clientCount = stats.totalClients;
     addMessageWithAnimation(QString("👥 <b>Clients:</b> %1 total").arg(clientCount));
 
     // Order stats
-    int commandCount = m_commandManager->getDAO()->getCommandCount();
-    double totalSales = m_commandManager->getDAO()->getTotalSales();
+    int commandCount = stats.totalCommands;
+    Money totalSales = stats.totalSales;
 
     addMessageWithAnimation(QString("📦 <b>Orders:</b> %1 total").arg(commandCount));
-    addMessageWithAnimation(QString("💰 <b>Revenue:</b> $%1").arg(QString::number(totalSales, 'f', 2)));
+    addMessageWithAnimation(QString("💰 <b>Revenue:</b> $%1").arg(totalSales.toString()));
 
     if (commandCount > 0) {
-        double avgOrder = totalSales / commandCount;
-        addMessageWithAnimation(QString("📈 <b>Average Order:</b> $%1").arg(QString::number(avgOrder, 'f', 2)));
+        Money avgOrder = totalSales.dividedBy(commandCount);
+        addMessageWithAnimation(QString("📈 <b>Average Order:</b> $%1").arg(avgOrder.toString()));
 
         double avgOrdersPerClient = (double)commandCount / clientCount;
         addMessageWithAnimation(QString("🔄 <b>Orders per Client:</b> %1").arg(QString::number(avgOrdersPerClient, 'f', 1)));
+
+        if (!stats.topClientName.isEmpty()) {
+            addMessageWithAnimation(QString("🏆 <b>Top Client:</b> %1").arg(stats.topClientName.toHtmlEscaped()));
+        }
+        if (!stats.mostUsedPaymentMethod.isEmpty()) {
+            addMessageWithAnimation(QString("💳 <b>Most Used Payment:</b> %1").arg(stats.mostUsedPaymentMethod.toHtmlEscaped()));
+        }
+        if (stats.firstOrderDate.isValid()) {
+            addMessageWithAnimation(QString("📅 <b>Orders From:</b> %1 to %2")
+                                        .arg(stats.firstOrderDate.toString("dd/MM/yyyy"),
+                                             stats.lastOrderDate.toString("dd/MM/yyyy")));
+        }
     }
 }
 
@@ -496,13 +573,13 @@ void ChatbotDialog::showAllClientsEnhanced()
         if (hasCommandManager()) {
             QList<Command> commands = m_commandManager->getClientCommands(client.id);
             if (!commands.isEmpty()) {
-                double total = 0;
+                Money total;
                 for (const Command &cmd : commands) {
-                    total += cmd.getTotalAmount();
+                    total += cmd.total;
                 }
                 addMessageWithAnimation(QString("   📦 %1 orders ($%2)")
                                             .arg(commands.size())
-                                            .arg(QString::number(total, 'f', 2)));
+                                            .arg(total.toString()));
             }
         }
         addMessageWithAnimation("");
@@ -541,8 +618,8 @@ void ChatbotDialog::showRecentOrders()
 
         addMessageWithAnimation(QString("🛒 Order #%1 - %2").arg(command.commandId).arg(clientName));
         addMessageWithAnimation(QString("   📅 %1 | 💰 $%2")
-                                    .arg(command.commandDate.toString("yyyy-MM-dd hh:mm"))
-                                    .arg(command.total));
+                                    .arg(command.commandDate().toString("yyyy-MM-dd hh:mm"))
+                                    .arg(command.total.toString()));
         addMessageWithAnimation("");
         shown++;
     }
@@ -679,27 +756,95 @@ void ChatbotDialog::showClientCommands(int clientId)
     for (const Command &command : commands) {
         addMessageWithAnimation(QString("🛒 Order #%1").arg(command.commandId));
         addMessageWithAnimation(QString("   📅 %1 | 💰 $%2 | %3")
-                                    .arg(command.commandDate.toString("yyyy-MM-dd"))
-                                    .arg(command.total)
+                                    .arg(command.commandDate().toString("yyyy-MM-dd"))
+                                    .arg(command.total.toString())
                                     .arg(command.paymentMethod));
         addMessageWithAnimation("");
     }
 }
 
-// Stub implementations for methods that need to be implemented
 void ChatbotDialog::searchClientByNameEnhanced(const QString &name) {
     addMessageWithAnimation(QString("🔍 Searching for client: %1").arg(name));
-    // Implementation needed
+    if (!hasClientManager()) {
+        addMessageWithAnimation("❌ Database connection not available.");
+        return;
+    }
+    QList<Client> clients = m_clientManager->getDAO()->searchClientsByName(name);
+    if (clients.isEmpty() && showClosestMatches(ClientSearchIndex::NameField, name)) {
+        return;
+    }
+    showClientResults(clients, QString("No client name contains '%1'.").arg(name));
 }
 
 void ChatbotDialog::searchClientByEmailEnhanced(const QString &email) {
     addMessageWithAnimation(QString("🔍 Searching for email: %1").arg(email));
-    // Implementation needed
+    if (!hasClientManager()) {
+        addMessageWithAnimation("❌ Database connection not available.");
+        return;
+    }
+    showClientResults(m_clientManager->getDAO()->searchClientsByEmail(email),
+                      QString("No client email contains '%1'.").arg(email));
 }
 
 void ChatbotDialog::searchClientByCityEnhanced(const QString &city) {
     addMessageWithAnimation(QString("🔍 Searching clients in city: %1").arg(city));
-    // Implementation needed
+    if (!hasClientManager()) {
+        addMessageWithAnimation("❌ Database connection not available.");
+        return;
+    }
+    QList<Client> clients = m_clientManager->getDAO()->searchClientsByCity(city);
+    if (clients.isEmpty() && showClosestMatches(ClientSearchIndex::CityField, city)) {
+        return;
+    }
+    showClientResults(clients, QString("No clients found in '%1'.").arg(city));
+}
+
+bool ChatbotDialog::showClosestMatches(ClientSearchIndex::Field field, const QString &text) {
+    ClientSearchIndex *index = m_clientManager->getDAO()->getSearchIndex();
+    if (!index || !index->isReady()) {
+        return false;
+    }
+
+    QList<BKTree::Match> matches = index->suggest(field, text, 3);
+    if (matches.isEmpty()) {
+        return false;
+    }
+
+    QStringList spellings;
+    QList<Client> clients;
+    for (const BKTree::Match &match : matches) {
+        Client first = index->client(match.ids.first());
+        spellings << (field == ClientSearchIndex::NameField ? first.name : first.city);
+        for (int id : match.ids) {
+            clients.append(index->client(id));
+        }
+    }
+
+    addMessageWithAnimation(QString("🤔 No exact match. Did you mean: <b>%1</b>?").arg(spellings.join(", ")));
+    showClientResults(clients, QString());
+    return true;
+}
+
+void ChatbotDialog::showClientResults(const QList<Client> &clients, const QString &emptyMessage) {
+    if (clients.isEmpty()) {
+        addMessageWithAnimation("📋 " + emptyMessage);
+        return;
+    }
+
+    addMessageWithAnimation(QString("📋 <b>%1 client(s) found</b>").arg(clients.size()));
+    for (int i = 0; i < clients.size() && i < 10; ++i) {
+        const Client &client = clients.at(i);
+        addMessageWithAnimation(QString("👤 <b>%1</b> (ID: %2)")
+                                    .arg(client.name)
+                                    .arg(client.id));
+        addMessageWithAnimation(QString("   📧 %1 | 🏙️ %2")
+                                    .arg(client.email.isEmpty() ? "No email" : client.email)
+                                    .arg(client.city.isEmpty() ? "No city" : client.city));
+    }
+
+    if (clients.size() > 10) {
+        addMessageWithAnimation(QString("... and %1 more clients").arg(clients.size() - 10));
+    }
 }
 
 void ChatbotDialog::showClientCount() {
@@ -707,7 +852,7 @@ void ChatbotDialog::showClientCount() {
         addMessageWithAnimation("❌ Database connection not available.");
         return;
     }
-    int count = m_clientManager->getDAO()->getClientCount();
+    int count = currentStatistics().totalClients;
     addMessageWithAnimation(QString("👥 Total clients: %1").arg(count));
 }
 
@@ -716,7 +861,7 @@ void ChatbotDialog::showCommandCount() {
         addMessageWithAnimation("❌ Database connection not available.");
         return;
     }
-    int count = m_commandManager->getDAO()->getCommandCount();
+    int count = currentStatistics().totalCommands;
     addMessageWithAnimation(QString("📦 Total commands: %1").arg(count));
 }
 
@@ -725,8 +870,8 @@ void ChatbotDialog::showTotalSalesEnhanced() {
         addMessageWithAnimation("❌ Database connection not available.");
         return;
     }
-    double total = m_commandManager->getDAO()->getTotalSales();
-    addMessageWithAnimation(QString("💰 Total sales: $%1").arg(QString::number(total, 'f', 2)));
+    Money total = currentStatistics().totalSales;
+    addMessageWithAnimation(QString("💰 Total sales: $%1").arg(total.toString()));
 }
 
 void ChatbotDialog::showAverageOrderValue() {
@@ -734,29 +879,90 @@ void ChatbotDialog::showAverageOrderValue() {
         addMessageWithAnimation("❌ Database connection not available.");
         return;
     }
-    int count = m_commandManager->getDAO()->getCommandCount();
-    double total = m_commandManager->getDAO()->getTotalSales();
-    if (count > 0) {
-        double avg = total / count;
-        addMessageWithAnimation(QString("📊 Average order value: $%1").arg(QString::number(avg, 'f', 2)));
+    CommandStatistics::Statistics stats = currentStatistics();
+    if (stats.totalCommands > 0) {
+        Money avg = stats.averageOrderValue;
+        addMessageWithAnimation(QString("📊 Average order value: $%1").arg(avg.toString()));
     } else {
         addMessageWithAnimation("📊 No orders found to calculate average.");
     }
 }
 
 void ChatbotDialog::showTopClients() {
-    addMessageWithAnimation("🏆 Top clients feature coming soon!");
-    // Implementation needed
+    if (!m_columnStore || !m_columnStore->isReady()) {
+        addMessageWithAnimation("❌ Order analytics are not loaded yet.");
+        return;
+    }
+
+    QList<QPair<int, CommandColumnStore::Bucket>> top = m_columnStore->topClients(5);
+    if (top.isEmpty()) {
+        addMessageWithAnimation("🏆 No orders yet, so no top clients.");
+        return;
+    }
+
+    addMessageWithAnimation("🏆 <b>Top Clients by Revenue</b>");
+    for (int i = 0; i < top.size(); ++i) {
+        QString name = m_columnStore->clientName(top.at(i).first);
+        addMessageWithAnimation(QString("%1. <b>%2</b> (ID: %3) | 💰 $%4 | 📦 %5 order(s)")
+                                    .arg(i + 1)
+                                    .arg(name.isEmpty() ? "Unknown client" : name)
+                                    .arg(top.at(i).first)
+                                    .arg(top.at(i).second.total.toString())
+                                    .arg(top.at(i).second.orders));
+    }
 }
 
 void ChatbotDialog::showMonthlyRevenue() {
-    addMessageWithAnimation("📈 Monthly revenue feature coming soon!");
-    // Implementation needed
+    if (!m_columnStore || !m_columnStore->isReady()) {
+        addMessageWithAnimation("❌ Order analytics are not loaded yet.");
+        return;
+    }
+
+    QDate today = QDate::currentDate();
+    QMap<QDate, CommandColumnStore::Bucket> months = m_columnStore->salesByMonth(today.addMonths(-11), today);
+
+    addMessageWithAnimation("📈 <b>Monthly Revenue (last 12 months)</b>");
+    Money total;
+    for (auto it = months.constBegin(); it != months.constEnd(); ++it) {
+        total = total + it.value().total;
+        addMessageWithAnimation(QString("📅 %1 | 💰 $%2 | 📦 %3 order(s)")
+                                    .arg(it.key().toString("MMM yyyy"))
+                                    .arg(it.value().total.toString())
+                                    .arg(it.value().orders));
+    }
+    addMessageWithAnimation(QString("💵 <b>12-month total:</b> $%1").arg(total.toString()));
 }
 
 void ChatbotDialog::showSalesByCity() {
-    addMessageWithAnimation("🏙️ Sales by city feature coming soon!");
-    // Implementation needed
+    if (!m_columnStore || !m_columnStore->isReady()) {
+        addMessageWithAnimation("❌ Order analytics are not loaded yet.");
+        return;
+    }
+
+    QMap<QString, CommandColumnStore::Bucket> cities = m_columnStore->salesByCity();
+    if (cities.isEmpty()) {
+        addMessageWithAnimation("🏙️ No orders yet, so no sales by city.");
+        return;
+    }
+
+    QList<QPair<QString, CommandColumnStore::Bucket>> ranked;
+    for (auto it = cities.constBegin(); it != cities.constEnd(); ++it) {
+        ranked.append(qMakePair(it.key(), it.value()));
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const auto &a, const auto &b) {
+        return a.second.total > b.second.total;
+    });
+
+    addMessageWithAnimation("🏙️ <b>Sales by City</b>");
+    for (int i = 0; i < ranked.size() && i < 10; ++i) {
+        addMessageWithAnimation(QString("📍 <b>%1</b> | 💰 $%2 | 📦 %3 order(s)")
+                                    .arg(ranked.at(i).first.isEmpty() ? "No city" : ranked.at(i).first)
+                                    .arg(ranked.at(i).second.total.toString())
+                                    .arg(ranked.at(i).second.orders));
+    }
+    if (ranked.size() > 10) {
+        addMessageWithAnimation(QString("... and %1 more cities").arg(ranked.size() - 10));
+    }
 }
 
 void ChatbotDialog::searchCommandsByClientEnhanced(const QString &clientInfo) {
@@ -7,6 +7,9 @@
 #include <QTimer>
 #include "clients.h"         // This contains ClientManager class
 #include "commands.h"        // This contains CommandManager class
+#include "clientsearchindex.h"
+#include "commandcolumnstore.h"
+#include "statisticscache.h"
 
 // Forward declarations
 class QCompleter;
@@ -28,6 +31,12 @@ public:
     // Manager setup - CHANGED TO USE ClientManager AND CommandManager CLASSES
     void setManagers(ClientManager* clientManager, CommandManager* commandManager);
 
+    // Analytics answers are computed from the column store instead of SQL when set
+    void setColumnStore(CommandColumnStore* store) { m_columnStore = store; }
+
+    // Counts and totals come from the shared snapshot when set
+    void setStatisticsCache(StatisticsCache* cache) { m_statisticsCache = cache; }
+
     // Utility methods
     bool hasClientManager() const;
     bool hasCommandManager() const;
@@ -43,14 +52,21 @@ private:
     // CHANGED TO USE ClientManager AND CommandManager CLASSES
     ClientManager *m_clientManager;
     CommandManager *m_commandManager;
+    CommandColumnStore *m_columnStore;
+    StatisticsCache *m_statisticsCache;
     QStringListModel *m_suggestionModel;
     QTimer *m_typingTimer;
+    QCompleter *m_completer;
+    QStringListModel *m_completionModel;
+    QStringList m_commandPhrases;
 
     // UI Setup and Enhancement
     void setupSuggestions();
     void setupAutoCompleter();
+    void updateCompletions(const QString &text);
     void showWelcomeMessage();
     void showQuickStats();
+    CommandStatistics::Statistics currentStatistics();
 
     // Core Processing
     void processQuery(const QString &query);
@@ -92,6 +108,8 @@ private:
     void showSampleClients();
     void showSampleEmails();
     void showAvailableCities();
+    void showClientResults(const QList<Client> &clients, const QString &emptyMessage);
+    bool showClosestMatches(ClientSearchIndex::Field field, const QString &text);
 
     // Query Parsing Helpers
     QString extractNameFromQuery(const QString &query, const QStringList &prefixes);
@@ -0,0 +1,274 @@
+// batchrunner.cpp
+#include "batchrunner.h"
+#include "csvexchange.h"
+#include "reportbuilder.h"
+#include "validationengine.h"
+#include <QTextStream>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QEventLoop>
+#include <QSaveFile>
+#include <QDir>
+#include <QHash>
+#include <QDateTime>
+
+static QTextStream& out()
+{
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+static QTextStream& err()
+{
+    static QTextStream stream(stderr);
+    return stream;
+}
+
+static int importExitCode(const CsvExchange::ImportResult& result)
+{
+    for (const QString& error : result.errors) {
+        err() << error << "\n";
+    }
+    out() << QString("Imported %1 of %2 rows\n").arg(result.imported).arg(result.rows);
+    if (result.ok()) {
+        return BatchRunner::Success;
+    }
+    return result.imported > 0 ? BatchRunner::PartialFailure : BatchRunner::JobFailed;
+}
+
+BatchRunner::BatchRunner(QObject *parent)
+    : QObject(parent)
+{
+    // The managers report DAO failures as validation errors
+    connect(&clientManager, &ClientManager::validationError, this, [](const QString& error) {
+        err() << error << "\n";
+    });
+    connect(&commandManager, &CommandManager::validationError, this, [](const QString& error) {
+        err() << error << "\n";
+    });
+}
+
+int BatchRunner::importClients(const QString& path)
+{
+    return importExitCode(CsvExchange::importClients(path, clientManager));
+}
+
+int BatchRunner::importOrders(const QString& path)
+{
+    return importExitCode(CsvExchange::importCommands(path, commandManager));
+}
+
+int BatchRunner::exportClients(const QString& path)
+{
+    QList<Client> clients = clientManager.getAllClients();
+    QString error;
+    if (!CsvExchange::exportClients(clients, path, error)) {
+        err() << error << "\n";
+        return JobFailed;
+    }
+    out() << QString("Exported %1 clients to %2\n").arg(clients.size()).arg(path);
+    return Success;
+}
+
+int BatchRunner::exportOrders(const QString& path)
+{
+    QList<Command> commands = commandManager.getAllCommands();
+    QString error;
+    if (!CsvExchange::exportCommands(commands, path, error)) {
+        err() << error << "\n";
+        return JobFailed;
+    }
+    out() << QString("Exported %1 orders to %2\n").arg(commands.size()).arg(path);
+    return Success;
+}
+
+int BatchRunner::statistics(bool json)
+{
+    CommandStatistics statistics(commandManager.getDAO());
+    CommandStatistics::Statistics stats = statistics.getOverallStatistics();
+    QList<QPair<int, Money>> topClients = statistics.getTopClientsByTotal(10);
+    QMap<QString, int> paymentMethods = statistics.getPaymentMethodStats();
+
+    if (json) {
+        QJsonObject object;
+        object["totalClients"] = stats.totalClients;
+        object["totalCommands"] = stats.totalCommands;
+        object["totalSales"] = stats.totalSales.toString();
+        object["averageOrderValue"] = stats.averageOrderValue.toString();
+        object["topClientId"] = stats.topClientId;
+        object["topClientName"] = stats.topClientName;
+        object["mostUsedPaymentMethod"] = stats.mostUsedPaymentMethod;
+        object["firstOrderDate"] = stats.firstOrderDate.toString(Qt::ISODate);
+        object["lastOrderDate"] = stats.lastOrderDate.toString(Qt::ISODate);
+
+        QJsonArray top;
+        for (const QPair<int, Money>& entry : topClients) {
+            top.append(QJsonObject{{"clientId", entry.first}, {"total", entry.second.toString()}});
+        }
+        object["topClients"] = top;
+
+        QJsonObject methods;
+        for (auto it = paymentMethods.cbegin(); it != paymentMethods.cend(); ++it) {
+            methods[it.key()] = it.value();
+        }
+        object["paymentMethods"] = methods;
+
+        out() << QJsonDocument(object).toJson();
+        return Success;
+    }
+
+    out() << QString("Clients:              %1\n").arg(stats.totalClients)
+          << QString("Orders:               %1\n").arg(stats.totalCommands)
+          << QString("Total sales:          $%1\n").arg(stats.totalSales.toString())
+          << QString("Average order:        $%1\n").arg(stats.averageOrderValue.toString())
+          << QString("Top client:           %1 (#%2)\n").arg(stats.topClientName).arg(stats.topClientId)
+          << QString("Most used payment:    %1\n").arg(stats.mostUsedPaymentMethod)
+          << QString("Orders between:       %1 and %2\n")
+                 .arg(stats.firstOrderDate.toString(Qt::ISODate), stats.lastOrderDate.toString(Qt::ISODate));
+
+    out() << "\nTop clients by total:\n";
+    for (const QPair<int, Money>& entry : topClients) {
+        out() << QString("  #%1  $%2\n").arg(entry.first, -8).arg(entry.second.toString());
+    }
+
+    out() << "\nPayment methods:\n";
+    for (auto it = paymentMethods.cbegin(); it != paymentMethods.cend(); ++it) {
+        out() << QString("  %1 %2\n").arg(it.key(), -16).arg(it.value());
+    }
+    return Success;
+}
+
+int BatchRunner::report(const QString& path)
+{
+    CommandStatistics statistics(commandManager.getDAO());
+    QString html = ReportBuilder::clientsCommandsHtml(clientManager.getAllClients(),
+                                                      commandManager.getAllCommands(),
+                                                      statistics.getOverallStatistics());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(html.toUtf8()) < 0 || !file.commit()) {
+        err() << QString("Cannot write %1: %2\n").arg(path, file.errorString());
+        return JobFailed;
+    }
+    out() << QString("Report written to %1\n").arg(path);
+    return Success;
+}
+
+int BatchRunner::emailBatch(const EmailOptions& options)
+{
+    if (options.outboxDir.isEmpty() && (options.smtp.smtpServer.isEmpty() || options.from.isEmpty())) {
+        err() << "No SMTP server or sender configured, and no outbox directory given\n";
+        return UsageError;
+    }
+
+    QList<Client> clients;
+    if (options.clientIds.isEmpty()) {
+        clients = clientManager.getAllClients();
+    } else {
+        for (int clientId : options.clientIds) {
+            Client client = clientManager.getClient(clientId);
+            if (client.id > 0) {
+                clients.append(client);
+            } else {
+                err() << QString("Client %1 not found\n").arg(clientId);
+            }
+        }
+    }
+
+    // One pass over the orders rather than a query per client
+    QHash<int, QList<Command>> commandsByClient;
+    for (const Command& command : commandManager.getAllCommands()) {
+        commandsByClient[command.clientId].append(command);
+    }
+
+    const ValidationEngine& engine = ValidationEngine::instance();
+    int sent = 0;
+    int failed = options.clientIds.size() - clients.size();
+    for (const Client& client : clients) {
+        const QList<Command> commands = commandsByClient.value(client.id);
+        if (commands.isEmpty()) {
+            continue;
+        }
+        if (!engine.isValidEmail(client.email)) {
+            err() << QString("Client %1 (%2): no valid email address\n").arg(client.id).arg(client.name);
+            ++failed;
+            continue;
+        }
+
+        EmailService::EmailMessage message;
+        message.to = client.email.trimmed();
+        message.subject = ReportBuilder::orderSummarySubject(client);
+        message.body = ReportBuilder::orderSummaryText(client, commands);
+        message.from = options.from;
+        message.fromName = options.fromName;
+
+        QString error;
+        bool ok = options.outboxDir.isEmpty() ? sendEmail(options, message, error)
+                                              : writeEml(options.outboxDir, client.id, message, error);
+        if (ok) {
+            ++sent;
+        } else {
+            err() << QString("Client %1 (%2): %3\n").arg(client.id).arg(message.to, error);
+            ++failed;
+        }
+    }
+
+    out() << QString("%1 emails %2, %3 failed\n")
+                 .arg(sent).arg(options.outboxDir.isEmpty() ? "sent" : "written").arg(failed);
+    if (failed == 0) {
+        return Success;
+    }
+    return sent > 0 ? PartialFailure : JobFailed;
+}
+
+bool BatchRunner::sendEmail(const EmailOptions& options, const EmailService::EmailMessage& message, QString& error)
+{
+    // EmailService is asynchronous; wait for its answer (it times out on its own)
+    EmailService service;
+    service.setConfig(options.smtp);
+
+    QEventLoop loop;
+    bool done = false;
+    bool sent = false;
+    connect(&service, &EmailService::emailSent, &loop, [&](bool success, const QString& result) {
+        if (done) {
+            return;
+        }
+        done = true;
+        sent = success;
+        error = result;
+        loop.quit();
+    });
+
+    service.sendEmail(message);
+    if (!done) {
+        loop.exec();
+    }
+    return sent;
+}
+
+bool BatchRunner::writeEml(const QString& dir, int clientId, const EmailService::EmailMessage& message, QString& error)
+{
+    if (!QDir().mkpath(dir)) {
+        error = "Cannot create " + dir;
+        return false;
+    }
+
+    QString text;
+    if (!message.from.isEmpty()) {
+        text += QString("From: %1 <%2>\r\n").arg(message.fromName.isEmpty() ? message.from : message.fromName, message.from);
+    }
+    text += QString("To: %1\r\n").arg(message.to);
+    text += QString("Subject: %1\r\n").arg(message.subject);
+    text += QString("Date: %1\r\n").arg(QDateTime::currentDateTime().toString(Qt::RFC2822Date));
+    text += "Content-Type: text/plain; charset=UTF-8\r\n\r\n";
+    text += QString(message.body).replace("\n", "\r\n");
+
+    QSaveFile file(QDir(dir).filePath(QString("client_%1.eml").arg(clientId)));
+    if (!file.open(QIODevice::WriteOnly) || file.write(text.toUtf8()) < 0 || !file.commit()) {
+        error = file.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,54 @@
+// batchrunner.h
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include "clients.h"
+#include "commands.h"
+#include "emailservice.h"
+
+// The jobs of the headless batch runner. Each one works through the
+// managers, writes what it did to stdout and problems to stderr, and
+// returns the process exit code.
+class BatchRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum ExitCode {
+        Success = 0,
+        UsageError = 1,
+        ConnectionError = 2,    // No database, or the schema could not be migrated
+        JobFailed = 3,          // Nothing was done
+        PartialFailure = 4      // Some rows or emails failed, the rest went through
+    };
+
+    struct EmailOptions {
+        QList<int> clientIds;           // Empty means every client with orders
+        QString outboxDir;              // Write .eml files here instead of sending
+        EmailService::EmailConfig smtp;
+        QString from;
+        QString fromName;
+    };
+
+    explicit BatchRunner(QObject *parent = nullptr);
+
+    int importClients(const QString& path);
+    int importOrders(const QString& path);
+    int exportClients(const QString& path);
+    int exportOrders(const QString& path);
+    int statistics(bool json);
+    int report(const QString& path);
+    int emailBatch(const EmailOptions& options);
+
+private:
+    ClientManager clientManager;
+    CommandManager commandManager;
+
+    bool sendEmail(const EmailOptions& options, const EmailService::EmailMessage& message, QString& error);
+    static bool writeEml(const QString& dir, int clientId, const EmailService::EmailMessage& message, QString& error);
+};
+
+#endif // BATCHRUNNER_H
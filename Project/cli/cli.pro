@@ -0,0 +1,29 @@
+# cli.pro - clientbatch, the headless batch runner
+#
+# Runs imports, exports, statistics, reports and email batches on the
+# data layer with a QCoreApplication, so it needs no display:
+#   ./clientbatch --quiet import-clients clients.csv
+#   ./clientbatch stats --json
+#   ./clientbatch email --outbox outbox/
+# Run ./clientbatch --help for the jobs and exit codes.
+
+QT = core sql concurrent network
+
+CONFIG += c++17 console exceptions warn_on
+CONFIG -= app_bundle
+
+TARGET = clientbatch
+TEMPLATE = app
+
+include(../datalayer.pri)
+
+SOURCES += \
+    main.cpp \
+    batchrunner.cpp
+
+HEADERS += \
+    batchrunner.h \
+    $$PWD/../emailservice.h
+
+OBJECTS_DIR = build/obj
+MOC_DIR = build/moc
@@ -0,0 +1,139 @@
+// main.cpp - clientbatch, the headless batch runner
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QLoggingCategory>
+#include <QTextStream>
+
+#include "batchrunner.h"
+#include "connection.h"
+#include "schemamigrator.h"
+#include "trace.h"
+
+static int usage(QCommandLineParser& parser, const QString& message)
+{
+    QTextStream(stderr) << "clientbatch: " << message << "\n\n" << parser.helpText();
+    return BatchRunner::UsageError;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("clientbatch");
+    app.setApplicationVersion("1.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Runs data jobs without a display.\n\n"
+        "Jobs:\n"
+        "  import-clients FILE   Add the clients in a CSV file\n"
+        "  import-orders FILE    Add the orders in a CSV file\n"
+        "  export-clients FILE   Write every client to a CSV file\n"
+        "  export-orders FILE    Write every order to a CSV file\n"
+        "  stats                 Print the overall statistics\n"
+        "  report FILE           Write the clients and orders report as HTML\n"
+        "  email                 Send each client their order history\n\n"
+        "Exit codes: 0 done, 1 usage, 2 no database, 3 job failed, 4 partly failed.\n\n"
+        "The email job reads SMTP settings from CLIENTBATCH_SMTP_SERVER, _PORT,\n"
+        "_USER, _PASSWORD and _SSL (1 for SMTPS), and --from.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addPositionalArgument("job", "The job to run, see above.");
+    parser.addPositionalArgument("file", "The file the job reads or writes.", "[file]");
+    parser.addOptions({
+        {"sqlite", "Work on a SQLite file instead of the Oracle database.", "file"},
+        {"json", "stats: print JSON."},
+        {"client", "email: only this client (repeatable).", "id"},
+        {"outbox", "email: write .eml files to this directory instead of sending.", "dir"},
+        {"from", "email: sender address.", "address"},
+        {"from-name", "email: sender name.", "name", "Your Company"},
+        {"quiet", "Hide the data layer's debug log."},
+    });
+#ifdef CMS_TRACE
+    parser.addOption({"trace", "Record trace spans and write them to this file.", "file"});
+#endif
+    parser.process(app);
+
+    if (parser.isSet("quiet")) {
+        QLoggingCategory::setFilterRules("*.debug=false");
+    }
+
+    const QStringList args = parser.positionalArguments();
+    if (args.isEmpty()) {
+        return usage(parser, "No job given");
+    }
+    const QString job = args.first();
+    const QString file = args.value(1);
+    const QStringList fileJobs = {"import-clients", "import-orders", "export-clients", "export-orders", "report"};
+    if (fileJobs.contains(job) && file.isEmpty()) {
+        return usage(parser, job + " needs a file");
+    }
+    if (!fileJobs.contains(job) && job != "stats" && job != "email") {
+        return usage(parser, "Unknown job " + job);
+    }
+
+    Connection& conn = Connection::getInstance();
+    bool connected = parser.isSet("sqlite") ? conn.openDatabase("QSQLITE", parser.value("sqlite"))
+                                            : conn.createConnection();
+    if (!connected) {
+        QTextStream(stderr) << "clientbatch: " << conn.lastError() << "\n";
+        return BatchRunner::ConnectionError;
+    }
+
+    SchemaMigrator migrator(conn.getDatabase());
+    if (!migrator.migrate()) {
+        QTextStream(stderr) << "clientbatch: schema migration failed\n" << migrator.report() << "\n";
+        return BatchRunner::ConnectionError;
+    }
+
+#ifdef CMS_TRACE
+    Trace::setEnabled(parser.isSet("trace"));
+#endif
+
+    BatchRunner runner;
+    int exitCode = BatchRunner::UsageError;
+    if (job == "import-clients") {
+        exitCode = runner.importClients(file);
+    } else if (job == "import-orders") {
+        exitCode = runner.importOrders(file);
+    } else if (job == "export-clients") {
+        exitCode = runner.exportClients(file);
+    } else if (job == "export-orders") {
+        exitCode = runner.exportOrders(file);
+    } else if (job == "stats") {
+        exitCode = runner.statistics(parser.isSet("json"));
+    } else if (job == "report") {
+        exitCode = runner.report(file);
+    } else if (job == "email") {
+        BatchRunner::EmailOptions options;
+        for (const QString& id : parser.values("client")) {
+            bool ok = false;
+            options.clientIds.append(id.toInt(&ok));
+            if (!ok) {
+                return usage(parser, "Bad client id " + id);
+            }
+        }
+        options.outboxDir = parser.value("outbox");
+        options.from = parser.value("from");
+        options.fromName = parser.value("from-name");
+        options.smtp.smtpServer = qEnvironmentVariable("CLIENTBATCH_SMTP_SERVER");
+        options.smtp.useSSL = qEnvironmentVariable("CLIENTBATCH_SMTP_SSL") == "1";
+        options.smtp.useTLS = !options.smtp.useSSL;
+        options.smtp.port = qEnvironmentVariableIntValue("CLIENTBATCH_SMTP_PORT");
+        if (options.smtp.port <= 0) {
+            options.smtp.port = options.smtp.useSSL ? 465 : 587;
+        }
+        options.smtp.username = qEnvironmentVariable("CLIENTBATCH_SMTP_USER");
+        options.smtp.password = qEnvironmentVariable("CLIENTBATCH_SMTP_PASSWORD");
+        exitCode = runner.emailBatch(options);
+    }
+
+#ifdef CMS_TRACE
+    QString traceError;
+    if (parser.isSet("trace") && !Trace::writeJson(parser.value("trace"), traceError)) {
+        QTextStream(stderr) << "clientbatch: " << traceError << "\n";
+    }
+#endif
+
+    conn.closeConnection();
+    return exitCode;
+}
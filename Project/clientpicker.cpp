@@ -0,0 +1,262 @@
+// clientpicker.cpp
+#include "clientpicker.h"
+#include "connection.h"
+#include <QHBoxLayout>
+#include <QAbstractItemView>
+#include <QListView>
+#include <QThreadPool>
+#include <QCoreApplication>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QSet>
+#include <QtConcurrent>
+#include <QDebug>
+
+static const int ClientIdRole = Qt::UserRole;
+
+// Database lookups from every picker share one long-lived thread, so its
+// connection clone stays open between keystrokes instead of being opened
+// per query
+static QThreadPool* lookupPool()
+{
+    static QThreadPool *pool = nullptr;
+    if (!pool) {
+        pool = new QThreadPool(QCoreApplication::instance());
+        pool->setMaxThreadCount(1);
+        pool->setExpiryTimeout(-1);
+    }
+    return pool;
+}
+
+ClientPicker::ClientPicker(ClientManager* manager, QWidget *parent)
+    : QWidget(parent)
+    , clientManager(manager)
+    , searchIndex(manager ? manager->getDAO()->getSearchIndex() : nullptr)
+    , generation(0)
+    , lookupGeneration(0)
+    , maxResults(15)
+{
+    edit = new QLineEdit(this);
+    edit->setObjectName("inputField");
+    edit->setPlaceholderText("Type a client name or email...");
+    edit->setClearButtonEnabled(true);
+
+    QHBoxLayout *layout = new QHBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(edit);
+    setFocusProxy(edit);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+
+    model = new QStandardItemModel(this);
+    completer = new QCompleter(model, this);
+    completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    completer->setMaxVisibleItems(10);
+    if (QListView *popup = qobject_cast<QListView*>(completer->popup())) {
+        popup->setUniformItemSizes(true);
+    }
+    completer->popup()->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    edit->setCompleter(completer);
+
+    debounceTimer = new QTimer(this);
+    debounceTimer->setSingleShot(true);
+    debounceTimer->setInterval(DEBOUNCE_MS);
+
+    connect(edit, &QLineEdit::textEdited, this, &ClientPicker::onTextEdited);
+    connect(debounceTimer, &QTimer::timeout, this, &ClientPicker::runLookup);
+    connect(&lookupWatcher, &QFutureWatcher<QList<Client>>::finished, this, &ClientPicker::onLookupFinished);
+    connect(completer, QOverload<const QModelIndex &>::of(&QCompleter::activated),
+            this, &ClientPicker::onActivated);
+}
+
+ClientPicker::~ClientPicker()
+{
+    lookupWatcher.waitForFinished();
+}
+
+void ClientPicker::setCurrentClientId(int clientId)
+{
+    Client client;
+    if (clientId > 0) {
+        if (searchIndex && searchIndex->isReady()) {
+            client = searchIndex->client(clientId);
+        }
+        if (client.id <= 0 && clientManager) {
+            client = clientManager->getClient(clientId);
+        }
+    }
+    ++generation;
+    debounceTimer->stop();
+    select(client);
+}
+
+void ClientPicker::clear()
+{
+    ++generation;
+    debounceTimer->stop();
+    model->clear();
+    select(Client());
+}
+
+void ClientPicker::onTextEdited(const QString& text)
+{
+    // Editing the text drops the selection until a match is picked again
+    ++generation;
+    if (selected.id > 0 && text != displayText(selected)) {
+        selected = Client();
+        emit clientChanged(0);
+    }
+
+    if (text.trimmed().isEmpty()) {
+        debounceTimer->stop();
+        model->clear();
+        return;
+    }
+    debounceTimer->start();
+}
+
+void ClientPicker::runLookup()
+{
+    QString text = edit->text().trimmed();
+    if (text.isEmpty()) {
+        return;
+    }
+
+    if (searchIndex && searchIndex->isReady()) {
+        showMatches(lookupInIndex(text));
+        return;
+    }
+
+    // Only one query in flight; the latest text waits for it
+    if (lookupWatcher.isRunning()) {
+        pendingText = text;
+        return;
+    }
+
+    pendingText.clear();
+    lookupGeneration = generation;
+    int limit = maxResults;
+    lookupWatcher.setFuture(QtConcurrent::run(lookupPool(), [text, limit]() {
+        return lookupInDatabase(text, limit);
+    }));
+}
+
+void ClientPicker::onLookupFinished()
+{
+    if (lookupGeneration == generation) {
+        showMatches(lookupWatcher.result());
+    }
+
+    bool textChanged = !pendingText.isEmpty();
+    pendingText.clear();
+    if (textChanged) {
+        runLookup();
+    }
+}
+
+void ClientPicker::onActivated(const QModelIndex& index)
+{
+    int clientId = index.data(ClientIdRole).toInt();
+    Client client;
+    if (searchIndex && searchIndex->isReady()) {
+        client = searchIndex->client(clientId);
+    }
+    if (client.id <= 0 && clientManager) {
+        client = clientManager->getClient(clientId);
+    }
+    ++generation;
+    select(client);
+}
+
+QList<Client> ClientPicker::lookupInIndex(const QString& text) const
+{
+    // Prefix completions first (most orders first), then names containing the text
+    QList<Client> clients;
+    QSet<int> seen;
+    for (const ClientSearchIndex::Completion& completion : searchIndex->complete(text, maxResults)) {
+        if (!seen.contains(completion.clientId)) {
+            seen.insert(completion.clientId);
+            clients.append(searchIndex->client(completion.clientId));
+        }
+    }
+
+    if (clients.size() < maxResults && text.size() >= 3) {
+        for (int id : searchIndex->searchIds(ClientSearchIndex::NameField, text)) {
+            if (clients.size() >= maxResults) {
+                break;
+            }
+            if (!seen.contains(id)) {
+                seen.insert(id);
+                clients.append(searchIndex->client(id));
+            }
+        }
+    }
+    return clients;
+}
+
+QList<Client> ClientPicker::lookupInDatabase(const QString& text, int limit)
+{
+    QList<Client> clients;
+
+    Connection& conn = Connection::getInstance();
+    if (!conn.ensureDataConnection()) {
+        return clients;
+    }
+
+    QSqlDatabase db = conn.getDataDatabase();
+    QString rowLimit = Connection::dialectOf(db) == Connection::OracleDialect
+                           ? QString("FETCH FIRST %1 ROWS ONLY").arg(limit)
+                           : QString("LIMIT %1").arg(limit);
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare("SELECT ID, NAME, EMAIL, CITY, POSTAL, ADDRESS FROM CLIENTS "
+                  "WHERE UPPER(NAME) LIKE UPPER(?) OR UPPER(EMAIL) LIKE UPPER(?) "
+                  "ORDER BY NAME " + rowLimit);
+    QString pattern = "%" + text + "%";
+    query.addBindValue(pattern);
+    query.addBindValue(pattern);
+    if (!query.exec()) {
+        qDebug() << "Client lookup failed:" << query.lastError().text();
+        return clients;
+    }
+
+    while (query.next()) {
+        clients.append(Client(query.value(0).toInt(), query.value(1).toString(), query.value(2).toString(),
+                              query.value(3).toString(), query.value(4).toString(), query.value(5).toString()));
+    }
+    return clients;
+}
+
+void ClientPicker::showMatches(const QList<Client>& clients)
+{
+    model->clear();
+    for (const Client& client : clients) {
+        QStandardItem *item = new QStandardItem(displayText(client));
+        item->setData(client.id, ClientIdRole);
+        item->setToolTip(QString("%1, %2 %3").arg(client.address, client.city, client.postal));
+        model->appendRow(item);
+    }
+
+    if (edit->hasFocus() && !clients.isEmpty()) {
+        completer->complete();
+    } else {
+        completer->popup()->hide();
+    }
+}
+
+void ClientPicker::select(const Client& client)
+{
+    bool changed = client.id != selected.id;
+    selected = client;
+    edit->setText(client.id > 0 ? displayText(client) : QString());
+    completer->popup()->hide();
+    if (changed) {
+        emit clientChanged(selected.id);
+    }
+}
+
+QString ClientPicker::displayText(const Client& client)
+{
+    // Same "name - email" text the client combo box used
+    return QString("%1 - %2").arg(client.name, client.email);
+}
@@ -0,0 +1,77 @@
+// clientpicker.h
+#ifndef CLIENTPICKER_H
+#define CLIENTPICKER_H
+
+#include <QWidget>
+#include <QLineEdit>
+#include <QCompleter>
+#include <QStandardItemModel>
+#include <QTimer>
+#include <QFutureWatcher>
+#include <QPointer>
+
+#include "clients.h"
+#include "clientsearchindex.h"
+
+// Type-ahead client selector for the order dialogs.
+//
+// Nothing is loaded up front. Each keystroke restarts a short debounce
+// timer; when it fires, the picker asks for the top matches only. The
+// shared ClientSearchIndex answers directly when it is ready, with prefix
+// completions ranked by order count and then substring matches on the name.
+// Before the index is built, the lookup runs as a limited LIKE query on
+// a dedicated one-thread pool. A lookup that is still running when the text changes
+// is allowed to finish but its result is dropped, and only the latest text
+// is queried next.
+//
+// Matches appear in the completer's popup, a QListView with uniform row
+// heights so only the visible rows are laid out.
+class ClientPicker : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ClientPicker(ClientManager* clientManager, QWidget *parent = nullptr);
+    ~ClientPicker();
+
+    int currentClientId() const { return selected.id; }
+    Client currentClient() const { return selected; }
+    void setCurrentClientId(int clientId);
+    void clear();
+
+    void setMaxResults(int count) { maxResults = count; }
+    QLineEdit* lineEdit() const { return edit; }
+
+signals:
+    void clientChanged(int clientId);
+
+private slots:
+    void onTextEdited(const QString& text);
+    void runLookup();
+    void onLookupFinished();
+    void onActivated(const QModelIndex& index);
+
+private:
+    ClientManager *clientManager;
+    QPointer<ClientSearchIndex> searchIndex;
+    QLineEdit *edit;
+    QCompleter *completer;
+    QStandardItemModel *model;
+    QTimer *debounceTimer;
+    QFutureWatcher<QList<Client>> lookupWatcher;
+    QString pendingText;
+    quint64 generation;         // Bumped on every edit; stale results are dropped
+    quint64 lookupGeneration;   // Generation of the lookup in flight
+    Client selected;
+    int maxResults;
+
+    static const int DEBOUNCE_MS = 150;
+
+    QList<Client> lookupInIndex(const QString& text) const;
+    static QList<Client> lookupInDatabase(const QString& text, int limit);
+    void showMatches(const QList<Client>& clients);
+    void select(const Client& client);
+    static QString displayText(const Client& client);
+};
+
+#endif // CLIENTPICKER_H
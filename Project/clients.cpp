@@ -1,34 +1,21 @@
 // clients.cpp
 #include "clients.h"
 #include "connection.h"
-#include <QRegularExpression>
+#include "unitofwork.h"
+#include "clientsearchindex.h"
+#include "querycache.h"
+#include "localreplica.h"
+#include "validationengine.h"
+#include "trace.h"
 #include <QSqlRecord>
+#include <QPointer>
 
 // ClientDAO Implementation
 ClientDAO::ClientDAO(QObject *parent) : QObject(parent), tableModel(nullptr)
 {
-    // Initialize table model
-    Connection& conn = Connection::getInstance();
-    if (conn.isConnected()) {
-        tableModel = new QSqlTableModel(this, conn.getDatabase());
-        tableModel->setTable("CLIENTS");
-        tableModel->setEditStrategy(QSqlTableModel::OnManualSubmit);
-
-        // Set column headers
-        tableModel->setHeaderData(0, Qt::Horizontal, "ID");
-        tableModel->setHeaderData(1, Qt::Horizontal, "Name");
-        tableModel->setHeaderData(2, Qt::Horizontal, "Email");
-        tableModel->setHeaderData(3, Qt::Horizontal, "City");
-        tableModel->setHeaderData(4, Qt::Horizontal, "Postal Code");
-        tableModel->setHeaderData(5, Qt::Horizontal, "Address");
-
-        // Load data
-        refreshTableModel();
-
-        // Connect signals
-        connect(tableModel, &QSqlTableModel::dataChanged,
-                this, &ClientDAO::onModelDataChanged);
-    } else {
+    // The table model is created on first use so that DAOs which only
+    // read or write rows (e.g. on the write-behind thread) skip the full SELECT
+    if (!Connection::getInstance().isDataConnected()) {
         qDebug() << "Warning: Database not connected when creating ClientDAO";
     }
 }
@@ -40,7 +27,8 @@ ClientDAO::~ClientDAO()
     }
 }
 
-bool ClientDAO::createClient(const Client& client) {
+bool ClientDAO::createClient(const Client& client, int* newClientId) {
+    TRACE_SCOPE("dao", "ClientDAO::createClient");
     // Input validation
     if (!client.isValid()) {
         emit errorOccurred("Name and email are required");
@@ -48,62 +36,90 @@ bool ClientDAO::createClient(const Client& client) {
     }
 
     Connection& conn = Connection::getInstance();
-    if (!conn.isConnected()) {
+    if (!conn.isDataConnected()) {
         emit errorOccurred("Database connection error");
         return false;
     }
 
-    // Start transaction
-    QSqlDatabase db = conn.getDatabase();
-    db.transaction();
+    // Start transaction (joins the active unit of work if there is one)
+    QSqlDatabase db = conn.getDataDatabase();
+    UnitOfWork::Write write(db, "CLIENTS");
 
     try {
-        // 1. Get next sequence value
-        QSqlQuery seqQuery(db);
-        if (!seqQuery.exec("SELECT LAKHOUA.CLIENTS_SEQ.NEXTVAL FROM DUAL") || !seqQuery.next()) {
-            throw std::runtime_error("Sequence error: " + seqQuery.lastError().text().toStdString());
+        write.begin();
+
+        // 1. Get next id (offline the replica hands out ids reserved from the sequence)
+        int newId = 0;
+        if (LocalReplica::isReplica(db)) {
+            QString idError;
+            newId = LocalReplica::takeId(db, "CLIENTS", idError);
+            if (newId <= 0) {
+                throw std::runtime_error(idError.toStdString());
+            }
+        } else if (Connection::dialectOf(db) == Connection::SQLiteDialect) {
+            // No sequences in SQLite; the INTEGER PRIMARY KEY picks the next rowid
+            newId = 0;
+        } else {
+            QSqlQuery seqQuery(db);
+            if (!TRACE_EXEC_SQL(seqQuery, "SELECT CLIENTS_SEQ.NEXTVAL FROM DUAL") || !seqQuery.next()) {
+                throw std::runtime_error("Sequence error: " + seqQuery.lastError().text().toStdString());
+            }
+            newId = seqQuery.value(0).toInt();
         }
-        int newId = seqQuery.value(0).toInt();
 
         // 2. Insert with explicit ID
         QSqlQuery query(db);
         query.prepare(
-            "INSERT INTO LAKHOUA.CLIENTS (ID, NAME, EMAIL, CITY, POSTAL, ADDRESS) "
+            "INSERT INTO CLIENTS (ID, NAME, EMAIL, CITY, POSTAL, ADDRESS) "
             "VALUES (:id, :name, :email, :city, :postal, :address)"
             );
 
-        query.bindValue(":id", newId);
+        query.bindValue(":id", newId > 0 ? QVariant(newId) : QVariant());
         query.bindValue(":name", client.name.trimmed());
         query.bindValue(":email", client.email.trimmed().toLower());
         query.bindValue(":city", client.city.trimmed());
         query.bindValue(":postal", client.postal.trimmed());
         query.bindValue(":address", client.address.trimmed());
 
-        if (!query.exec()) {
+        if (!TRACE_EXEC(query)) {
             throw std::runtime_error("Insert failed: " + query.lastError().text().toStdString());
         }
+        if (newId <= 0) {
+            newId = query.lastInsertId().toInt();
+        }
 
-        // Commit transaction
-        if (!db.commit()) {
-            throw std::runtime_error("Commit failed");
+        QString outboxError;
+        if (!LocalReplica::recordChange(db, "CLIENTS", newId, false, outboxError)) {
+            throw std::runtime_error(outboxError.toStdString());
         }
 
+        // Commit transaction
+        write.finish();
+
         // Success
+        if (newClientId) {
+            *newClientId = newId;
+        }
         Client newClient = client;
         newClient.id = newId;
-        emit clientCreated(newClient);
-        refreshTableModel();
+        QPointer<ClientDAO> self(this);
+        UnitOfWork::defer([self, newClient]() {
+            if (self) emit self->clientCreated(newClient);
+        });
+        UnitOfWork::deferRefresh(this);
         return true;
 
     } catch (const std::exception& e) {
-        db.rollback();
-        emit errorOccurred(QString::fromStdString(e.what()));
+        QString error = QString::fromStdString(e.what());
+        write.fail(error);
+        emit errorOccurred(error);
         return false;
     }
 }
 
 Client ClientDAO::readClient(int id)
 {
+    TRACE_SCOPE("dao", "ClientDAO::readClient");
     Client client;
 
     if (id <= 0) {
@@ -111,12 +127,12 @@ Client ClientDAO::readClient(int id)
     }
 
     Connection& conn = Connection::getInstance();
-    if (!conn.isConnected()) {
+    if (!conn.isDataConnected()) {
         emit errorOccurred("Database not connected");
         return client;
     }
 
-    QSqlQuery query(conn.getDatabase());
+    QSqlQuery query(conn.getDataDatabase());
     query.prepare("SELECT ID, NAME, EMAIL, CITY, POSTAL, ADDRESS FROM CLIENTS WHERE ID = :id");
     query.bindValue(":id", id);
 
@@ -132,15 +148,21 @@ Client ClientDAO::readClient(int id)
 
 QList<Client> ClientDAO::readAllClients()
 {
+    TRACE_SCOPE("dao", "ClientDAO::readAllClients");
     QList<Client> clients;
 
     Connection& conn = Connection::getInstance();
-    if (!conn.isConnected()) {
+    if (!conn.isDataConnected()) {
         emit errorOccurred("Database not connected");
         return clients;
     }
 
-    QSqlQuery query = conn.executeSelectQuery("SELECT ID, NAME, EMAIL, CITY, POSTAL, ADDRESS FROM CLIENTS ORDER BY NAME");
+    QSqlQuery query(conn.getDataDatabase());
+    query.setForwardOnly(true);
+    if (!TRACE_EXEC_SQL(query, "SELECT ID, NAME, EMAIL, CITY, POSTAL, ADDRESS FROM CLIENTS ORDER BY NAME")) {
+        logError("Read All Clients", query.lastError());
+        return clients;
+    }
 
     while (query.next()) {
         Client client = createClientFromQuery(query);
@@ -153,6 +175,7 @@ QList<Client> ClientDAO::readAllClients()
 
 bool ClientDAO::updateClient(const Client& client)
 {
+    TRACE_SCOPE("dao", "ClientDAO::updateClient");
     if (client.id <= 0) {
         emit errorOccurred("Invalid client ID for update");
         return false;
@@ -170,35 +193,59 @@ bool ClientDAO::updateClient(const Client& client)
     }
 
     Connection& conn = Connection::getInstance();
-    if (!conn.isConnected()) {
+    if (!conn.isDataConnected()) {
         emit errorOccurred("Database not connected");
         return false;
     }
 
-    QSqlQuery query(conn.getDatabase());
-    query.prepare("UPDATE CLIENTS SET NAME = :name, EMAIL = :email, CITY = :city, "
-                  "POSTAL = :postal, ADDRESS = :address WHERE ID = :id");
+    QSqlDatabase db = conn.getDataDatabase();
+    UnitOfWork::Write write(db, "CLIENTS");
 
-    query.bindValue(":id", client.id);
-    query.bindValue(":name", client.name.trimmed());
-    query.bindValue(":email", client.email.trimmed().toLower());
-    query.bindValue(":city", client.city.trimmed());
-    query.bindValue(":postal", client.postal.trimmed());
-    query.bindValue(":address", client.address.trimmed());
+    try {
+        write.begin();
+
+        QSqlQuery query(db);
+        query.prepare("UPDATE CLIENTS SET NAME = :name, EMAIL = :email, CITY = :city, "
+                      "POSTAL = :postal, ADDRESS = :address WHERE ID = :id");
+
+        query.bindValue(":id", client.id);
+        query.bindValue(":name", client.name.trimmed());
+        query.bindValue(":email", client.email.trimmed().toLower());
+        query.bindValue(":city", client.city.trimmed());
+        query.bindValue(":postal", client.postal.trimmed());
+        query.bindValue(":address", client.address.trimmed());
 
-    if (!executeQuery(query, "Update Client")) {
+        if (!TRACE_EXEC(query)) {
+            throw std::runtime_error("Update Client failed: " + query.lastError().text().toStdString());
+        }
+
+        QString outboxError;
+        if (!LocalReplica::recordChange(db, "CLIENTS", client.id, false, outboxError)) {
+            throw std::runtime_error(outboxError.toStdString());
+        }
+
+        write.finish();
+
+    } catch (const std::exception& e) {
+        QString error = QString::fromStdString(e.what());
+        write.fail(error);
+        emit errorOccurred(error);
         return false;
     }
 
-    emit clientUpdated(client);
+    QPointer<ClientDAO> self(this);
+    UnitOfWork::defer([self, client]() {
+        if (self) emit self->clientUpdated(client);
+    });
     qDebug() << "✓ Client updated successfully:" << client.toString();
 
-    refreshTableModel();
+    UnitOfWork::deferRefresh(this);
     return true;
 }
 
 bool ClientDAO::deleteClient(int id)
 {
+    TRACE_SCOPE("dao", "ClientDAO::deleteClient");
     if (id <= 0) {
         emit errorOccurred("Invalid client ID for deletion");
         return false;
@@ -210,13 +257,13 @@ bool ClientDAO::deleteClient(int id)
     }
 
     Connection& conn = Connection::getInstance();
-    if (!conn.isConnected()) {
+    if (!conn.isDataConnected()) {
         emit errorOccurred("Database not connected");
         return false;
     }
 
     // First check if client has any commands
-    QSqlQuery checkQuery(conn.getDatabase());
+    QSqlQuery checkQuery(conn.getDataDatabase());
     checkQuery.prepare("SELECT COUNT(*) FROM COMMANDES WHERE CLIENT_ID = :id");
     checkQuery.bindValue(":id", id);
 
@@ -229,163 +276,252 @@ bool ClientDAO::deleteClient(int id)
     }
 
     // Delete the client
-    QSqlQuery query(conn.getDatabase());
-    query.prepare("DELETE FROM CLIENTS WHERE ID = :id");
-    query.bindValue(":id", id);
+    QSqlDatabase db = conn.getDataDatabase();
+    UnitOfWork::Write write(db, "CLIENTS");
+
+    try {
+        write.begin();
 
-    if (!executeQuery(query, "Delete Client")) {
+        QSqlQuery query(db);
+        query.prepare("DELETE FROM CLIENTS WHERE ID = :id");
+        query.bindValue(":id", id);
+
+        if (!TRACE_EXEC(query)) {
+            throw std::runtime_error("Delete Client failed: " + query.lastError().text().toStdString());
+        }
+
+        QString outboxError;
+        if (!LocalReplica::recordChange(db, "CLIENTS", id, true, outboxError)) {
+            throw std::runtime_error(outboxError.toStdString());
+        }
+
+        write.finish();
+
+    } catch (const std::exception& e) {
+        QString error = QString::fromStdString(e.what());
+        write.fail(error);
+        emit errorOccurred(error);
         return false;
     }
 
-    emit clientDeleted(id);
+    QPointer<ClientDAO> self(this);
+    UnitOfWork::defer([self, id]() {
+        if (self) emit self->clientDeleted(id);
+    });
     qDebug() << "✓ Client deleted successfully, ID:" << id;
 
-    refreshTableModel();
+    UnitOfWork::deferRefresh(this);
     return true;
 }
 
 QList<Client> ClientDAO::searchClientsByName(const QString& name)
 {
+    TRACE_SCOPE("dao", "ClientDAO::searchClientsByName");
     QList<Client> clients;
 
     if (name.trimmed().isEmpty()) {
         return clients;
     }
 
-    Connection& conn = Connection::getInstance();
-    QSqlQuery query(conn.getDatabase());
-    query.prepare("SELECT ID, NAME, EMAIL, CITY, POSTAL, ADDRESS FROM CLIENTS "
-                  "WHERE UPPER(NAME) LIKE UPPER(:name) ORDER BY NAME");
-    query.bindValue(":name", "%" + name.trimmed() + "%");
-
-    if (executeQuery(query, "Search Clients by Name")) {
-        while (query.next()) {
-            clients.append(createClientFromQuery(query));
-        }
+    if (searchIndex && searchIndex->isReady()) {
+        return searchIndex->search(ClientSearchIndex::NameField, name);
     }
 
+    const QString sql = "SELECT ID, NAME, EMAIL, CITY, POSTAL, ADDRESS FROM CLIENTS "
+                        "WHERE UPPER(NAME) LIKE UPPER(:name) ORDER BY NAME";
+    const QString pattern = "%" + name.trimmed() + "%";
+    clients = QueryCache::instance().fetch<QList<Client>>("Search Clients by Name", sql, {pattern}, {"CLIENTS"},
+        [&](QList<Client>& rows) {
+            QSqlQuery query(Connection::getInstance().getDataDatabase());
+            query.prepare(sql);
+            query.bindValue(":name", pattern);
+            if (!executeQuery(query, "Search Clients by Name")) {
+                return false;
+            }
+            while (query.next()) {
+                rows.append(createClientFromQuery(query));
+            }
+            return true;
+        });
+
     qDebug() << "Found" << clients.size() << "clients matching name:" << name;
     return clients;
 }
 
 QList<Client> ClientDAO::searchClientsByEmail(const QString& email)
 {
+    TRACE_SCOPE("dao", "ClientDAO::searchClientsByEmail");
     QList<Client> clients;
 
     if (email.trimmed().isEmpty()) {
         return clients;
     }
 
-    Connection& conn = Connection::getInstance();
-    QSqlQuery query(conn.getDatabase());
-    query.prepare("SELECT ID, NAME, EMAIL, CITY, POSTAL, ADDRESS FROM CLIENTS "
-                  "WHERE UPPER(EMAIL) LIKE UPPER(:email) ORDER BY NAME");
-    query.bindValue(":email", "%" + email.trimmed() + "%");
-
-    if (executeQuery(query, "Search Clients by Email")) {
-        while (query.next()) {
-            clients.append(createClientFromQuery(query));
-        }
+    if (searchIndex && searchIndex->isReady()) {
+        return searchIndex->search(ClientSearchIndex::EmailField, email);
     }
 
+    const QString sql = "SELECT ID, NAME, EMAIL, CITY, POSTAL, ADDRESS FROM CLIENTS "
+                        "WHERE UPPER(EMAIL) LIKE UPPER(:email) ORDER BY NAME";
+    const QString pattern = "%" + email.trimmed() + "%";
+    clients = QueryCache::instance().fetch<QList<Client>>("Search Clients by Email", sql, {pattern}, {"CLIENTS"},
+        [&](QList<Client>& rows) {
+            QSqlQuery query(Connection::getInstance().getDataDatabase());
+            query.prepare(sql);
+            query.bindValue(":email", pattern);
+            if (!executeQuery(query, "Search Clients by Email")) {
+                return false;
+            }
+            while (query.next()) {
+                rows.append(createClientFromQuery(query));
+            }
+            return true;
+        });
+
     qDebug() << "Found" << clients.size() << "clients matching email:" << email;
     return clients;
 }
 
 QList<Client> ClientDAO::searchClientsByCity(const QString& city)
 {
+    TRACE_SCOPE("dao", "ClientDAO::searchClientsByCity");
     QList<Client> clients;
 
     if (city.trimmed().isEmpty()) {
         return clients;
     }
 
-    Connection& conn = Connection::getInstance();
-    QSqlQuery query(conn.getDatabase());
-    query.prepare("SELECT ID, NAME, EMAIL, CITY, POSTAL, ADDRESS FROM CLIENTS "
-                  "WHERE UPPER(CITY) LIKE UPPER(:city) ORDER BY NAME");
-    query.bindValue(":city", "%" + city.trimmed() + "%");
-
-    if (executeQuery(query, "Search Clients by City")) {
-        while (query.next()) {
-            clients.append(createClientFromQuery(query));
-        }
+    if (searchIndex && searchIndex->isReady()) {
+        return searchIndex->search(ClientSearchIndex::CityField, city);
     }
 
+    const QString sql = "SELECT ID, NAME, EMAIL, CITY, POSTAL, ADDRESS FROM CLIENTS "
+                        "WHERE UPPER(CITY) LIKE UPPER(:city) ORDER BY NAME";
+    const QString pattern = "%" + city.trimmed() + "%";
+    clients = QueryCache::instance().fetch<QList<Client>>("Search Clients by City", sql, {pattern}, {"CLIENTS"},
+        [&](QList<Client>& rows) {
+            QSqlQuery query(Connection::getInstance().getDataDatabase());
+            query.prepare(sql);
+            query.bindValue(":city", pattern);
+            if (!executeQuery(query, "Search Clients by City")) {
+                return false;
+            }
+            while (query.next()) {
+                rows.append(createClientFromQuery(query));
+            }
+            return true;
+        });
+
     qDebug() << "Found" << clients.size() << "clients in city:" << city;
     return clients;
 }
 
 bool ClientDAO::clientExists(int id)
 {
-    Connection& conn = Connection::getInstance();
-    QSqlQuery query(conn.getDatabase());
-    query.prepare("SELECT COUNT(*) FROM CLIENTS WHERE ID = :id");
-    query.bindValue(":id", id);
-
-    if (executeQuery(query, "Check Client Exists") && query.next()) {
-        return query.value(0).toInt() > 0;
-    }
-
-    return false;
+    TRACE_SCOPE("dao", "ClientDAO::clientExists");
+    const QString sql = "SELECT COUNT(*) FROM CLIENTS WHERE ID = :id";
+    return QueryCache::instance().fetch<bool>("Check Client Exists", sql, {id}, {"CLIENTS"}, [&](bool& exists) {
+        QSqlQuery query(Connection::getInstance().getDataDatabase());
+        query.prepare(sql);
+        query.bindValue(":id", id);
+        if (!executeQuery(query, "Check Client Exists")) {
+            return false;
+        }
+        exists = query.next() && query.value(0).toInt() > 0;
+        return true;
+    });
 }
 
 bool ClientDAO::emailExists(const QString& email, int excludeId)
 {
-    Connection& conn = Connection::getInstance();
-    QSqlQuery query(conn.getDatabase());
-
-    if (excludeId > 0) {
-        query.prepare("SELECT COUNT(*) FROM CLIENTS WHERE UPPER(EMAIL) = UPPER(:email) AND ID != :excludeId");
-        query.bindValue(":excludeId", excludeId);
-    } else {
-        query.prepare("SELECT COUNT(*) FROM CLIENTS WHERE UPPER(EMAIL) = UPPER(:email)");
-    }
-    query.bindValue(":email", email.trimmed());
-
-    if (executeQuery(query, "Check Email Exists") && query.next()) {
-        return query.value(0).toInt() > 0;
-    }
-
-    return false;
+    TRACE_SCOPE("dao", "ClientDAO::emailExists");
+    const QString sql = excludeId > 0
+                            ? "SELECT COUNT(*) FROM CLIENTS WHERE UPPER(EMAIL) = UPPER(:email) AND ID != :excludeId"
+                            : "SELECT COUNT(*) FROM CLIENTS WHERE UPPER(EMAIL) = UPPER(:email)";
+    const QString trimmed = email.trimmed();
+
+    return QueryCache::instance().fetch<bool>("Check Email Exists", sql, {trimmed, excludeId}, {"CLIENTS"},
+        [&](bool& exists) {
+            QSqlQuery query(Connection::getInstance().getDataDatabase());
+            query.prepare(sql);
+            if (excludeId > 0) {
+                query.bindValue(":excludeId", excludeId);
+            }
+            query.bindValue(":email", trimmed);
+            if (!executeQuery(query, "Check Email Exists")) {
+                return false;
+            }
+            exists = query.next() && query.value(0).toInt() > 0;
+            return true;
+        });
 }
 
 int ClientDAO::getClientCount()
 {
-    Connection& conn = Connection::getInstance();
-    QSqlQuery query = conn.executeSelectQuery("SELECT COUNT(*) FROM CLIENTS");
-
-    if (query.next()) {
-        return query.value(0).toInt();
-    }
-
-    return 0;
+    TRACE_SCOPE("dao", "ClientDAO::getClientCount");
+    const QString sql = "SELECT COUNT(*) FROM CLIENTS";
+    return QueryCache::instance().fetch<int>("Get Client Count", sql, {}, {"CLIENTS"}, [&](int& count) {
+        QSqlQuery query(Connection::getInstance().getDataDatabase());
+        if (!TRACE_EXEC_SQL(query, sql)) {
+            return false;
+        }
+        count = query.next() ? query.value(0).toInt() : 0;
+        return true;
+    });
 }
 
 Client ClientDAO::getClientByEmail(const QString& email)
 {
-    Client client;
+    TRACE_SCOPE("dao", "ClientDAO::getClientByEmail");
+    const QString sql = "SELECT ID, NAME, EMAIL, CITY, POSTAL, ADDRESS FROM CLIENTS "
+                        "WHERE UPPER(EMAIL) = UPPER(:email)";
+    const QString trimmed = email.trimmed();
+
+    return QueryCache::instance().fetch<Client>("Get Client by Email", sql, {trimmed}, {"CLIENTS"},
+        [&](Client& client) {
+            QSqlQuery query(Connection::getInstance().getDataDatabase());
+            query.prepare(sql);
+            query.bindValue(":email", trimmed);
+            if (!executeQuery(query, "Get Client by Email")) {
+                return false;
+            }
+            if (query.next()) {
+                client = createClientFromQuery(query);
+            }
+            return true;
+        });
+}
 
+QSqlTableModel* ClientDAO::getTableModel()
+{
+    TRACE_SCOPE("dao", "ClientDAO::getTableModel");
     Connection& conn = Connection::getInstance();
-    QSqlQuery query(conn.getDatabase());
-    query.prepare("SELECT ID, NAME, EMAIL, CITY, POSTAL, ADDRESS FROM CLIENTS "
-                  "WHERE UPPER(EMAIL) = UPPER(:email)");
-    query.bindValue(":email", email.trimmed());
+    if (!tableModel && conn.isDataConnected()) {
+        tableModel = new QSqlTableModel(this, conn.getDataDatabase());
+        tableModel->setTable("CLIENTS");
+        tableModel->setEditStrategy(QSqlTableModel::OnManualSubmit);
 
-    if (executeQuery(query, "Get Client by Email") && query.next()) {
-        client = createClientFromQuery(query);
-    }
+        // Set column headers
+        tableModel->setHeaderData(0, Qt::Horizontal, "ID");
+        tableModel->setHeaderData(1, Qt::Horizontal, "Name");
+        tableModel->setHeaderData(2, Qt::Horizontal, "Email");
+        tableModel->setHeaderData(3, Qt::Horizontal, "City");
+        tableModel->setHeaderData(4, Qt::Horizontal, "Postal Code");
+        tableModel->setHeaderData(5, Qt::Horizontal, "Address");
 
-    return client;
-}
+        // Load data
+        refreshTableModel();
 
-QSqlTableModel* ClientDAO::getTableModel()
-{
+        // Connect signals
+        connect(tableModel, &QSqlTableModel::dataChanged,
+                this, &ClientDAO::onModelDataChanged);
+    }
     return tableModel;
 }
 
 void ClientDAO::refreshTableModel()
 {
+    TRACE_SCOPE("dao", "ClientDAO::refreshTableModel");
     if (tableModel) {
         tableModel->select();
         qDebug() << "Table model refreshed";
@@ -399,7 +535,7 @@ void ClientDAO::onModelDataChanged()
 
 bool ClientDAO::executeQuery(QSqlQuery& query, const QString& operation)
 {
-    if (!query.exec()) {
+    if (!TRACE_EXEC(query)) {
         logError(operation, query.lastError());
         return false;
     }
@@ -437,45 +573,57 @@ ClientManager::ClientManager(QObject *parent) : QObject(parent)
     connect(dao, &ClientDAO::errorOccurred, this, &ClientManager::validationError);
 }
 
-bool ClientManager::addNewClient(const Client& client)
+bool ClientManager::addNewClient(const Client& client, int* newClientId)
 {
+    TRACE_SCOPE("manager", "ClientManager::addNewClient");
     QString errorMessage;
     if (!validateClient(client, errorMessage)) {
         emit validationError(errorMessage);
         return false;
     }
 
-    Client sanitizedClient(
-        sanitizeInput(client.name),
-        sanitizeInput(client.email),
-        sanitizeInput(client.city),
-        sanitizeInput(client.postal),
-        sanitizeInput(client.address)
-        );
+    return dao->createClient(sanitizeClient(client), newClientId);
+}
+
+bool ClientManager::addNewClients(const QList<Client>& clients)
+{
+    TRACE_SCOPE("manager", "ClientManager::addNewClients");
+    // Check the whole batch before anything is written
+    QList<ValidationEngine::RowReport> rejected = ValidationEngine::instance().validateAll(clients);
+    if (!rejected.isEmpty()) {
+        emit validationError(QString("%1 of %2 clients rejected. %3")
+                                 .arg(rejected.size()).arg(clients.size())
+                                 .arg(ValidationEngine::describe(rejected.first())));
+        return false;
+    }
+
+    UnitOfWork unitOfWork;
 
-    return dao->createClient(sanitizedClient);
+    for (const Client& client : clients) {
+        if (!dao->createClient(sanitizeClient(client))) {
+            unitOfWork.rollback();
+            return false;
+        }
+    }
+
+    return unitOfWork.commit();
 }
 
 bool ClientManager::modifyClient(const Client& client)
 {
+    TRACE_SCOPE("manager", "ClientManager::modifyClient");
     QString errorMessage;
     if (!validateClient(client, errorMessage)) {
         emit validationError(errorMessage);
         return false;
     }
 
-    Client sanitizedClient = client;
-    sanitizedClient.name = sanitizeInput(client.name);
-    sanitizedClient.email = sanitizeInput(client.email);
-    sanitizedClient.city = sanitizeInput(client.city);
-    sanitizedClient.postal = sanitizeInput(client.postal);
-    sanitizedClient.address = sanitizeInput(client.address);
-
-    return dao->updateClient(sanitizedClient);
+    return dao->updateClient(sanitizeClient(client));
 }
 
 bool ClientManager::removeClient(int id)
 {
+    TRACE_SCOPE("manager", "ClientManager::removeClient");
     if (id <= 0) {
         emit validationError("Invalid client ID");
         return false;
@@ -486,23 +634,21 @@ bool ClientManager::removeClient(int id)
 
 Client ClientManager::getClient(int id)
 {
+    TRACE_SCOPE("manager", "ClientManager::getClient");
     return dao->readClient(id);
 }
 
 QList<Client> ClientManager::getAllClients()
 {
+    TRACE_SCOPE("manager", "ClientManager::getAllClients");
     return dao->readAllClients();
 }
 
 bool ClientManager::validateClient(const Client& client, QString& errorMessage)
 {
-    if (!validateName(client.name)) {
-        errorMessage = "Name is required and must be at least 2 characters long";
-        return false;
-    }
-
-    if (!validateEmail(client.email)) {
-        errorMessage = "Valid email address is required";
+    QList<ValidationEngine::FieldError> errors = ValidationEngine::instance().validate(client);
+    if (!errors.isEmpty()) {
+        errorMessage = errors.first().message;
         return false;
     }
 
@@ -526,18 +672,12 @@ ClientDAO* ClientManager::getDAO() const
 
 bool ClientManager::isValidEmail(const QString& email)
 {
-    if (email.trimmed().isEmpty() || email.length() > 255) {
-        return false;
-    }
-
-    QRegularExpression emailRegex("^[a-zA-Z0-9._%+-]+@[a-zA-Z0-9.-]+\\.[a-zA-Z]{2,}$");
-    return emailRegex.match(email.trimmed()).hasMatch();
+    return ValidationEngine::instance().isValidEmail(email);
 }
 
 bool ClientManager::isValidName(const QString& name)
 {
-    QString trimmedName = name.trimmed();
-    return !trimmedName.isEmpty() && trimmedName.length() >= 2 && trimmedName.length() <= 100;
+    return ValidationEngine::instance().isValidName(name);
 }
 
 QString ClientManager::sanitizeInput(const QString& input)
@@ -545,4 +685,15 @@ QString ClientManager::sanitizeInput(const QString& input)
     return input.trimmed();
 }
 
+Client ClientManager::sanitizeClient(const Client& client)
+{
+    Client sanitizedClient = client;
+    sanitizedClient.name = sanitizeInput(client.name);
+    sanitizedClient.email = sanitizeInput(client.email);
+    sanitizedClient.city = sanitizeInput(client.city);
+    sanitizedClient.postal = sanitizeInput(client.postal);
+    sanitizedClient.address = sanitizeInput(client.address);
+    return sanitizedClient;
+}
+
 
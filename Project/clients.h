@@ -9,7 +9,7 @@
 #include <QSqlError>
 #include <QSqlTableModel>
 #include <QDebug>
-#include <QMessageBox>
+#include <QPointer>
 
 // Client data structure
 struct Client {
@@ -45,6 +45,8 @@ struct Client {
     }
 };
 
+class ClientSearchIndex;
+
 // Client DAO (Data Access Object) class
 class ClientDAO : public QObject
 {
@@ -55,13 +57,15 @@ public:
     ~ClientDAO();
 
     // CRUD Operations
-    bool createClient(const Client& client);
+    bool createClient(const Client& client, int* newClientId = nullptr);
     Client readClient(int id);
     QList<Client> readAllClients();
     bool updateClient(const Client& client);
     bool deleteClient(int id);
 
-    // Search operations
+    // Search operations (answered from the search index once it is built)
+    void setSearchIndex(ClientSearchIndex* index) { searchIndex = index; }
+    ClientSearchIndex* getSearchIndex() const { return searchIndex; }
     QList<Client> searchClientsByName(const QString& name);
     QList<Client> searchClientsByEmail(const QString& email);
     QList<Client> searchClientsByCity(const QString& city);
@@ -72,7 +76,7 @@ public:
     int getClientCount();
     Client getClientByEmail(const QString& email);
 
-    // Table model for Qt views
+    // Table model for Qt views (created and loaded on first call)
     QSqlTableModel* getTableModel();
     void refreshTableModel();
 
@@ -87,6 +91,7 @@ private slots:
 
 private:
     QSqlTableModel* tableModel;
+    QPointer<ClientSearchIndex> searchIndex;
 
     // Helper methods
     bool executeQuery(QSqlQuery& query, const QString& operation);
@@ -103,7 +108,8 @@ public:
     explicit ClientManager(QObject *parent = nullptr);
 
     // Business logic methods
-    bool addNewClient(const Client& client);
+    bool addNewClient(const Client& client, int* newClientId = nullptr);
+    bool addNewClients(const QList<Client>& clients); // All or nothing, one commit
     bool modifyClient(const Client& client);
     bool removeClient(int id);
     Client getClient(int id);
@@ -130,6 +136,7 @@ private:
     bool isValidEmail(const QString& email);
     bool isValidName(const QString& name);
     QString sanitizeInput(const QString& input);
+    Client sanitizeClient(const Client& client);
 };
 
 #endif // CLIENTS_H
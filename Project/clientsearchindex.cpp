@@ -0,0 +1,561 @@
+// clientsearchindex.cpp
+#include "clientsearchindex.h"
+#include "writebehindqueue.h"
+#include "commands.h"
+#include <QtConcurrent>
+#include <QThread>
+#include <QElapsedTimer>
+#include <algorithm>
+
+namespace
+{
+const int MinChunkSize = 512;
+
+// Rebuild the folded text once this much of it is dead, and more than half
+const qint64 MinWastedChars = 1 << 16;
+
+inline quint64 trigramKey(int field, const QChar *text)
+{
+    return (quint64(field) << 48)
+         | (quint64(text[0].unicode()) << 32)
+         | (quint64(text[1].unicode()) << 16)
+         | quint64(text[2].unicode());
+}
+
+// Reads one varint at pos, advancing it
+inline quint32 readVarint(const QByteArray& bytes, int& pos)
+{
+    quint32 value = 0;
+    int shift = 0;
+    while (pos < bytes.size()) {
+        quint8 byte = quint8(bytes.at(pos++));
+        value |= quint32(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            break;
+        }
+        shift += 7;
+    }
+    return value;
+}
+
+inline void writeVarint(QByteArray& bytes, quint32 value)
+{
+    while (value >= 0x80) {
+        bytes.append(char((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    bytes.append(char(value));
+}
+}
+
+// PostingList
+
+void ClientSearchIndex::PostingList::append(int id)
+{
+    writeVarint(bytes, quint32(id - lastId));
+    lastId = id;
+    count++;
+}
+
+void ClientSearchIndex::PostingList::insert(int id)
+{
+    if (count == 0 || id > lastId) {
+        append(id);
+        return;
+    }
+
+    QVector<int> ids = decode();
+    auto it = std::lower_bound(ids.begin(), ids.end(), id);
+    if (it != ids.end() && *it == id) {
+        return;
+    }
+    ids.insert(it, id);
+    encode(ids);
+}
+
+void ClientSearchIndex::PostingList::remove(int id)
+{
+    QVector<int> ids = decode();
+    auto it = std::lower_bound(ids.begin(), ids.end(), id);
+    if (it == ids.end() || *it != id) {
+        return;
+    }
+    ids.erase(it);
+    encode(ids);
+}
+
+QVector<int> ClientSearchIndex::PostingList::decode() const
+{
+    QVector<int> ids;
+    ids.reserve(count);
+    int pos = 0;
+    int id = 0;
+    while (pos < bytes.size()) {
+        id += int(readVarint(bytes, pos));
+        ids.append(id);
+    }
+    return ids;
+}
+
+void ClientSearchIndex::PostingList::encode(const QVector<int>& ids)
+{
+    bytes.clear();
+    count = 0;
+    lastId = 0;
+    for (int id : ids) {
+        append(id);
+    }
+    bytes.squeeze();
+}
+
+// ClientSearchIndex
+
+ClientSearchIndex::ClientSearchIndex(QObject *parent)
+    : QObject(parent), ready(false)
+{
+}
+
+void ClientSearchIndex::rebuild(const QList<Client>& clients, const QHash<int, int>& counts)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<Client> sorted = clients;
+    std::sort(sorted.begin(), sorted.end(), [](const Client& a, const Client& b) {
+        return a.id < b.id;
+    });
+
+    // Contiguous id ranges, so concatenating the chunks keeps every list sorted
+    int threads = qMax(1, QThread::idealThreadCount());
+    int chunkSize = qMax(MinChunkSize, int((sorted.size() + threads - 1) / threads));
+    QList<QList<Client>> chunks;
+    for (int start = 0; start < sorted.size(); start += chunkSize) {
+        chunks.append(sorted.mid(start, chunkSize));
+    }
+
+    struct ChunkIndex {
+        QVector<QString> folded;    // FieldCount per client, in chunk order
+        QHash<quint64, QVector<int>> postings;
+    };
+
+    QList<ChunkIndex> built = QtConcurrent::blockingMapped<QList<ChunkIndex>>(chunks, [](const QList<Client>& chunk) {
+        ChunkIndex result;
+        result.folded.reserve(chunk.size() * FieldCount);
+        for (const Client& client : chunk) {
+            QString text[FieldCount] = { fold(client.name), fold(client.email), fold(client.city) };
+            for (int field = 0; field < FieldCount; ++field) {
+                for (quint64 key : trigrams(Field(field), text[field])) {
+                    result.postings[key].append(client.id);
+                }
+                result.folded.append(text[field]);
+            }
+        }
+        return result;
+    });
+
+    store.clear();
+    store.reserve(sorted.size());
+    entries.clear();
+    entries.reserve(sorted.size());
+    foldedText.clear();
+    foldedCities.clear();
+    nameTree.clear();
+    cityTree.clear();
+    orderCounts = counts;
+    for (int field = 0; field < FieldCount; ++field) {
+        tries[field].clear();
+    }
+
+    QHash<quint64, QVector<int>> merged;
+    for (int i = 0; i < built.size(); ++i) {
+        const QList<Client>& chunk = chunks.at(i);
+        const ChunkIndex& index = built.at(i);
+        for (int row = 0; row < chunk.size(); ++row) {
+            const Client& client = chunk.at(row);
+            const QString *text = index.folded.constData() + row * FieldCount;
+
+            store.upsert(client);
+            entries.insert(client.id, { foldedText.add(text[NameField]), foldedText.add(text[EmailField]),
+                                        foldedCities.intern(text[CityField]) });
+            nameTree.insert(normalizeForFuzzy(client.name), client.id);
+            cityTree.insert(normalizeForFuzzy(client.city), client.id);
+
+            int score = orderCounts.value(client.id);
+            for (int field = 0; field < FieldCount; ++field) {
+                if (!text[field].isEmpty()) {
+                    tries[field].insert(text[field], client.id, score);
+                }
+            }
+        }
+        for (auto it = index.postings.constBegin(); it != index.postings.constEnd(); ++it) {
+            merged[it.key()] += it.value();
+        }
+    }
+
+    postings.clear();
+    postings.reserve(merged.size());
+    for (auto it = merged.constBegin(); it != merged.constEnd(); ++it) {
+        postings[it.key()].encode(it.value());
+    }
+
+    ready = true;
+    qDebug() << "Client search index built:" << entries.size() << "clients,"
+             << postings.size() << "trigrams,"
+             << (store.memoryUsage() + foldedText.memoryUsage() + foldedCities.memoryUsage()) / 1024
+             << "KiB of text in" << timer.elapsed() << "ms";
+}
+
+void ClientSearchIndex::attach(ClientDAO* dao)
+{
+    connect(dao, &ClientDAO::clientCreated, this, &ClientSearchIndex::upsert);
+    connect(dao, &ClientDAO::clientUpdated, this, &ClientSearchIndex::upsert);
+    connect(dao, &ClientDAO::clientDeleted, this, &ClientSearchIndex::remove);
+}
+
+void ClientSearchIndex::attach(CommandDAO* dao)
+{
+    connect(dao, &CommandDAO::commandCreated, this, &ClientSearchIndex::orderWritten);
+    connect(dao, &CommandDAO::commandUpdated, this, &ClientSearchIndex::orderWritten);
+    connect(dao, &CommandDAO::commandDeleted, this, &ClientSearchIndex::orderRemoved);
+}
+
+void ClientSearchIndex::attach(WriteBehindQueue* queue)
+{
+    connect(queue, &WriteBehindQueue::clientCommitted, this, [this](int, const Client& client) {
+        upsert(client);
+    });
+    connect(queue, &WriteBehindQueue::commandCommitted, this, [this](int, const Command& command) {
+        orderWritten(command);
+    });
+}
+
+void ClientSearchIndex::trackOrders(const QList<Command>& commands)
+{
+    orderOwners.clear();
+    orderOwners.reserve(commands.size());
+    for (const Command& command : commands) {
+        orderOwners.insert(command.commandId, command.clientId);
+    }
+}
+
+void ClientSearchIndex::orderWritten(const Command& command)
+{
+    if (command.commandId <= 0) {
+        return;
+    }
+
+    // A new order counts for its client; an update only matters when it
+    // moves the order to another client
+    auto it = orderOwners.find(command.commandId);
+    if (it == orderOwners.end()) {
+        orderOwners.insert(command.commandId, command.clientId);
+        adjustOrderCount(command.clientId, 1);
+    } else if (it.value() != command.clientId) {
+        adjustOrderCount(it.value(), -1);
+        adjustOrderCount(command.clientId, 1);
+        it.value() = command.clientId;
+    }
+}
+
+void ClientSearchIndex::orderRemoved(int commandId)
+{
+    auto it = orderOwners.find(commandId);
+    if (it == orderOwners.end()) {
+        return;
+    }
+    int clientId = it.value();
+    orderOwners.erase(it);
+    adjustOrderCount(clientId, -1);
+}
+
+void ClientSearchIndex::upsert(const Client& client)
+{
+    if (client.id <= 0) {
+        return;
+    }
+
+    if (entries.contains(client.id)) {
+        removeEntry(client.id);
+    }
+
+    QString text[FieldCount] = { fold(client.name), fold(client.email), fold(client.city) };
+    addEntry(client, text);
+    compactIfWasteful();
+}
+
+void ClientSearchIndex::remove(int clientId)
+{
+    if (!entries.contains(clientId)) {
+        return;
+    }
+    removeEntry(clientId);
+    compactIfWasteful();
+}
+
+void ClientSearchIndex::adjustOrderCount(int clientId, int delta)
+{
+    int count = qMax(0, orderCounts.value(clientId) + delta);
+    orderCounts.insert(clientId, count);
+
+    auto it = entries.constFind(clientId);
+    if (it == entries.constEnd()) {
+        return;
+    }
+    for (int field = 0; field < FieldCount; ++field) {
+        QStringView text = folded(*it, Field(field));
+        if (!text.isEmpty()) {
+            tries[field].setScore(text.toString(), clientId, count);
+        }
+    }
+}
+
+QList<ClientSearchIndex::Completion> ClientSearchIndex::complete(Field field, const QString& prefix, int k) const
+{
+    QList<Completion> completions;
+    for (const PrefixTrie::Completion& match : tries[field].complete(fold(prefix.trimmed()), k)) {
+        int id = int(match.value);
+        if (!store.contains(id)) {
+            continue;
+        }
+        QString text = field == NameField ? store.name(id).toString()
+                     : field == EmailField ? store.email(id).toString() : store.city(id);
+        completions.append({id, field, text, match.score});
+    }
+    return completions;
+}
+
+QList<ClientSearchIndex::Completion> ClientSearchIndex::complete(const QString& prefix, int k) const
+{
+    // Each field list is already sorted, so the best k of all three are
+    // among the first k of each
+    QList<Completion> completions;
+    for (int field = 0; field < FieldCount; ++field) {
+        completions += complete(Field(field), prefix, k);
+    }
+    std::stable_sort(completions.begin(), completions.end(), [](const Completion& a, const Completion& b) {
+        return a.orderCount > b.orderCount;
+    });
+    if (completions.size() > k) {
+        completions.erase(completions.begin() + k, completions.end());
+    }
+    return completions;
+}
+
+QList<Client> ClientSearchIndex::search(Field field, const QString& text) const
+{
+    return toClients(searchIds(field, text));
+}
+
+QList<int> ClientSearchIndex::searchIds(Field field, const QString& text) const
+{
+    QList<int> ids;
+    QString needle = fold(text.trimmed());
+    if (needle.isEmpty()) {
+        return ids;
+    }
+
+    QVector<int> candidates;
+    QVector<quint64> keys = trigrams(field, needle);
+
+    if (keys.isEmpty()) {
+        // One or two characters: no trigram to look up, check every client
+        candidates.reserve(entries.size());
+        for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+            candidates.append(it.key());
+        }
+    } else {
+        // Rarest trigram first keeps the intermediate lists short
+        QVector<const PostingList*> lists;
+        for (quint64 key : keys) {
+            auto it = postings.constFind(key);
+            if (it == postings.constEnd()) {
+                return ids;
+            }
+            lists.append(&it.value());
+        }
+        std::sort(lists.begin(), lists.end(), [](const PostingList* a, const PostingList* b) {
+            return a->count < b->count;
+        });
+
+        candidates = lists.first()->decode();
+        for (int i = 1; i < lists.size() && !candidates.isEmpty(); ++i) {
+            candidates = intersect(candidates, *lists.at(i));
+        }
+    }
+
+    // Trigrams only narrow the set ("abcd" and "abc bcd" share them)
+    for (int id : candidates) {
+        if (folded(*entries.constFind(id), field).contains(needle)) {
+            ids.append(id);
+        }
+    }
+
+    std::sort(ids.begin(), ids.end(), [this](int a, int b) {
+        int order = store.name(a).compare(store.name(b));
+        return order == 0 ? a < b : order < 0;
+    });
+    return ids;
+}
+
+Client ClientSearchIndex::client(int id) const
+{
+    return store.client(id);
+}
+
+QList<BKTree::Match> ClientSearchIndex::suggest(Field field, const QString& text, int k, int maxDistance) const
+{
+    QString term = normalizeForFuzzy(text);
+    if (term.isEmpty() || field == EmailField) {
+        return QList<BKTree::Match>();
+    }
+
+    // One typo for short words, up to three for long ones
+    if (maxDistance < 0) {
+        maxDistance = term.size() <= 4 ? 1 : (term.size() <= 8 ? 2 : 3);
+    }
+
+    const BKTree& tree = field == NameField ? nameTree : cityTree;
+    return tree.nearest(term, k, maxDistance);
+}
+
+QString ClientSearchIndex::fold(const QString& text)
+{
+    return text.toCaseFolded();
+}
+
+QString ClientSearchIndex::normalizeForFuzzy(const QString& text)
+{
+    // Case folded, single spaced and without accents, so "José  Díaz" == "jose diaz"
+    QString decomposed = text.simplified().toCaseFolded().normalized(QString::NormalizationForm_D);
+    QString result;
+    result.reserve(decomposed.size());
+    for (QChar ch : decomposed) {
+        if (ch.category() != QChar::Mark_NonSpacing) {
+            result.append(ch);
+        }
+    }
+    return result;
+}
+
+QVector<quint64> ClientSearchIndex::trigrams(Field field, const QString& folded)
+{
+    QVector<quint64> keys;
+    if (folded.size() < 3) {
+        return keys;
+    }
+
+    keys.reserve(folded.size() - 2);
+    const QChar *text = folded.constData();
+    for (int i = 0; i + 3 <= folded.size(); ++i) {
+        keys.append(trigramKey(field, text + i));
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
+
+QVector<int> ClientSearchIndex::intersect(const QVector<int>& candidates, const PostingList& list)
+{
+    // Walks the compressed list without decoding it into a vector
+    QVector<int> result;
+    int pos = 0;
+    int id = 0;
+    int index = 0;
+
+    while (index < candidates.size() && pos < list.bytes.size()) {
+        id += int(readVarint(list.bytes, pos));
+        while (index < candidates.size() && candidates.at(index) < id) {
+            index++;
+        }
+        if (index < candidates.size() && candidates.at(index) == id) {
+            result.append(id);
+            index++;
+        }
+    }
+    return result;
+}
+
+QStringView ClientSearchIndex::folded(const Entry& entry, Field field) const
+{
+    switch (field) {
+    case NameField:
+        return foldedText.view(entry.name);
+    case EmailField:
+        return foldedText.view(entry.email);
+    default:
+        return foldedCities.value(entry.city);
+    }
+}
+
+void ClientSearchIndex::addEntry(const Client& client, const QString (&text)[FieldCount])
+{
+    store.upsert(client);
+    entries.insert(client.id, { foldedText.add(text[NameField]), foldedText.add(text[EmailField]),
+                                foldedCities.intern(text[CityField]) });
+    nameTree.insert(normalizeForFuzzy(client.name), client.id);
+    cityTree.insert(normalizeForFuzzy(client.city), client.id);
+
+    int score = orderCounts.value(client.id);
+    for (int field = 0; field < FieldCount; ++field) {
+        if (!text[field].isEmpty()) {
+            tries[field].insert(text[field], client.id, score);
+        }
+    }
+    for (int field = 0; field < FieldCount; ++field) {
+        for (quint64 key : trigrams(Field(field), text[field])) {
+            postings[key].insert(client.id);
+        }
+    }
+}
+
+void ClientSearchIndex::removeEntry(int clientId)
+{
+    Entry entry = entries.take(clientId);
+    nameTree.remove(normalizeForFuzzy(store.name(clientId).toString()), clientId);
+    cityTree.remove(normalizeForFuzzy(store.city(clientId)), clientId);
+
+    for (int field = 0; field < FieldCount; ++field) {
+        QString text = folded(entry, Field(field)).toString();
+        tries[field].remove(text, clientId);
+
+        for (quint64 key : trigrams(Field(field), text)) {
+            auto it = postings.find(key);
+            if (it == postings.end()) {
+                continue;
+            }
+            it->remove(clientId);
+            if (it->count == 0) {
+                postings.erase(it);
+            }
+        }
+    }
+
+    foldedText.release(entry.name);
+    foldedText.release(entry.email);
+    store.remove(clientId);
+}
+
+void ClientSearchIndex::compactIfWasteful()
+{
+    // The store compacts its own arena; this one holds the folded copies
+    if (foldedText.wastedChars() < MinWastedChars || foldedText.wastedChars() * 2 < foldedText.usedChars()) {
+        return;
+    }
+
+    TextArena compacted;
+    for (Entry& entry : entries) {
+        entry.name = compacted.add(foldedText.view(entry.name));
+        entry.email = compacted.add(foldedText.view(entry.email));
+    }
+    foldedText = compacted;
+}
+
+QList<Client> ClientSearchIndex::toClients(const QList<int>& ids) const
+{
+    QList<Client> clients;
+    clients.reserve(ids.size());
+    for (int id : ids) {
+        clients.append(store.client(id));
+    }
+    return clients;
+}
@@ -0,0 +1,134 @@
+// clientsearchindex.h
+#ifndef CLIENTSEARCHINDEX_H
+#define CLIENTSEARCHINDEX_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QVector>
+#include <QByteArray>
+
+#include "clients.h"
+#include "commands.h"
+#include "clientstore.h"
+#include "bktree.h"
+#include "prefixtrie.h"
+
+class WriteBehindQueue;
+
+// In-memory trigram index for client substring search.
+//
+// Name, email and city are case folded and split into overlapping
+// three-character keys; each key maps to the sorted client ids containing
+// it, stored as delta-encoded varints. A search intersects the posting
+// lists of the query's trigrams, checks every candidate against the real
+// text and returns the clients ordered by name, matching the results of
+// UPPER(col) LIKE UPPER('%x%') without touching the database.
+//
+// Names and cities are also kept in BK-trees so a misspelt query can be
+// answered with the closest spellings ("did you mean"), and in one prefix
+// trie per field ranked by the client's order count for autocomplete.
+//
+// The clients themselves are kept in a ClientStore; the folded name and
+// email sit in one more TextArena and the folded city in a dictionary, so
+// a client costs a 36-byte store record, a 20-byte entry and its text
+// twice (as stored and folded), plus its trigram postings and tree nodes.
+//
+// The index lives on the GUI thread. rebuild() splits the client list
+// across the thread pool; afterwards it follows the DAO signals it is
+// attached to (queued when the DAO lives on another thread).
+class ClientSearchIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Field { NameField = 0, EmailField = 1, CityField = 2, FieldCount = 3 };
+
+    struct Completion {
+        int clientId;
+        Field field;
+        QString text;       // Field value as stored, not folded
+        int orderCount;
+    };
+
+    explicit ClientSearchIndex(QObject *parent = nullptr);
+
+    // orderCounts (client id -> number of orders) ranks the completions
+    void rebuild(const QList<Client>& clients, const QHash<int, int>& orderCounts = QHash<int, int>());
+    void attach(ClientDAO* dao);
+    void attach(CommandDAO* dao);
+    void attach(WriteBehindQueue* queue);
+
+    // Which client owns each order, so later deletes and moves between
+    // clients adjust the right order count; call with every loaded order
+    void trackOrders(const QList<Command>& commands);
+
+    bool isReady() const { return ready; }
+    int size() const { return entries.size(); }
+
+    QList<Client> search(Field field, const QString& text) const;
+    QList<int> searchIds(Field field, const QString& text) const;
+    Client client(int id) const;
+
+    // Closest names or cities by edit distance; maxDistance < 0 picks a
+    // limit from the query length. Email has no fuzzy index.
+    QList<BKTree::Match> suggest(Field field, const QString& text, int k = 5, int maxDistance = -1) const;
+
+    // Clients whose field starts with prefix, most orders first
+    QList<Completion> complete(Field field, const QString& prefix, int k = 10) const;
+    QList<Completion> complete(const QString& prefix, int k = 10) const;   // All fields
+
+public slots:
+    void upsert(const Client& client);
+    void remove(int clientId);
+    void adjustOrderCount(int clientId, int delta);
+
+private:
+    // Sorted ids as varint deltas; appending a larger id is O(1)
+    struct PostingList {
+        QByteArray bytes;
+        int count = 0;
+        int lastId = 0;
+
+        void append(int id);
+        void insert(int id);
+        void remove(int id);
+        QVector<int> decode() const;
+        void encode(const QVector<int>& ids);
+    };
+
+    // Folded text of one client; the client itself is in store
+    struct Entry {
+        TextArena::Ref name;
+        TextArena::Ref email;
+        quint32 city;       // Code in foldedCities
+    };
+
+    ClientStore store;
+    QHash<int, Entry> entries;
+    TextArena foldedText;
+    StringDictionary foldedCities;
+    QHash<quint64, PostingList> postings;
+    BKTree nameTree;
+    BKTree cityTree;
+    PrefixTrie tries[FieldCount];
+    QHash<int, int> orderCounts;
+    QHash<int, int> orderOwners;    // Command id -> client id
+    bool ready;
+
+    static QString fold(const QString& text);
+    static QString normalizeForFuzzy(const QString& text);
+    static QVector<quint64> trigrams(Field field, const QString& folded);
+    static QVector<int> intersect(const QVector<int>& candidates, const PostingList& list);
+
+    void orderWritten(const Command& command);
+    void orderRemoved(int commandId);
+    QStringView folded(const Entry& entry, Field field) const;
+    void addEntry(const Client& client, const QString (&text)[FieldCount]);
+    void removeEntry(int clientId);
+    void compactIfWasteful();
+    QList<Client> toClients(const QList<int>& ids) const;
+};
+
+#endif // CLIENTSEARCHINDEX_H
@@ -0,0 +1,254 @@
+// clientstore.cpp
+#include "clientstore.h"
+#include <QDebug>
+
+// Rebuild an arena once this much of it is dead text, and more than half
+static const qint64 MinWastedChars = 1 << 16;
+
+static qint64 hashMemory(const QHash<int, int>& hash)
+{
+    // Qt 6 stores the entries in spans: the node itself plus about one
+    // byte of offset table per slot
+    return hash.capacity() * qint64(sizeof(int) * 2 + 1);
+}
+
+// ClientStore
+
+void ClientStore::clear()
+{
+    records.clear();
+    rowById.clear();
+    text.clear();
+    cities.clear();
+    postals.clear();
+}
+
+void ClientStore::reserve(int count)
+{
+    records.reserve(count);
+    rowById.reserve(count);
+}
+
+void ClientStore::upsert(const Client& client)
+{
+    Record record;
+    record.id = client.id;
+    record.name = text.add(client.name);
+    record.email = text.add(client.email);
+    record.address = text.add(client.address);
+    record.city = cities.intern(client.city);
+    record.postal = postals.intern(client.postal);
+
+    auto it = rowById.constFind(client.id);
+    if (it == rowById.constEnd()) {
+        rowById.insert(client.id, records.size());
+        records.append(record);
+        return;
+    }
+
+    Record& old = records[it.value()];
+    text.release(old.name);
+    text.release(old.email);
+    text.release(old.address);
+    old = record;
+    compactIfWasteful();
+}
+
+bool ClientStore::remove(int id)
+{
+    auto it = rowById.constFind(id);
+    if (it == rowById.constEnd()) {
+        return false;
+    }
+
+    int row = it.value();
+    rowById.erase(it);
+    const Record& old = records.at(row);
+    text.release(old.name);
+    text.release(old.email);
+    text.release(old.address);
+
+    // Move the last record into the hole
+    int last = records.size() - 1;
+    if (row != last) {
+        records[row] = records.at(last);
+        rowById[records.at(row).id] = row;
+    }
+    records.removeLast();
+    compactIfWasteful();
+    return true;
+}
+
+Client ClientStore::client(int id) const
+{
+    auto it = rowById.constFind(id);
+    return it == rowById.constEnd() ? Client() : clientAt(it.value());
+}
+
+Client ClientStore::clientAt(int row) const
+{
+    const Record& record = records.at(row);
+    return Client(record.id, text.text(record.name), text.text(record.email),
+                  cities.value(record.city), postals.value(record.postal), text.text(record.address));
+}
+
+QList<Client> ClientStore::toList() const
+{
+    QList<Client> clients;
+    clients.reserve(records.size());
+    for (int row = 0; row < records.size(); ++row) {
+        clients.append(clientAt(row));
+    }
+    return clients;
+}
+
+QStringView ClientStore::name(int id) const
+{
+    auto it = rowById.constFind(id);
+    return it == rowById.constEnd() ? QStringView() : text.view(records.at(it.value()).name);
+}
+
+QStringView ClientStore::email(int id) const
+{
+    auto it = rowById.constFind(id);
+    return it == rowById.constEnd() ? QStringView() : text.view(records.at(it.value()).email);
+}
+
+QString ClientStore::city(int id) const
+{
+    auto it = rowById.constFind(id);
+    return it == rowById.constEnd() ? QString() : cities.value(records.at(it.value()).city);
+}
+
+qint64 ClientStore::memoryUsage() const
+{
+    return records.capacity() * qint64(sizeof(Record)) + hashMemory(rowById)
+           + text.memoryUsage() + cities.memoryUsage() + postals.memoryUsage();
+}
+
+void ClientStore::compactIfWasteful()
+{
+    if (text.wastedChars() < MinWastedChars || text.wastedChars() * 2 < text.usedChars()) {
+        return;
+    }
+
+    TextArena compacted;
+    for (Record& record : records) {
+        record.name = compacted.add(text.view(record.name));
+        record.email = compacted.add(text.view(record.email));
+        record.address = compacted.add(text.view(record.address));
+    }
+    text = compacted;
+}
+
+// CommandStore
+
+void CommandStore::clear()
+{
+    records.clear();
+    rowById.clear();
+    text.clear();
+    paymentMethods.clear();
+}
+
+void CommandStore::reserve(int count)
+{
+    records.reserve(count);
+    rowById.reserve(count);
+}
+
+void CommandStore::upsert(const Command& command)
+{
+    Record record;
+    record.commandId = command.commandId;
+    record.clientId = command.clientId;
+    record.dateMs = command.commandDateMs;
+    record.cents = command.total.toCents();
+    record.paymentMethod = paymentMethods.intern(command.paymentMethod);
+    record.deliveryAddress = text.add(command.deliveryAddress);
+
+    auto it = rowById.constFind(command.commandId);
+    if (it == rowById.constEnd()) {
+        rowById.insert(command.commandId, records.size());
+        records.append(record);
+        return;
+    }
+
+    Record& old = records[it.value()];
+    text.release(old.deliveryAddress);
+    old = record;
+    compactIfWasteful();
+}
+
+bool CommandStore::remove(int commandId)
+{
+    auto it = rowById.constFind(commandId);
+    if (it == rowById.constEnd()) {
+        return false;
+    }
+
+    int row = it.value();
+    rowById.erase(it);
+    text.release(records.at(row).deliveryAddress);
+
+    int last = records.size() - 1;
+    if (row != last) {
+        records[row] = records.at(last);
+        rowById[records.at(row).commandId] = row;
+    }
+    records.removeLast();
+    compactIfWasteful();
+    return true;
+}
+
+Command CommandStore::command(int commandId, const ClientStore* clients) const
+{
+    auto it = rowById.constFind(commandId);
+    return it == rowById.constEnd() ? Command() : commandAt(it.value(), clients);
+}
+
+Command CommandStore::commandAt(int row, const ClientStore* clients) const
+{
+    const Record& record = records.at(row);
+    Command command;
+    command.commandId = record.commandId;
+    command.clientId = record.clientId;
+    command.commandDateMs = record.dateMs;
+    command.total = Money::fromCents(record.cents);
+    command.paymentMethod = paymentMethods.value(record.paymentMethod);
+    command.deliveryAddress = text.text(record.deliveryAddress);
+    if (clients) {
+        command.clientName = clients->name(record.clientId).toString();
+        command.clientEmail = clients->email(record.clientId).toString();
+    }
+    return command;
+}
+
+QList<Command> CommandStore::toList(const ClientStore* clients) const
+{
+    QList<Command> commands;
+    commands.reserve(records.size());
+    for (int row = 0; row < records.size(); ++row) {
+        commands.append(commandAt(row, clients));
+    }
+    return commands;
+}
+
+qint64 CommandStore::memoryUsage() const
+{
+    return records.capacity() * qint64(sizeof(Record)) + hashMemory(rowById)
+           + text.memoryUsage() + paymentMethods.memoryUsage();
+}
+
+void CommandStore::compactIfWasteful()
+{
+    if (text.wastedChars() < MinWastedChars || text.wastedChars() * 2 < text.usedChars()) {
+        return;
+    }
+
+    TextArena compacted;
+    for (Record& record : records) {
+        record.deliveryAddress = compacted.add(text.view(record.deliveryAddress));
+    }
+    text = compacted;
+}
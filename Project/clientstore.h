@@ -0,0 +1,112 @@
+// clientstore.h
+#ifndef CLIENTSTORE_H
+#define CLIENTSTORE_H
+
+#include <QString>
+#include <QStringView>
+#include <QList>
+#include <QVector>
+#include <QHash>
+
+#include "clients.h"
+#include "commands.h"
+#include "stringpool.h"
+
+// Compact in-memory copy of CLIENTS.
+//
+// A Client holds five separately allocated QStrings. Here a client is one
+// 36-byte record: the id, arena references for name, email and address,
+// and dictionary codes for city and postal code, which repeat across many
+// clients. Lookups by id go through one hash; client() builds a Client on
+// demand for code that needs one.
+//
+// Plain value type: copies share their storage until one of them changes,
+// so a store can be handed to a worker thread cheaply. Removing a client
+// moves the last record into its slot, so record order carries no meaning.
+class ClientStore
+{
+public:
+    void clear();
+    void reserve(int count);
+
+    void upsert(const Client& client);
+    bool remove(int id);
+
+    bool contains(int id) const { return rowById.contains(id); }
+    int size() const { return records.size(); }
+    int idAt(int row) const { return records.at(row).id; }
+
+    Client client(int id) const;     // Client() when unknown
+    Client clientAt(int row) const;
+    QList<Client> toList() const;
+
+    QStringView name(int id) const;
+    QStringView email(int id) const;
+    QString city(int id) const;
+
+    qint64 memoryUsage() const;
+
+private:
+    struct Record {
+        qint32 id;
+        TextArena::Ref name;
+        TextArena::Ref email;
+        TextArena::Ref address;
+        quint32 city;
+        quint32 postal;
+    };
+
+    QVector<Record> records;
+    QHash<int, int> rowById;
+    TextArena text;
+    StringDictionary cities;
+    StringDictionary postals;
+
+    void compactIfWasteful();
+};
+
+// Compact in-memory copy of COMMANDS.
+//
+// A 40-byte record per order: ids, date, total in cents, a dictionary code
+// for the payment method and an arena reference for the delivery address.
+// Orders refer to their client by id only; command() fills in the client
+// name and email from a ClientStore when one is given.
+class CommandStore
+{
+public:
+    void clear();
+    void reserve(int count);
+
+    void upsert(const Command& command);
+    bool remove(int commandId);
+
+    bool contains(int commandId) const { return rowById.contains(commandId); }
+    int size() const { return records.size(); }
+    int idAt(int row) const { return records.at(row).commandId; }
+    int clientIdAt(int row) const { return records.at(row).clientId; }
+
+    Command command(int commandId, const ClientStore* clients = nullptr) const;
+    Command commandAt(int row, const ClientStore* clients = nullptr) const;
+    QList<Command> toList(const ClientStore* clients = nullptr) const;
+
+    qint64 memoryUsage() const;
+
+private:
+    struct Record {
+        qint32 commandId;
+        qint32 clientId;
+        qint64 dateMs;
+        qint64 cents;
+        quint32 paymentMethod;
+        TextArena::Ref deliveryAddress;
+    };
+
+    QVector<Record> records;
+    QHash<int, int> rowById;
+    TextArena text;
+    StringDictionary paymentMethods;
+
+    void compactIfWasteful();
+};
+
+#endif // CLIENTSTORE_H
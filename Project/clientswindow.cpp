@@ -1,4 +1,8 @@
 #include "clientswindow.h"
+#include "writebehindqueue.h"
+#include "duplicatedetector.h"
+#include "validationengine.h"
+#include "trace.h"
 #include <QApplication>
 #include <QScreen>
 #include <QRegularExpression>
@@ -95,8 +99,11 @@ ClientsWindow::ClientsWindow(QWidget *parent, Mode mode)
     : QDialog(parent)
     , currentMode(mode)
     , clientManager(nullptr)
+    , writeQueue(nullptr)
+    , duplicateDetector(nullptr)
     , fadeAnimation(nullptr)
     , validationTimer(new QTimer(this))
+    , duplicateTimer(new QTimer(this))
 {
     // Initialize client manager
     clientManager = new ClientManager(this);
@@ -212,6 +219,14 @@ void ClientsWindow::setupUI()
     validationLabel->hide();
 
     formContainer->addWidget(validationLabel);
+
+    // Duplicate warning label
+    duplicateLabel = new QLabel();
+    duplicateLabel->setObjectName("duplicateLabel");
+    duplicateLabel->setWordWrap(true);
+    duplicateLabel->hide();
+
+    formContainer->addWidget(duplicateLabel);
     formContainer->addStretch();
 
     mainLayout->addWidget(formFrame);
@@ -284,6 +299,14 @@ void ClientsWindow::setupConnections()
     connect(validationTimer, &QTimer::timeout, [this]() {
         validateAllFields();
     });
+
+    // Duplicate check follows the fields it compares, debounced the same way
+    duplicateTimer->setSingleShot(true);
+    duplicateTimer->setInterval(300);
+    connect(duplicateTimer, &QTimer::timeout, [this]() { checkForDuplicates(); });
+    connect(nameEdit, &QLineEdit::textChanged, [this]() { duplicateTimer->start(); });
+    connect(postalEdit, &QLineEdit::textChanged, [this]() { duplicateTimer->start(); });
+    connect(addressEdit, &QTextEdit::textChanged, [this]() { duplicateTimer->start(); });
 }
 
 void ClientsWindow::applyModernStyling()
@@ -337,6 +360,16 @@ void ClientsWindow::applyModernStyling()
         "border-radius: 6px; "
         "padding: 8px 12px; "
         "margin: 10px 0px; "
+        "} "
+
+        "QLabel#duplicateLabel { "
+        "color: #975a16; "
+        "font-size: 12px; "
+        "font-weight: 500; "
+        "background: #fefcbf; "
+        "border: 1px solid #f6e05e; "
+        "border-radius: 6px; "
+        "padding: 8px 12px; "
         "}"
         );
 
@@ -482,10 +515,7 @@ Client ClientsWindow::getClient() const
 
 bool ClientsWindow::isValidEmail(const QString& email)
 {
-    int pos = 0;
-    QString emailCopy = email;
-    QValidator::State state = emailValidator->validate(emailCopy, pos);
-    return (state == QValidator::Acceptable);
+    return ValidationEngine::instance().isValidEmail(email);
 }
 
 bool ClientsWindow::validateAllFields()
@@ -580,6 +610,7 @@ void ClientsWindow::validateInput()
 
 void ClientsWindow::onSaveClicked()
 {
+    TRACE_SCOPE("ui", "ClientsWindow::onSaveClicked");
     if (currentMode == ViewMode) {
         accept();
         return;
@@ -593,6 +624,33 @@ void ClientsWindow::onSaveClicked()
     Client client = getClient();
     QString errorMessage;
 
+    if (currentMode == AddMode && duplicateDetector) {
+        QList<DuplicateDetector::Match> matches = duplicateDetector->findSimilar(client);
+        if (!matches.isEmpty()) {
+            Client existing = duplicateDetector->client(matches.first().otherId);
+            QMessageBox::StandardButton reply = QMessageBox::question(this, "Possible Duplicate",
+                QString("This looks like client #%1 %2 (%3% similar).\nSave anyway?")
+                    .arg(QString::number(existing.id), existing.name,
+                         QString::number(qRound(matches.first().similarity * 100))),
+                QMessageBox::Yes | QMessageBox::No);
+            if (reply != QMessageBox::Yes) {
+                return;
+            }
+        }
+    }
+
+    if (writeQueue) {
+        // The view shows the change right away, the database write follows
+        if (currentMode == AddMode) {
+            client.id = writeQueue->enqueueClientInsert(client);
+        } else if (currentMode == EditMode) {
+            writeQueue->enqueueClientUpdate(client, currentClient);
+        }
+        currentClient = client;
+        accept();
+        return;
+    }
+
     bool success = false;
     if (currentMode == AddMode) {
         success = clientManager->addNewClient(client);
@@ -688,6 +746,36 @@ void ClientsWindow::animateShow()
     fadeAnimation->start(QPropertyAnimation::DeleteWhenStopped);
 }
 
+void ClientsWindow::checkForDuplicates()
+{
+    if (!duplicateDetector || !duplicateDetector->isReady() || currentMode == ViewMode) {
+        duplicateLabel->hide();
+        return;
+    }
+
+    Client draft = getClient();
+    if (draft.name.length() < 2) {
+        duplicateLabel->hide();
+        return;
+    }
+
+    QList<DuplicateDetector::Match> matches = duplicateDetector->findSimilar(draft, currentClient.id);
+    if (matches.isEmpty()) {
+        duplicateLabel->hide();
+        return;
+    }
+
+    QStringList lines;
+    for (const DuplicateDetector::Match& match : matches) {
+        Client existing = duplicateDetector->client(match.otherId);
+        lines << QString("⚠️ Possible duplicate of #%1 %2, %3 (%4%)")
+                     .arg(existing.id).arg(existing.name, existing.city)
+                     .arg(qRound(match.similarity * 100));
+    }
+    duplicateLabel->setText(lines.join("\n"));
+    duplicateLabel->show();
+}
+
 bool ClientsWindow::eventFilter(QObject *watched, QEvent *event)
 {
     // Handle focus events for better user experience
@@ -20,6 +20,9 @@
 
 #include "clients.h"
 
+class WriteBehindQueue;
+class DuplicateDetector;
+
 class ClientsWindow : public QDialog
 {
     // No Q_OBJECT macro for .pro qmake without slots
@@ -43,6 +46,12 @@ public:
     void setMode(Mode mode);
     Mode getMode() const { return currentMode; }
 
+    // Save through the write-behind queue instead of writing synchronously
+    void setWriteQueue(WriteBehindQueue *queue) { writeQueue = queue; }
+
+    // Warn while typing when the form resembles an existing client
+    void setDuplicateDetector(DuplicateDetector *detector) { duplicateDetector = detector; }
+
 protected:
     void keyPressEvent(QKeyEvent *event) override;
     void showEvent(QShowEvent *event) override;
@@ -67,6 +76,7 @@ private:
     bool validateAllFields();
     void showValidationError(const QString &message);
     void animateShow();
+    void checkForDuplicates();
 
     // Email validation helper
     bool isValidEmail(const QString& email);
@@ -92,15 +102,19 @@ private:
     QPushButton *clearButton;
 
     QLabel *validationLabel;
+    QLabel *duplicateLabel;
 
     // Data and state
     Client currentClient;
     Mode currentMode;
     ClientManager *clientManager;
+    WriteBehindQueue *writeQueue;
+    DuplicateDetector *duplicateDetector;
 
     // Animation
     QPropertyAnimation *fadeAnimation;
     QTimer *validationTimer;
+    QTimer *duplicateTimer;
 
     // Validation
     QRegularExpressionValidator *emailValidator;
@@ -0,0 +1,444 @@
+// commandcolumnstore.cpp
+#include "commandcolumnstore.h"
+#include "writebehindqueue.h"
+#include "datecodec.h"
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <QSet>
+#include <algorithm>
+
+namespace
+{
+// Rows per parallel task; smaller scans stay on the calling thread
+const int ChunkRows = 1 << 20;
+
+template <typename Partial, typename Kernel>
+QList<Partial> scanChunks(int rows, Kernel kernel)
+{
+    if (rows <= ChunkRows) {
+        return QList<Partial>{kernel(0, rows)};
+    }
+
+    QList<QPair<int, int>> ranges;
+    for (int begin = 0; begin < rows; begin += ChunkRows) {
+        ranges.append(qMakePair(begin, qMin(rows, begin + ChunkRows)));
+    }
+    return QtConcurrent::blockingMapped<QList<Partial>>(ranges, [&kernel](const QPair<int, int>& range) {
+        return kernel(range.first, range.second);
+    });
+}
+
+// Order count and cent sum per group code
+struct GroupPartial {
+    QVector<int> orders;
+    QVector<qint64> cents;
+
+    explicit GroupPartial(int groups = 0) : orders(groups, 0), cents(groups, 0) {}
+
+    void merge(const GroupPartial& other)
+    {
+        for (int i = 0; i < orders.size(); ++i) {
+            orders[i] += other.orders.at(i);
+            cents[i] += other.cents.at(i);
+        }
+    }
+};
+
+GroupPartial mergeAll(const QList<GroupPartial>& partials)
+{
+    GroupPartial result = partials.first();
+    for (int i = 1; i < partials.size(); ++i) {
+        result.merge(partials.at(i));
+    }
+    return result;
+}
+}
+
+CommandColumnStore::CommandColumnStore(QObject *parent)
+    : QObject(parent), ready(false)
+{
+}
+
+void CommandColumnStore::rebuildOrders(const QList<Command>& commands)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    commandIds.clear();
+    clientIds.clear();
+    dates.clear();
+    cents.clear();
+    payments.clear();
+    rowById.clear();
+    paymentDictionary.clear();
+    paymentCodes.clear();
+
+    commandIds.reserve(commands.size());
+    clientIds.reserve(commands.size());
+    dates.reserve(commands.size());
+    cents.reserve(commands.size());
+    payments.reserve(commands.size());
+    rowById.reserve(commands.size());
+
+    for (const Command& command : commands) {
+        appendRow(command);
+    }
+    ready = true;
+
+    qDebug() << "Command column store loaded:" << rowCount() << "rows,"
+             << paymentDictionary.size() << "payment methods in" << timer.elapsed() << "ms";
+}
+
+void CommandColumnStore::rebuildClients(const QList<Client>& clients)
+{
+    cityByClient.clear();
+    cityDictionary.clear();
+    cityCodes.clear();
+    clientNames.clear();
+    clientNames.reserve(clients.size());
+
+    for (const Client& client : clients) {
+        upsertClient(client);
+    }
+}
+
+void CommandColumnStore::attach(ClientDAO* dao)
+{
+    connect(dao, &ClientDAO::clientCreated, this, &CommandColumnStore::upsertClient);
+    connect(dao, &ClientDAO::clientUpdated, this, &CommandColumnStore::upsertClient);
+    connect(dao, &ClientDAO::clientDeleted, this, &CommandColumnStore::removeClient);
+}
+
+void CommandColumnStore::attach(CommandDAO* dao)
+{
+    connect(dao, &CommandDAO::commandCreated, this, &CommandColumnStore::upsertOrder);
+    connect(dao, &CommandDAO::commandUpdated, this, &CommandColumnStore::upsertOrder);
+    connect(dao, &CommandDAO::commandDeleted, this, &CommandColumnStore::removeOrder);
+}
+
+void CommandColumnStore::attach(WriteBehindQueue* queue)
+{
+    connect(queue, &WriteBehindQueue::clientCommitted, this, [this](int, const Client& client) {
+        upsertClient(client);
+    });
+    connect(queue, &WriteBehindQueue::commandCommitted, this, [this](int, const Command& command) {
+        upsertOrder(command);
+    });
+}
+
+void CommandColumnStore::upsertOrder(const Command& command)
+{
+    if (command.commandId <= 0) {
+        return;
+    }
+
+    auto it = rowById.constFind(command.commandId);
+    if (it == rowById.constEnd()) {
+        appendRow(command);
+        return;
+    }
+
+    int row = it.value();
+    clientIds[row] = command.clientId;
+    dates[row] = command.commandDateMs;
+    cents[row] = command.total.toCents();
+    payments[row] = paymentCode(command.paymentMethod);
+}
+
+void CommandColumnStore::removeOrder(int commandId)
+{
+    auto it = rowById.find(commandId);
+    if (it == rowById.end()) {
+        return;
+    }
+
+    int row = it.value();
+    rowById.erase(it);
+
+    // Move the last row into the hole
+    int last = commandIds.size() - 1;
+    if (row != last) {
+        commandIds[row] = commandIds.at(last);
+        clientIds[row] = clientIds.at(last);
+        dates[row] = dates.at(last);
+        cents[row] = cents.at(last);
+        payments[row] = payments.at(last);
+        rowById[commandIds.at(row)] = row;
+    }
+    commandIds.removeLast();
+    clientIds.removeLast();
+    dates.removeLast();
+    cents.removeLast();
+    payments.removeLast();
+}
+
+void CommandColumnStore::upsertClient(const Client& client)
+{
+    if (client.id <= 0) {
+        return;
+    }
+    if (client.id >= cityByClient.size()) {
+        cityByClient.resize(client.id + 1, -1);
+    }
+    cityByClient[client.id] = cityCode(client.city);
+    clientNames.insert(client.id, client.name);
+}
+
+void CommandColumnStore::removeClient(int clientId)
+{
+    if (clientId > 0 && clientId < cityByClient.size()) {
+        cityByClient[clientId] = -1;
+    }
+    clientNames.remove(clientId);
+}
+
+int CommandColumnStore::cityCount() const
+{
+    QSet<qint32> used;
+    for (qint32 code : cityByClient) {
+        if (code >= 0) {
+            used.insert(code);
+        }
+    }
+    return used.size();
+}
+
+CommandColumnStore::Totals CommandColumnStore::totals(qint64 fromMs, qint64 toMs) const
+{
+    struct Partial {
+        int orders = 0;
+        qint64 sum = 0;
+        qint64 first = std::numeric_limits<qint64>::max();
+        qint64 last = std::numeric_limits<qint64>::min();
+    };
+
+    const qint64 *date = dates.constData();
+    const qint64 *amount = cents.constData();
+
+    QList<Partial> partials = scanChunks<Partial>(rowCount(), [=](int begin, int end) {
+        Partial partial;
+        // Predicated rather than branching so the loop vectorises; undated
+        // orders sit at NoDate and never count, even in the default range
+        for (int i = begin; i < end; ++i) {
+            bool inRange = date[i] != Command::NoDate && date[i] >= fromMs && date[i] < toMs;
+            partial.orders += inRange;
+            partial.sum += inRange ? amount[i] : 0;
+            partial.first = inRange && date[i] < partial.first ? date[i] : partial.first;
+            partial.last = inRange && date[i] > partial.last ? date[i] : partial.last;
+        }
+        return partial;
+    });
+
+    Totals result;
+    qint64 sum = 0;
+    qint64 first = std::numeric_limits<qint64>::max();
+    qint64 last = std::numeric_limits<qint64>::min();
+    for (const Partial& partial : partials) {
+        result.orders += partial.orders;
+        sum += partial.sum;
+        first = qMin(first, partial.first);
+        last = qMax(last, partial.last);
+    }
+    result.sales = Money::fromCents(sum);
+    if (result.orders > 0) {
+        result.firstMs = first;
+        result.lastMs = last;
+    }
+    return result;
+}
+
+QList<QPair<int, CommandColumnStore::Bucket>> CommandColumnStore::topClients(int k) const
+{
+    QList<QPair<int, Bucket>> result;
+    if (k <= 0 || rowCount() == 0) {
+        return result;
+    }
+
+    // Dense per-client sums; client ids come from a sequence so the range stays compact
+    int maxClient = *std::max_element(clientIds.constBegin(), clientIds.constEnd());
+    if (maxClient <= 0) {
+        return result;
+    }
+    QVector<qint64> sums(maxClient + 1, 0);
+    QVector<int> orders(maxClient + 1, 0);
+
+    const qint32 *client = clientIds.constData();
+    const qint64 *amount = cents.constData();
+    for (int i = 0, rows = rowCount(); i < rows; ++i) {
+        if (client[i] > 0) {
+            sums[client[i]] += amount[i];
+            orders[client[i]]++;
+        }
+    }
+
+    QVector<int> ids;
+    for (int id = 1; id <= maxClient; ++id) {
+        if (orders.at(id) > 0) {
+            ids.append(id);
+        }
+    }
+
+    int count = qMin(k, int(ids.size()));
+    std::partial_sort(ids.begin(), ids.begin() + count, ids.end(), [&sums](int a, int b) {
+        return sums.at(a) != sums.at(b) ? sums.at(a) > sums.at(b) : a < b;
+    });
+
+    for (int i = 0; i < count; ++i) {
+        Bucket bucket;
+        bucket.orders = orders.at(ids.at(i));
+        bucket.total = Money::fromCents(sums.at(ids.at(i)));
+        result.append(qMakePair(ids.at(i), bucket));
+    }
+    return result;
+}
+
+QMap<QDate, CommandColumnStore::Bucket> CommandColumnStore::salesByMonth(const QDate& from, const QDate& to) const
+{
+    QMap<QDate, Bucket> result;
+    QDate firstMonth(from.year(), from.month(), 1);
+    QDate lastMonth(to.year(), to.month(), 1);
+    if (!firstMonth.isValid() || lastMonth < firstMonth) {
+        return result;
+    }
+
+    // Local midnight of each month start; a row belongs to the last boundary at or before it
+    QVector<qint64> boundaries;
+    for (QDate month = firstMonth; month <= lastMonth.addMonths(1); month = month.addMonths(1)) {
+        boundaries.append(DateCodec::toEpochMs(month, 0));
+    }
+    int months = boundaries.size() - 1;
+
+    const qint64 *date = dates.constData();
+    const qint64 *amount = cents.constData();
+    const qint64 *bounds = boundaries.constData();
+    const qint64 lower = boundaries.first();
+    const qint64 upper = boundaries.last();
+
+    QList<GroupPartial> partials = scanChunks<GroupPartial>(rowCount(), [=](int begin, int end) {
+        GroupPartial partial(months);
+        for (int i = begin; i < end; ++i) {
+            if (date[i] < lower || date[i] >= upper) {
+                continue;
+            }
+            int month = int(std::upper_bound(bounds, bounds + months + 1, date[i]) - bounds) - 1;
+            partial.orders[month]++;
+            partial.cents[month] += amount[i];
+        }
+        return partial;
+    });
+    GroupPartial merged = mergeAll(partials);
+
+    for (int i = 0; i < months; ++i) {
+        Bucket bucket;
+        bucket.orders = merged.orders.at(i);
+        bucket.total = Money::fromCents(merged.cents.at(i));
+        result.insert(firstMonth.addMonths(i), bucket);
+    }
+    return result;
+}
+
+QMap<QString, CommandColumnStore::Bucket> CommandColumnStore::salesByCity() const
+{
+    // Last group collects orders whose client has no city (or is unknown)
+    const int groups = cityDictionary.size() + 1;
+    const int unknown = groups - 1;
+
+    const qint32 *client = clientIds.constData();
+    const qint64 *amount = cents.constData();
+    const qint32 *cityOf = cityByClient.constData();
+    const int clientLimit = cityByClient.size();
+
+    QList<GroupPartial> partials = scanChunks<GroupPartial>(rowCount(), [=](int begin, int end) {
+        GroupPartial partial(groups);
+        for (int i = begin; i < end; ++i) {
+            int city = client[i] > 0 && client[i] < clientLimit ? cityOf[client[i]] : -1;
+            int group = city >= 0 ? city : unknown;
+            partial.orders[group]++;
+            partial.cents[group] += amount[i];
+        }
+        return partial;
+    });
+    GroupPartial merged = mergeAll(partials);
+
+    QMap<QString, Bucket> result;
+    for (int i = 0; i < groups; ++i) {
+        if (merged.orders.at(i) == 0) {
+            continue;
+        }
+        Bucket bucket;
+        bucket.orders = merged.orders.at(i);
+        bucket.total = Money::fromCents(merged.cents.at(i));
+        result.insert(i == unknown ? QString() : cityDictionary.at(i), bucket);
+    }
+    return result;
+}
+
+QMap<QString, CommandColumnStore::Bucket> CommandColumnStore::salesByPaymentMethod() const
+{
+    const int groups = paymentDictionary.size();
+    const quint16 *payment = payments.constData();
+    const qint64 *amount = cents.constData();
+
+    QList<GroupPartial> partials = scanChunks<GroupPartial>(rowCount(), [=](int begin, int end) {
+        GroupPartial partial(groups);
+        for (int i = begin; i < end; ++i) {
+            partial.orders[payment[i]]++;
+            partial.cents[payment[i]] += amount[i];
+        }
+        return partial;
+    });
+    GroupPartial merged = mergeAll(partials);
+
+    QMap<QString, Bucket> result;
+    for (int i = 0; i < groups; ++i) {
+        if (merged.orders.at(i) == 0) {
+            continue;
+        }
+        Bucket bucket;
+        bucket.orders = merged.orders.at(i);
+        bucket.total = Money::fromCents(merged.cents.at(i));
+        result.insert(paymentDictionary.at(i), bucket);
+    }
+    return result;
+}
+
+void CommandColumnStore::appendRow(const Command& command)
+{
+    rowById.insert(command.commandId, commandIds.size());
+    commandIds.append(command.commandId);
+    clientIds.append(command.clientId);
+    dates.append(command.commandDateMs);
+    cents.append(command.total.toCents());
+    payments.append(paymentCode(command.paymentMethod));
+}
+
+quint16 CommandColumnStore::paymentCode(const QString& method)
+{
+    auto it = paymentCodes.constFind(method);
+    if (it != paymentCodes.constEnd()) {
+        return it.value();
+    }
+    quint16 code = quint16(paymentDictionary.size());
+    paymentDictionary.append(method);
+    paymentCodes.insert(method, code);
+    return code;
+}
+
+qint32 CommandColumnStore::cityCode(const QString& city)
+{
+    QString trimmed = city.trimmed();
+    if (trimmed.isEmpty()) {
+        return -1;
+    }
+
+    // "paris" and "Paris " are one city, shown with the first spelling seen
+    QString key = trimmed.toCaseFolded();
+    auto it = cityCodes.constFind(key);
+    if (it != cityCodes.constEnd()) {
+        return it.value();
+    }
+    qint32 code = qint32(cityDictionary.size());
+    cityDictionary.append(trimmed);
+    cityCodes.insert(key, code);
+    return code;
+}
@@ -0,0 +1,110 @@
+// commandcolumnstore.h
+#ifndef COMMANDCOLUMNSTORE_H
+#define COMMANDCOLUMNSTORE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QVector>
+#include <QHash>
+#include <QMap>
+#include <QPair>
+#include <QDate>
+#include <limits>
+
+#include "clients.h"
+#include "commands.h"
+
+class WriteBehindQueue;
+
+// In-memory column store over COMMANDS for the dashboard and chatbot analytics.
+//
+// Each order is one row across parallel arrays: client id (int32), date
+// (epoch ms), total (int64 cents) and payment method (uint16 code into a
+// dictionary). Cities come from a client id -> city code column, so sales
+// by city is a lookup per row rather than a join. Aggregations are plain
+// loops over contiguous arrays that the compiler vectorises; scans over
+// more than one chunk of rows are split across the thread pool and the
+// partial results merged.
+//
+// Loaded with the tables and kept current by the DAO and write-behind
+// queue signals, like the search indexes. Removing a row moves the last
+// row into its slot, so row order carries no meaning.
+class CommandColumnStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Totals {
+        int orders = 0;
+        Money sales;
+        qint64 firstMs = Command::NoDate;
+        qint64 lastMs = Command::NoDate;
+    };
+
+    struct Bucket {
+        int orders = 0;
+        Money total;
+    };
+
+    explicit CommandColumnStore(QObject *parent = nullptr);
+
+    // Orders and clients are loaded separately, each replacing its own columns
+    void rebuildOrders(const QList<Command>& commands);
+    void rebuildClients(const QList<Client>& clients);
+    void attach(ClientDAO* dao);
+    void attach(CommandDAO* dao);
+    void attach(WriteBehindQueue* queue);
+
+    bool isReady() const { return ready; }
+    int rowCount() const { return commandIds.size(); }
+    QString clientName(int clientId) const { return clientNames.value(clientId); }
+    int cityCount() const;   // Distinct cities among known clients
+
+    // Dated orders with fromMs <= date < toMs
+    Totals totals(qint64 fromMs = std::numeric_limits<qint64>::min(),
+                  qint64 toMs = std::numeric_limits<qint64>::max()) const;
+
+    // Biggest spenders first
+    QList<QPair<int, Bucket>> topClients(int k) const;
+
+    // Keyed by the first day of each month from 'from' to 'to'; empty months are included
+    QMap<QDate, Bucket> salesByMonth(const QDate& from, const QDate& to) const;
+
+    // Clients without a city are grouped under an empty key
+    QMap<QString, Bucket> salesByCity() const;
+    QMap<QString, Bucket> salesByPaymentMethod() const;
+
+public slots:
+    void upsertOrder(const Command& command);
+    void removeOrder(int commandId);
+    void upsertClient(const Client& client);
+    void removeClient(int clientId);
+
+private:
+    // Order columns, one entry per row
+    QVector<qint32> commandIds;
+    QVector<qint32> clientIds;
+    QVector<qint64> dates;
+    QVector<qint64> cents;
+    QVector<quint16> payments;
+    QHash<int, int> rowById;
+
+    QStringList paymentDictionary;
+    QHash<QString, quint16> paymentCodes;
+
+    // Client columns, indexed by client id; -1 means no city
+    QVector<qint32> cityByClient;
+    QStringList cityDictionary;
+    QHash<QString, qint32> cityCodes;
+    QHash<int, QString> clientNames;
+
+    bool ready;
+
+    void appendRow(const Command& command);
+    quint16 paymentCode(const QString& method);
+    qint32 cityCode(const QString& city);
+};
+
+#endif // COMMANDCOLUMNSTORE_H
@@ -1,39 +1,25 @@
 #include "commands.h"
 #include "connection.h"
+#include "unitofwork.h"
+#include "datecodec.h"
+#include "salesrollup.h"
+#include "topkleaderboard.h"
+#include "querycache.h"
+#include "localreplica.h"
+#include "validationengine.h"
+#include "trace.h"
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QVariant>
-#include <QRegularExpression>
-#include <QApplication>
+#include <QPointer>
 
 // CommandDAO Implementation
 CommandDAO::CommandDAO(QObject *parent)
     : QObject(parent), tableModel(nullptr), joinedModel(nullptr)
 {
-    // Initialize table model
-    Connection& conn = Connection::getInstance();
-    if (conn.isConnected()) {
-        // Get fresh database reference each time
-        QSqlDatabase db = conn.getDatabase();
-        tableModel = new QSqlTableModel(this, db);
-        tableModel->setTable("COMMANDS");
-        tableModel->setEditStrategy(QSqlTableModel::OnManualSubmit);
-
-        // Set column headers
-        tableModel->setHeaderData(0, Qt::Horizontal, "COMMAND_ID");
-        tableModel->setHeaderData(1, Qt::Horizontal, "CLIENT_ID");
-        tableModel->setHeaderData(2, Qt::Horizontal, "COMMAND_DATE");
-        tableModel->setHeaderData(3, Qt::Horizontal, "TOTAL");
-        tableModel->setHeaderData(4, Qt::Horizontal, "PAYMENT_METHOD");
-        tableModel->setHeaderData(5, Qt::Horizontal, "DELIVERY_ADDRESS");
-
-        // Initialize joined model
-        joinedModel = new QSqlTableModel(this, db);
-
-        // Load data
-        refreshTableModel();
-    } else {
+    // Models are created on first use, see getTableModel()
+    if (!Connection::getInstance().isDataConnected()) {
         qDebug() << "Warning: Database not connected when creating CommandDAO";
     }
 }
@@ -48,152 +34,169 @@ CommandDAO::~CommandDAO()
     }
 }
 
-bool CommandDAO::createCommand(const Command& command) {
+bool CommandDAO::createCommand(const Command& command, int* newCommandId) {
+    TRACE_SCOPE("dao", "CommandDAO::createCommand");
     if (!command.isValid()) {
         emit errorOccurred("Invalid command data");
         return false;
     }
 
     Connection& conn = Connection::getInstance();
-    if (!conn.ensureConnected()) {
+    if (!conn.ensureDataConnection()) {
         emit errorOccurred("Database connection error");
         return false;
     }
 
-    QSqlDatabase db = conn.getDatabase();
-    db.transaction();
+    QSqlDatabase db = conn.getDataDatabase();
+    UnitOfWork::Write write(db, "COMMANDS");
 
     try {
-        QSqlQuery seqQuery(db);
-        if (!seqQuery.exec("SELECT LAKHOUA.COMMANDS_SEQ.NEXTVAL FROM DUAL") || !seqQuery.next()) {
-            throw std::runtime_error("Sequence error: " + seqQuery.lastError().text().toStdString());
+        write.begin();
+
+        SalesRollup rollup(db);
+        QString rollupError;
+        if (!LocalReplica::isReplica(db) && !rollup.lockState(rollupError)) {
+            throw std::runtime_error(rollupError.toStdString());
+        }
+
+        // Offline the replica hands out ids reserved from the sequence
+        int newId = 0;
+        if (LocalReplica::isReplica(db)) {
+            QString idError;
+            newId = LocalReplica::takeId(db, "COMMANDS", idError);
+            if (newId <= 0) {
+                throw std::runtime_error(idError.toStdString());
+            }
+        } else if (Connection::dialectOf(db) == Connection::SQLiteDialect) {
+            // No sequences in SQLite; the INTEGER PRIMARY KEY picks the next rowid
+            newId = 0;
+        } else {
+            QSqlQuery seqQuery(db);
+            if (!TRACE_EXEC_SQL(seqQuery, "SELECT COMMANDS_SEQ.NEXTVAL FROM DUAL") || !seqQuery.next()) {
+                throw std::runtime_error("Sequence error: " + seqQuery.lastError().text().toStdString());
+            }
+            newId = seqQuery.value(0).toInt();
         }
-        int newId = seqQuery.value(0).toInt();
 
         QSqlQuery query(db);
         query.prepare(
-            "INSERT INTO LAKHOUA.COMMANDS (COMMAND_ID, CLIENT_ID, COMMAND_DATE, TOTAL, PAYMENT_METHOD, DELIVERY_ADDRESS) "
-            "VALUES (:commandId, :clientId, TO_DATE(:commandDate, 'YYYY-MM-DD HH24:MI:SS'), :total, :paymentMethod, :deliveryAddress)"
+            "INSERT INTO COMMANDS (COMMAND_ID, CLIENT_ID, COMMAND_DATE, TOTAL, PAYMENT_METHOD, DELIVERY_ADDRESS) "
+            "VALUES (:commandId, :clientId, :commandDate, :totalCents / 100.0, :paymentMethod, :deliveryAddress)"
             );
 
-        query.bindValue(":commandId", newId);
+        query.bindValue(":commandId", newId > 0 ? QVariant(newId) : QVariant());
         query.bindValue(":clientId", command.clientId);
-        query.bindValue(":commandDate", command.commandDate.toString("yyyy-MM-dd hh:mm:ss"));
-        query.bindValue(":total", command.total);
+        query.bindValue(":commandDate", command.commandDate());
+        // Bound as whole cents and scaled in SQL, so no binary fraction is involved
+        query.bindValue(":totalCents", command.total.toCents());
         query.bindValue(":paymentMethod", command.paymentMethod);
         query.bindValue(":deliveryAddress", command.deliveryAddress);
 
-        if (!query.exec()) {
+        if (!TRACE_EXEC(query)) {
             throw std::runtime_error("Insert failed: " + query.lastError().text().toStdString());
         }
-
-        if (!db.commit()) {
-            throw std::runtime_error("Commit failed");
+        if (newId <= 0) {
+            newId = query.lastInsertId().toInt();
         }
 
         Command newCommand = command;
         newCommand.commandId = newId;
-        emit commandCreated(newCommand);
-        refreshTableModel();
+
+        // Rollups change in the same transaction as the row; on the replica
+        // the sync applies them when it pushes the row
+        if (!LocalReplica::isReplica(db) && !rollup.addCommand(newCommand, rollupError)) {
+            throw std::runtime_error(rollupError.toStdString());
+        }
+        if (!LocalReplica::recordChange(db, "COMMANDS", newId, false, rollupError)) {
+            throw std::runtime_error(rollupError.toStdString());
+        }
+
+        write.finish();
+
+        if (newCommandId) {
+            *newCommandId = newId;
+        }
+        QPointer<CommandDAO> self(this);
+        UnitOfWork::defer([self, newCommand]() {
+            if (self) emit self->commandCreated(newCommand);
+        });
+        UnitOfWork::deferRefresh(this);
         return true;
 
     } catch (const std::exception& e) {
-        db.rollback();
-        emit errorOccurred(QString::fromStdString(e.what()));
+        QString error = QString::fromStdString(e.what());
+        write.fail(error);
+        emit errorOccurred(error);
         return false;
     }
 }
 
 Command CommandDAO::readCommand(int commandId) {
+    TRACE_SCOPE("dao", "CommandDAO::readCommand");
     Connection& conn = Connection::getInstance();
-    if (!conn.isConnected()) {
+    if (!conn.isDataConnected()) {
         qDebug() << "Database not connected in readCommand";
         return Command();
     }
 
-    QSqlDatabase db = conn.getDatabase();
+    QSqlDatabase db = conn.getDataDatabase();
     QSqlQuery query(db);  // Specify the database for the query
 
-    query.prepare("SELECT COMMAND_ID, CLIENT_ID, TO_CHAR(COMMAND_DATE, 'YYYY-MM-DD HH24:MI:SS') as COMMAND_DATE, "
+    query.prepare("SELECT COMMAND_ID, CLIENT_ID, COMMAND_DATE, "
                   "TOTAL, PAYMENT_METHOD, DELIVERY_ADDRESS "
                   "FROM COMMANDS WHERE COMMAND_ID = :commandId");
     query.bindValue(":commandId", commandId);
 
-    if (!query.exec()) {
+    if (!TRACE_EXEC(query)) {
         logError("Read Command", query.lastError());
         return Command();
     }
 
     if (query.next()) {
-        Command command;
-        command.commandId = query.value("COMMAND_ID").toInt();
-        command.clientId = query.value("CLIENT_ID").toInt();
-
-        // Handle date parsing more robustly
-        QString dateString = query.value("COMMAND_DATE").toString();
-        QDateTime dateTime = QDateTime::fromString(dateString, "yyyy-MM-dd hh:mm:ss");
-        if (!dateTime.isValid()) {
-            qWarning() << "Invalid date format from database:" << dateString;
-            dateTime = QDateTime::currentDateTime();
-        }
-        command.commandDate = dateTime;
-
-        command.total = query.value("TOTAL").toString();
-        command.paymentMethod = query.value("PAYMENT_METHOD").toString();
-        command.deliveryAddress = query.value("DELIVERY_ADDRESS").toString();
-        return command;
+        return createCommandFromQuery(query);
     }
 
     return Command();
 }
 
 QList<Command> CommandDAO::readAllCommands() {
+    TRACE_SCOPE("dao", "CommandDAO::readAllCommands");
     QList<Command> commands;
 
     // Get the database connection and ensure it's connected
     Connection& conn = Connection::getInstance();
-    if (!conn.ensureConnected()) {
+    if (!conn.ensureDataConnection()) {
         qDebug() << "Database not connected in readAllCommands";
         return commands;
     }
 
     // Get the database instance using the connection name
-    QSqlDatabase db = conn.getDatabase();
+    QSqlDatabase db = conn.getDataDatabase();
     QSqlQuery query(db);
 
-    // Use explicit column names and proper Oracle date formatting
-    QString queryString = "SELECT COMMAND_ID, CLIENT_ID, "
-                          "TO_CHAR(COMMAND_DATE, 'YYYY-MM-DD HH24:MI:SS') as COMMAND_DATE_STR, "
+    // Dates come back as native timestamps, see createCommandFromQuery()
+    QString queryString = "SELECT COMMAND_ID, CLIENT_ID, COMMAND_DATE, "
                           "TOTAL, PAYMENT_METHOD, DELIVERY_ADDRESS "
                           "FROM COMMANDS "
                           "ORDER BY COMMAND_DATE DESC";
 
-    if (!query.exec(queryString)) {
+    // Forward-only avoids caching every row in the driver
+    query.setForwardOnly(true);
+
+    if (!TRACE_EXEC_SQL(query, queryString)) {
         qDebug() << "Failed to execute query:" << query.lastError().text();
         qDebug() << "Database open status:" << db.isOpen();
         qDebug() << "Database valid status:" << db.isValid();
-        qDebug() << "Connection status:" << conn.isConnected();
+        qDebug() << "Connection status:" << conn.isDataConnected();
         return commands;
     }
 
-    while (query.next()) {
-        Command cmd;
-        cmd.commandId = query.value("COMMAND_ID").toInt();
-        cmd.clientId = query.value("CLIENT_ID").toInt();
-
-        // Parse the Oracle date string
-        QString dateStr = query.value("COMMAND_DATE_STR").toString();
-        cmd.commandDate = QDateTime::fromString(dateStr, "yyyy-MM-dd hh:mm:ss");
-        if (!cmd.commandDate.isValid()) {
-            qDebug() << "Invalid date format:" << dateStr;
-            cmd.commandDate = QDateTime::currentDateTime();
-        }
-
-        cmd.total = query.value("TOTAL").toString();
-        cmd.paymentMethod = query.value("PAYMENT_METHOD").toString();
-        cmd.deliveryAddress = query.value("DELIVERY_ADDRESS").toString();
+    if (query.size() > 0) {
+        commands.reserve(query.size());
+    }
 
-        commands.append(cmd);
+    while (query.next()) {
+        commands.append(createCommandFromQuery(query));
     }
 
     qDebug() << "Retrieved" << commands.size() << "commands from database";
@@ -202,23 +205,16 @@ QList<Command> CommandDAO::readAllCommands() {
 
 QList<Command> CommandDAO::readCommandsByClient(int clientId)
 {
-    QList<Command> commands;
-    QSqlQuery query;
-    query.prepare("SELECT COMMAND_ID, CLIENT_ID, COMMAND_DATE, TOTAL, PAYMENT_METHOD, DELIVERY_ADDRESS "
-                  "FROM COMMANDS WHERE CLIENT_ID = ? ORDER BY COMMAND_DATE DESC");
-    query.addBindValue(clientId);
-
-    if (executeQuery(query, "Read Commands By Client")) {
-        while (query.next()) {
-            commands.append(createCommandFromQuery(query));
-        }
-    }
-
-    return commands;
+    TRACE_SCOPE("dao", "CommandDAO::readCommandsByClient");
+    return cachedCommands("Read Commands By Client",
+                          "SELECT COMMAND_ID, CLIENT_ID, COMMAND_DATE, TOTAL, PAYMENT_METHOD, DELIVERY_ADDRESS "
+                          "FROM COMMANDS WHERE CLIENT_ID = ? ORDER BY COMMAND_DATE DESC",
+                          {clientId});
 }
 
 bool CommandDAO::updateCommand(const Command& command)
 {
+    TRACE_SCOPE("dao", "CommandDAO::updateCommand");
     if (!command.isValid() || command.commandId <= 0) {
         emit errorOccurred("Invalid command data for update");
         return false;
@@ -229,139 +225,178 @@ bool CommandDAO::updateCommand(const Command& command)
         return false;
     }
 
-    QSqlQuery query;
-    query.prepare("UPDATE COMMANDS SET "
-                  "CLIENT_ID = :clientId, "
-                  "COMMAND_DATE = TO_DATE(:commandDate, 'YYYY-MM-DD HH24:MI:SS'), "
-                  "TOTAL = :total, "
-                  "PAYMENT_METHOD = :paymentMethod, "
-                  "DELIVERY_ADDRESS = :deliveryAddress "
-                  "WHERE COMMAND_ID = :commandId");
-
-    query.bindValue(":clientId", command.clientId);
-    query.bindValue(":commandDate", command.commandDate.toString("yyyy-MM-dd hh:mm:ss"));
-    query.bindValue(":total", command.total);
-    query.bindValue(":paymentMethod", command.paymentMethod);
-    query.bindValue(":deliveryAddress", command.deliveryAddress);
-    query.bindValue(":commandId", command.commandId);
-
-    if (!query.exec()) {
-        logError("Update Command", query.lastError());
+    Connection& conn = Connection::getInstance();
+    if (!conn.ensureDataConnection()) {
+        emit errorOccurred("Database connection error");
         return false;
     }
 
-    refreshTableModel();
-    emit commandUpdated(command);
+    QSqlDatabase db = conn.getDataDatabase();
+    UnitOfWork::Write write(db, "COMMANDS");
+
+    try {
+        write.begin();
+
+        SalesRollup rollup(db);
+        QString rollupError;
+        if (!LocalReplica::isReplica(db) && !rollup.lockState(rollupError)) {
+            throw std::runtime_error(rollupError.toStdString());
+        }
+
+        Command previous = readCommand(command.commandId);
+
+        QSqlQuery query(db);
+        query.prepare("UPDATE COMMANDS SET "
+                      "CLIENT_ID = :clientId, "
+                      "COMMAND_DATE = :commandDate, "
+                      "TOTAL = :totalCents / 100.0, "
+                      "PAYMENT_METHOD = :paymentMethod, "
+                      "DELIVERY_ADDRESS = :deliveryAddress "
+                      "WHERE COMMAND_ID = :commandId");
+
+        query.bindValue(":clientId", command.clientId);
+        query.bindValue(":commandDate", command.commandDate());
+        query.bindValue(":totalCents", command.total.toCents());
+        query.bindValue(":paymentMethod", command.paymentMethod);
+        query.bindValue(":deliveryAddress", command.deliveryAddress);
+        query.bindValue(":commandId", command.commandId);
+
+        if (!TRACE_EXEC(query)) {
+            throw std::runtime_error("Update Command failed: " + query.lastError().text().toStdString());
+        }
+
+        if (!LocalReplica::isReplica(db)
+            && ((previous.commandId > 0 && !rollup.removeCommand(previous, rollupError))
+                || !rollup.addCommand(command, rollupError))) {
+            throw std::runtime_error(rollupError.toStdString());
+        }
+        if (!LocalReplica::recordChange(db, "COMMANDS", command.commandId, false, rollupError)) {
+            throw std::runtime_error(rollupError.toStdString());
+        }
+
+        write.finish();
+
+    } catch (const std::exception& e) {
+        QString error = QString::fromStdString(e.what());
+        write.fail(error);
+        emit errorOccurred(error);
+        return false;
+    }
+
+    UnitOfWork::deferRefresh(this);
+    QPointer<CommandDAO> self(this);
+    UnitOfWork::defer([self, command]() {
+        if (self) emit self->commandUpdated(command);
+    });
     return true;
 }
 
 bool CommandDAO::deleteCommand(int commandId) {
+    TRACE_SCOPE("dao", "CommandDAO::deleteCommand");
     Connection& conn = Connection::getInstance();
-    if (!conn.ensureConnected()) {
+    if (!conn.ensureDataConnection()) {
         qDebug() << "Database connection failed in deleteCommand";
         emit errorOccurred("Database connection error");
         return false;
     }
 
-    QSqlDatabase db = conn.getDatabase();
-    QSqlQuery query(db);
+    QSqlDatabase db = conn.getDataDatabase();
+    UnitOfWork::Write write(db, "COMMANDS");
 
-    query.prepare("DELETE FROM COMMANDS WHERE COMMAND_ID = :commandId");
-    query.bindValue(":commandId", commandId);
+    try {
+        write.begin();
 
-    if (!query.exec()) {
-        qDebug() << "Delete failed:" << query.lastError().text();
-        emit errorOccurred(QString("Delete failed: %1").arg(query.lastError().text()));
-        return false;
-    }
+        SalesRollup rollup(db);
+        QString rollupError;
+        if (!LocalReplica::isReplica(db) && !rollup.lockState(rollupError)) {
+            throw std::runtime_error(rollupError.toStdString());
+        }
+
+        // Taken out of the rollups first, while its rolled-up city can still be read
+        Command previous = readCommand(commandId);
+        if (!LocalReplica::isReplica(db) && previous.commandId > 0
+            && !rollup.removeCommand(previous, rollupError)) {
+            throw std::runtime_error(rollupError.toStdString());
+        }
+
+        QSqlQuery query(db);
+        query.prepare("DELETE FROM COMMANDS WHERE COMMAND_ID = :commandId");
+        query.bindValue(":commandId", commandId);
+
+        if (!TRACE_EXEC(query)) {
+            throw std::runtime_error("Delete failed: " + query.lastError().text().toStdString());
+        }
+
+        // Check if any row was actually deleted
+        if (query.numRowsAffected() == 0) {
+            throw std::runtime_error(QString("No command found with ID: %1").arg(commandId).toStdString());
+        }
+
+        if (!LocalReplica::recordChange(db, "COMMANDS", commandId, true, rollupError)) {
+            throw std::runtime_error(rollupError.toStdString());
+        }
 
-    // Check if any row was actually deleted
-    if (query.numRowsAffected() == 0) {
-        qDebug() << "No command found with ID:" << commandId;
-        emit errorOccurred(QString("No command found with ID: %1").arg(commandId));
+        write.finish();
+
+    } catch (const std::exception& e) {
+        QString error = QString::fromStdString(e.what());
+        write.fail(error);
+        emit errorOccurred(error);
         return false;
     }
 
-    refreshTableModel();
-    emit commandDeleted(commandId);
+    UnitOfWork::deferRefresh(this);
+    QPointer<CommandDAO> self(this);
+    UnitOfWork::defer([self, commandId]() {
+        if (self) emit self->commandDeleted(commandId);
+    });
     return true;
 }
 
 QList<Command> CommandDAO::searchCommandsByDate(const QDate& startDate, const QDate& endDate)
 {
-    QList<Command> commands;
-    QSqlQuery query;
-    query.prepare("SELECT COMMAND_ID, CLIENT_ID, COMMAND_DATE, TOTAL, PAYMENT_METHOD, DELIVERY_ADDRESS "
-                  "FROM COMMANDS WHERE DATE(COMMAND_DATE) BETWEEN ? AND ? ORDER BY COMMAND_DATE DESC");
-    query.addBindValue(startDate);
-    query.addBindValue(endDate);
-
-    if (executeQuery(query, "Search Commands By Date")) {
-        while (query.next()) {
-            commands.append(createCommandFromQuery(query));
-        }
-    }
-
-    return commands;
+    TRACE_SCOPE("dao", "CommandDAO::searchCommandsByDate");
+    // Half-open range on the bare column so COMMANDS_DATE_IDX can be used
+    return cachedCommands("Search Commands By Date",
+                          "SELECT COMMAND_ID, CLIENT_ID, COMMAND_DATE, TOTAL, PAYMENT_METHOD, DELIVERY_ADDRESS "
+                          "FROM COMMANDS WHERE COMMAND_DATE >= ? AND COMMAND_DATE < ? ORDER BY COMMAND_DATE DESC",
+                          {startDate.startOfDay(), endDate.addDays(1).startOfDay()});
 }
 
 QList<Command> CommandDAO::searchCommandsByPaymentMethod(const QString& paymentMethod)
 {
-    QList<Command> commands;
-    QSqlQuery query;
-    query.prepare("SELECT COMMAND_ID, CLIENT_ID, COMMAND_DATE, TOTAL, PAYMENT_METHOD, DELIVERY_ADDRESS "
-                  "FROM COMMANDS WHERE UPPER(PAYMENT_METHOD) LIKE UPPER(?) ORDER BY COMMAND_DATE DESC");
-    query.addBindValue("%" + paymentMethod + "%");
-
-    if (executeQuery(query, "Search Commands By Payment Method")) {
-        while (query.next()) {
-            commands.append(createCommandFromQuery(query));
-        }
-    }
-
-    return commands;
+    TRACE_SCOPE("dao", "CommandDAO::searchCommandsByPaymentMethod");
+    return cachedCommands("Search Commands By Payment Method",
+                          "SELECT COMMAND_ID, CLIENT_ID, COMMAND_DATE, TOTAL, PAYMENT_METHOD, DELIVERY_ADDRESS "
+                          "FROM COMMANDS WHERE UPPER(PAYMENT_METHOD) LIKE UPPER(?) ORDER BY COMMAND_DATE DESC",
+                          {"%" + paymentMethod + "%"});
 }
 
-QList<Command> CommandDAO::searchCommandsByTotalRange(double minTotal, double maxTotal)
+QList<Command> CommandDAO::searchCommandsByTotalRange(const Money& minTotal, const Money& maxTotal)
 {
-    QList<Command> commands;
-    QSqlQuery query;
-    query.prepare("SELECT COMMAND_ID, CLIENT_ID, COMMAND_DATE, TOTAL, PAYMENT_METHOD, DELIVERY_ADDRESS "
-                  "FROM COMMANDS WHERE CAST(TOTAL AS DECIMAL) BETWEEN ? AND ? ORDER BY TOTAL DESC");
-    query.addBindValue(minTotal);
-    query.addBindValue(maxTotal);
-
-    if (executeQuery(query, "Search Commands By Total Range")) {
-        while (query.next()) {
-            commands.append(createCommandFromQuery(query));
-        }
-    }
-
-    return commands;
+    TRACE_SCOPE("dao", "CommandDAO::searchCommandsByTotalRange");
+    // Plain comparison on the NUMBER column so COMMANDS_TOTAL_IDX can be used
+    return cachedCommands("Search Commands By Total Range",
+                          "SELECT COMMAND_ID, CLIENT_ID, COMMAND_DATE, TOTAL, PAYMENT_METHOD, DELIVERY_ADDRESS "
+                          "FROM COMMANDS WHERE TOTAL BETWEEN ? / 100.0 AND ? / 100.0 ORDER BY TOTAL DESC",
+                          {minTotal.toCents(), maxTotal.toCents()});
 }
 
 QList<Command> CommandDAO::searchCommandsByClient(const QString& clientName)
 {
-    QList<Command> commands;
-    QSqlQuery query;
-    query.prepare("SELECT c.COMMAND_ID, c.CLIENT_ID, c.COMMAND_DATE, c.TOTAL, c.PAYMENT_METHOD, c.DELIVERY_ADDRESS, "
-                  "cl.NAME, cl.EMAIL FROM COMMANDS c "
-                  "JOIN CLIENTS cl ON c.CLIENT_ID = cl.ID "
-                  "WHERE UPPER(cl.NAME) LIKE UPPER(?) ORDER BY c.COMMAND_DATE DESC");
-    query.addBindValue("%" + clientName + "%");
-
-    if (executeQuery(query, "Search Commands By Client")) {
-        while (query.next()) {
-            commands.append(createCommandFromQuery(query, true));
-        }
-    }
-
-    return commands;
+    TRACE_SCOPE("dao", "CommandDAO::searchCommandsByClient");
+    return cachedCommands("Search Commands By Client",
+                          "SELECT c.COMMAND_ID, c.CLIENT_ID, c.COMMAND_DATE, c.TOTAL, c.PAYMENT_METHOD, c.DELIVERY_ADDRESS, "
+                          "cl.NAME, cl.EMAIL FROM COMMANDS c "
+                          "JOIN CLIENTS cl ON c.CLIENT_ID = cl.ID "
+                          "WHERE UPPER(cl.NAME) LIKE UPPER(?) ORDER BY c.COMMAND_DATE DESC",
+                          {"%" + clientName + "%"}, true);
 }
 
 bool CommandDAO::commandExists(int commandId)
 {
-    QSqlQuery query;
+    TRACE_SCOPE("dao", "CommandDAO::commandExists");
+    QSqlQuery query = createConnectedQuery();
     query.prepare("SELECT COUNT(*) FROM COMMANDS WHERE COMMAND_ID = ?");
     query.addBindValue(commandId);
 
@@ -376,108 +411,140 @@ bool CommandDAO::commandExists(int commandId)
 
 int CommandDAO::getCommandCount()
 {
-    Connection& conn = Connection::getInstance();
-    if (!conn.ensureConnected()) {
-        qDebug() << "Database not connected in getCommandCount";
-        return 0;
-    }
-
-    QSqlDatabase db = conn.getDatabase();
-    QSqlQuery query(db);
+    TRACE_SCOPE("dao", "CommandDAO::getCommandCount");
+    const QString sql = "SELECT COUNT(*) FROM COMMANDS";
+    return QueryCache::instance().fetch<int>("Get Command Count", sql, {}, {"COMMANDS"}, [&](int& count) {
+        Connection& conn = Connection::getInstance();
+        if (!conn.ensureDataConnection()) {
+            qDebug() << "Database not connected in getCommandCount";
+            return false;
+        }
 
-    if (!query.exec("SELECT COUNT(*) FROM COMMANDS")) {
-        qDebug() << "Get Command Count failed:" << query.lastError().text();
-        return 0;
-    }
+        QSqlQuery query(conn.getDataDatabase());
+        if (!TRACE_EXEC_SQL(query, sql)) {
+            qDebug() << "Get Command Count failed:" << query.lastError().text();
+            return false;
+        }
 
-    if (query.next()) {
-        int count = query.value(0).toInt();
+        count = query.next() ? query.value(0).toInt() : 0;
         qDebug() << "Command count:" << count;
-        return count;
-    }
-
-    return 0;
+        return true;
+    });
 }
 
 int CommandDAO::getCommandCountByClient(int clientId)
 {
-    QSqlQuery query;
-    query.prepare("SELECT COUNT(*) FROM COMMANDS WHERE CLIENT_ID = ?");
-    query.addBindValue(clientId);
-
-    if (executeQuery(query, "Get Command Count By Client")) {
-        if (query.next()) {
-            return query.value(0).toInt();
-        }
-    }
-
-    return 0;
+    TRACE_SCOPE("dao", "CommandDAO::getCommandCountByClient");
+    const QString sql = "SELECT COUNT(*) FROM COMMANDS WHERE CLIENT_ID = ?";
+    return QueryCache::instance().fetch<int>("Get Command Count By Client", sql, {clientId}, {"COMMANDS"},
+        [&](int& count) {
+            QSqlQuery query = createConnectedQuery();
+            query.prepare(sql);
+            query.addBindValue(clientId);
+            if (!executeQuery(query, "Get Command Count By Client")) {
+                return false;
+            }
+            count = query.next() ? query.value(0).toInt() : 0;
+            return true;
+        });
 }
 
-double CommandDAO::getTotalSales()
+QHash<int, int> CommandDAO::getCommandCountsByClient()
 {
-    Connection& conn = Connection::getInstance();
-    if (!conn.ensureConnected()) {
-        qDebug() << "Database not connected in getTotalSales";
-        return 0.0;
-    }
-
-    QSqlDatabase db = conn.getDatabase();
-    QSqlQuery query(db);
+    TRACE_SCOPE("dao", "CommandDAO::getCommandCountsByClient");
+    QHash<int, int> counts;
+    QSqlQuery query = createConnectedQuery();
+    query.setForwardOnly(true);
+    query.prepare("SELECT CLIENT_ID, COUNT(*) FROM COMMANDS GROUP BY CLIENT_ID");
 
-    if (!query.exec("SELECT SUM(CAST(TOTAL AS DECIMAL)) FROM COMMANDS")) {
-        qDebug() << "Get Total Sales failed:" << query.lastError().text();
-        return 0.0;
-    }
-
-    if (query.next()) {
-        double total = query.value(0).toDouble();
-        qDebug() << "Total sales:" << total;
-        return total;
+    if (executeQuery(query, "Get Command Counts By Client")) {
+        while (query.next()) {
+            counts.insert(query.value(0).toInt(), query.value(1).toInt());
+        }
     }
 
-    return 0.0;
+    return counts;
 }
 
-double CommandDAO::getTotalSalesByClient(int clientId)
+Money CommandDAO::getTotalSales()
 {
-    QSqlQuery query;
-    query.prepare("SELECT SUM(CAST(TOTAL AS DECIMAL)) FROM COMMANDS WHERE CLIENT_ID = ?");
-    query.addBindValue(clientId);
+    TRACE_SCOPE("dao", "CommandDAO::getTotalSales");
+    const QString sql = "SELECT SUM(TOTAL) FROM COMMANDS";
+    return QueryCache::instance().fetch<Money>("Get Total Sales", sql, {}, {"COMMANDS"}, [&](Money& total) {
+        Connection& conn = Connection::getInstance();
+        if (!conn.ensureDataConnection()) {
+            qDebug() << "Database not connected in getTotalSales";
+            return false;
+        }
+
+        QSqlQuery query(conn.getDataDatabase());
+        // Fetch the sum as decimal text so no cents are lost on the way
+        query.setNumericalPrecisionPolicy(QSql::HighPrecision);
+
+        if (!TRACE_EXEC_SQL(query, sql)) {
+            qDebug() << "Get Total Sales failed:" << query.lastError().text();
+            return false;
+        }
 
-    if (executeQuery(query, "Get Total Sales By Client")) {
         if (query.next()) {
-            return query.value(0).toDouble();
+            total = Money::fromVariant(query.value(0));
         }
-    }
+        qDebug() << "Total sales:" << total.toString();
+        return true;
+    });
+}
 
-    return 0.0;
+Money CommandDAO::getTotalSalesByClient(int clientId)
+{
+    TRACE_SCOPE("dao", "CommandDAO::getTotalSalesByClient");
+    const QString sql = "SELECT SUM(TOTAL) FROM COMMANDS WHERE CLIENT_ID = ?";
+    return QueryCache::instance().fetch<Money>("Get Total Sales By Client", sql, {clientId}, {"COMMANDS"},
+        [&](Money& total) {
+            QSqlQuery query = createConnectedQuery();
+            query.setNumericalPrecisionPolicy(QSql::HighPrecision);
+            query.prepare(sql);
+            query.addBindValue(clientId);
+            if (!executeQuery(query, "Get Total Sales By Client")) {
+                return false;
+            }
+            if (query.next()) {
+                total = Money::fromVariant(query.value(0));
+            }
+            return true;
+        });
 }
 
 QStringList CommandDAO::getPaymentMethods()
 {
-    QStringList methods;
-    QSqlQuery query("SELECT DISTINCT PAYMENT_METHOD FROM COMMANDS WHERE PAYMENT_METHOD IS NOT NULL ORDER BY PAYMENT_METHOD");
-
-    if (executeQuery(query, "Get Payment Methods")) {
-        while (query.next()) {
-            QString method = query.value(0).toString();
-            if (!method.isEmpty()) {
-                methods.append(method);
+    TRACE_SCOPE("dao", "CommandDAO::getPaymentMethods");
+    const QString sql = "SELECT DISTINCT PAYMENT_METHOD FROM COMMANDS "
+                        "WHERE PAYMENT_METHOD IS NOT NULL ORDER BY PAYMENT_METHOD";
+    return QueryCache::instance().fetch<QStringList>("Get Payment Methods", sql, {}, {"COMMANDS"},
+        [&](QStringList& methods) {
+            QSqlQuery query = createConnectedQuery();
+            query.prepare(sql);
+            if (!executeQuery(query, "Get Payment Methods")) {
+                return false;
             }
-        }
-    }
-
-    return methods;
+            while (query.next()) {
+                QString method = query.value(0).toString();
+                if (!method.isEmpty()) {
+                    methods.append(method);
+                }
+            }
+            return true;
+        });
 }
 
 QList<Command> CommandDAO::getCommandsWithClientInfo()
 {
+    TRACE_SCOPE("dao", "CommandDAO::getCommandsWithClientInfo");
     QList<Command> commands;
-    QSqlQuery query("SELECT c.COMMAND_ID, c.CLIENT_ID, c.COMMAND_DATE, c.TOTAL, c.PAYMENT_METHOD, c.DELIVERY_ADDRESS, "
-                    "cl.NAME, cl.EMAIL FROM COMMANDS c "
-                    "LEFT JOIN CLIENTS cl ON c.CLIENT_ID = cl.ID "
-                    "ORDER BY c.COMMAND_DATE DESC");
+    QSqlQuery query = createConnectedQuery();
+    query.prepare("SELECT c.COMMAND_ID, c.CLIENT_ID, c.COMMAND_DATE, c.TOTAL, c.PAYMENT_METHOD, c.DELIVERY_ADDRESS, "
+                  "cl.NAME, cl.EMAIL FROM COMMANDS c "
+                  "LEFT JOIN CLIENTS cl ON c.CLIENT_ID = cl.ID "
+                  "ORDER BY c.COMMAND_DATE DESC");
 
     if (executeQuery(query, "Get Commands With Client Info")) {
         while (query.next()) {
@@ -490,7 +557,8 @@ QList<Command> CommandDAO::getCommandsWithClientInfo()
 
 Command CommandDAO::getCommandWithClientInfo(int commandId)
 {
-    QSqlQuery query;
+    TRACE_SCOPE("dao", "CommandDAO::getCommandWithClientInfo");
+    QSqlQuery query = createConnectedQuery();
     query.prepare("SELECT c.COMMAND_ID, c.CLIENT_ID, c.COMMAND_DATE, c.TOTAL, c.PAYMENT_METHOD, c.DELIVERY_ADDRESS, "
                   "cl.NAME, cl.EMAIL FROM COMMANDS c "
                   "LEFT JOIN CLIENTS cl ON c.CLIENT_ID = cl.ID "
@@ -508,11 +576,38 @@ Command CommandDAO::getCommandWithClientInfo(int commandId)
 
 QSqlTableModel* CommandDAO::getTableModel()
 {
+    TRACE_SCOPE("dao", "CommandDAO::getTableModel");
+    Connection& conn = Connection::getInstance();
+    if (!tableModel && conn.isDataConnected()) {
+        tableModel = new QSqlTableModel(this, conn.getDataDatabase());
+        tableModel->setTable("COMMANDS");
+        tableModel->setEditStrategy(QSqlTableModel::OnManualSubmit);
+
+        // Set column headers by name; migrations move and add columns
+        // (TOTAL is rebuilt as the last one)
+        const QStringList headers = {"COMMAND_ID", "CLIENT_ID", "COMMAND_DATE",
+                                     "TOTAL", "PAYMENT_METHOD", "DELIVERY_ADDRESS"};
+        for (const QString& header : headers) {
+            int column = tableModel->fieldIndex(header);
+            if (column >= 0) {
+                tableModel->setHeaderData(column, Qt::Horizontal, header);
+            }
+        }
+
+        // Load data
+        refreshTableModel();
+    }
     return tableModel;
 }
 
 QSqlTableModel* CommandDAO::getCommandsWithClientsModel()
 {
+    TRACE_SCOPE("dao", "CommandDAO::getCommandsWithClientsModel");
+    Connection& conn = Connection::getInstance();
+    if (!joinedModel && conn.isDataConnected()) {
+        joinedModel = new QSqlTableModel(this, conn.getDataDatabase());
+    }
+
     if (joinedModel) {
         // Since QSqlTableModel doesn't handle JOINs well, we'll use a custom approach
         // This is a simplified version - you might want to use QSqlQueryModel instead
@@ -526,6 +621,7 @@ QSqlTableModel* CommandDAO::getCommandsWithClientsModel()
 
 void CommandDAO::refreshTableModel()
 {
+    TRACE_SCOPE("dao", "CommandDAO::refreshTableModel");
     if (tableModel) {
         tableModel->select();
     }
@@ -537,9 +633,36 @@ void CommandDAO::onModelDataChanged()
     qDebug() << "Command table model data changed";
 }
 
+QList<Command> CommandDAO::cachedCommands(const QString& operation, const QString& sql,
+                                          const QVariantList& binds, bool includeClientInfo)
+{
+    // Joined reads depend on client names too
+    QStringList tables{"COMMANDS"};
+    if (includeClientInfo) {
+        tables << "CLIENTS";
+    }
+
+    return QueryCache::instance().fetch<QList<Command>>(operation, sql, binds, tables,
+        [&](QList<Command>& commands) {
+            QSqlQuery query = createConnectedQuery();
+            query.setForwardOnly(true);
+            query.prepare(sql);
+            for (const QVariant& value : binds) {
+                query.addBindValue(value);
+            }
+            if (!executeQuery(query, operation)) {
+                return false;
+            }
+            while (query.next()) {
+                commands.append(createCommandFromQuery(query, includeClientInfo));
+            }
+            return true;
+        });
+}
+
 bool CommandDAO::executeQuery(QSqlQuery& query, const QString& operation)
 {
-    if (!query.exec()) {
+    if (!TRACE_EXEC(query)) {
         logError(operation, query.lastError());
         return false;
     }
@@ -560,22 +683,14 @@ Command CommandDAO::createCommandFromQuery(const QSqlQuery& query, bool includeC
     command.commandId = query.value("COMMAND_ID").toInt();
     command.clientId = query.value("CLIENT_ID").toInt();
 
-    // FIXED: Replace deprecated type() call
+    // Native timestamp from the driver, or the fixed-format text fallback
     QVariant dateValue = query.value("COMMAND_DATE");
-
-    // Use typeId() instead of deprecated type()
-    if (dateValue.typeId() == QMetaType::QDateTime) {
-        command.commandDate = dateValue.toDateTime();
-    } else {
-        // Fallback for string dates
-        QString dateStr = dateValue.toString();
-        command.commandDate = QDateTime::fromString(dateStr, "yyyy-MM-dd hh:mm:ss");
-        if (!command.commandDate.isValid()) {
-            command.commandDate = QDateTime::currentDateTime();
-        }
+    if (!DateCodec::decode(dateValue, &command.commandDateMs)) {
+        qWarning() << "Invalid date from database:" << dateValue;
+        command.commandDateMs = QDateTime::currentMSecsSinceEpoch();
     }
 
-    command.total = query.value("TOTAL").toString();
+    command.total = Money::fromVariant(query.value("TOTAL"));
     command.paymentMethod = query.value("PAYMENT_METHOD").toString();
     command.deliveryAddress = query.value("DELIVERY_ADDRESS").toString();
 
@@ -591,9 +706,49 @@ Command CommandDAO::createCommandFromQuery(const QSqlQuery& query, bool includeC
     return command;
 }
 
+QList<Command> CommandDAO::readTopCommands(int limit)
+{
+    TRACE_SCOPE("dao", "CommandDAO::readTopCommands");
+    QList<Command> commands;
+    QSqlQuery query = createConnectedQuery();
+    // The query runs on the data database, which is the SQLite replica
+    // when one is attached, whatever the central database is
+    QString rowLimit = Connection::dialectOf(Connection::getInstance().getDataDatabase()) == Connection::OracleDialect
+                           ? QString("FETCH FIRST %1 ROWS ONLY").arg(limit)
+                           : QString("LIMIT %1").arg(limit);
+    query.prepare("SELECT COMMAND_ID, CLIENT_ID, COMMAND_DATE, TOTAL, PAYMENT_METHOD, DELIVERY_ADDRESS "
+                  "FROM COMMANDS ORDER BY TOTAL DESC, COMMAND_ID " + rowLimit);
+
+    if (executeQuery(query, "Read Top Commands")) {
+        while (query.next()) {
+            commands.append(createCommandFromQuery(query));
+        }
+    }
+    return commands;
+}
+
+QList<Command> CommandDAO::readCommandsByIds(const QList<int>& commandIds)
+{
+    TRACE_SCOPE("dao", "CommandDAO::readCommandsByIds");
+    if (commandIds.isEmpty()) {
+        return QList<Command>();
+    }
+
+    QStringList placeholders;
+    QVariantList binds;
+    for (int commandId : commandIds) {
+        placeholders << "?";
+        binds << commandId;
+    }
+    return cachedCommands("Read Commands By Ids",
+                          "SELECT COMMAND_ID, CLIENT_ID, COMMAND_DATE, TOTAL, PAYMENT_METHOD, DELIVERY_ADDRESS "
+                          "FROM COMMANDS WHERE COMMAND_ID IN (" + placeholders.join(", ") + ")",
+                          binds);
+}
+
 bool CommandDAO::validateClientExists(int clientId)
 {
-    QSqlQuery query;
+    QSqlQuery query = createConnectedQuery();
     query.prepare("SELECT COUNT(*) FROM CLIENTS WHERE ID = ?");
     query.addBindValue(clientId);
 
@@ -619,19 +774,45 @@ CommandManager::CommandManager(QObject *parent)
     connect(dao, &CommandDAO::errorOccurred, this, &CommandManager::validationError);
 }
 
-bool CommandManager::addNewCommand(const Command& command)
+bool CommandManager::addNewCommand(const Command& command, int* newCommandId)
 {
+    TRACE_SCOPE("manager", "CommandManager::addNewCommand");
     QString errorMessage;
     if (!validateCommand(command, errorMessage)) {
         emit validationError(errorMessage);
         return false;
     }
 
-    return dao->createCommand(command);
+    return dao->createCommand(command, newCommandId);
+}
+
+bool CommandManager::addNewCommands(const QList<Command>& commands)
+{
+    TRACE_SCOPE("manager", "CommandManager::addNewCommands");
+    // Check the whole batch before anything is written
+    QList<ValidationEngine::RowReport> rejected = ValidationEngine::instance().validateAll(commands);
+    if (!rejected.isEmpty()) {
+        emit validationError(QString("%1 of %2 orders rejected. %3")
+                                 .arg(rejected.size()).arg(commands.size())
+                                 .arg(ValidationEngine::describe(rejected.first())));
+        return false;
+    }
+
+    UnitOfWork unitOfWork;
+
+    for (const Command& command : commands) {
+        if (!dao->createCommand(command)) {
+            unitOfWork.rollback();
+            return false;
+        }
+    }
+
+    return unitOfWork.commit();
 }
 
 bool CommandManager::modifyCommand(const Command& command)
 {
+    TRACE_SCOPE("manager", "CommandManager::modifyCommand");
     QString errorMessage;
     if (!validateCommand(command, errorMessage)) {
         emit validationError(errorMessage);
@@ -648,6 +829,7 @@ bool CommandManager::modifyCommand(const Command& command)
 
 bool CommandManager::removeCommand(int commandId)
 {
+    TRACE_SCOPE("manager", "CommandManager::removeCommand");
     if (commandId <= 0) {
         qDebug() << "Invalid command ID:" << commandId;
         emit validationError("Invalid command ID");
@@ -662,31 +844,37 @@ bool CommandManager::removeCommand(int commandId)
 
 Command CommandManager::getCommand(int commandId)
 {
+    TRACE_SCOPE("manager", "CommandManager::getCommand");
     return dao->readCommand(commandId);
 }
 
 QList<Command> CommandManager::getAllCommands()
 {
+    TRACE_SCOPE("manager", "CommandManager::getAllCommands");
     return dao->readAllCommands();
 }
 
 QList<Command> CommandManager::getClientCommands(int clientId)
 {
+    TRACE_SCOPE("manager", "CommandManager::getClientCommands");
     return dao->readCommandsByClient(clientId);
 }
 
-double CommandManager::calculateClientTotal(int clientId)
+Money CommandManager::calculateClientTotal(int clientId)
 {
+    TRACE_SCOPE("manager", "CommandManager::calculateClientTotal");
     return dao->getTotalSalesByClient(clientId);
 }
 
 int CommandManager::getClientCommandCount(int clientId)
 {
+    TRACE_SCOPE("manager", "CommandManager::getClientCommandCount");
     return dao->getCommandCountByClient(clientId);
 }
 
 QList<Command> CommandManager::getRecentCommands(int days)
 {
+    TRACE_SCOPE("manager", "CommandManager::getRecentCommands");
     QDate startDate = QDate::currentDate().addDays(-days);
     QDate endDate = QDate::currentDate();
     return dao->searchCommandsByDate(startDate, endDate);
@@ -694,45 +882,36 @@ QList<Command> CommandManager::getRecentCommands(int days)
 
 QList<Command> CommandManager::getTopCommands(int limit)
 {
-    // Get all commands and sort by total
-    QList<Command> allCommands = dao->readAllCommands();
-
-    // Sort by total amount descending
-    std::sort(allCommands.begin(), allCommands.end(), [](const Command& a, const Command& b) {
-        return a.getTotalAmount() > b.getTotalAmount();
-    });
-
-    // Return top commands up to limit
-    if (allCommands.size() > limit) {
-        return allCommands.mid(0, limit);
+    TRACE_SCOPE("manager", "CommandManager::getTopCommands");
+    TopKLeaderboard* board = dao->getLeaderboard();
+    if (!board || !board->isReady()) {
+        return dao->readTopCommands(limit);
     }
 
-    return allCommands;
-}
-
-bool CommandManager::validateCommand(const Command& command, QString& errorMessage) {
-    if (command.clientId <= 0) {
-        errorMessage = "Invalid client ID";
-        return false;
+    // Only the k winning rows are read back, in one query
+    QList<int> ids;
+    for (const QPair<int, Money>& entry : board->topOrders(limit)) {
+        ids.append(entry.first);
     }
-
-    if (command.total.isEmpty() || !isValidTotal(command.total)) {
-        errorMessage = "Invalid total amount";
-        return false;
+    QHash<int, Command> byId;
+    for (const Command& command : dao->readCommandsByIds(ids)) {
+        byId.insert(command.commandId, command);
     }
 
-    if (command.paymentMethod.trimmed().isEmpty()) {
-        errorMessage = "Payment method cannot be empty";
-        return false;
-    }
-
-    if (command.deliveryAddress.trimmed().isEmpty()) {
-        errorMessage = "Delivery address cannot be empty";
-        return false;
+    QList<Command> commands;
+    for (int commandId : ids) {
+        auto it = byId.constFind(commandId);
+        if (it != byId.constEnd()) {
+            commands.append(it.value());
+        }
     }
+    return commands;
+}
 
-    if (!command.commandDate.isValid()) {
-        errorMessage = "Invalid command date";
+bool CommandManager::validateCommand(const Command& command, QString& errorMessage) {
+    QList<ValidationEngine::FieldError> errors = ValidationEngine::instance().validate(command);
+    if (!errors.isEmpty()) {
+        errorMessage = errors.first().message;
         return false;
     }
 
@@ -766,34 +945,25 @@ bool CommandManager::isValidTotal(const QString& total)
     }
 
     bool ok;
-    double amount = total.toDouble(&ok);
-    return ok && amount >= 0;
+    Money amount = Money::fromString(total, &ok);
+    return ok && !amount.isNegative();
 }
 
 bool CommandManager::isValidPaymentMethod(const QString& paymentMethod)
 {
-    QString trimmed = paymentMethod.trimmed();
-    if (trimmed.isEmpty()) {
-        return false;
-    }
-
-    QStringList validMethods = getValidPaymentMethods();
-    return validMethods.contains(trimmed, Qt::CaseInsensitive) || validMethods.isEmpty();
+    return ValidationEngine::instance().isValidPaymentMethod(paymentMethod);
 }
 
 QString CommandManager::sanitizeInput(const QString& input)
 {
-    QString sanitized = input.trimmed();
     // Remove potentially dangerous characters
-    sanitized.remove(QRegularExpression("[<>\"'%;()&+]"));
-    return sanitized;
+    return ValidationEngine::instance().stripUnsafe(input);
 }
 
 QStringList CommandManager::getValidPaymentMethods() const
 {
-    // Define valid payment methods - you can modify this list as needed
-    return QStringList() << "Cash" << "Credit Card" << "Debit Card" << "PayPal"
-                         << "Bank Transfer" << "Check" << "Mobile Payment";
+    // Defined once in the validation engine
+    return ValidationEngine::instance().paymentMethods();
 }
 
 // CommandStatistics Implementation
@@ -802,81 +972,120 @@ CommandStatistics::CommandStatistics(CommandDAO* dao, QObject *parent)
 {
 }
 
-CommandStatistics::Statistics CommandStatistics::getOverallStatistics()
+static QDate statisticsDate(const QVariant& value)
 {
-    Statistics stats;
-
-    stats.totalCommands = commandDAO->getCommandCount();
-    stats.totalSales = commandDAO->getTotalSales();
-
-    if (stats.totalCommands > 0) {
-        stats.averageOrderValue = stats.totalSales / stats.totalCommands;
-    } else {
-        stats.averageOrderValue = 0.0;
+    qint64 epochMs;
+    if (value.isNull() || !DateCodec::decode(value, &epochMs)) {
+        return QDate();
     }
+    return QDateTime::fromMSecsSinceEpoch(epochMs).date();
+}
 
-    // Get top client by total sales
-    auto topClients = getTopClientsByTotal(1);
-    if (!topClients.isEmpty()) {
-        stats.topClientId = topClients.first().first;
-
-        // Get client name
-        QSqlQuery query;
-        query.prepare("SELECT NAME FROM CLIENTS WHERE ID = ?");
-        query.addBindValue(stats.topClientId);
-        if (query.exec() && query.next()) {
-            stats.topClientName = query.value(0).toString();
-        }
-    }
+CommandStatistics::Statistics CommandStatistics::getOverallStatistics()
+{
+    TRACE_SCOPE("manager", "CommandStatistics::getOverallStatistics");
+    Statistics stats;
 
-    // Get most used payment method
-    auto paymentStats = getPaymentMethodStats();
-    if (!paymentStats.isEmpty()) {
-        auto it = std::max_element(paymentStats.begin(), paymentStats.end(),
-                                   [](const auto& a, const auto& b) { return a < b; });
-        stats.mostUsedPaymentMethod = it.key();
-    }
+    Connection& conn = Connection::getInstance();
+    if (!conn.ensureDataConnection()) {
+        return stats;
+    }
+
+    // Every figure in one round trip; the CTEs each scan COMMANDS once
+    QSqlDatabase db = conn.getDataDatabase();
+    QString firstRow = Connection::dialectOf(db) == Connection::OracleDialect
+                           ? "FETCH FIRST 1 ROWS ONLY"
+                           : "LIMIT 1";
+
+    // The leaderboard already ranks clients; the GROUP BY over COMMANDS is
+    // only the fallback until it has loaded
+    TopKLeaderboard* board = commandDAO ? commandDAO->getLeaderboard() : nullptr;
+    bool fromBoard = board && board->isReady();
+    QString topClient = fromBoard
+        ? QString("top_client AS ("
+                  "    SELECT ID AS CLIENT_ID FROM CLIENTS WHERE ID = ?), ")
+        : QString("top_client AS ("
+                  "    SELECT CLIENT_ID, SUM(TOTAL) AS SALES FROM COMMANDS "
+                  "    GROUP BY CLIENT_ID ORDER BY SALES DESC, CLIENT_ID %1), ").arg(firstRow);
 
-    // Get date range
-    QSqlQuery dateQuery("SELECT MIN(COMMAND_DATE), MAX(COMMAND_DATE) FROM COMMANDS");
-    if (dateQuery.exec() && dateQuery.next()) {
-        stats.firstOrderDate = dateQuery.value(0).toDate();
-        stats.lastOrderDate = dateQuery.value(1).toDate();
-    }
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.setNumericalPrecisionPolicy(QSql::HighPrecision);
+    query.prepare(QString(
+        "WITH totals AS ("
+        "    SELECT COUNT(*) AS ORDERS, SUM(TOTAL) AS SALES, "
+        "           MIN(COMMAND_DATE) AS FIRST_DATE, MAX(COMMAND_DATE) AS LAST_DATE "
+        "    FROM COMMANDS), "
+        "%1"
+        "top_payment AS ("
+        "    SELECT PAYMENT_METHOD, COUNT(*) AS USES FROM COMMANDS "
+        "    WHERE PAYMENT_METHOD IS NOT NULL "
+        "    GROUP BY PAYMENT_METHOD ORDER BY USES DESC, PAYMENT_METHOD %2) "
+        "SELECT t.ORDERS, t.SALES, t.FIRST_DATE, t.LAST_DATE, "
+        "       tc.CLIENT_ID, cl.NAME, tp.PAYMENT_METHOD, "
+        "       (SELECT COUNT(*) FROM CLIENTS) AS CLIENT_COUNT "
+        "FROM totals t "
+        "LEFT JOIN top_client tc ON 1 = 1 "
+        "LEFT JOIN CLIENTS cl ON cl.ID = tc.CLIENT_ID "
+        "LEFT JOIN top_payment tp ON 1 = 1").arg(topClient, firstRow));
+    if (fromBoard) {
+        QList<QPair<int, Money>> top = board->topClients(1);
+        query.addBindValue(top.isEmpty() ? 0 : top.first().first);
+    }
+
+    if (!TRACE_EXEC(query)) {
+        qDebug() << "Statistics query failed:" << query.lastError().text();
+        return stats;
+    }
+    if (!query.next()) {
+        return stats;
+    }
+
+    stats.totalCommands = query.value(0).toInt();
+    stats.totalSales = Money::fromVariant(query.value(1));
+    stats.averageOrderValue = stats.totalSales.dividedBy(stats.totalCommands);
+    stats.firstOrderDate = statisticsDate(query.value(2));
+    stats.lastOrderDate = statisticsDate(query.value(3));
+    stats.topClientId = query.value(4).toInt();
+    stats.topClientName = query.value(5).toString();
+    stats.mostUsedPaymentMethod = query.value(6).toString();
+    stats.totalClients = query.value(7).toInt();
+    stats.valid = true;
 
     return stats;
 }
 
 CommandStatistics::Statistics CommandStatistics::getClientStatistics(int clientId)
 {
+    TRACE_SCOPE("manager", "CommandStatistics::getClientStatistics");
     Statistics stats;
+    stats.topClientId = clientId;
 
-    stats.totalCommands = commandDAO->getCommandCountByClient(clientId);
-    stats.totalSales = commandDAO->getTotalSalesByClient(clientId);
-
-    if (stats.totalCommands > 0) {
-        stats.averageOrderValue = stats.totalSales / stats.totalCommands;
-    } else {
-        stats.averageOrderValue = 0.0;
+    Connection& conn = Connection::getInstance();
+    if (!conn.ensureDataConnection()) {
+        return stats;
     }
 
-    stats.topClientId = clientId;
-
-    // Get client name
-    QSqlQuery query;
-    query.prepare("SELECT NAME FROM CLIENTS WHERE ID = ?");
+    QSqlQuery query(conn.getDataDatabase());
+    query.setForwardOnly(true);
+    query.setNumericalPrecisionPolicy(QSql::HighPrecision);
+    query.prepare("SELECT COUNT(c.COMMAND_ID), SUM(c.TOTAL), "
+                  "MIN(c.COMMAND_DATE), MAX(c.COMMAND_DATE), cl.NAME "
+                  "FROM CLIENTS cl LEFT JOIN COMMANDS c ON c.CLIENT_ID = cl.ID "
+                  "WHERE cl.ID = ? GROUP BY cl.NAME");
     query.addBindValue(clientId);
-    if (query.exec() && query.next()) {
-        stats.topClientName = query.value(0).toString();
-    }
 
-    // Get date range for this client
-    QSqlQuery dateQuery;
-    dateQuery.prepare("SELECT MIN(COMMAND_DATE), MAX(COMMAND_DATE) FROM COMMANDS WHERE CLIENT_ID = ?");
-    dateQuery.addBindValue(clientId);
-    if (dateQuery.exec() && dateQuery.next()) {
-        stats.firstOrderDate = dateQuery.value(0).toDate();
-        stats.lastOrderDate = dateQuery.value(1).toDate();
+    if (!TRACE_EXEC(query)) {
+        qDebug() << "Client statistics query failed:" << query.lastError().text();
+        return stats;
+    }
+    if (query.next()) {
+        stats.totalCommands = query.value(0).toInt();
+        stats.totalSales = Money::fromVariant(query.value(1));
+        stats.averageOrderValue = stats.totalSales.dividedBy(stats.totalCommands);
+        stats.firstOrderDate = statisticsDate(query.value(2));
+        stats.lastOrderDate = statisticsDate(query.value(3));
+        stats.topClientName = query.value(4).toString();
     }
 
     return stats;
@@ -884,11 +1093,21 @@ CommandStatistics::Statistics CommandStatistics::getClientStatistics(int clientI
 
 QMap<QString, int> CommandStatistics::getPaymentMethodStats()
 {
+    TRACE_SCOPE("manager", "CommandStatistics::getPaymentMethodStats");
     QMap<QString, int> stats;
 
-    QSqlQuery query("SELECT PAYMENT_METHOD, COUNT(*) FROM COMMANDS "
-                    "WHERE PAYMENT_METHOD IS NOT NULL "
-                    "GROUP BY PAYMENT_METHOD");
+    Connection& conn = Connection::getInstance();
+    if (!conn.ensureDataConnection()) {
+        return stats;
+    }
+
+    QSqlQuery query(conn.getDataDatabase());
+    if (!TRACE_EXEC_SQL(query, "SELECT PAYMENT_METHOD, COUNT(*) FROM COMMANDS "
+                               "WHERE PAYMENT_METHOD IS NOT NULL "
+                               "GROUP BY PAYMENT_METHOD")) {
+        qDebug() << "Payment method statistics query failed:" << query.lastError().text();
+        return stats;
+    }
 
     while (query.next()) {
         QString method = query.value(0).toString();
@@ -899,47 +1118,48 @@ QMap<QString, int> CommandStatistics::getPaymentMethodStats()
     return stats;
 }
 
-QMap<QDate, double> CommandStatistics::getDailySales(const QDate& startDate, const QDate& endDate)
+QMap<QDate, Money> CommandStatistics::getDailySales(const QDate& startDate, const QDate& endDate)
 {
-    QMap<QDate, double> sales;
+    TRACE_SCOPE("manager", "CommandStatistics::getDailySales");
+    // Rolled-up days plus the raw rows after the rollup boundary
+    SalesRollup rollup(Connection::getInstance().getDataDatabase());
+    return rollup.totals(SalesRollup::Daily, startDate, endDate);
+}
 
-    QSqlQuery query;
-    query.prepare("SELECT DATE(COMMAND_DATE), SUM(CAST(TOTAL AS DECIMAL)) "
-                  "FROM COMMANDS "
-                  "WHERE DATE(COMMAND_DATE) BETWEEN ? AND ? "
-                  "GROUP BY DATE(COMMAND_DATE) "
-                  "ORDER BY DATE(COMMAND_DATE)");
-    query.addBindValue(startDate);
-    query.addBindValue(endDate);
+QMap<QDate, Money> CommandStatistics::getMonthlySales(const QDate& startDate, const QDate& endDate)
+{
+    TRACE_SCOPE("manager", "CommandStatistics::getMonthlySales");
+    SalesRollup rollup(Connection::getInstance().getDataDatabase());
+    return rollup.totals(SalesRollup::Monthly, startDate, endDate);
+}
 
-    if (query.exec()) {
-        while (query.next()) {
-            QDate date = query.value(0).toDate();
-            double total = query.value(1).toDouble();
-            sales[date] = total;
-        }
+QList<QPair<int, Money>> CommandStatistics::getTopClientsByTotal(int limit)
+{
+    TRACE_SCOPE("manager", "CommandStatistics::getTopClientsByTotal");
+    TopKLeaderboard* board = commandDAO->getLeaderboard();
+    if (board && board->isReady()) {
+        return board->topClients(limit);
     }
 
-    return sales;
-}
+    QList<QPair<int, Money>> topClients;
 
-QList<QPair<int, double>> CommandStatistics::getTopClientsByTotal(int limit)
-{
-    QList<QPair<int, double>> topClients;
+    // Oracle has no LIMIT; FETCH FIRST needs 12c or later
+    QSqlDatabase db = Connection::getInstance().getDataDatabase();
+    QString rowLimit = Connection::dialectOf(db) == Connection::OracleDialect
+                           ? QString("FETCH FIRST %1 ROWS ONLY").arg(limit)
+                           : QString("LIMIT %1").arg(limit);
 
-    QSqlQuery query;
-    query.prepare("SELECT CLIENT_ID, SUM(CAST(TOTAL AS DECIMAL)) as TOTAL_SALES "
+    QSqlQuery query(db);
+    query.setNumericalPrecisionPolicy(QSql::HighPrecision);
+    query.prepare("SELECT CLIENT_ID, SUM(TOTAL) AS TOTAL_SALES "
                   "FROM COMMANDS "
                   "GROUP BY CLIENT_ID "
-                  "ORDER BY TOTAL_SALES DESC "
-                  "LIMIT ?");
-    query.addBindValue(limit);
+                  "ORDER BY TOTAL_SALES DESC, CLIENT_ID " + rowLimit);
 
-    if (query.exec()) {
+    if (TRACE_EXEC(query)) {
         while (query.next()) {
             int clientId = query.value(0).toInt();
-            double totalSales = query.value(1).toDouble();
-            topClients.append(qMakePair(clientId, totalSales));
+            topClients.append(qMakePair(clientId, Money::fromVariant(query.value(1))));
         }
     }
 
@@ -948,11 +1168,11 @@ QList<QPair<int, double>> CommandStatistics::getTopClientsByTotal(int limit)
 QSqlQuery CommandDAO::createConnectedQuery()
 {
     Connection& conn = Connection::getInstance();
-    if (!conn.ensureConnected()) {
+    if (!conn.ensureDataConnection()) {
         qDebug() << "Database connection failed";
         return QSqlQuery();
     }
-    return QSqlQuery(conn.getDatabase());
+    return QSqlQuery(conn.getDataDatabase());
 }
 
 
@@ -5,23 +5,30 @@
 #include <QObject>
 #include <QString>
 #include <QList>
+#include <QHash>
 #include <QDateTime>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QSqlRecord>  // Add this include
 #include <QSqlTableModel>
 #include <QDebug>
-#include <QMessageBox>
 #include <QMap>
 #include <QPair>
 #include <QDate>
+#include <QPointer>
+#include <limits>
+
+#include "money.h"
 
 // Command data structure
 struct Command {
+    // Sentinel for a command without a date
+    static constexpr qint64 NoDate = std::numeric_limits<qint64>::min();
+
     int commandId;
     int clientId;
-    QDateTime commandDate;
-    QString total;
+    qint64 commandDateMs;   // Milliseconds since epoch, use commandDate() to display
+    Money total;
     QString paymentMethod;
     QString deliveryAddress;
 
@@ -29,46 +36,58 @@ struct Command {
     QString clientName;  // For joining with clients table
     QString clientEmail; // For display purposes
 
-    // Default constructor
-    Command() : commandId(0), clientId(0), commandDate(QDateTime::currentDateTime()) {}
+    // Default constructor (no date; rows read from the database always set one)
+    Command() : commandId(0), clientId(0), commandDateMs(NoDate) {}
 
     // Constructor with parameters
     Command(int commandId, int clientId, const QDateTime& commandDate,
-            const QString& total, const QString& paymentMethod, const QString& deliveryAddress)
-        : commandId(commandId), clientId(clientId), commandDate(commandDate),
-        total(total), paymentMethod(paymentMethod), deliveryAddress(deliveryAddress) {}
+            const Money& total, const QString& paymentMethod, const QString& deliveryAddress)
+        : commandId(commandId), clientId(clientId), commandDateMs(NoDate),
+        total(total), paymentMethod(paymentMethod), deliveryAddress(deliveryAddress) {
+        setCommandDate(commandDate);
+    }
 
     // Constructor without command ID (for new commands)
-    Command(int clientId, const QString& total, const QString& paymentMethod,
+    Command(int clientId, const Money& total, const QString& paymentMethod,
             const QString& deliveryAddress)
-        : commandId(0), clientId(clientId), commandDate(QDateTime::currentDateTime()),
+        : commandId(0), clientId(clientId), commandDateMs(QDateTime::currentMSecsSinceEpoch()),
         total(total), paymentMethod(paymentMethod), deliveryAddress(deliveryAddress) {}
 
+    // Date accessors; the QDateTime is only built when it is shown or bound
+    bool hasCommandDate() const { return commandDateMs != NoDate; }
+    QDateTime commandDate() const {
+        return hasCommandDate() ? QDateTime::fromMSecsSinceEpoch(commandDateMs) : QDateTime();
+    }
+    void setCommandDate(const QDateTime& date) {
+        commandDateMs = date.isValid() ? date.toMSecsSinceEpoch() : NoDate;
+    }
+
     // Check if command is valid
     bool isValid() const {
-        return clientId > 0 && !total.isEmpty() && commandDate.isValid();
+        return clientId > 0 && !total.isNegative() && hasCommandDate();
     }
 
-    // Get total as double
+    // Get total as double (display only, use total for arithmetic)
     double getTotalAmount() const {
         return total.toDouble();
     }
 
     // Set total from double
     void setTotalAmount(double amount) {
-        total = QString::number(amount, 'f', 2);
+        total = Money::fromDouble(amount);
     }
 
     // Convert to string for debugging
     QString toString() const {
         return QString("Command[ID: %1, ClientID: %2, Date: %3, Total: %4, Payment: %5, Address: %6]")
-        .arg(commandId).arg(clientId).arg(commandDate.toString("yyyy-MM-dd hh:mm:ss"))
-            .arg(total).arg(paymentMethod).arg(deliveryAddress);
+        .arg(commandId).arg(clientId).arg(commandDate().toString("yyyy-MM-dd hh:mm:ss"))
+            .arg(total.toString()).arg(paymentMethod).arg(deliveryAddress);
     }
 };
 
 // Forward declaration
 class CommandManager;
+class TopKLeaderboard;
 
 // Command DAO (Data Access Object) class
 class CommandDAO : public QObject
@@ -80,7 +99,7 @@ public:
     ~CommandDAO();
 
     // CRUD Operations
-    bool createCommand(const Command& command);
+    bool createCommand(const Command& command, int* newCommandId = nullptr);
     Command readCommand(int commandId);
     QList<Command> readAllCommands();
     QList<Command> readCommandsByClient(int clientId);
@@ -90,23 +109,32 @@ public:
     // Search operations
     QList<Command> searchCommandsByDate(const QDate& startDate, const QDate& endDate);
     QList<Command> searchCommandsByPaymentMethod(const QString& paymentMethod);
-    QList<Command> searchCommandsByTotalRange(double minTotal, double maxTotal);
+    QList<Command> searchCommandsByTotalRange(const Money& minTotal, const Money& maxTotal);
     QList<Command> searchCommandsByClient(const QString& clientName);
 
     // Utility methods
     bool commandExists(int commandId);
     int getCommandCount();
     int getCommandCountByClient(int clientId);
-    double getTotalSales();
-    double getTotalSalesByClient(int clientId);
+    QHash<int, int> getCommandCountsByClient(); // Client id -> number of orders
+    Money getTotalSales();
+    Money getTotalSalesByClient(int clientId);
     QStringList getPaymentMethods();
     bool validateClientExists(int clientId); // Make this public
 
+    // Largest orders first, straight from COMMANDS_TOTAL_IDX
+    QList<Command> readTopCommands(int limit);
+    QList<Command> readCommandsByIds(const QList<int>& commandIds);   // In no particular order
+
+    // Top-k reads are answered from the leaderboard once it is loaded
+    void setLeaderboard(TopKLeaderboard* board) { leaderboard = board; }
+    TopKLeaderboard* getLeaderboard() const { return leaderboard; }
+
     // Get commands with client information (JOIN query)
     QList<Command> getCommandsWithClientInfo();
     Command getCommandWithClientInfo(int commandId);
 
-    // Table model for Qt views
+    // Table models for Qt views (created and loaded on first call)
     QSqlTableModel* getTableModel();
     QSqlTableModel* getCommandsWithClientsModel();
     void refreshTableModel();
@@ -123,10 +151,14 @@ private slots:
 private:
     QSqlTableModel* tableModel;
     QSqlTableModel* joinedModel;
+    QPointer<TopKLeaderboard> leaderboard;
     QSqlQuery createConnectedQuery();
 
     // Helper methods
     bool executeQuery(QSqlQuery& query, const QString& operation);
+    // Prepared read of full rows through the query cache, binds in '?' order
+    QList<Command> cachedCommands(const QString& operation, const QString& sql,
+                                  const QVariantList& binds, bool includeClientInfo = false);
     void logError(const QString& operation, const QSqlError& error);
     Command createCommandFromQuery(const QSqlQuery& query, bool includeClientInfo = false);
 };
@@ -140,7 +172,8 @@ public:
     explicit CommandManager(QObject *parent = nullptr);
 
     // Business logic methods
-    bool addNewCommand(const Command& command);
+    bool addNewCommand(const Command& command, int* newCommandId = nullptr);
+    bool addNewCommands(const QList<Command>& commands); // All or nothing, one commit
     bool modifyCommand(const Command& command);
     bool removeCommand(int commandId);
     Command getCommand(int commandId);
@@ -148,7 +181,7 @@ public:
     QList<Command> getClientCommands(int clientId);
 
     // Business calculations
-    double calculateClientTotal(int clientId);
+    Money calculateClientTotal(int clientId);
     int getClientCommandCount(int clientId);
     QList<Command> getRecentCommands(int days = 30);
     QList<Command> getTopCommands(int limit = 10);
@@ -188,24 +221,26 @@ public:
 
     struct Statistics {
         int totalCommands;
-        double totalSales;
-        double averageOrderValue;
+        Money totalSales;
+        Money averageOrderValue;
         int topClientId;
         QString topClientName;
         QString mostUsedPaymentMethod;
         QDate firstOrderDate;
         QDate lastOrderDate;
+        int totalClients;       // Overall statistics only
+        bool valid;             // False when the figures could not be read
 
         // Initialize with default values
-        Statistics() : totalCommands(0), totalSales(0.0), averageOrderValue(0.0),
-            topClientId(0) {}
+        Statistics() : totalCommands(0), topClientId(0), totalClients(0), valid(false) {}
     };
 
     Statistics getOverallStatistics();
     Statistics getClientStatistics(int clientId);
     QMap<QString, int> getPaymentMethodStats();
-    QMap<QDate, double> getDailySales(const QDate& startDate, const QDate& endDate);
-    QList<QPair<int, double>> getTopClientsByTotal(int limit = 10);
+    QMap<QDate, Money> getDailySales(const QDate& startDate, const QDate& endDate);
+    QMap<QDate, Money> getMonthlySales(const QDate& startDate, const QDate& endDate); // Keyed by first of month
+    QList<QPair<int, Money>> getTopClientsByTotal(int limit = 10);
 
 private:
     CommandDAO* commandDAO;
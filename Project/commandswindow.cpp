@@ -1,4 +1,6 @@
 #include "commandswindow.h"
+#include "writebehindqueue.h"
+#include "trace.h"
 #include <QCloseEvent>
 #include <QShowEvent>
 #include <QApplication>
@@ -21,11 +23,10 @@ CommandsWindow::CommandsWindow(CommandManager* commandManager,
     , clientSelectionLayout(nullptr)
     , commandManager(commandManager)
     , clientManager(clientManager)
+    , writeQueue(nullptr)
     , currentMode(AddMode)
     , isModified(false)
     , validationTimer(nullptr)
-    , clientCompleter(nullptr)
-    , clientModel(nullptr)
     , showAnimation(nullptr)
     , opacityEffect(nullptr)
 {
@@ -33,7 +34,6 @@ CommandsWindow::CommandsWindow(CommandManager* commandManager,
     setModal(true);
 
     setupUI();
-    loadClientData();
     loadPaymentMethods();
     clearForm();
 
@@ -57,12 +57,11 @@ CommandsWindow::CommandsWindow(CommandManager* commandManager,
     , clientSelectionLayout(nullptr)
     , commandManager(commandManager)
     , clientManager(clientManager)
+    , writeQueue(nullptr)
     , currentCommand(command)
     , currentMode(mode)
     , isModified(false)
     , validationTimer(nullptr)
-    , clientCompleter(nullptr)
-    , clientModel(nullptr)
     , showAnimation(nullptr)
     , opacityEffect(nullptr)
 {
@@ -70,7 +69,6 @@ CommandsWindow::CommandsWindow(CommandManager* commandManager,
     setModal(true);
 
     setupUI();
-    loadClientData();
     loadPaymentMethods();
     setCommand(command);
     setMode(mode);
@@ -93,14 +91,6 @@ CommandsWindow::~CommandsWindow()
     if (opacityEffect) {
         delete opacityEffect;
     }
-
-    if (clientCompleter) {
-        delete clientCompleter;
-    }
-
-    if (clientModel) {
-        delete clientModel;
-    }
 }
 
 void CommandsWindow::setupUI()
@@ -174,9 +164,8 @@ void CommandsWindow::setupFormLayout()
     clientSelectionLayout = new QHBoxLayout();
 
     clientLabel = new QLabel("Client:");
-    clientCombo = new QComboBox();
-    clientCombo->setObjectName("inputField");
-    clientCombo->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+    // Type-ahead over the shared client index; nothing is loaded up front
+    clientPicker = new ClientPicker(clientManager);
 
     selectClientBtn = new QPushButton("Select");
     selectClientBtn->setObjectName("secondaryBtn");
@@ -187,18 +176,12 @@ void CommandsWindow::setupFormLayout()
     newClientBtn->setFixedWidth(70);
 
     clientSelectionLayout->addWidget(clientLabel);
-    clientSelectionLayout->addWidget(clientCombo, 1);
+    clientSelectionLayout->addWidget(clientPicker, 1);
     clientSelectionLayout->addWidget(selectClientBtn);
     clientSelectionLayout->addWidget(newClientBtn);
 
     clientGroupLayout->addLayout(clientSelectionLayout);
 
-    // Client search
-    clientSearchEdit = new QLineEdit();
-    clientSearchEdit->setPlaceholderText("Search clients by name or email...");
-    clientSearchEdit->setObjectName("searchField");
-    clientGroupLayout->addWidget(clientSearchEdit);
-
     // Client display info
     QFrame *clientDisplayFrame = new QFrame();
     clientDisplayFrame->setObjectName("clientDisplayFrame");
@@ -525,8 +508,7 @@ void CommandsWindow::applyModernStyling()
 void CommandsWindow::connectSignals()
 {
     // Form field signals
-    connect(clientCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
-            this, &CommandsWindow::onClientChanged);
+    connect(clientPicker, &ClientPicker::clientChanged, this, &CommandsWindow::onClientChanged);
     connect(totalEdit, &QLineEdit::textChanged, this, &CommandsWindow::onTotalChanged);
     connect(paymentMethodCombo, QOverload<const QString&>::of(&QComboBox::currentTextChanged),
             this, &CommandsWindow::onPaymentMethodChanged);
@@ -540,7 +522,6 @@ void CommandsWindow::connectSignals()
     connect(calculateBtn, &QPushButton::clicked, this, &CommandsWindow::onCalculateTotal);
 
     // Search and validation signals
-    connect(clientSearchEdit, &QLineEdit::textChanged, this, &CommandsWindow::onClientSearch);
     connect(validationTimer, &QTimer::timeout, this, &CommandsWindow::onValidationTimer);
 
     // Field modification tracking
@@ -550,37 +531,6 @@ void CommandsWindow::connectSignals()
     connect(notesEdit, &QTextEdit::textChanged, [this]() { isModified = true; });
 }
 
-void CommandsWindow::loadClientData()
-{
-    if (!clientManager) return;
-
-    availableClients = clientManager->getAllClients();
-
-    clientCombo->clear();
-    clientCombo->addItem("-- Select Client --", -1);
-
-    QStringList clientNames;
-    for (const Client& client : availableClients) {
-        QString displayText = QString("%1 - %2").arg(client.name, client.email);
-        clientCombo->addItem(displayText, client.id);
-        clientNames << displayText;
-    }
-
-    // Setup completer for client search
-    if (!clientModel) {
-        clientModel = new QStringListModel(this);
-    }
-    clientModel->setStringList(clientNames);
-
-    if (!clientCompleter) {
-        clientCompleter = new QCompleter(this);
-        clientSearchEdit->setCompleter(clientCompleter);
-    }
-    clientCompleter->setModel(clientModel);
-    clientCompleter->setCaseSensitivity(Qt::CaseInsensitive);
-    clientCompleter->setFilterMode(Qt::MatchContains);
-}
-
 void CommandsWindow::loadPaymentMethods()
 {
     if (!commandManager) return;
@@ -603,20 +553,14 @@ void CommandsWindow::populateForm()
         commandIdEdit->setText("New Command");
     }
 
-    commandDateEdit->setDateTime(currentCommand.commandDate);
-    totalEdit->setText(currentCommand.total);
+    commandDateEdit->setDateTime(currentCommand.hasCommandDate() ? currentCommand.commandDate()
+                                                                 : QDateTime::currentDateTime());
+    totalEdit->setText(currentCommand.total.toString());
     paymentMethodCombo->setCurrentText(currentCommand.paymentMethod);
     deliveryAddressEdit->setPlainText(currentCommand.deliveryAddress);
 
     // Set client selection
-    if (currentCommand.clientId > 0) {
-        for (int i = 0; i < clientCombo->count(); ++i) {
-            if (clientCombo->itemData(i).toInt() == currentCommand.clientId) {
-                clientCombo->setCurrentIndex(i);
-                break;
-            }
-        }
-    }
+    clientPicker->setCurrentClientId(currentCommand.clientId);
 
     updateClientInfo();
     isModified = false;
@@ -630,8 +574,7 @@ void CommandsWindow::clearForm()
     paymentMethodCombo->setCurrentIndex(0);
     deliveryAddressEdit->clear();
     notesEdit->clear();
-    clientCombo->setCurrentIndex(0);
-    clientSearchEdit->clear();
+    clientPicker->clear();
 
     updateClientInfo();
     clearValidationErrors();
@@ -642,30 +585,24 @@ void CommandsWindow::clearForm()
 
 void CommandsWindow::updateClientInfo()
 {
-    int clientId = clientCombo->currentData().toInt();
+    Client client = clientPicker->currentClient();
 
-    if (clientId <= 0) {
+    if (client.id <= 0) {
         clientNameDisplay->setText("Not selected");
         clientEmailDisplay->setText("Not selected");
         clientAddressDisplay->setText("Not selected");
         return;
     }
 
-    // Find client in available clients
-    for (const Client& client : availableClients) {
-        if (client.id == clientId) {
-            clientNameDisplay->setText(client.name);
-            clientEmailDisplay->setText(client.email);
-            clientAddressDisplay->setText(QString("%1, %2 %3").arg(client.address, client.city, client.postal));
-
-            // Auto-fill delivery address if empty
-            if (deliveryAddressEdit->toPlainText().isEmpty()) {
-                deliveryAddressEdit->setPlainText(QString("%1\n%2, %3 %4").arg(
-                    client.name, client.address, client.city, client.postal));
-                isModified = true;
-            }
-            break;
-        }
+    clientNameDisplay->setText(client.name);
+    clientEmailDisplay->setText(client.email);
+    clientAddressDisplay->setText(QString("%1, %2 %3").arg(client.address, client.city, client.postal));
+
+    // Auto-fill delivery address if empty
+    if (deliveryAddressEdit->toPlainText().isEmpty()) {
+        deliveryAddressEdit->setPlainText(QString("%1\n%2, %3 %4").arg(
+            client.name, client.address, client.city, client.postal));
+        isModified = true;
     }
 }
 
@@ -674,12 +611,12 @@ bool CommandsWindow::validateForm()
     validationErrors.clear();
 
     // Validate client selection
-    int clientId = clientCombo->currentData().toInt();
+    int clientId = clientPicker->currentClientId();
     if (clientId <= 0) {
         validationErrors << "Please select a client";
-        setFieldError(clientCombo, true);
+        setFieldError(clientPicker, true);
     } else {
-        setFieldError(clientCombo, false);
+        setFieldError(clientPicker, false);
     }
 
     // Validate total amount
@@ -737,7 +674,7 @@ void CommandsWindow::clearValidationErrors()
     validationErrors.clear();
 
     // Clear field error states
-    setFieldError(clientCombo, false);
+    setFieldError(clientPicker, false);
     setFieldError(totalEdit, false);
     setFieldError(paymentMethodCombo, false);
     setFieldError(deliveryAddressEdit, false);
@@ -830,12 +767,11 @@ void CommandsWindow::updateButtonStates()
 void CommandsWindow::setFieldsReadOnly(bool readOnly)
 {
     commandDateEdit->setReadOnly(readOnly);
-    clientCombo->setEnabled(!readOnly);
+    clientPicker->setEnabled(!readOnly);
     totalEdit->setReadOnly(readOnly);
     paymentMethodCombo->setEnabled(!readOnly);
     deliveryAddressEdit->setReadOnly(readOnly);
     notesEdit->setReadOnly(readOnly);
-    clientSearchEdit->setEnabled(!readOnly);
     selectClientBtn->setEnabled(!readOnly);
     newClientBtn->setEnabled(!readOnly);
     calculateBtn->setEnabled(!readOnly);
@@ -861,9 +797,9 @@ Command CommandsWindow::getCurrentCommand() const
         command.commandId = 0; // Will be set by database
     }
 
-    command.commandDate = commandDateEdit->dateTime();
-    command.clientId = clientCombo->currentData().toInt();
-    command.total = totalEdit->text();
+    command.setCommandDate(commandDateEdit->dateTime());
+    command.clientId = clientPicker->currentClientId();
+    command.total = Money::fromString(totalEdit->text());
     command.paymentMethod = paymentMethodCombo->currentText();
     command.deliveryAddress = deliveryAddressEdit->toPlainText();
     // command.notes = notesEdit->toPlainText(); // Uncomment if Command has notes field
@@ -923,6 +859,7 @@ void CommandsWindow::showEvent(QShowEvent *event)
 }
 
 void CommandsWindow::accept() {
+    TRACE_SCOPE("ui", "CommandsWindow::accept");
     if (currentMode == ViewMode) {
         setMode(EditMode);
         return;
@@ -935,10 +872,23 @@ void CommandsWindow::accept() {
         return;
     }
 
+    Command command = getCurrentCommand();
+
+    if (writeQueue) {
+        // The view shows the change right away, the database write follows
+        if (currentMode == AddMode) {
+            writeQueue->enqueueCommandInsert(command);
+        } else if (currentMode == EditMode) {
+            writeQueue->enqueueCommandUpdate(command, currentCommand);
+        }
+        isModified = false;
+        QDialog::accept();
+        return;
+    }
+
     statusLabel->setText("Saving...");
     QApplication::processEvents();
 
-    Command command = getCurrentCommand();
     bool success = false;
 
     try {
@@ -1052,7 +1002,7 @@ void CommandsWindow::onValidationTimer()
     bool isValid = true;
 
     // Check client
-    if (clientCombo->currentData().toInt() <= 0) {
+    if (clientPicker->currentClientId() <= 0) {
         isValid = false;
     }
 
@@ -1081,30 +1031,6 @@ void CommandsWindow::onValidationTimer()
     }
 }
 
-void CommandsWindow::onClientSearch()
-{
-    QString searchText = clientSearchEdit->text();
-    if (searchText.isEmpty()) {
-        return;
-    }
-
-    // Filter the combo box based on search
-    clientCombo->clear();
-    clientCombo->addItem("-- Select Client --", -1);
-
-    for (const Client& client : availableClients) {
-        QString displayText = QString("%1 - %2").arg(client.name, client.email);
-        if (displayText.contains(searchText, Qt::CaseInsensitive)) {
-            clientCombo->addItem(displayText, client.id);
-        }
-    }
-
-    // If only one match found (plus the default item), auto-select it
-    if (clientCombo->count() == 2) {
-        clientCombo->setCurrentIndex(1);
-    }
-}
-
 void CommandsWindow::onSelectClientClicked()
 {
     // This would open a client selection dialog
@@ -21,11 +21,12 @@
 #include <QTimer>
 #include <QPropertyAnimation>
 #include <QGraphicsOpacityEffect>
-#include <QCompleter>
-#include <QStringListModel>
 
 #include "commands.h"
 #include "clients.h"
+#include "clientpicker.h"
+
+class WriteBehindQueue;
 
 class CommandsWindow : public QDialog
 {
@@ -53,6 +54,9 @@ public:
     void setMode(Mode mode);
     Mode getMode() const { return currentMode; }
 
+    // Save through the write-behind queue instead of writing synchronously
+    void setWriteQueue(WriteBehindQueue *queue) { writeQueue = queue; }
+
 protected:
     void closeEvent(QCloseEvent *event) override;
     void showEvent(QShowEvent *event) override;
@@ -68,7 +72,6 @@ private slots:
     void onTotalChanged();
     void onPaymentMethodChanged();
     void onValidationTimer();
-    void onClientSearch();
     void onSelectClientClicked();
     void onNewClientClicked();
     void onCalculateTotal();
@@ -83,7 +86,6 @@ private:
     void connectSignals();
 
     // Data management
-    void loadClientData();
     void loadPaymentMethods();
     void populateForm();
     void clearForm();
@@ -121,10 +123,9 @@ private:
     QLineEdit *commandIdEdit;
 
     QLabel *clientLabel;
-    QComboBox *clientCombo;
+    ClientPicker *clientPicker;
     QPushButton *selectClientBtn;
     QPushButton *newClientBtn;
-    QLineEdit *clientSearchEdit;
 
     QLabel *clientNameDisplay;
     QLabel *clientEmailDisplay;
@@ -159,6 +160,7 @@ private:
     // Data managers
     CommandManager *commandManager;
     ClientManager *clientManager;
+    WriteBehindQueue *writeQueue;
 
     // Current state
     Command currentCommand;
@@ -169,11 +171,6 @@ private:
     QTimer *validationTimer;
     QStringList validationErrors;
 
-    // Client data cache
-    QList<Client> availableClients;
-    QCompleter *clientCompleter;
-    QStringListModel *clientModel;
-
     // Animation
     QPropertyAnimation *showAnimation;
     QGraphicsOpacityEffect *opacityEffect;
@@ -1,4 +1,9 @@
 #include "connection.h"
+#include "localreplica.h"
+#include "trace.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QMutexLocker>
 
 // Database configuration constants (Updated for ODBC)
 const QString Connection::DB_HOSTNAME = "localhost";
@@ -8,7 +13,7 @@ const QString Connection::DB_PASSWORD = "505";
 const int Connection::DB_PORT = 1521;
 const QString Connection::DB_DRIVER = "QODBC";  // Changed from QOCI to QODBC
 
-Connection::Connection() : connected(false)
+Connection::Connection() : connected(false), localReplica(nullptr)
 {
     // Constructor - connection will be made when createConnection() is called
 }
@@ -37,8 +42,7 @@ bool Connection::createConnection()
         QString errorMsg = QString("QODBC driver not available!\n"
                                    "Available Qt drivers: %1")
                                .arg(QSqlDatabase::drivers().join(", "));
-        qDebug() << errorMsg;
-        QMessageBox::critical(nullptr, "Driver Error", errorMsg);
+        reportError("Driver Error", errorMsg);
         return false;
     }
 
@@ -77,8 +81,7 @@ bool Connection::createConnection()
                                    "   ODBC Data Source Administrator (64-bit)")
                                    .arg(db.lastError().text());
 
-        qDebug() << errorDetails;
-        QMessageBox::critical(nullptr, "Connection Failed", errorDetails);
+        reportError("Connection Failed", errorDetails);
         connected = false;
         return false;
     }
@@ -96,6 +99,30 @@ bool Connection::createConnection()
     return true;
 }
 
+bool Connection::openDatabase(const QString& driver, const QString& databaseName)
+{
+    if (connected && db.isOpen()) {
+        closeConnection();
+    }
+
+    if (QSqlDatabase::contains("OracleConnection")) {
+        QSqlDatabase::removeDatabase("OracleConnection");
+    }
+
+    db = QSqlDatabase::addDatabase(driver, "OracleConnection");
+    db.setDatabaseName(databaseName);
+    if (!db.open()) {
+        reportError("Connection Failed", QString("Failed to open %1 database %2: %3")
+                                             .arg(driver, databaseName, db.lastError().text()));
+        connected = false;
+        return false;
+    }
+
+    connected = true;
+    qDebug() << "✓ Opened" << driver << "database" << databaseName;
+    return true;
+}
+
 void Connection::closeConnection()
 {
     if (connected && db.isOpen()) {
@@ -108,20 +135,111 @@ void Connection::closeConnection()
     // Don't remove it automatically to prevent issues with ongoing queries
 }
 
+
+// QSqlDatabase connections may only be used from the thread that opened them
+static QString threadConnectionName()
+{
+    return QString("OracleConnection_%1").arg(quintptr(QThread::currentThreadId()));
+}
+
+static bool isMainThread()
+{
+    QCoreApplication *app = QCoreApplication::instance();
+    return !app || QThread::currentThread() == app->thread();
+}
+
 bool Connection::isConnected() const
 {
+    if (!isMainThread()) {
+        QSqlDatabase threadDb = getDatabase();
+        return connected && threadDb.isOpen() && threadDb.isValid();
+    }
     return connected && db.isOpen() && db.isValid();
 }
 
 QSqlDatabase Connection::getDatabase() const
 {
-    // Always return the same database instance
-    return QSqlDatabase::database("OracleConnection");
+    // The GUI thread always uses the same database instance
+    if (isMainThread()) {
+        return QSqlDatabase::database("OracleConnection");
+    }
+
+    // Worker threads get a lazily opened clone of the main connection
+    QString name = threadConnectionName();
+    if (!QSqlDatabase::contains(name)) {
+        QSqlDatabase clone = QSqlDatabase::cloneDatabase("OracleConnection", name);
+        if (!clone.open()) {
+            qDebug() << "Failed to open worker connection" << name << ":" << clone.lastError().text();
+        } else {
+            qDebug() << "✓ Opened worker connection" << name;
+        }
+    }
+
+    return QSqlDatabase::database(name);
+}
+
+void Connection::releaseThreadDatabase()
+{
+    if (isMainThread()) {
+        return;
+    }
+
+    QString name = threadConnectionName();
+    if (QSqlDatabase::contains(name)) {
+        {
+            QSqlDatabase threadDb = QSqlDatabase::database(name, false);
+            threadDb.close();
+        }
+        QSqlDatabase::removeDatabase(name);
+        qDebug() << "Worker connection released:" << name;
+    }
+}
+
+Connection::Dialect Connection::dialect() const
+{
+    return dialectOf(getDatabase());
+}
+
+Connection::Dialect Connection::dialectOf(const QSqlDatabase& database)
+{
+    // QODBC and QOCI both talk to Oracle here
+    return database.driverName().startsWith("QSQLITE") ? SQLiteDialect : OracleDialect;
+}
+
+void Connection::attachReplica(LocalReplica* replica)
+{
+    localReplica = replica;
+}
+
+QSqlDatabase Connection::getDataDatabase() const
+{
+    return localReplica && localReplica->isOpen() ? localReplica->database() : getDatabase();
+}
+
+bool Connection::isDataConnected() const
+{
+    return localReplica && localReplica->isOpen() ? localReplica->database().isOpen() : isConnected();
+}
+
+bool Connection::ensureDataConnection()
+{
+    // The replica is a local file; it stays usable while the link is down
+    if (localReplica && localReplica->isOpen()) {
+        QSqlDatabase local = localReplica->database();
+        return local.isOpen() || local.open();
+    }
+    return ensureConnected();
 }
 
 // Add a method to ensure connection is alive
 bool Connection::ensureConnected()
 {
+    if (!isMainThread()) {
+        // Worker threads only reopen their own clone
+        QSqlDatabase threadDb = getDatabase();
+        return threadDb.isOpen() || threadDb.open();
+    }
+
     if (!isConnected()) {
         qDebug() << "Connection lost, attempting to reconnect...";
         return createConnection();
@@ -137,11 +255,10 @@ bool Connection::testConnection()
     }
 
     QSqlQuery query(db);
-    if (!query.exec("SELECT 1 FROM DUAL")) {
+    if (!TRACE_EXEC_SQL(query, "SELECT 1 FROM DUAL")) {
         QString errorMsg = QString("Connection test failed!\nError: %1")
         .arg(query.lastError().text());
-        qDebug() << errorMsg;
-        QMessageBox::warning(nullptr, "Connection Test Failed", errorMsg);
+        reportError("Connection Test Failed", errorMsg);
         return false;
     }
 
@@ -153,20 +270,18 @@ bool Connection::executeQuery(const QString& queryString)
 {
     if (!ensureConnected()) {
         QString errorMsg = "Database not connected! Cannot execute query.";
-        qDebug() << errorMsg;
-        QMessageBox::warning(nullptr, "Database Error", errorMsg);
+        reportError("Database Error", errorMsg);
         return false;
     }
 
     QSqlQuery query(getDatabase());
-    if (!query.exec(queryString)) {
+    if (!TRACE_EXEC_SQL(query, queryString)) {
         QString errorMsg = QString("Query execution failed!\n\n"
                                    "Query: %1\n\n"
                                    "Error: %2")
                                .arg(queryString)
                                .arg(query.lastError().text());
-        qDebug() << errorMsg;
-        QMessageBox::warning(nullptr, "Query Error", errorMsg);
+        reportError("Query Error", errorMsg);
         return false;
     }
 
@@ -183,17 +298,34 @@ QSqlQuery Connection::executeSelectQuery(const QString& queryString)
         return query;
     }
 
-    if (!query.exec(queryString)) {
+    if (!TRACE_EXEC_SQL(query, queryString)) {
         QString errorMsg = QString("Select query execution failed!\n\n"
                                    "Query: %1\n\n"
                                    "Error: %2")
                                .arg(queryString)
                                .arg(query.lastError().text());
-        qDebug() << errorMsg;
-        QMessageBox::warning(nullptr, "Query Error", errorMsg);
+        reportError("Query Error", errorMsg);
     } else {
         qDebug() << "✓ Select query executed successfully:" << queryString;
     }
 
     return query;
 }
+
+QString Connection::lastError() const
+{
+    QMutexLocker locker(&errorMutex);
+    return lastErrorText;
+}
+
+void Connection::reportError(const QString& title, const QString& message)
+{
+    qDebug() << message;
+    {
+        QMutexLocker locker(&errorMutex);
+        lastErrorText = message;
+    }
+    if (errorHandler) {
+        errorHandler(title, message);
+    }
+}
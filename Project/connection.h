@@ -6,11 +6,20 @@
 #include <QSqlError>
 #include <QString>
 #include <QDebug>
-#include <QMessageBox>
+#include <QMutex>
+#include <functional>
+
+class LocalReplica;
 
 class Connection
 {
 public:
+    // SQL flavour spoken by a connection
+    enum Dialect {
+        OracleDialect,
+        SQLiteDialect
+    };
+
     Connection();
     ~Connection();
 
@@ -19,12 +28,28 @@ public:
 
     // Database connection methods
     bool createConnection();
+    // Stand-in for the Oracle connection, e.g. a SQLite file for the
+    // benchmarks; worker threads clone it like the real one
+    bool openDatabase(const QString& driver, const QString& databaseName);
     void closeConnection();
     bool isConnected() const;
     bool ensureConnected(); // New method to ensure connection is alive
 
-    // Get database reference
+    // Get database reference (worker threads get their own clone)
     QSqlDatabase getDatabase() const;
+    void releaseThreadDatabase();
+
+    // Dialect of the current connection, or of any database handle
+    Dialect dialect() const;
+    static Dialect dialectOf(const QSqlDatabase& database);
+
+    // Where the DAOs read and write: the local replica when one is
+    // attached, otherwise the central database
+    void attachReplica(LocalReplica* replica);
+    LocalReplica* replica() const { return localReplica; }
+    QSqlDatabase getDataDatabase() const;
+    bool isDataConnected() const;
+    bool ensureDataConnection();
 
     // Test connection
     bool testConnection();
@@ -33,9 +58,21 @@ public:
     bool executeQuery(const QString& queryString);
     QSqlQuery executeSelectQuery(const QString& queryString);
 
+    // Errors are logged and kept in lastError(); the handler, when set,
+    // gets them too (the desktop application shows a message box)
+    using ErrorHandler = std::function<void(const QString& title, const QString& message)>;
+    void setErrorHandler(const ErrorHandler& handler) { errorHandler = handler; }
+    QString lastError() const;
+
 private:
     QSqlDatabase db;
     bool connected;
+    LocalReplica* localReplica;
+    ErrorHandler errorHandler;
+    mutable QMutex errorMutex;
+    QString lastErrorText;
+
+    void reportError(const QString& title, const QString& message);
 
     // Database configuration for lakhoua
     static const QString DB_HOSTNAME;
@@ -0,0 +1,267 @@
+// csvexchange.cpp
+#include "csvexchange.h"
+#include "validationengine.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QSet>
+#include <QDebug>
+#include <algorithm>
+
+static const QStringList ClientColumns = {"ID", "NAME", "EMAIL", "CITY", "POSTAL", "ADDRESS"};
+static const QStringList CommandColumns = {"COMMAND_ID", "CLIENT_ID", "COMMAND_DATE", "TOTAL",
+                                           "PAYMENT_METHOD", "DELIVERY_ADDRESS"};
+
+QString CsvExchange::escape(const QString& field)
+{
+    if (!field.contains(',') && !field.contains('"') && !field.contains('\n') && !field.contains('\r')) {
+        return field;
+    }
+    QString quoted = field;
+    quoted.replace("\"", "\"\"");
+    return "\"" + quoted + "\"";
+}
+
+QList<QStringList> CsvExchange::parse(const QString& text)
+{
+    QList<QStringList> rows;
+    QStringList row;
+    QString field;
+    bool quoted = false;
+
+    for (int i = 0; i < text.size(); ++i) {
+        QChar c = text.at(i);
+        if (quoted) {
+            if (c == '"') {
+                if (i + 1 < text.size() && text.at(i + 1) == '"') {
+                    field += '"';
+                    ++i;
+                } else {
+                    quoted = false;
+                }
+            } else {
+                field += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            row.append(field);
+            field.clear();
+        } else if (c == '\n' || c == '\r') {
+            if (c == '\r' && i + 1 < text.size() && text.at(i + 1) == '\n') {
+                ++i;
+            }
+            row.append(field);
+            field.clear();
+            rows.append(row);
+            row.clear();
+        } else {
+            field += c;
+        }
+    }
+
+    // Last line without a line break
+    if (!field.isEmpty() || !row.isEmpty()) {
+        row.append(field);
+        rows.append(row);
+    }
+    return rows;
+}
+
+bool CsvExchange::write(const QString& path, const QString& text, QString& error)
+{
+    // QSaveFile leaves an existing file alone if the export fails half way
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(text.toUtf8()) < 0 || !file.commit()) {
+        error = QString("Cannot write %1: %2").arg(path, file.errorString());
+        return false;
+    }
+    return true;
+}
+
+bool CsvExchange::read(const QString& path, const QStringList& header, QList<QStringList>& rows, QString& error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = QString("Cannot read %1: %2").arg(path, file.errorString());
+        return false;
+    }
+
+    rows = parse(QString::fromUtf8(file.readAll()));
+    if (rows.isEmpty()) {
+        error = QString("%1 is empty").arg(path);
+        return false;
+    }
+
+    QStringList found;
+    for (const QString& column : rows.takeFirst()) {
+        found.append(column.trimmed().toUpper());
+    }
+    if (found != header) {
+        error = QString("%1: expected the columns %2").arg(path, header.join(','));
+        return false;
+    }
+
+    // Blank lines carry no row
+    rows.erase(std::remove_if(rows.begin(), rows.end(), [](const QStringList& row) {
+        return row.size() == 1 && row.first().trimmed().isEmpty();
+    }), rows.end());
+    return true;
+}
+
+bool CsvExchange::exportClients(const QList<Client>& clients, const QString& path, QString& error)
+{
+    QString text = ClientColumns.join(',') + "\r\n";
+    for (const Client& client : clients) {
+        text += QStringList{QString::number(client.id), escape(client.name), escape(client.email),
+                            escape(client.city), escape(client.postal), escape(client.address)}.join(',');
+        text += "\r\n";
+    }
+    return write(path, text, error);
+}
+
+bool CsvExchange::exportCommands(const QList<Command>& commands, const QString& path, QString& error)
+{
+    QString text = CommandColumns.join(',') + "\r\n";
+    for (const Command& command : commands) {
+        text += QStringList{QString::number(command.commandId), QString::number(command.clientId),
+                            command.commandDate().toString(Qt::ISODate), command.total.toString(),
+                            escape(command.paymentMethod), escape(command.deliveryAddress)}.join(',');
+        text += "\r\n";
+    }
+    return write(path, text, error);
+}
+
+CsvExchange::ImportResult CsvExchange::importClients(const QString& path, ClientManager& manager)
+{
+    ImportResult result;
+    QList<QStringList> rows;
+    QString error;
+    if (!read(path, ClientColumns, rows, error)) {
+        result.errors.append(error);
+        return result;
+    }
+    result.rows = rows.size();
+
+    QList<Client> clients;
+    QSet<int> rejected;
+    for (int i = 0; i < rows.size(); ++i) {
+        const QStringList& row = rows.at(i);
+        if (row.size() != ClientColumns.size()) {
+            result.errors.append(QString("Row %1: expected %2 fields, found %3")
+                                     .arg(i + 1).arg(ClientColumns.size()).arg(row.size()));
+            rejected.insert(i);
+            clients.append(Client());
+            continue;
+        }
+        clients.append(Client(row.at(1).trimmed(), row.at(2).trimmed(), row.at(3).trimmed(),
+                              row.at(4).trimmed(), row.at(5).trimmed()));
+    }
+
+    for (const ValidationEngine::RowReport& report : ValidationEngine::instance().validateAll(clients)) {
+        if (!rejected.contains(report.row)) {
+            result.errors.append(ValidationEngine::describe(report));
+            rejected.insert(report.row);
+        }
+    }
+
+    QString batchError;
+    QMetaObject::Connection errors = QObject::connect(&manager, &ClientManager::validationError,
+                                                      [&batchError](const QString& message) {
+        batchError = message;
+    });
+
+    QList<Client> batch;
+    int firstRow = 0;
+    for (int i = 0; i <= clients.size(); ++i) {
+        bool last = i == clients.size();
+        if (!last && !rejected.contains(i)) {
+            if (batch.isEmpty()) {
+                firstRow = i + 1;
+            }
+            batch.append(clients.at(i));
+        }
+        if (!batch.isEmpty() && (batch.size() == BatchSize || last)) {
+            batchError.clear();
+            if (manager.addNewClients(batch)) {
+                result.imported += batch.size();
+            } else {
+                result.errors.append(QString("Rows %1-%2: %3").arg(firstRow).arg(i + (last ? 0 : 1)).arg(batchError));
+            }
+            batch.clear();
+        }
+    }
+
+    QObject::disconnect(errors);
+    qDebug() << "Imported" << result.imported << "of" << result.rows << "clients from" << path;
+    return result;
+}
+
+CsvExchange::ImportResult CsvExchange::importCommands(const QString& path, CommandManager& manager)
+{
+    ImportResult result;
+    QList<QStringList> rows;
+    QString error;
+    if (!read(path, CommandColumns, rows, error)) {
+        result.errors.append(error);
+        return result;
+    }
+    result.rows = rows.size();
+
+    QList<Command> commands;
+    QSet<int> rejected;
+    for (int i = 0; i < rows.size(); ++i) {
+        const QStringList& row = rows.at(i);
+        bool totalOk = row.size() == CommandColumns.size();
+        Money total = totalOk ? Money::fromString(row.at(3).trimmed(), &totalOk) : Money();
+        if (!totalOk) {
+            result.errors.append(row.size() == CommandColumns.size()
+                                     ? QString("Row %1, Total: \"%2\" is not an amount").arg(i + 1).arg(row.at(3))
+                                     : QString("Row %1: expected %2 fields, found %3")
+                                           .arg(i + 1).arg(CommandColumns.size()).arg(row.size()));
+            rejected.insert(i);
+            commands.append(Command());
+            continue;
+        }
+        commands.append(Command(0, row.at(1).trimmed().toInt(),
+                                QDateTime::fromString(row.at(2).trimmed(), Qt::ISODate), total,
+                                row.at(4).trimmed(), row.at(5).trimmed()));
+    }
+
+    for (const ValidationEngine::RowReport& report : ValidationEngine::instance().validateAll(commands)) {
+        if (!rejected.contains(report.row)) {
+            result.errors.append(ValidationEngine::describe(report));
+            rejected.insert(report.row);
+        }
+    }
+
+    QString batchError;
+    QMetaObject::Connection errors = QObject::connect(&manager, &CommandManager::validationError,
+                                                      [&batchError](const QString& message) {
+        batchError = message;
+    });
+
+    QList<Command> batch;
+    int firstRow = 0;
+    for (int i = 0; i <= commands.size(); ++i) {
+        bool last = i == commands.size();
+        if (!last && !rejected.contains(i)) {
+            if (batch.isEmpty()) {
+                firstRow = i + 1;
+            }
+            batch.append(commands.at(i));
+        }
+        if (!batch.isEmpty() && (batch.size() == BatchSize || last)) {
+            batchError.clear();
+            if (manager.addNewCommands(batch)) {
+                result.imported += batch.size();
+            } else {
+                result.errors.append(QString("Rows %1-%2: %3").arg(firstRow).arg(i + (last ? 0 : 1)).arg(batchError));
+            }
+            batch.clear();
+        }
+    }
+
+    QObject::disconnect(errors);
+    qDebug() << "Imported" << result.imported << "of" << result.rows << "orders from" << path;
+    return result;
+}
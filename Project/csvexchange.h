@@ -0,0 +1,47 @@
+// csvexchange.h
+#ifndef CSVEXCHANGE_H
+#define CSVEXCHANGE_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include "clients.h"
+#include "commands.h"
+
+// CSV import and export of clients and orders (RFC 4180 quoting, UTF-8,
+// header row first). Exports write the columns the imports read back:
+//
+//   clients: ID,NAME,EMAIL,CITY,POSTAL,ADDRESS
+//   orders:  COMMAND_ID,CLIENT_ID,COMMAND_DATE,TOTAL,PAYMENT_METHOD,DELIVERY_ADDRESS
+//
+// Imports ignore the ID columns (the database assigns new ones), check
+// every row with the ValidationEngine, report and skip the rows that fail,
+// and insert the rest through the managers in all-or-nothing batches.
+class CsvExchange
+{
+public:
+    struct ImportResult {
+        int rows = 0;           // Data rows read
+        int imported = 0;
+        QStringList errors;     // One line per rejected row or failed batch
+
+        bool ok() const { return errors.isEmpty(); }
+    };
+
+    static bool exportClients(const QList<Client>& clients, const QString& path, QString& error);
+    static bool exportCommands(const QList<Command>& commands, const QString& path, QString& error);
+
+    static ImportResult importClients(const QString& path, ClientManager& manager);
+    static ImportResult importCommands(const QString& path, CommandManager& manager);
+
+    static QList<QStringList> parse(const QString& text);
+    static QString escape(const QString& field);
+
+private:
+    static const int BatchSize = 500;
+
+    static bool write(const QString& path, const QString& text, QString& error);
+    static bool read(const QString& path, const QStringList& header, QList<QStringList>& rows, QString& error);
+};
+
+#endif // CSVEXCHANGE_H
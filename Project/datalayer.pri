@@ -0,0 +1,18 @@
+# datalayer.pri - Links the data layer library (datalayer/datalayer.pro).
+# Included by the application, the batch runner, the load generator, the
+# benchmarks and the tests; Project.pro builds the library before any of
+# them.
+# Needs QT += sql concurrent.
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+# qmake CONFIG+=tracing compiles in the TRACE_SCOPE spans, see trace.h
+tracing: DEFINES += CMS_TRACE
+
+DATALAYER_DIR = $$shadowed($$PWD/datalayer)
+win32-msvc*: DATALAYER_LIB = $$DATALAYER_DIR/datalayer.lib
+else: DATALAYER_LIB = $$DATALAYER_DIR/libdatalayer.a
+
+LIBS += -L$$DATALAYER_DIR -ldatalayer
+PRE_TARGETDEPS += $$DATALAYER_LIB
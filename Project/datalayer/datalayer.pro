@@ -0,0 +1,72 @@
+# datalayer.pro - Data access layer as a static library: connection, DAOs,
+# managers, statistics, caches, validation, reports and CSV exchange.
+# No widgets here; errors are logged and reported through signals and
+# Connection::lastError(), so everything built on it can run headless.
+#
+# Consumers include ../datalayer.pri to link it.
+
+QT = core sql concurrent
+
+CONFIG += c++17 staticlib exceptions warn_on
+CONFIG -= precompile_header
+
+TARGET = datalayer
+TEMPLATE = lib
+
+# One output directory on every platform, see ../datalayer.pri
+DESTDIR = $$OUT_PWD
+
+INCLUDEPATH += $$PWD/..
+
+# qmake CONFIG+=tracing compiles in the TRACE_SCOPE spans, see trace.h
+tracing: DEFINES += CMS_TRACE
+
+SOURCES += \
+    $$PWD/../clients.cpp \
+    $$PWD/../commands.cpp \
+    $$PWD/../connection.cpp \
+    $$PWD/../unitofwork.cpp \
+    $$PWD/../writebehindqueue.cpp \
+    $$PWD/../datecodec.cpp \
+    $$PWD/../schemamigrator.cpp \
+    $$PWD/../clientsearchindex.cpp \
+    $$PWD/../stringpool.cpp \
+    $$PWD/../clientstore.cpp \
+    $$PWD/../bktree.cpp \
+    $$PWD/../prefixtrie.cpp \
+    $$PWD/../salesrollup.cpp \
+    $$PWD/../topkleaderboard.cpp \
+    $$PWD/../statisticscache.cpp \
+    $$PWD/../querycache.cpp \
+    $$PWD/../localreplica.cpp \
+    $$PWD/../validationengine.cpp \
+    $$PWD/../reportbuilder.cpp \
+    $$PWD/../csvexchange.cpp \
+    $$PWD/../trace.cpp
+
+HEADERS += \
+    $$PWD/../clients.h \
+    $$PWD/../commands.h \
+    $$PWD/../connection.h \
+    $$PWD/../unitofwork.h \
+    $$PWD/../writebehindqueue.h \
+    $$PWD/../datecodec.h \
+    $$PWD/../schemamigrator.h \
+    $$PWD/../clientsearchindex.h \
+    $$PWD/../stringpool.h \
+    $$PWD/../clientstore.h \
+    $$PWD/../bktree.h \
+    $$PWD/../prefixtrie.h \
+    $$PWD/../salesrollup.h \
+    $$PWD/../topkleaderboard.h \
+    $$PWD/../statisticscache.h \
+    $$PWD/../querycache.h \
+    $$PWD/../localreplica.h \
+    $$PWD/../validationengine.h \
+    $$PWD/../reportbuilder.h \
+    $$PWD/../csvexchange.h \
+    $$PWD/../trace.h \
+    $$PWD/../money.h
+
+OBJECTS_DIR = build/obj
+MOC_DIR = build/moc
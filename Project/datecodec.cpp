@@ -0,0 +1,142 @@
+// datecodec.cpp
+#include "datecodec.h"
+#include <QHash>
+#include <QTime>
+
+namespace
+{
+struct LocalDay {
+    qint64 midnightMs;
+    bool hasTransition;   // Day is not 24h long in local time
+};
+
+const int MsecsPerDay = 24 * 60 * 60 * 1000;
+const int MaxCachedDays = 8192;
+
+thread_local QHash<qint64, LocalDay> s_days;
+
+LocalDay localDay(const QDate& date)
+{
+    qint64 julianDay = date.toJulianDay();
+    auto it = s_days.constFind(julianDay);
+    if (it != s_days.constEnd()) {
+        return *it;
+    }
+
+    if (s_days.size() >= MaxCachedDays) {
+        s_days.clear();
+    }
+
+    LocalDay day;
+    day.midnightMs = date.startOfDay().toMSecsSinceEpoch();
+    day.hasTransition = date.addDays(1).startOfDay().toMSecsSinceEpoch() - day.midnightMs != MsecsPerDay;
+    s_days.insert(julianDay, day);
+    return day;
+}
+
+inline int readDigits(const QChar *text, int count, bool *ok)
+{
+    int value = 0;
+    for (int i = 0; i < count; ++i) {
+        ushort ch = text[i].unicode();
+        if (ch < '0' || ch > '9') {
+            *ok = false;
+            return 0;
+        }
+        value = value * 10 + (ch - '0');
+    }
+    return value;
+}
+}
+
+qint64 DateCodec::toEpochMs(const QDate& date, int msecsOfDay)
+{
+    LocalDay day = localDay(date);
+    if (day.hasTransition) {
+        return QDateTime(date, QTime::fromMSecsSinceStartOfDay(msecsOfDay)).toMSecsSinceEpoch();
+    }
+    return day.midnightMs + msecsOfDay;
+}
+
+qint64 DateCodec::toEpochMs(const QDateTime& dateTime)
+{
+    if (dateTime.timeSpec() != Qt::LocalTime) {
+        return dateTime.toMSecsSinceEpoch();
+    }
+    return toEpochMs(dateTime.date(), dateTime.time().msecsSinceStartOfDay());
+}
+
+bool DateCodec::parse(const QString& text, qint64 *epochMs)
+{
+    if (text.size() < 19) {
+        return false;
+    }
+
+    const QChar *p = text.constData();
+    if (p[4] != '-' || p[7] != '-' || (p[10] != ' ' && p[10] != 'T') || p[13] != ':' || p[16] != ':') {
+        return false;
+    }
+
+    bool ok = true;
+    int year = readDigits(p, 4, &ok);
+    int month = readDigits(p + 5, 2, &ok);
+    int day = readDigits(p + 8, 2, &ok);
+    int hour = readDigits(p + 11, 2, &ok);
+    int minute = readDigits(p + 14, 2, &ok);
+    int second = readDigits(p + 17, 2, &ok);
+
+    // Optional fraction, only milliseconds are kept
+    int msec = 0;
+    if (text.size() > 20 && p[19] == '.') {
+        int digits = 0;
+        for (int i = 20; i < text.size() && p[i].isDigit(); ++i) {
+            if (digits < 3) {
+                msec = msec * 10 + p[i].digitValue();
+            }
+            digits++;
+        }
+        for (; digits < 3; ++digits) {
+            msec *= 10;
+        }
+    }
+
+    if (!ok || hour > 23 || minute > 59 || second > 59) {
+        return false;
+    }
+
+    QDate date(year, month, day);
+    if (!date.isValid()) {
+        return false;
+    }
+
+    *epochMs = toEpochMs(date, ((hour * 60 + minute) * 60 + second) * 1000 + msec);
+    return true;
+}
+
+bool DateCodec::decode(const QVariant& value, qint64 *epochMs)
+{
+    if (value.isNull()) {
+        return false;
+    }
+
+    switch (value.typeId()) {
+    case QMetaType::QDateTime: {
+        QDateTime dateTime = value.toDateTime();
+        if (!dateTime.isValid()) {
+            return false;
+        }
+        *epochMs = toEpochMs(dateTime);
+        return true;
+    }
+    case QMetaType::QDate: {
+        QDate date = value.toDate();
+        if (!date.isValid()) {
+            return false;
+        }
+        *epochMs = toEpochMs(date, 0);
+        return true;
+    }
+    default:
+        return parse(value.toString(), epochMs);
+    }
+}
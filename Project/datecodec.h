@@ -0,0 +1,27 @@
+// datecodec.h
+#ifndef DATECODEC_H
+#define DATECODEC_H
+
+#include <QDate>
+#include <QDateTime>
+#include <QString>
+#include <QVariant>
+
+// Fast conversions between database dates and epoch milliseconds.
+//
+// Local midnight is looked up once per calendar day and cached per thread,
+// so decoding a row is an addition instead of a full time zone conversion.
+// Days with a daylight saving change go through QDateTime.
+namespace DateCodec
+{
+    qint64 toEpochMs(const QDate& date, int msecsOfDay);
+    qint64 toEpochMs(const QDateTime& dateTime);
+
+    // Fixed "yyyy-MM-dd hh:mm:ss[.zzz]" parser (a 'T' separator is accepted too)
+    bool parse(const QString& text, qint64 *epochMs);
+
+    // Column value as delivered by the driver: QDateTime, QDate or text
+    bool decode(const QVariant& value, qint64 *epochMs);
+}
+
+#endif // DATECODEC_H
@@ -0,0 +1,373 @@
+// duplicatedetector.cpp
+#include "duplicatedetector.h"
+#include "writebehindqueue.h"
+#include <QtConcurrent>
+#include <QSet>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+inline quint64 mix64(quint64 x)
+{
+    // splitmix64 finaliser
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+QString normalize(const QString& text)
+{
+    QString decomposed = text.toCaseFolded().normalized(QString::NormalizationForm_D);
+    QString result;
+    result.reserve(decomposed.size());
+    for (QChar ch : decomposed) {
+        if (ch.category() == QChar::Mark_NonSpacing) {
+            continue;
+        }
+        result.append(ch.isLetterOrNumber() ? ch : QChar(' '));
+    }
+    return result.simplified();
+}
+
+void addShingles(QVector<quint64>& shingles, const QString& text, quint64 fieldSeed)
+{
+    if (text.isEmpty()) {
+        return;
+    }
+
+    // Padded so the first and last characters get shingles of their own
+    QString padded = " " + text + " ";
+    for (int i = 0; i + 3 <= padded.size(); ++i) {
+        quint64 gram = (quint64(padded.at(i).unicode()) << 32)
+                     | (quint64(padded.at(i + 1).unicode()) << 16)
+                     | quint64(padded.at(i + 2).unicode());
+        shingles.append(mix64(gram ^ fieldSeed));
+    }
+}
+}
+
+DuplicateDetector::DuplicateDetector(QObject *parent)
+    : QObject(parent), ready(false), hasPendingRebuild(false)
+{
+    connect(&rebuildWatcher, &QFutureWatcher<Signature>::finished, this, &DuplicateDetector::onRebuildFinished);
+}
+
+DuplicateDetector::~DuplicateDetector()
+{
+    rebuildWatcher.cancel();
+    rebuildWatcher.waitForFinished();
+}
+
+void DuplicateDetector::rebuild(const QList<Client>& list)
+{
+    // Changes from here on are not in the list
+    changesDuringRebuild.clear();
+    if (rebuildWatcher.isRunning()) {
+        pendingClients = list;
+        hasPendingRebuild = true;
+        return;
+    }
+    startRebuild(list);
+}
+
+void DuplicateDetector::startRebuild(const QList<Client>& list)
+{
+    rebuildClients = list;
+    rebuildWatcher.setFuture(QtConcurrent::mapped(rebuildClients, &DuplicateDetector::signature));
+}
+
+void DuplicateDetector::onRebuildFinished()
+{
+    if (rebuildWatcher.isCanceled()) {
+        return;
+    }
+    if (hasPendingRebuild) {
+        // This result is already out of date
+        hasPendingRebuild = false;
+        QList<Client> list;
+        list.swap(pendingClients);
+        startRebuild(list);
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<Signature> computed = rebuildWatcher.future().results();
+    QList<Client> list;
+    list.swap(rebuildClients);
+    QList<Change> changes;
+    changes.swap(changesDuringRebuild);
+
+    clients.clear();
+    clients.reserve(list.size());
+    signatures.clear();
+    buckets.clear();
+    for (int i = 0; i < list.size() && i < computed.size(); ++i) {
+        const Client& client = list.at(i);
+        clients.upsert(client);
+        signatures.insert(client.id, computed.at(i));
+        addToBuckets(client.id, computed.at(i));
+    }
+
+    // Upserts and removals are idempotent, so replaying ones the list
+    // already had is harmless
+    for (const Change& change : changes) {
+        if (change.removed) {
+            remove(change.clientId);
+        } else {
+            upsert(change.client);
+        }
+    }
+
+    ready = true;
+    qDebug() << "Duplicate detector built:" << clients.size() << "clients," << buckets.size()
+             << "buckets, swapped in" << timer.elapsed() << "ms";
+}
+
+void DuplicateDetector::attach(ClientDAO* dao)
+{
+    connect(dao, &ClientDAO::clientCreated, this, &DuplicateDetector::upsert);
+    connect(dao, &ClientDAO::clientUpdated, this, &DuplicateDetector::upsert);
+    connect(dao, &ClientDAO::clientDeleted, this, &DuplicateDetector::remove);
+}
+
+void DuplicateDetector::attach(WriteBehindQueue* queue)
+{
+    connect(queue, &WriteBehindQueue::clientCommitted, this, [this](int, const Client& client) {
+        upsert(client);
+    });
+}
+
+void DuplicateDetector::upsert(const Client& client)
+{
+    if (client.id <= 0) {
+        return;
+    }
+    remove(client.id);
+    // After remove(), which journals a removal of its own
+    if (isRebuilding()) {
+        changesDuringRebuild.append({client.id, false, client});
+    }
+
+    Signature sig = signature(client);
+    clients.upsert(client);
+    signatures.insert(client.id, sig);
+    addToBuckets(client.id, sig);
+}
+
+void DuplicateDetector::remove(int clientId)
+{
+    if (isRebuilding()) {
+        changesDuringRebuild.append({clientId, true, Client()});
+    }
+    auto it = signatures.find(clientId);
+    if (it == signatures.end()) {
+        return;
+    }
+    removeFromBuckets(clientId, it.value());
+    signatures.erase(it);
+    clients.remove(clientId);
+}
+
+QList<DuplicateDetector::Match> DuplicateDetector::findSimilar(const Client& draft, int excludeId,
+                                                               double threshold, int limit) const
+{
+    QList<Match> matches;
+    Signature sig = signature(draft);
+    if (sig.isEmpty()) {
+        return matches;
+    }
+
+    QSet<int> seen;
+    for (int band = 0; band < Bands; ++band) {
+        auto bucket = buckets.constFind(bandKey(sig, band));
+        if (bucket == buckets.constEnd()) {
+            continue;
+        }
+        for (int id : bucket.value()) {
+            if (id == excludeId || seen.contains(id)) {
+                continue;
+            }
+            seen.insert(id);
+
+            double score = similarity(sig, signatures.value(id));
+            if (score >= threshold) {
+                matches.append({draft.id, id, score});
+            }
+        }
+    }
+
+    std::sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) {
+        return a.similarity > b.similarity;
+    });
+    if (matches.size() > limit) {
+        matches.erase(matches.begin() + limit, matches.end());
+    }
+    return matches;
+}
+
+DuplicateDetector::Scan DuplicateDetector::findAllPairs(const QList<Client>& list, double threshold)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<Signature> sigs = QtConcurrent::blockingMapped<QList<Signature>>(list, &DuplicateDetector::signature);
+
+    // Bucket list positions one band at a time, then collect each pair once
+    QSet<quint64> pairKeys;
+    QSet<int> unchecked;
+    for (int band = 0; band < Bands; ++band) {
+        QHash<quint64, QVector<int>> bandBuckets;
+        for (int i = 0; i < sigs.size(); ++i) {
+            if (!sigs.at(i).isEmpty()) {
+                bandBuckets[bandKey(sigs.at(i), band)].append(i);
+            }
+        }
+        for (const QVector<int>& bucket : std::as_const(bandBuckets)) {
+            collectPairs(bucket, band, 1, sigs, pairKeys, unchecked);
+        }
+    }
+
+    QList<quint64> candidates(pairKeys.constBegin(), pairKeys.constEnd());
+    QList<Match> scored = QtConcurrent::blockingMapped<QList<Match>>(candidates, [&](quint64 key) {
+        int a = int(key >> 32);
+        int b = int(key & 0xffffffffu);
+        return Match{list.at(a).id, list.at(b).id, similarity(sigs.at(a), sigs.at(b))};
+    });
+
+    Scan scan;
+    scan.uncheckedClients = unchecked.size();
+    for (const Match& match : scored) {
+        if (match.similarity >= threshold) {
+            scan.pairs.append(match);
+        }
+    }
+    std::sort(scan.pairs.begin(), scan.pairs.end(), [](const Match& a, const Match& b) {
+        return a.similarity > b.similarity;
+    });
+
+    qDebug() << "Duplicate scan:" << list.size() << "clients," << candidates.size() << "candidate pairs,"
+             << scan.pairs.size() << "above" << threshold << "," << scan.uncheckedClients << "unchecked in"
+             << timer.elapsed() << "ms";
+    return scan;
+}
+
+void DuplicateDetector::collectPairs(const QVector<int>& bucket, int band, int depth, const QList<Signature>& sigs,
+                                     QSet<quint64>& pairKeys, QSet<int>& unchecked)
+{
+    if (bucket.size() < 2) {
+        return;
+    }
+
+    if (bucket.size() <= MaxBucketSize) {
+        for (int a = 0; a < bucket.size(); ++a) {
+            for (int b = a + 1; b < bucket.size(); ++b) {
+                pairKeys.insert((quint64(bucket.at(a)) << 32) | quint64(bucket.at(b)));
+            }
+        }
+        return;
+    }
+
+    // A crowded bucket (e.g. a common city with empty names) is split by
+    // the rows of the following bands; members agreeing on every band have
+    // the same signature and are only counted
+    if (depth == Bands) {
+        for (int index : bucket) {
+            unchecked.insert(index);
+        }
+        return;
+    }
+
+    QHash<quint64, QVector<int>> parts;
+    int nextBand = (band + depth) % Bands;
+    for (int index : bucket) {
+        parts[bandKey(sigs.at(index), nextBand)].append(index);
+    }
+    for (const QVector<int>& part : std::as_const(parts)) {
+        collectPairs(part, band, depth + 1, sigs, pairKeys, unchecked);
+    }
+}
+
+DuplicateDetector::Signature DuplicateDetector::signature(const Client& client)
+{
+    QVector<quint64> shingles;
+    addShingles(shingles, normalize(client.name), 0x6e616d65ULL);
+    addShingles(shingles, normalize(client.address), 0x61646472ULL);
+    addShingles(shingles, normalize(client.postal).remove(' '), 0x706f7374ULL);
+
+    Signature sig;
+    if (shingles.isEmpty()) {
+        return sig;
+    }
+
+    // Hash i of a shingle is h1 + i * h2 (Kirsch-Mitzenmacher), so one
+    // 64-bit hash per shingle feeds all 64 minimums
+    sig.fill(std::numeric_limits<quint32>::max(), SignatureSize);
+    for (quint64 shingle : shingles) {
+        quint32 h1 = quint32(shingle);
+        quint32 h2 = quint32(shingle >> 32) | 1u;
+        for (int i = 0; i < SignatureSize; ++i) {
+            quint32 value = h1 + quint32(i) * h2;
+            if (value < sig[i]) {
+                sig[i] = value;
+            }
+        }
+    }
+    return sig;
+}
+
+double DuplicateDetector::similarity(const Signature& a, const Signature& b)
+{
+    if (a.size() != SignatureSize || b.size() != SignatureSize) {
+        return 0.0;
+    }
+    int equal = 0;
+    for (int i = 0; i < SignatureSize; ++i) {
+        if (a.at(i) == b.at(i)) {
+            equal++;
+        }
+    }
+    return double(equal) / SignatureSize;
+}
+
+quint64 DuplicateDetector::bandKey(const Signature& signature, int band)
+{
+    quint64 key = mix64(quint64(band) + 1);
+    for (int row = 0; row < RowsPerBand; ++row) {
+        key = mix64(key ^ signature.at(band * RowsPerBand + row));
+    }
+    return key;
+}
+
+void DuplicateDetector::addToBuckets(int clientId, const Signature& signature)
+{
+    if (signature.isEmpty()) {
+        return;
+    }
+    for (int band = 0; band < Bands; ++band) {
+        buckets[bandKey(signature, band)].append(clientId);
+    }
+}
+
+void DuplicateDetector::removeFromBuckets(int clientId, const Signature& signature)
+{
+    if (signature.isEmpty()) {
+        return;
+    }
+    for (int band = 0; band < Bands; ++band) {
+        auto it = buckets.find(bandKey(signature, band));
+        if (it == buckets.end()) {
+            continue;
+        }
+        it.value().removeOne(clientId);
+        if (it.value().isEmpty()) {
+            buckets.erase(it);
+        }
+    }
+}
@@ -0,0 +1,107 @@
+// duplicatedetector.h
+#ifndef DUPLICATEDETECTOR_H
+#define DUPLICATEDETECTOR_H
+
+#include <QObject>
+#include <QList>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QFutureWatcher>
+
+#include "clients.h"
+#include "clientstore.h"
+
+class WriteBehindQueue;
+
+// Near-duplicate client detection with MinHash signatures and LSH banding.
+//
+// Name, address and postal code are normalised (case, accents, punctuation,
+// spacing) and cut into character 3-gram shingles. Each client gets a
+// 64-value MinHash signature whose agreement rate estimates the Jaccard
+// similarity of two shingle sets. Signatures are split into 16 bands of 4;
+// clients sharing any band land in the same bucket and only those pairs
+// are compared, so a full scan stays close to linear in the client count.
+//
+// findSimilar() serves the live check in ClientsWindow; findAllPairs() is
+// the batch job and may run off the GUI thread on a copied client list.
+// rebuild() computes the signatures on the thread pool and swaps them in
+// when done, replaying the changes seen in the meantime.
+class DuplicateDetector : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Match {
+        int clientId;
+        int otherId;
+        double similarity;   // Estimated Jaccard, 0..1
+    };
+
+    // findAllPairs() result; uncheckedClients share their whole signature
+    // with more than MaxBucketSize others and were not compared pairwise
+    struct Scan {
+        QList<Match> pairs;
+        int uncheckedClients = 0;
+    };
+
+    static const int SignatureSize = 64;
+    static const int Bands = 16;
+    static const int RowsPerBand = SignatureSize / Bands;
+    static const int MaxBucketSize = 500;
+
+    typedef QVector<quint32> Signature;
+
+    explicit DuplicateDetector(QObject *parent = nullptr);
+    ~DuplicateDetector();
+
+    void rebuild(const QList<Client>& clients);
+    void attach(ClientDAO* dao);
+    void attach(WriteBehindQueue* queue);
+
+    bool isReady() const { return ready; }
+    Client client(int id) const { return clients.client(id); }
+
+    // Existing clients resembling a draft, best first; excludeId skips the client being edited
+    QList<Match> findSimilar(const Client& draft, int excludeId = 0, double threshold = 0.6, int limit = 3) const;
+
+    // Every likely duplicate pair in the list, best first (signatures computed in parallel)
+    static Scan findAllPairs(const QList<Client>& clients, double threshold = 0.6);
+
+    static Signature signature(const Client& client);
+    static double similarity(const Signature& a, const Signature& b);
+
+public slots:
+    void upsert(const Client& client);
+    void remove(int clientId);
+
+private:
+    struct Change {
+        int clientId;
+        bool removed;
+        Client client;
+    };
+
+    ClientStore clients;
+    QHash<int, Signature> signatures;
+    QHash<quint64, QVector<int>> buckets;
+    bool ready;
+
+    QFutureWatcher<Signature> rebuildWatcher;
+    QList<Client> rebuildClients;       // The list being signed, kept alive for the watcher
+    QList<Client> pendingClients;       // A newer list asked for while signing
+    bool hasPendingRebuild;
+    QList<Change> changesDuringRebuild;
+
+    bool isRebuilding() const { return rebuildWatcher.isRunning() || hasPendingRebuild; }
+    void startRebuild(const QList<Client>& list);
+    void onRebuildFinished();
+
+    static quint64 bandKey(const Signature& signature, int band);
+    static void collectPairs(const QVector<int>& bucket, int band, int depth, const QList<Signature>& sigs,
+                             QSet<quint64>& pairKeys, QSet<int>& unchecked);
+    void addToBuckets(int clientId, const Signature& signature);
+    void removeFromBuckets(int clientId, const Signature& signature);
+};
+
+#endif // DUPLICATEDETECTOR_H
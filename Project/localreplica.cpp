@@ -0,0 +1,977 @@
+// localreplica.cpp
+#include "localreplica.h"
+#include "salesrollup.h"
+#include "querycache.h"
+#include "datecodec.h"
+#include "money.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QCoreApplication>
+#include <QThread>
+#include <QDir>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <QDebug>
+#include <algorithm>
+
+static const qint64 BucketSize = 1000;      // Ids per verification bucket
+static const int PushBatchSize = 200;       // Outbox entries per central transaction
+static const int PullChunkSize = 5000;      // Pulled rows per local transaction
+static const int IdPoolLow = 20;
+static const int IdPoolRefill = 100;
+
+static bool isMainThread()
+{
+    QCoreApplication *app = QCoreApplication::instance();
+    return !app || QThread::currentThread() == app->thread();
+}
+
+static QString threadConnectionName(const QString& base)
+{
+    return QString("%1_%2").arg(base).arg(quintptr(QThread::currentThreadId()));
+}
+
+LocalReplica::LocalReplica(QObject *parent)
+    : QObject(parent), syncTimer(nullptr), syncCount(0), verifyEvery(20), online(false)
+{
+    connect(&watcher, &QFutureWatcher<SyncResult>::finished, this, &LocalReplica::onSyncFinished);
+}
+
+LocalReplica::~LocalReplica()
+{
+    watcher.waitForFinished();
+}
+
+const QList<LocalReplica::Table>& LocalReplica::tables()
+{
+    // Parents first; pushes and pulls walk this list in order
+    static const QList<Table> list = {
+        {"CLIENTS", "ID",
+         {"ID", "NAME", "EMAIL", "CITY", "POSTAL", "ADDRESS"}, "CLIENTS_SEQ"},
+        {"COMMANDS", "COMMAND_ID",
+         {"COMMAND_ID", "CLIENT_ID", "COMMAND_DATE", "TOTAL", "PAYMENT_METHOD", "DELIVERY_ADDRESS"}, "COMMANDS_SEQ"}
+    };
+    return list;
+}
+
+const LocalReplica::Table* LocalReplica::tableNamed(const QString& name)
+{
+    for (const Table& table : tables()) {
+        if (table.name == name) {
+            return &table;
+        }
+    }
+    return nullptr;
+}
+
+QString LocalReplica::connectionName()
+{
+    return "ReplicaConnection";
+}
+
+bool LocalReplica::open(const QString& filePath)
+{
+    path = filePath;
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSqlDatabase local = QSqlDatabase::contains(connectionName())
+                             ? QSqlDatabase::database(connectionName(), false)
+                             : QSqlDatabase::addDatabase("QSQLITE", connectionName());
+    local.setDatabaseName(path);
+    if (!local.open()) {
+        qDebug() << "✗ Could not open local replica" << path << ":" << local.lastError().text();
+        return false;
+    }
+
+    QString error;
+    if (!ensureSchema(local, error)) {
+        qDebug() << "✗ Local replica schema failed:" << error;
+        local.close();
+        return false;
+    }
+
+    qDebug() << "✓ Local replica opened:" << path;
+    return true;
+}
+
+bool LocalReplica::isOpen() const
+{
+    return QSqlDatabase::contains(connectionName())
+           && QSqlDatabase::database(connectionName(), false).isOpen();
+}
+
+bool LocalReplica::hasData()
+{
+    QSqlQuery query(database());
+    return query.exec("SELECT COUNT(*) FROM REPLICA_STATE") && query.next() && query.value(0).toInt() > 0;
+}
+
+QSqlDatabase LocalReplica::database() const
+{
+    if (isMainThread()) {
+        return QSqlDatabase::database(connectionName(), false);
+    }
+
+    // Worker threads get their own handle on the same file
+    QString name = threadConnectionName(connectionName());
+    if (!QSqlDatabase::contains(name)) {
+        QSqlDatabase clone = QSqlDatabase::cloneDatabase(connectionName(), name);
+        if (!clone.open()) {
+            qDebug() << "Failed to open replica connection" << name << ":" << clone.lastError().text();
+        } else {
+            QSqlQuery(clone).exec("PRAGMA busy_timeout = 5000");
+        }
+    }
+    return QSqlDatabase::database(name);
+}
+
+void LocalReplica::releaseThreadDatabase()
+{
+    if (isMainThread()) {
+        return;
+    }
+
+    QString name = threadConnectionName(connectionName());
+    if (QSqlDatabase::contains(name)) {
+        {
+            QSqlDatabase threadDb = QSqlDatabase::database(name, false);
+            threadDb.close();
+        }
+        QSqlDatabase::removeDatabase(name);
+    }
+}
+
+bool LocalReplica::ensureSchema(QSqlDatabase& local, QString& error)
+{
+    // WAL lets the sync thread write while the GUI thread reads
+    const QStringList statements = {
+        "PRAGMA journal_mode = WAL",
+        "PRAGMA synchronous = NORMAL",
+        "PRAGMA busy_timeout = 5000",
+        "CREATE TABLE IF NOT EXISTS CLIENTS ("
+        "ID INTEGER PRIMARY KEY, "
+        "NAME TEXT NOT NULL, "
+        "EMAIL TEXT NOT NULL, "
+        "CITY TEXT, "
+        "POSTAL TEXT, "
+        "ADDRESS TEXT, "
+        "ROW_VERSION INTEGER NOT NULL DEFAULT 0, "
+        "ROW_CHECKSUM INTEGER)",
+        "CREATE TABLE IF NOT EXISTS COMMANDS ("
+        "COMMAND_ID INTEGER PRIMARY KEY, "
+        "CLIENT_ID INTEGER NOT NULL, "
+        "COMMAND_DATE TIMESTAMP NOT NULL, "
+        "TOTAL NUMERIC(12,2) NOT NULL, "
+        "PAYMENT_METHOD TEXT, "
+        "DELIVERY_ADDRESS TEXT, "
+        "ROW_VERSION INTEGER NOT NULL DEFAULT 0, "
+        "ROW_CHECKSUM INTEGER)",
+        "CREATE INDEX IF NOT EXISTS COMMANDS_CLIENT_DATE_IDX ON COMMANDS (CLIENT_ID, COMMAND_DATE)",
+        "CREATE INDEX IF NOT EXISTS COMMANDS_DATE_IDX ON COMMANDS (COMMAND_DATE)",
+        "CREATE INDEX IF NOT EXISTS COMMANDS_TOTAL_IDX ON COMMANDS (TOTAL)",
+        "CREATE INDEX IF NOT EXISTS CLIENTS_UPPER_EMAIL_IDX ON CLIENTS (UPPER(EMAIL))",
+        "CREATE INDEX IF NOT EXISTS CLIENTS_UPPER_NAME_IDX ON CLIENTS (UPPER(NAME))",
+        "CREATE TABLE IF NOT EXISTS REPLICA_STATE ("
+        "NAME TEXT PRIMARY KEY, "
+        "LAST_VERSION INTEGER NOT NULL)",
+        "CREATE TABLE IF NOT EXISTS REPLICA_OUTBOX ("
+        "SEQ INTEGER PRIMARY KEY AUTOINCREMENT, "
+        "TABLE_NAME TEXT NOT NULL, "
+        "ROW_ID INTEGER NOT NULL, "
+        "DELETED INTEGER NOT NULL, "
+        "REVISION INTEGER NOT NULL DEFAULT 0, "
+        "ATTEMPTS INTEGER NOT NULL DEFAULT 0, "
+        "LAST_ERROR TEXT)",
+        "CREATE UNIQUE INDEX IF NOT EXISTS REPLICA_OUTBOX_ROW_IDX ON REPLICA_OUTBOX (TABLE_NAME, ROW_ID)",
+        "CREATE TABLE IF NOT EXISTS REPLICA_ID_POOL ("
+        "TABLE_NAME TEXT NOT NULL, "
+        "ID INTEGER NOT NULL, "
+        "PRIMARY KEY (TABLE_NAME, ID))"
+    };
+
+    for (const QString& statement : statements) {
+        QSqlQuery query(local);
+        if (!query.exec(statement)) {
+            error = QString("%1\n   %2").arg(statement, query.lastError().text());
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LocalReplica::isReplica(const QSqlDatabase& db)
+{
+    return db.connectionName().startsWith(connectionName());
+}
+
+int LocalReplica::takeId(QSqlDatabase& db, const QString& table, QString& error)
+{
+    QSqlQuery query(db);
+    query.prepare("SELECT MIN(ID) FROM REPLICA_ID_POOL WHERE TABLE_NAME = ?");
+    query.addBindValue(table);
+    if (!query.exec() || !query.next() || query.value(0).isNull()) {
+        error = QString("No reserved %1 ids left; connect to the central database to get more").arg(table);
+        return 0;
+    }
+    int id = query.value(0).toInt();
+
+    QSqlQuery take(db);
+    take.prepare("DELETE FROM REPLICA_ID_POOL WHERE TABLE_NAME = ? AND ID = ?");
+    take.addBindValue(table);
+    take.addBindValue(id);
+    if (!take.exec()) {
+        error = "Could not take a reserved id: " + take.lastError().text();
+        return 0;
+    }
+    return id;
+}
+
+bool LocalReplica::recordChange(QSqlDatabase& db, const QString& table, int rowId, bool deleted, QString& error)
+{
+    if (!isReplica(db)) {
+        return true;
+    }
+
+    // One entry per row, kept at its first position; the revision tells a
+    // running push that the row changed again after it was read
+    QSqlQuery update(db);
+    update.prepare("UPDATE REPLICA_OUTBOX SET DELETED = ?, REVISION = REVISION + 1 "
+                   "WHERE TABLE_NAME = ? AND ROW_ID = ?");
+    update.addBindValue(deleted ? 1 : 0);
+    update.addBindValue(table);
+    update.addBindValue(rowId);
+    if (!update.exec()) {
+        error = "Outbox update failed: " + update.lastError().text();
+        return false;
+    }
+    if (update.numRowsAffected() > 0) {
+        return true;
+    }
+
+    QSqlQuery insert(db);
+    insert.prepare("INSERT INTO REPLICA_OUTBOX (TABLE_NAME, ROW_ID, DELETED) VALUES (?, ?, ?)");
+    insert.addBindValue(table);
+    insert.addBindValue(rowId);
+    insert.addBindValue(deleted ? 1 : 0);
+    if (!insert.exec()) {
+        error = "Outbox insert failed: " + insert.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+LocalReplica::SyncResult LocalReplica::sync(bool verifyRows)
+{
+    SyncResult result;
+    QElapsedTimer timer;
+    timer.start();
+
+    Connection& conn = Connection::getInstance();
+    {
+        QSqlDatabase local = database();
+        QSqlDatabase central = conn.getDatabase();
+
+        QSqlQuery ping(central);
+        bool reachable = central.isOpen()
+                         && ping.exec(Connection::dialectOf(central) == Connection::OracleDialect
+                                          ? "SELECT 1 FROM DUAL" : "SELECT 1");
+
+        if (!local.isOpen()) {
+            result.error = "Local replica is not open";
+        } else if (!reachable) {
+            result.error = "Central database unreachable: " + central.lastError().text();
+        } else {
+            result.online = true;
+            QString error;
+            bool ok = push(central, local, &result.pushed, error)
+                      && pull(central, local, &result.pulled, error)
+                      && topUpIds(central, local, error)
+                      && (!verifyRows || verify(central, local, &result.repaired, error));
+            if (!ok) {
+                result.error = error;
+            }
+        }
+
+        QSqlQuery pending(local);
+        if (pending.exec("SELECT COUNT(*) FROM REPLICA_OUTBOX") && pending.next()) {
+            result.pending = pending.value(0).toInt();
+        }
+    }
+
+    if (result.pulled + result.repaired > 0) {
+        QueryCache::instance().invalidate({"CLIENTS", "COMMANDS"});
+    }
+
+    qDebug() << QString("Replica sync: %1 pushed, %2 pulled, %3 repaired, %4 pending in %5 ms%6")
+                    .arg(result.pushed).arg(result.pulled).arg(result.repaired).arg(result.pending)
+                    .arg(timer.elapsed())
+                    .arg(result.error.isEmpty() ? QString() : " - " + result.error);
+
+    if (!isMainThread()) {
+        conn.releaseThreadDatabase();
+        releaseThreadDatabase();
+    }
+    return result;
+}
+
+void LocalReplica::syncNow(bool verifyRows)
+{
+    if (watcher.isRunning() || !isOpen()) {
+        return;
+    }
+    watcher.setFuture(QtConcurrent::run([this, verifyRows]() { return sync(verifyRows); }));
+}
+
+void LocalReplica::startPeriodicSync(int intervalMs, int everyNth)
+{
+    verifyEvery = qMax(1, everyNth);
+    if (!syncTimer) {
+        syncTimer = new QTimer(this);
+        connect(syncTimer, &QTimer::timeout, this, [this]() {
+            syncNow(++syncCount % verifyEvery == 0);
+        });
+    }
+    syncTimer->start(intervalMs);
+}
+
+int LocalReplica::pendingCount()
+{
+    QSqlQuery query(database());
+    return query.exec("SELECT COUNT(*) FROM REPLICA_OUTBOX") && query.next() ? query.value(0).toInt() : 0;
+}
+
+void LocalReplica::onSyncFinished()
+{
+    SyncResult result = watcher.result();
+
+    if (result.online != online) {
+        online = result.online;
+        emit onlineChanged(online);
+    }
+    emit pendingCountChanged(result.pending);
+
+    if (result.error.isEmpty()) {
+        emit synced(result.pushed, result.pulled, result.repaired);
+    } else {
+        emit syncFailed(result.error);
+    }
+}
+
+// Push
+
+static bool readRow(QSqlDatabase& db, const QString& table, const QString& key, const QStringList& columns,
+                    int id, QVariantList *values, QString& error)
+{
+    QSqlQuery query(db);
+    query.setNumericalPrecisionPolicy(QSql::HighPrecision);
+    query.prepare(QString("SELECT %1 FROM %2 WHERE %3 = ?").arg(columns.join(", "), table, key));
+    query.addBindValue(id);
+    if (!query.exec()) {
+        error = QString("Reading %1 %2 failed: %3").arg(table).arg(id).arg(query.lastError().text());
+        return false;
+    }
+
+    values->clear();
+    if (query.next()) {
+        for (int i = 0; i < columns.size(); ++i) {
+            values->append(query.value(i));
+        }
+    }
+    return true;
+}
+
+static Command commandFromRow(const QVariantList& values)
+{
+    Command command;
+    command.commandId = values.at(0).toInt();
+    command.clientId = values.at(1).toInt();
+    if (!DateCodec::decode(values.at(2), &command.commandDateMs)) {
+        command.commandDateMs = Command::NoDate;
+    }
+    command.total = Money::fromVariant(values.at(3));
+    command.paymentMethod = values.at(4).toString();
+    command.deliveryAddress = values.at(5).toString();
+    return command;
+}
+
+bool LocalReplica::push(QSqlDatabase& central, QSqlDatabase& local, int *pushed, QString& error)
+{
+    QList<OutboxEntry> entries;
+    QSqlQuery query(local);
+    if (!query.exec("SELECT SEQ, REVISION, TABLE_NAME, ROW_ID, DELETED FROM REPLICA_OUTBOX ORDER BY SEQ")) {
+        error = "Reading the outbox failed: " + query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        entries.append({query.value(0).toLongLong(), query.value(1).toInt(), query.value(2).toString(),
+                        query.value(3).toInt(), query.value(4).toInt() != 0});
+    }
+    if (entries.isEmpty()) {
+        return true;
+    }
+
+    // Upserts parents first, deletes children first, otherwise in outbox order
+    auto phase = [](const OutboxEntry& entry) {
+        int index = 0;
+        while (index < tables().size() && tables().at(index).name != entry.table) {
+            ++index;
+        }
+        return entry.deleted ? 2 * tables().size() - 1 - index : index;
+    };
+    std::stable_sort(entries.begin(), entries.end(), [&phase](const OutboxEntry& a, const OutboxEntry& b) {
+        return phase(a) < phase(b);
+    });
+
+    for (int start = 0; start < entries.size(); start += PushBatchSize) {
+        QList<OutboxEntry> batch = entries.mid(start, PushBatchSize);
+
+        central.transaction();
+        const OutboxEntry *failed = nullptr;
+        for (const OutboxEntry& entry : batch) {
+            if (!pushEntry(central, local, entry, error)) {
+                failed = &entry;
+                break;
+            }
+        }
+        if (!failed && !central.commit()) {
+            error = "Central commit failed: " + central.lastError().text();
+            failed = &batch.first();
+        }
+
+        if (failed) {
+            central.rollback();
+            QSqlQuery mark(local);
+            mark.prepare("UPDATE REPLICA_OUTBOX SET ATTEMPTS = ATTEMPTS + 1, LAST_ERROR = ? WHERE SEQ = ?");
+            mark.addBindValue(error);
+            mark.addBindValue(failed->seq);
+            mark.exec();
+            return false;
+        }
+
+        // Acknowledge; an entry whose row changed during the push stays queued
+        local.transaction();
+        for (const OutboxEntry& entry : batch) {
+            QSqlQuery ack(local);
+            ack.prepare("DELETE FROM REPLICA_OUTBOX WHERE SEQ = ? AND REVISION = ?");
+            ack.addBindValue(entry.seq);
+            ack.addBindValue(entry.revision);
+            ack.exec();
+        }
+        if (!local.commit()) {
+            // The rows are safely central; pushing them again later is harmless
+            qDebug() << "Outbox acknowledgement failed:" << local.lastError().text();
+            local.rollback();
+        }
+        *pushed += batch.size();
+    }
+    return true;
+}
+
+bool LocalReplica::pushEntry(QSqlDatabase& central, QSqlDatabase& local, const OutboxEntry& entry, QString& error)
+{
+    const Table* table = tableNamed(entry.table);
+    if (!table) {
+        error = "Unknown outbox table: " + entry.table;
+        return false;
+    }
+    bool isCommand = table->name == "COMMANDS";
+    SalesRollup rollup(central);
+
+    // Take the central row's old amount off the rollups first
+    if (isCommand) {
+        if (!rollup.lockState(error)) {
+            return false;
+        }
+        QVariantList previous;
+        if (!readRow(central, table->name, table->key, table->columns, entry.rowId, &previous, error)) {
+            return false;
+        }
+        if (!previous.isEmpty() && !rollup.removeCommand(commandFromRow(previous), error)) {
+            return false;
+        }
+    }
+
+    if (entry.deleted) {
+        QSqlQuery remove(central);
+        remove.prepare(QString("DELETE FROM %1 WHERE %2 = ?").arg(table->name, table->key));
+        remove.addBindValue(entry.rowId);
+        if (!remove.exec()) {
+            error = QString("Deleting %1 %2 failed: %3").arg(table->name).arg(entry.rowId).arg(remove.lastError().text());
+            return false;
+        }
+        return true;
+    }
+
+    QVariantList current;
+    if (!readRow(local, table->name, table->key, table->columns, entry.rowId, &current, error)) {
+        return false;
+    }
+    if (current.isEmpty()) {
+        return true;    // Gone locally without a delete entry; nothing to send
+    }
+
+    QStringList placeholders;
+    QStringList assignments;
+    for (const QString& column : table->columns.mid(1)) {
+        assignments << column;
+    }
+
+    QSqlQuery upsert(central);
+    if (Connection::dialectOf(central) == Connection::OracleDialect) {
+        QStringList sourceColumns;
+        QStringList sets;
+        QStringList values;
+        for (const QString& column : table->columns) {
+            sourceColumns << QString("? AS %1").arg(column);
+            values << "s." + column;
+        }
+        for (const QString& column : assignments) {
+            sets << QString("t.%1 = s.%1").arg(column);
+        }
+        upsert.prepare(QString("MERGE INTO %1 t USING (SELECT %2 FROM DUAL) s ON (t.%3 = s.%3) "
+                               "WHEN MATCHED THEN UPDATE SET %4 "
+                               "WHEN NOT MATCHED THEN INSERT (%5) VALUES (%6)")
+                           .arg(table->name, sourceColumns.join(", "), table->key, sets.join(", "),
+                                table->columns.join(", "), values.join(", ")));
+    } else {
+        QStringList sets;
+        for (int i = 0; i < table->columns.size(); ++i) {
+            placeholders << "?";
+        }
+        for (const QString& column : assignments) {
+            sets << QString("%1 = excluded.%1").arg(column);
+        }
+        upsert.prepare(QString("INSERT INTO %1 (%2) VALUES (%3) ON CONFLICT (%4) DO UPDATE SET %5")
+                           .arg(table->name, table->columns.join(", "), placeholders.join(", "),
+                                table->key, sets.join(", ")));
+    }
+    for (int i = 0; i < table->columns.size(); ++i) {
+        upsert.addBindValue(storedValue(table->columns.at(i), current.at(i)));
+    }
+    if (!upsert.exec()) {
+        error = QString("Sending %1 %2 failed: %3").arg(table->name).arg(entry.rowId).arg(upsert.lastError().text());
+        return false;
+    }
+
+    return !isCommand || rollup.addCommand(commandFromRow(current), error);
+}
+
+// Pull
+
+bool LocalReplica::pull(QSqlDatabase& central, QSqlDatabase& local, int *pulled, QString& error)
+{
+    QHash<QString, QSet<int>> pending = pendingRows(local);
+
+    for (const Table& table : tables()) {
+        qint64 version = lastVersion(local, table.name);
+        const QSet<int> skip = pending.value(table.name);
+
+        QSqlQuery query(central);
+        query.setForwardOnly(true);
+        query.setNumericalPrecisionPolicy(QSql::HighPrecision);
+        query.prepare(QString("SELECT %1, ROW_VERSION FROM %2 WHERE ROW_VERSION > ? ORDER BY ROW_VERSION")
+                          .arg(table.columns.join(", "), table.name));
+        query.addBindValue(version);
+        if (!query.exec()) {
+            error = QString("Pulling %1 failed: %2").arg(table.name, query.lastError().text());
+            return false;
+        }
+
+        // Committed in chunks so an interrupted first copy keeps its progress
+        int inChunk = 0;
+        local.transaction();
+        while (query.next()) {
+            QVariantList values;
+            for (int i = 0; i < table.columns.size(); ++i) {
+                values.append(storedValue(table.columns.at(i), query.value(i)));
+            }
+            version = query.value(table.columns.size()).toLongLong();
+
+            if (!skip.contains(values.first().toInt())) {
+                if (!writeRow(local, table, values, version, error)) {
+                    local.rollback();
+                    return false;
+                }
+                ++*pulled;
+            }
+
+            if (++inChunk == PullChunkSize) {
+                if (!setLastVersion(local, table.name, version, error) || !local.commit()) {
+                    local.rollback();
+                    return false;
+                }
+                local.transaction();
+                inChunk = 0;
+            }
+        }
+
+        if (!setLastVersion(local, table.name, version, error) || !local.commit()) {
+            local.rollback();
+            return false;
+        }
+    }
+
+    return pullTombstones(central, local, pulled, error);
+}
+
+bool LocalReplica::pullTombstones(QSqlDatabase& central, QSqlDatabase& local, int *pulled, QString& error)
+{
+    QHash<QString, QSet<int>> pending = pendingRows(local);
+    qint64 version = lastVersion(local, "DELETED_ROWS");
+
+    QSqlQuery query(central);
+    query.setForwardOnly(true);
+    query.setNumericalPrecisionPolicy(QSql::HighPrecision);
+    query.prepare("SELECT TABLE_NAME, ROW_ID, ROW_VERSION FROM DELETED_ROWS "
+                  "WHERE ROW_VERSION > ? ORDER BY ROW_VERSION");
+    query.addBindValue(version);
+    if (!query.exec()) {
+        error = "Pulling deletes failed: " + query.lastError().text();
+        return false;
+    }
+
+    local.transaction();
+    while (query.next()) {
+        QString name = query.value(0).toString();
+        int rowId = query.value(1).toInt();
+        version = query.value(2).toLongLong();
+
+        const Table* table = tableNamed(name);
+        if (!table || pending.value(name).contains(rowId)) {
+            continue;
+        }
+
+        QSqlQuery remove(local);
+        remove.prepare(QString("DELETE FROM %1 WHERE %2 = ?").arg(table->name, table->key));
+        remove.addBindValue(rowId);
+        if (!remove.exec()) {
+            error = "Applying a delete failed: " + remove.lastError().text();
+            local.rollback();
+            return false;
+        }
+        *pulled += remove.numRowsAffected() > 0 ? 1 : 0;
+    }
+
+    if (!setLastVersion(local, "DELETED_ROWS", version, error) || !local.commit()) {
+        local.rollback();
+        return false;
+    }
+    return true;
+}
+
+// Verification
+
+QString LocalReplica::bucketExpression(Connection::Dialect dialect, const QString& key)
+{
+    return dialect == Connection::OracleDialect
+               ? QString("FLOOR(%1 / %2)").arg(key).arg(BucketSize)
+               : QString("(%1 / %2)").arg(key).arg(BucketSize);
+}
+
+bool LocalReplica::verify(QSqlDatabase& central, QSqlDatabase& local, int *repaired, QString& error)
+{
+    QHash<QString, QSet<int>> pending = pendingRows(local);
+
+    for (const Table& table : tables()) {
+        const QSet<int> pendingIds = pending.value(table.name);
+        QSet<qint64> suspect;
+
+        // Stored checksums against the values now in the file; rows edited
+        // locally since the last pull are expected to differ
+        QSqlQuery rows(local);
+        rows.setForwardOnly(true);
+        if (!rows.exec(QString("SELECT %1, ROW_CHECKSUM FROM %2 WHERE ROW_CHECKSUM IS NOT NULL")
+                           .arg(table.columns.join(", "), table.name))) {
+            error = QString("Reading local %1 failed: %2").arg(table.name, rows.lastError().text());
+            return false;
+        }
+        while (rows.next()) {
+            QVariantList values;
+            for (int i = 0; i < table.columns.size(); ++i) {
+                values.append(storedValue(table.columns.at(i), rows.value(i)));
+            }
+            if (!pendingIds.contains(values.first().toInt())
+                && rowChecksum(values) != rows.value(table.columns.size()).toLongLong()) {
+                suspect.insert(values.first().toLongLong() / BucketSize);
+            }
+        }
+
+        // Row count and version sum per bucket on both sides
+        auto summarize = [&table](QSqlDatabase& db, QHash<qint64, QPair<qint64, qint64>> *buckets, QString& err) {
+            QString bucket = bucketExpression(Connection::dialectOf(db), table.key);
+            QSqlQuery query(db);
+            query.setForwardOnly(true);
+            query.setNumericalPrecisionPolicy(QSql::HighPrecision);
+            if (!query.exec(QString("SELECT %1, COUNT(*), SUM(ROW_VERSION) FROM %2 GROUP BY %1")
+                                .arg(bucket, table.name))) {
+                err = QString("Summarising %1 failed: %2").arg(table.name, query.lastError().text());
+                return false;
+            }
+            while (query.next()) {
+                buckets->insert(query.value(0).toLongLong(),
+                                qMakePair(query.value(1).toLongLong(), query.value(2).toLongLong()));
+            }
+            return true;
+        };
+
+        QHash<qint64, QPair<qint64, qint64>> centralBuckets;
+        QHash<qint64, QPair<qint64, qint64>> localBuckets;
+        if (!summarize(central, &centralBuckets, error) || !summarize(local, &localBuckets, error)) {
+            return false;
+        }
+        for (auto it = centralBuckets.constBegin(); it != centralBuckets.constEnd(); ++it) {
+            if (localBuckets.value(it.key()) != it.value()) {
+                suspect.insert(it.key());
+            }
+        }
+        for (auto it = localBuckets.constBegin(); it != localBuckets.constEnd(); ++it) {
+            if (!centralBuckets.contains(it.key())) {
+                suspect.insert(it.key());
+            }
+        }
+
+        for (qint64 bucket : suspect) {
+            if (!repairBucket(central, local, table, bucket, pendingIds, repaired, error)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool LocalReplica::repairBucket(QSqlDatabase& central, QSqlDatabase& local, const Table& table, qint64 bucket,
+                                const QSet<int>& pending, int *repaired, QString& error)
+{
+    qint64 low = bucket * BucketSize;
+    qint64 high = low + BucketSize;
+
+    // What the file holds now: id -> (version, checksum)
+    QHash<int, QPair<qint64, qint64>> held;
+    QSqlQuery existing(local);
+    existing.prepare(QString("SELECT %1, ROW_VERSION, ROW_CHECKSUM FROM %2 WHERE %1 >= ? AND %1 < ?")
+                         .arg(table.key, table.name));
+    existing.addBindValue(low);
+    existing.addBindValue(high);
+    if (!existing.exec()) {
+        error = "Reading a local bucket failed: " + existing.lastError().text();
+        return false;
+    }
+    while (existing.next()) {
+        held.insert(existing.value(0).toInt(), qMakePair(existing.value(1).toLongLong(), existing.value(2).toLongLong()));
+    }
+
+    QSqlQuery query(central);
+    query.setForwardOnly(true);
+    query.setNumericalPrecisionPolicy(QSql::HighPrecision);
+    query.prepare(QString("SELECT %1, ROW_VERSION FROM %2 WHERE %3 >= ? AND %3 < ?")
+                      .arg(table.columns.join(", "), table.name, table.key));
+    query.addBindValue(low);
+    query.addBindValue(high);
+    if (!query.exec()) {
+        error = "Reading a central bucket failed: " + query.lastError().text();
+        return false;
+    }
+
+    local.transaction();
+    while (query.next()) {
+        QVariantList values;
+        for (int i = 0; i < table.columns.size(); ++i) {
+            values.append(storedValue(table.columns.at(i), query.value(i)));
+        }
+        qint64 version = query.value(table.columns.size()).toLongLong();
+        int id = values.first().toInt();
+
+        auto heldRow = held.constFind(id);
+        bool same = heldRow != held.constEnd()
+                    && heldRow.value().first == version && heldRow.value().second == rowChecksum(values);
+        held.remove(id);
+        if (same || pending.contains(id)) {
+            continue;
+        }
+        if (!writeRow(local, table, values, version, error)) {
+            local.rollback();
+            return false;
+        }
+        ++*repaired;
+    }
+
+    // Whatever is left no longer exists centrally
+    for (auto it = held.constBegin(); it != held.constEnd(); ++it) {
+        if (pending.contains(it.key())) {
+            continue;
+        }
+        QSqlQuery remove(local);
+        remove.prepare(QString("DELETE FROM %1 WHERE %2 = ?").arg(table.name, table.key));
+        remove.addBindValue(it.key());
+        if (!remove.exec()) {
+            error = "Removing a stale row failed: " + remove.lastError().text();
+            local.rollback();
+            return false;
+        }
+        ++*repaired;
+    }
+
+    if (!local.commit()) {
+        error = "Repair commit failed: " + local.lastError().text();
+        local.rollback();
+        return false;
+    }
+    return true;
+}
+
+// Id pool
+
+bool LocalReplica::topUpIds(QSqlDatabase& central, QSqlDatabase& local, QString& error)
+{
+    // Only the Oracle schema has the sequences
+    if (Connection::dialectOf(central) != Connection::OracleDialect) {
+        return true;
+    }
+
+    for (const Table& table : tables()) {
+        QSqlQuery count(local);
+        count.prepare("SELECT COUNT(*) FROM REPLICA_ID_POOL WHERE TABLE_NAME = ?");
+        count.addBindValue(table.name);
+        if (!count.exec() || !count.next()) {
+            error = "Reading the id pool failed: " + count.lastError().text();
+            return false;
+        }
+        if (count.value(0).toInt() >= IdPoolLow) {
+            continue;
+        }
+
+        QSqlQuery reserve(central);
+        if (!reserve.exec(QString("SELECT %1.NEXTVAL FROM DUAL CONNECT BY LEVEL <= %2")
+                              .arg(table.sequence).arg(IdPoolRefill))) {
+            error = QString("Reserving %1 ids failed: %2").arg(table.name, reserve.lastError().text());
+            return false;
+        }
+
+        local.transaction();
+        while (reserve.next()) {
+            QSqlQuery insert(local);
+            insert.prepare("INSERT OR IGNORE INTO REPLICA_ID_POOL (TABLE_NAME, ID) VALUES (?, ?)");
+            insert.addBindValue(table.name);
+            insert.addBindValue(reserve.value(0).toInt());
+            insert.exec();
+        }
+        if (!local.commit()) {
+            error = "Storing reserved ids failed: " + local.lastError().text();
+            local.rollback();
+            return false;
+        }
+    }
+    return true;
+}
+
+// Helpers
+
+bool LocalReplica::writeRow(QSqlDatabase& local, const Table& table, const QVariantList& values,
+                            qint64 version, QString& error)
+{
+    QStringList placeholders;
+    for (int i = 0; i < table.columns.size() + 2; ++i) {
+        placeholders << "?";
+    }
+
+    QSqlQuery query(local);
+    query.prepare(QString("INSERT OR REPLACE INTO %1 (%2, ROW_VERSION, ROW_CHECKSUM) VALUES (%3)")
+                      .arg(table.name, table.columns.join(", "), placeholders.join(", ")));
+    for (const QVariant& value : values) {
+        query.addBindValue(value);
+    }
+    query.addBindValue(version);
+    query.addBindValue(rowChecksum(values));
+
+    if (!query.exec()) {
+        error = QString("Writing local %1 failed: %2").arg(table.name, query.lastError().text());
+        return false;
+    }
+    return true;
+}
+
+QHash<QString, QSet<int>> LocalReplica::pendingRows(QSqlDatabase& local)
+{
+    QHash<QString, QSet<int>> rows;
+    QSqlQuery query(local);
+    if (query.exec("SELECT TABLE_NAME, ROW_ID FROM REPLICA_OUTBOX")) {
+        while (query.next()) {
+            rows[query.value(0).toString()].insert(query.value(1).toInt());
+        }
+    }
+    return rows;
+}
+
+qint64 LocalReplica::lastVersion(QSqlDatabase& local, const QString& name)
+{
+    // -1 so the first pull includes rows still at version 0
+    QSqlQuery query(local);
+    query.prepare("SELECT LAST_VERSION FROM REPLICA_STATE WHERE NAME = ?");
+    query.addBindValue(name);
+    return query.exec() && query.next() ? query.value(0).toLongLong() : -1;
+}
+
+bool LocalReplica::setLastVersion(QSqlDatabase& local, const QString& name, qint64 version, QString& error)
+{
+    QSqlQuery query(local);
+    query.prepare("INSERT OR REPLACE INTO REPLICA_STATE (NAME, LAST_VERSION) VALUES (?, ?)");
+    query.addBindValue(name);
+    query.addBindValue(version);
+    if (!query.exec()) {
+        error = "Saving the replica state failed: " + query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+QVariant LocalReplica::storedValue(const QString& column, const QVariant& value)
+{
+    // One representation for values read from either database
+    if (value.isNull()) {
+        return QVariant();
+    }
+    if (column == "COMMAND_DATE") {
+        qint64 epochMs;
+        return DateCodec::decode(value, &epochMs) ? QVariant(QDateTime::fromMSecsSinceEpoch(epochMs)) : QVariant();
+    }
+    if (column == "TOTAL") {
+        return Money::fromVariant(value).toDouble();
+    }
+    if (column == "ID" || column.endsWith("_ID")) {
+        return value.toInt();
+    }
+    return value.toString();
+}
+
+qint64 LocalReplica::rowChecksum(const QVariantList& values)
+{
+    // 64-bit FNV-1a over the canonical text of each value
+    quint64 hash = 14695981039346656037ULL;
+    auto feed = [&hash](const QByteArray& bytes) {
+        for (char byte : bytes) {
+            hash ^= quint8(byte);
+            hash *= 1099511628211ULL;
+        }
+        hash ^= 0x1f;
+        hash *= 1099511628211ULL;
+    };
+
+    for (const QVariant& value : values) {
+        switch (value.typeId()) {
+        case QMetaType::UnknownType:
+            feed(QByteArray("\\N"));
+            break;
+        case QMetaType::QDateTime:
+            feed(QByteArray::number(value.toDateTime().toMSecsSinceEpoch()));
+            break;
+        case QMetaType::Double:
+            feed(QByteArray::number(qRound64(value.toDouble() * 100)));
+            break;
+        default:
+            feed(value.toString().toUtf8());
+            break;
+        }
+    }
+    return qint64(hash);
+}
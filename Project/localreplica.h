@@ -0,0 +1,139 @@
+// localreplica.h
+#ifndef LOCALREPLICA_H
+#define LOCALREPLICA_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QSet>
+#include <QHash>
+#include <QVariant>
+#include <QTimer>
+#include <QFutureWatcher>
+#include <QSqlDatabase>
+
+#include "connection.h"
+
+// Local SQLite copy of CLIENTS and COMMANDS for sites with a slow or
+// unreliable link to the central database.
+//
+// While a replica is attached to Connection, ClientDAO and CommandDAO read
+// and write the local file. Every write also records the row in
+// REPLICA_OUTBOX in the same local transaction; sync() later pushes the
+// current state of those rows to the central database in batches (clients
+// before orders, deletes last, so foreign keys hold) and applies the sales
+// rollup deltas there. Conflicting edits are last writer wins.
+//
+// The central tables carry a ROW_VERSION set from ROW_VERSION_SEQ by
+// triggers, and deletes leave a tombstone in DELETED_ROWS (migration 5).
+// A pull fetches rows and tombstones newer than the last version seen.
+// Rows with local changes still waiting in the outbox are left alone.
+//
+// Every pulled row stores a checksum of its values. verify() recomputes
+// the checksums and compares per-bucket row counts and version sums with
+// the central tables. Buckets that disagree are copied again, which also
+// catches a row whose version was assigned before, but committed after,
+// the last pull.
+//
+// New rows need ids while offline, so sync() keeps a pool of ids reserved
+// from the central sequences. A create fails once the pool is used up.
+class LocalReplica : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct SyncResult {
+        bool online = false;
+        int pushed = 0;
+        int pulled = 0;
+        int repaired = 0;
+        int pending = 0;
+        QString error;
+    };
+
+    explicit LocalReplica(QObject *parent = nullptr);
+    ~LocalReplica();
+
+    bool open(const QString& path);
+    bool isOpen() const;
+    bool hasData();
+
+    // Per-thread handle, like Connection::getDatabase()
+    QSqlDatabase database() const;
+    void releaseThreadDatabase();
+
+    // Write path, called inside the DAO transaction on database()
+    static bool isReplica(const QSqlDatabase& db);
+    static int takeId(QSqlDatabase& db, const QString& table, QString& error);
+    // No-op on any other database
+    static bool recordChange(QSqlDatabase& db, const QString& table, int rowId, bool deleted, QString& error);
+
+    // Push the outbox, pull newer rows and optionally verify; blocking,
+    // runs on whatever thread calls it
+    SyncResult sync(bool verify);
+
+    // Background sync through the thread pool; a call while one runs is dropped
+    void syncNow(bool verify = false);
+    void startPeriodicSync(int intervalMs, int verifyEvery = 20);
+    bool isSyncing() const { return watcher.isRunning(); }
+    bool isOnline() const { return online; }
+    int pendingCount();
+
+signals:
+    void synced(int pushed, int pulled, int repaired);
+    void syncFailed(const QString& error);
+    void onlineChanged(bool online);
+    void pendingCountChanged(int count);
+
+private:
+    struct Table {
+        QString name;
+        QString key;
+        QStringList columns;    // Key first
+        QString sequence;
+    };
+
+    struct OutboxEntry {
+        qint64 seq;
+        int revision;
+        QString table;
+        int rowId;
+        bool deleted;
+    };
+
+    QString path;
+    QTimer *syncTimer;
+    QFutureWatcher<SyncResult> watcher;
+    int syncCount;
+    int verifyEvery;
+    bool online;
+
+    static const QList<Table>& tables();
+    static const Table* tableNamed(const QString& name);
+    static QString connectionName();
+
+    bool ensureSchema(QSqlDatabase& local, QString& error);
+
+    bool push(QSqlDatabase& central, QSqlDatabase& local, int *pushed, QString& error);
+    bool pushEntry(QSqlDatabase& central, QSqlDatabase& local, const OutboxEntry& entry, QString& error);
+    bool pull(QSqlDatabase& central, QSqlDatabase& local, int *pulled, QString& error);
+    bool pullTombstones(QSqlDatabase& central, QSqlDatabase& local, int *pulled, QString& error);
+    bool verify(QSqlDatabase& central, QSqlDatabase& local, int *repaired, QString& error);
+    bool repairBucket(QSqlDatabase& central, QSqlDatabase& local, const Table& table, qint64 bucket,
+                      const QSet<int>& pending, int *repaired, QString& error);
+    bool topUpIds(QSqlDatabase& central, QSqlDatabase& local, QString& error);
+
+    bool writeRow(QSqlDatabase& local, const Table& table, const QVariantList& values, qint64 version, QString& error);
+    QHash<QString, QSet<int>> pendingRows(QSqlDatabase& local);
+    qint64 lastVersion(QSqlDatabase& local, const QString& name);
+    bool setLastVersion(QSqlDatabase& local, const QString& name, qint64 version, QString& error);
+
+    static QVariant storedValue(const QString& column, const QVariant& value);
+    static qint64 rowChecksum(const QVariantList& values);
+    static QString bucketExpression(Connection::Dialect dialect, const QString& key);
+
+    void onSyncFinished();
+};
+
+#endif // LOCALREPLICA_H
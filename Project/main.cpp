@@ -3,9 +3,18 @@
 #include <QDebug>
 #include <QSqlDatabase>
 #include <QDir>
+#include <QFuture>
+#include <QtConcurrent>
+#include <QStandardPaths>
+#include <QThread>
 
 #include "mainwindow.h"
 #include "connection.h"
+#include "schemamigrator.h"
+#include "salesrollup.h"
+#include "querycache.h"
+#include "localreplica.h"
+#include "trace.h"
 
 int main(int argc, char *argv[])
 {
@@ -18,6 +27,16 @@ int main(int argc, char *argv[])
     app.setOrganizationName("Your Company");
     app.setOrganizationDomain("yourcompany.com");
 
+#ifdef CMS_TRACE
+    // --trace FILE records trace spans from startup and writes them on exit
+    QString traceFile;
+    int traceArg = app.arguments().indexOf("--trace");
+    if (traceArg > 0 && traceArg + 1 < app.arguments().size()) {
+        traceFile = app.arguments().at(traceArg + 1);
+        Trace::setEnabled(true);
+    }
+#endif
+
     qDebug() << "=== Starting Client Management System ===";
     qDebug() << "Qt Version:" << QT_VERSION_STR;
     qDebug() << "Working Directory:" << QDir::currentPath();
@@ -29,7 +48,35 @@ int main(int argc, char *argv[])
     qDebug() << "Initializing database connection...";
     Connection& conn = Connection::getInstance();
 
-    if (!conn.createConnection()) {
+    // The data layer only logs errors; show them here, on the GUI thread
+    conn.setErrorHandler([](const QString& title, const QString& message) {
+        if (QThread::currentThread() != qApp->thread()) {
+            return;
+        }
+        if (title == "Driver Error" || title == "Connection Failed") {
+            QMessageBox::critical(nullptr, title, message);
+        } else {
+            QMessageBox::warning(nullptr, title, message);
+        }
+    });
+
+    // --replica keeps a local copy of the data and works through it, so the
+    // application stays usable while the central database is unreachable
+    LocalReplica *replica = nullptr;
+    if (app.arguments().contains("--replica")) {
+        replica = new LocalReplica(&app);
+        QString path = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/replica.sqlite";
+        if (!replica->open(path)) {
+            delete replica;
+            replica = nullptr;
+        }
+    }
+
+    bool online = conn.createConnection();
+    if (!online && replica && replica->hasData()) {
+        qDebug() << "⚠ Central database unreachable, working from the local replica";
+        conn.attachReplica(replica);
+    } else if (!online) {
         qDebug() << "Failed to establish database connection!";
 
         // Show error message to user
@@ -46,60 +93,88 @@ int main(int argc, char *argv[])
         return -1; // Exit with error code
     }
 
-    qDebug() << "✓ Database connection established successfully!";
-
-    // Test database tables
-    qDebug() << "Testing database tables...";
-    QStringList tables = conn.getDatabase().tables();
-    qDebug() << "Available tables:" << tables;
-
-    // Check for required tables
     bool clientsTableExists = false;
     bool commandsTableExists = false;
+    QFuture<void> rollupBackfill;
+
+    if (online) {
+        qDebug() << "✓ Database connection established successfully!";
+
+        // Test database tables
+        qDebug() << "Testing database tables...";
+        QStringList tables = conn.getDatabase().tables();
+        qDebug() << "Available tables:" << tables;
+
+        // Check for required tables
+        for (const QString& table : tables) {
+            if (table.toUpper() == "CLIENTS") {
+                clientsTableExists = true;
+                qDebug() << "✓ CLIENTS table found";
+            }
+            if (table.toUpper() == "COMMANDS") {
+                commandsTableExists = true;
+                qDebug() << "✓ COMMANDS table found";
+            }
+        }
 
-    for (const QString& table : tables) {
-        if (table.toUpper() == "CLIENTS") {
-            clientsTableExists = true;
-            qDebug() << "✓ CLIENTS table found";
+        // Bring the schema up to date (creates missing tables, indexes)
+        SchemaMigrator migrator(conn.getDatabase());
+        if (migrator.migrate()) {
+            clientsTableExists = commandsTableExists = true;
+        } else {
+            qDebug() << "⚠ WARNING: schema migration failed";
+            QMessageBox::warning(nullptr,
+                                 "Schema Warning",
+                                 "The database schema could not be brought up to date.\n"
+                                 "Some features may not work correctly.\n\n" + migrator.report());
         }
-        if (table.toUpper() == "COMMANDS") {
-            commandsTableExists = true;
-            qDebug() << "✓ COMMANDS table found";
+        qDebug() << "Schema version:" << migrator.currentVersion();
+
+        // Roll up every complete day in the background; today stays in the raw tail
+        rollupBackfill = QtConcurrent::run([]() {
+            Connection& worker = Connection::getInstance();
+            QString error;
+            if (!SalesRollup(worker.getDatabase()).backfillUntil(QDate::currentDate(), error)) {
+                qDebug() << "⚠ Sales rollup backfill failed:" << error;
+            }
+            worker.releaseThreadDatabase();
+        });
+
+        // Test database with simple queries
+        if (clientsTableExists) {
+            QSqlQuery clientCount = conn.executeSelectQuery("SELECT COUNT(*) FROM CLIENTS");
+            if (clientCount.next()) {
+                int count = clientCount.value(0).toInt();
+                qDebug() << "Number of clients in database:" << count;
+            }
         }
-    }
-
-    // Warn if tables don't exist
-    if (!clientsTableExists) {
-        qDebug() << "⚠ WARNING: CLIENTS table not found";
-        QMessageBox::warning(nullptr,
-                             "Table Warning",
-                             "CLIENTS table not found in database.\n"
-                             "Some features may not work correctly.");
-    }
 
-    if (!commandsTableExists) {
-        qDebug() << "⚠ WARNING: COMMANDS table not found";
-        QMessageBox::warning(nullptr,
-                             "Table Warning",
-                             "COMMANDS table not found in database.\n"
-                             "Some features may not work correctly.");
-    }
+        if (commandsTableExists) {
+            QSqlQuery commandCount = conn.executeSelectQuery("SELECT COUNT(*) FROM COMMANDS");
+            if (commandCount.next()) {
+                int count = commandCount.value(0).toInt();
+                qDebug() << "Number of commands in database:" << count;
+            }
+        }
 
-    // Test database with simple queries
-    if (clientsTableExists) {
-        QSqlQuery clientCount = conn.executeSelectQuery("SELECT COUNT(*) FROM CLIENTS");
-        if (clientCount.next()) {
-            int count = clientCount.value(0).toInt();
-            qDebug() << "Number of clients in database:" << count;
+        // First run copies everything before the window reads from the replica
+        if (replica) {
+            if (!replica->hasData()) {
+                LocalReplica::SyncResult initial = replica->sync(true);
+                if (!initial.error.isEmpty()) {
+                    qDebug() << "⚠ Initial replica sync failed:" << initial.error;
+                }
+            }
+            if (replica->hasData()) {
+                conn.attachReplica(replica);
+            }
         }
     }
 
-    if (commandsTableExists) {
-        QSqlQuery commandCount = conn.executeSelectQuery("SELECT COUNT(*) FROM COMMANDS");
-        if (commandCount.next()) {
-            int count = commandCount.value(0).toInt();
-            qDebug() << "Number of commands in database:" << count;
-        }
+    if (conn.replica()) {
+        clientsTableExists = commandsTableExists = true;
+        conn.replica()->startPeriodicSync(30 * 1000);
+        conn.replica()->syncNow();
     }
 
     // Create and show the main window
@@ -114,15 +189,24 @@ int main(int argc, char *argv[])
     window.show();
     qDebug() << "✓ Main window displayed";
 
-    // Show success message
-    QMessageBox::information(&window,
-                             "Connection Successful",
-                             QString("Successfully connected to database 'lakhoua'!\n\n"
-                                     "Tables found:\n"
-                                     "• CLIENTS: %1\n"
-                                     "• COMMANDS: %2")
-                                 .arg(clientsTableExists ? "✓ Available" : "✗ Missing")
-                                 .arg(commandsTableExists ? "✓ Available" : "✗ Missing"));
+    if (!online) {
+        window.setWindowTitle("Client Management System - Offline (local replica)");
+        QMessageBox::warning(&window,
+                             "Working Offline",
+                             "The lakhoua database is unreachable.\n\n"
+                             "Changes are kept in the local replica and sent once the\n"
+                             "connection is back.");
+    } else {
+        // Show success message
+        QMessageBox::information(&window,
+                                 "Connection Successful",
+                                 QString("Successfully connected to database 'lakhoua'!\n\n"
+                                         "Tables found:\n"
+                                         "• CLIENTS: %1\n"
+                                         "• COMMANDS: %2")
+                                     .arg(clientsTableExists ? "✓ Available" : "✗ Missing")
+                                     .arg(commandsTableExists ? "✓ Available" : "✗ Missing"));
+    }
 
     qDebug() << "=== Application started successfully ===";
 
@@ -131,6 +215,18 @@ int main(int argc, char *argv[])
 
     // Cleanup when application exits
     qDebug() << "Application shutting down...";
+    rollupBackfill.waitForFinished();
+#ifdef CMS_TRACE
+    if (!traceFile.isEmpty()) {
+        QString traceError;
+        if (Trace::writeJson(traceFile, traceError)) {
+            qDebug() << "Trace written to" << traceFile;
+        } else {
+            qDebug() << traceError;
+        }
+    }
+#endif
+    qDebug().noquote() << "Query cache hit ratios:\n" + QueryCache::instance().report();
     conn.closeConnection();
     qDebug() << "Database connection closed.";
     qDebug() << "Application exit code:" << result;
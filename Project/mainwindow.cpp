@@ -8,6 +8,12 @@
 #include <QHBoxLayout>
 #include <QGridLayout>
 #include <QSplitter>
+#include <QSet>
+#include <QToolBar>
+#include <QShortcut>
+#include <QSignalBlocker>
+#include <QFutureWatcher>
+#include <QtConcurrent>
 #include <QGroupBox>
 #include <QSpacerItem>
 #include <QPropertyAnimation>
@@ -15,6 +21,12 @@
 #include <QParallelAnimationGroup>
 #include <QEvent>
 #include "chatbotdialog.h"
+#include "localreplica.h"
+#include "reportbuilder.h"
+#include "trace.h"
+#include "responsivenesshud.h"
+#include <QStandardPaths>
+#include <QElapsedTimer>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -28,6 +40,7 @@ MainWindow::MainWindow(QWidget *parent)
     , avgOrderValueLabel(nullptr)
     , fadeAnimation(nullptr)
     , refreshTimer(nullptr)
+    , responsivenessHud(nullptr)
     , chatbotDialog(nullptr)
 
 {
@@ -46,15 +59,81 @@ MainWindow::MainWindow(QWidget *parent)
     // Initialize managers
     clientManager = new ClientManager(this);
     commandManager = new CommandManager(this);
+    writeQueue = new WriteBehindQueue(this);
+
+    // Client search index, filled by the first table load and kept current by DAO signals
+    clientIndex = new ClientSearchIndex(this);
+    clientIndex->attach(clientManager->getDAO());
+    clientIndex->attach(commandManager->getDAO());
+    clientIndex->attach(writeQueue);
+    clientManager->getDAO()->setSearchIndex(clientIndex);
+
+    // Omnibox index over clients and orders, loaded with the tables
+    omniboxIndex = new OmniboxIndex(this);
+    omniboxIndex->attach(clientManager->getDAO());
+    omniboxIndex->attach(commandManager->getDAO());
+    omniboxIndex->attach(writeQueue);
+
+    // Near-duplicate blocking index, used by the client dialogs while typing
+    duplicateDetector = new DuplicateDetector(this);
+    duplicateDetector->attach(clientManager->getDAO());
+    duplicateDetector->attach(writeQueue);
+
+    // Column store behind the dashboard cards and chatbot analytics
+    commandStore = new CommandColumnStore(this);
+    commandStore->attach(clientManager->getDAO());
+    commandStore->attach(commandManager->getDAO());
+    commandStore->attach(writeQueue);
+
+    // Top clients and largest orders; rebuilt with the table and every ten minutes
+    leaderboard = new TopKLeaderboard(this);
+    leaderboard->attach(commandManager->getDAO());
+    leaderboard->attach(writeQueue);
+    leaderboard->startPeriodicRebuild(10 * 60 * 1000);
+    commandManager->getDAO()->setLeaderboard(leaderboard);
+
+    // One statistics snapshot per minute at most, shared with the chatbot
+    statisticsCache = new StatisticsCache(commandManager->getDAO(), 60 * 1000, this);
+    statisticsCache->attach(clientManager->getDAO());
+    statisticsCache->attach(commandManager->getDAO());
+    statisticsCache->attach(writeQueue);
+
+    // Rows pulled from the central database bypass the DAO signals
+    if (LocalReplica *replica = Connection::getInstance().replica()) {
+        connect(replica, &LocalReplica::synced, this, [this](int, int pulled, int repaired) {
+            if (pulled + repaired > 0) {
+                statisticsCache->invalidate();
+                reloadAllData();
+            }
+        });
+    }
 
     // Setup UI components
     setupUI();
     applyModernStyling();
     connectSignals();
 
+    // Last session's snapshot goes on screen first; a delta fetch in the
+    // background brings it current, and it is saved again every 5 minutes
+    snapshotStore = new SnapshotStore(
+        QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/snapshot.bin", this);
+
     // Load initial data
-    loadClientsData();
-    loadCommandsData();
+    if (snapshotStore->loadCached()) {
+        showSnapshot();
+
+        // Only the startup catch-up repaints; after that the DAO and queue
+        // signals keep the tables current
+        connect(snapshotStore, &SnapshotStore::refreshed, this, [this](bool changed) {
+            if (changed && writeQueue->pendingCount() == 0) {
+                showSnapshot();
+            }
+        }, Qt::SingleShotConnection);
+    } else {
+        reloadAllData();
+    }
+    snapshotStore->refresh();
+    snapshotStore->startPeriodicSave(5 * 60 * 1000);
 
     // Setup refresh timer
     refreshTimer = new QTimer(this);
@@ -62,6 +141,12 @@ MainWindow::MainWindow(QWidget *parent)
     connect(refreshTimer, &QTimer::timeout, this, &MainWindow::refreshStatistics);
     refreshTimer->start();
 
+    // Responsiveness overlay, toggled with Ctrl+Shift+H or on from --hud
+    responsivenessHud = new ResponsivenessHud(this);
+    responsivenessHud->watchPaint(clientsTable->viewport(), "clients table");
+    responsivenessHud->watchPaint(commandsTable->viewport(), "orders table");
+    responsivenessHud->setActive(QCoreApplication::arguments().contains("--hud"));
+
     // Show with animation
     QTimer::singleShot(100, this, &MainWindow::animateStatCards);
     setupEmailService();
@@ -69,6 +154,9 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    // Flush queued writes while the rest of the window still exists
+    delete writeQueue;
+    snapshotStore->saveNow();
     delete ui;
 }
 
@@ -93,6 +181,7 @@ void MainWindow::setupUI()
     // Setup tables and statistics
     setupTables();
     setupStatisticsFrames();
+    setupOmnibox();
     // Update button texts to match new functionality
     ui->clientStatsBtn->setText("🤖 Chatbot");
     ui->exportClientsBtn->setText("🔄 Refresh Data");
@@ -182,6 +271,41 @@ void MainWindow::setupTables()
     commandsTable->setSortingEnabled(true);
 }
 
+void MainWindow::setupOmnibox()
+{
+    QToolBar *searchBar = addToolBar("Search");
+    searchBar->setObjectName("searchBar");
+    searchBar->setMovable(false);
+
+    omniboxEdit = new QLineEdit(searchBar);
+    omniboxEdit->setObjectName("omniboxEdit");
+    omniboxEdit->setPlaceholderText("🔍 Search clients and orders (Ctrl+K)");
+    omniboxEdit->setClearButtonEnabled(true);
+    searchBar->addWidget(omniboxEdit);
+
+    // Results are already ranked by the index, the completer only shows them
+    omniboxModel = new QStandardItemModel(this);
+    omniboxCompleter = new QCompleter(omniboxModel, this);
+    omniboxCompleter->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    omniboxCompleter->setMaxVisibleItems(10);
+    omniboxEdit->setCompleter(omniboxCompleter);
+
+    connect(omniboxEdit, &QLineEdit::textEdited, this, &MainWindow::onOmniboxEdited);
+    connect(omniboxCompleter, QOverload<const QModelIndex &>::of(&QCompleter::activated),
+            this, &MainWindow::openOmniboxResult);
+
+    QShortcut *focusShortcut = new QShortcut(QKeySequence("Ctrl+K"), this);
+    connect(focusShortcut, &QShortcut::activated, this, [this]() {
+        omniboxEdit->setFocus();
+        omniboxEdit->selectAll();
+    });
+
+    searchBar->addSeparator();
+    QAction *duplicatesAction = searchBar->addAction("🧬 Find duplicates");
+    duplicatesAction->setObjectName("findDuplicatesAction");
+    connect(duplicatesAction, &QAction::triggered, this, &MainWindow::onFindDuplicatesClicked);
+}
+
 void MainWindow::applyModernStyling()
 {
     setStyleSheet(R"(
@@ -439,6 +563,23 @@ void MainWindow::applyModernStyling()
     )");
     statusBar()->addPermanentWidget(connectionStatus);
 
+    // With a local replica the indicator follows the sync instead
+    if (LocalReplica *replica = Connection::getInstance().replica()) {
+        auto showSyncState = [connectionStatus, replica]() {
+            int pending = replica->pendingCount();
+            QString changes = pending > 0 ? QString(", %1 change(s) to sync").arg(pending) : QString();
+            connectionStatus->setProperty("connected", replica->isOnline());
+            connectionStatus->setText(replica->isOnline() ? " ✓ Connected" + changes : " ✗ Offline" + changes);
+            connectionStatus->style()->unpolish(connectionStatus);
+            connectionStatus->style()->polish(connectionStatus);
+        };
+        connect(replica, &LocalReplica::onlineChanged, connectionStatus, showSyncState);
+        connect(replica, &LocalReplica::pendingCountChanged, connectionStatus, showSyncState);
+        if (!Connection::getInstance().isConnected()) {
+            showSyncState();
+        }
+    }
+
     // Version Info
     QLabel *versionLabel = new QLabel(this);
     versionLabel->setObjectName("versionLabel");
@@ -489,6 +630,50 @@ void MainWindow::connectSignals()
     connect(ui->deliveryStatusBtn, &QPushButton::clicked, this, &MainWindow::generateClientsCommandsPDF);
     connect(ui->sendMailBtn, &QPushButton::clicked, this, &MainWindow::onSendMailClicked);
     connect(ui->clientStatsBtn, &QPushButton::clicked, this, &MainWindow::onChatbotClicked);
+
+    // Optimistic updates from the write-behind queue
+    connect(writeQueue, &WriteBehindQueue::clientApplied, this, &MainWindow::onClientWriteApplied);
+    connect(writeQueue, &WriteBehindQueue::clientCommitted, this, &MainWindow::onClientWriteCommitted);
+    connect(writeQueue, &WriteBehindQueue::clientReverted, this, &MainWindow::onClientWriteReverted);
+    connect(writeQueue, &WriteBehindQueue::commandApplied, this, &MainWindow::onCommandWriteApplied);
+    connect(writeQueue, &WriteBehindQueue::commandCommitted, this, &MainWindow::onCommandWriteCommitted);
+    connect(writeQueue, &WriteBehindQueue::commandReverted, this, &MainWindow::onCommandWriteReverted);
+    connect(writeQueue, &WriteBehindQueue::pendingCountChanged, this, &MainWindow::onPendingWritesChanged);
+
+    // Ctrl+Shift+H shows the responsiveness HUD; hiding it logs the numbers
+    QShortcut *hudShortcut = new QShortcut(QKeySequence("Ctrl+Shift+H"), this);
+    connect(hudShortcut, &QShortcut::activated, this, [this]() {
+        bool visible = !responsivenessHud->isActive();
+        if (visible) {
+            responsivenessHud->clear();
+        }
+        responsivenessHud->setActive(visible);
+    });
+
+#ifdef CMS_TRACE
+    // Ctrl+Shift+T starts recording trace spans; pressing it again saves them
+    QShortcut *traceShortcut = new QShortcut(QKeySequence("Ctrl+Shift+T"), this);
+    connect(traceShortcut, &QShortcut::activated, this, [this]() {
+        if (!Trace::isEnabled()) {
+            Trace::clear();
+            Trace::setEnabled(true);
+            statusBar()->showMessage("Tracing - press Ctrl+Shift+T again to save the trace");
+            return;
+        }
+
+        Trace::setEnabled(false);
+        statusBar()->clearMessage();
+        QString fileName = QFileDialog::getSaveFileName(this, "Save Trace",
+                                                        QDir::homePath() + "/trace.json",
+                                                        "Trace Files (*.json)");
+        QString error;
+        if (!fileName.isEmpty() && !Trace::writeJson(fileName, error)) {
+            QMessageBox::warning(this, "Trace", error);
+        } else if (!fileName.isEmpty()) {
+            statusBar()->showMessage("Trace saved; open it in ui.perfetto.dev or chrome://tracing", 5000);
+        }
+    });
+#endif
 }
 
 QFrame* MainWindow::createStatCard(const QString &title, const QString &value, const QString &icon)
@@ -565,6 +750,7 @@ bool MainWindow::eventFilter(QObject *watched, QEvent *event)
 
 void MainWindow::loadClientsData()
 {
+    UI_SCOPE("MainWindow::loadClientsData");
     if (!clientManager) return;
 
     populateClientsTable();
@@ -572,6 +758,7 @@ void MainWindow::loadClientsData()
 }
 
 void MainWindow::loadCommandsData() {
+    UI_SCOPE("MainWindow::loadCommandsData");
     try {
         qDebug() << "Loading commands data...";
         populateCommandsTable();
@@ -583,72 +770,147 @@ void MainWindow::loadCommandsData() {
     }
 }
 
-void MainWindow::populateClientsTable()
+void MainWindow::reloadAllData()
 {
-    QList<Client> clients = clientManager->getAllClients();
+    UI_SCOPE("MainWindow::reloadAllData");
+    if (!clientManager) return;
+
+    populateClientsTable(true);
+    updateClientStatistics();
+    try {
+        populateCommandsTable(true);
+        updateCommandStatistics();
+    } catch (const std::exception &e) {
+        qCritical() << "Error loading commands:" << e.what();
+        QMessageBox::critical(this, "Error",
+                              QString("Failed to load commands:\n%1").arg(e.what()));
+    }
+}
+
+void MainWindow::showSnapshot()
+{
+    UI_SCOPE("MainWindow::showSnapshot");
+    QElapsedTimer timer;
+    timer.start();
+
+    const SnapshotStore::Data &data = snapshotStore->data();
+    QHash<int, int> orderCounts;
+    for (int row = 0; row < data.commands.size(); ++row) {
+        orderCounts[data.commands.clientIdAt(row)]++;
+    }
+    if (data.hasStatistics) {
+        statisticsCache->prime(data.statistics);
+    }
+
+    showClients(data.clientList(), orderCounts, true);
+    showCommands(data.commandList(), true);
+    updateClientStatistics();
+    updateCommandStatistics();
+    qDebug() << "Snapshot shown in" << timer.elapsed() << "ms";
+}
+
+void MainWindow::populateClientsTable(bool rebuildIndexes)
+{
+    UI_SCOPE("MainWindow::populateClientsTable");
+    // Order counts only seed the search index
+    showClients(clientManager->getAllClients(),
+                rebuildIndexes ? commandManager->getDAO()->getCommandCountsByClient() : QHash<int, int>(),
+                rebuildIndexes);
+}
+
+void MainWindow::showClients(const QList<Client> &clients, const QHash<int, int> &orderCounts, bool rebuildIndexes)
+{
+    UI_SCOPE("MainWindow::showClients");
+    if (rebuildIndexes) {
+        clientIndex->rebuild(clients, orderCounts);
+        omniboxIndex->rebuildClients(clients);
+        duplicateDetector->rebuild(clients);    // Signs on the thread pool
+        commandStore->rebuildClients(clients);
+    }
+
+    clientsTable->setSortingEnabled(false);
     clientsTable->setRowCount(clients.size());
 
     for (int row = 0; row < clients.size(); ++row) {
-        const Client &client = clients.at(row);
-
-        // Add regular data cells
-        clientsTable->setItem(row, 0, new QTableWidgetItem(QString::number(client.id)));
-        clientsTable->setItem(row, 1, new QTableWidgetItem(client.name));
-        clientsTable->setItem(row, 2, new QTableWidgetItem(client.email));
-        clientsTable->setItem(row, 3, new QTableWidgetItem(client.city));
-        clientsTable->setItem(row, 4, new QTableWidgetItem(client.postal));
-        clientsTable->setItem(row, 5, new QTableWidgetItem(client.address));
-
-        // Add action buttons
-        QWidget *actionWidget = new QWidget();
-        QHBoxLayout *layout = new QHBoxLayout(actionWidget);
-        layout->setContentsMargins(5, 2, 5, 2);
-        layout->setSpacing(5);
-
-        // Edit button
-        QPushButton *editBtn = new QPushButton("✏️");
-        editBtn->setObjectName("editBtn");
-        editBtn->setProperty("class", "table-action-btn");
-        editBtn->setToolTip("Edit client");
-        connect(editBtn, &QPushButton::clicked, this, [this, row]() {
-            editClient(row);
-        });
+        setClientRow(row, clients.at(row));
+    }
 
-        // Delete button
-        QPushButton *deleteBtn = new QPushButton("🗑️");
-        deleteBtn->setObjectName("deleteBtn");
-        deleteBtn->setProperty("class", "table-action-btn");
-        deleteBtn->setToolTip("Delete client");
-        connect(deleteBtn, &QPushButton::clicked, this, [this, row]() {
-            deleteClient(row);
-        });
+    clientsTable->setSortingEnabled(true);
+}
 
-        layout->addWidget(editBtn);
-        layout->addWidget(deleteBtn);
-        layout->addStretch();
-        actionWidget->setLayout(layout);
+void MainWindow::setClientRow(int row, const Client &client)
+{
+    // Add regular data cells
+    clientsTable->setItem(row, 0, new QTableWidgetItem(QString::number(client.id)));
+    clientsTable->setItem(row, 1, new QTableWidgetItem(client.name));
+    clientsTable->setItem(row, 2, new QTableWidgetItem(client.email));
+    clientsTable->setItem(row, 3, new QTableWidgetItem(client.city));
+    clientsTable->setItem(row, 4, new QTableWidgetItem(client.postal));
+    clientsTable->setItem(row, 5, new QTableWidgetItem(client.address));
+
+    // Add action buttons
+    QWidget *actionWidget = new QWidget();
+    QHBoxLayout *layout = new QHBoxLayout(actionWidget);
+    layout->setContentsMargins(5, 2, 5, 2);
+    layout->setSpacing(5);
+
+    // Buttons look their row up by client ID since rows move when sorting
+    // or when optimistic saves insert and remove rows
+    int clientId = client.id;
+
+    // Edit button
+    QPushButton *editBtn = new QPushButton("✏️");
+    editBtn->setObjectName("editBtn");
+    editBtn->setProperty("class", "table-action-btn");
+    editBtn->setToolTip("Edit client");
+    connect(editBtn, &QPushButton::clicked, this, [this, clientId]() {
+        int currentRow = findTableRow(clientsTable, clientId);
+        if (currentRow >= 0) editClient(currentRow);
+    });
 
-        clientsTable->setCellWidget(row, 6, actionWidget);
-    }
+    // Delete button
+    QPushButton *deleteBtn = new QPushButton("🗑️");
+    deleteBtn->setObjectName("deleteBtn");
+    deleteBtn->setProperty("class", "table-action-btn");
+    deleteBtn->setToolTip("Delete client");
+    connect(deleteBtn, &QPushButton::clicked, this, [this, clientId]() {
+        int currentRow = findTableRow(clientsTable, clientId);
+        if (currentRow >= 0) deleteClient(currentRow);
+    });
+
+    layout->addWidget(editBtn);
+    layout->addWidget(deleteBtn);
+    layout->addStretch();
+    actionWidget->setLayout(layout);
+
+    clientsTable->setCellWidget(row, 6, actionWidget);
 }
+
 void MainWindow::editClient(int row)
 {
+    TRACE_SCOPE("ui", "MainWindow::editClient");
     int clientId = clientsTable->item(row, 0)->text().toInt();
+    if (clientId <= 0) {
+        statusBar()->showMessage("This client is still being saved, try again in a moment", 3000);
+        return;
+    }
     Client client = clientManager->getClient(clientId);
 
     ClientsWindow *dialog = new ClientsWindow(client, this, ClientsWindow::EditMode);
-    connect(dialog, &ClientsWindow::finished, this, [this](int result) {
-        if (result == QDialog::Accepted) {
-            loadClientsData();
-        }
-    });
+    dialog->setWriteQueue(writeQueue);
+    dialog->setDuplicateDetector(duplicateDetector);
     dialog->exec();
 }
 
 void MainWindow::deleteClient(int row)
 {
+    TRACE_SCOPE("ui", "MainWindow::deleteClient");
     int clientId = clientsTable->item(row, 0)->text().toInt();
     QString clientName = clientsTable->item(row, 1)->text();
+    if (clientId <= 0) {
+        statusBar()->showMessage("This client is still being saved, try again in a moment", 3000);
+        return;
+    }
 
     QMessageBox::StandardButton reply = QMessageBox::question(
         this,
@@ -658,8 +920,8 @@ void MainWindow::deleteClient(int row)
         );
 
     if (reply == QMessageBox::Yes) {
+        // clientRemoved reloads the table
         if (clientManager->removeClient(clientId)) {
-            loadClientsData();
             QMessageBox::information(this, "Success", "Client deleted successfully");
         } else {
             QMessageBox::warning(this, "Error", "Failed to delete client");
@@ -667,12 +929,24 @@ void MainWindow::deleteClient(int row)
     }
 }
 
-void MainWindow::populateCommandsTable() {
+void MainWindow::populateCommandsTable(bool rebuildIndexes) {
+    UI_SCOPE("MainWindow::populateCommandsTable");
+    qDebug() << "Fetching commands from database...";
+    showCommands(commandManager->getAllCommands(), rebuildIndexes);
+}
+
+void MainWindow::showCommands(const QList<Command> &commands, bool rebuildIndexes)
+{
+    UI_SCOPE("MainWindow::showCommands");
     commandsTable->setRowCount(0);
     commandsTable->setSortingEnabled(false);
 
-    qDebug() << "Fetching commands from database...";
-    QList<Command> commands = commandManager->getAllCommands();
+    if (rebuildIndexes) {
+        omniboxIndex->rebuildOrders(commands);
+        clientIndex->trackOrders(commands);
+        commandStore->rebuildOrders(commands);
+        leaderboard->rebuild(commands);
+    }
 
     if (commands.isEmpty()) {
         qDebug() << "No commands found or error occurred";
@@ -688,8 +962,15 @@ void MainWindow::populateCommandsTable() {
     qDebug() << "Populating table with" << commands.size() << "commands";
     commandsTable->setRowCount(commands.size());
 
-    // Pre-cache client names to avoid repeated queries
+    // Names come from the clients table; only ids missing there are queried
     QHash<int, QString> clientNames;
+    for (int row = 0; row < clientsTable->rowCount(); ++row) {
+        QTableWidgetItem *idItem = clientsTable->item(row, 0);
+        QTableWidgetItem *nameItem = clientsTable->item(row, 1);
+        if (idItem && nameItem) {
+            clientNames.insert(idItem->text().toInt(), nameItem->text());
+        }
+    }
 
     try {
         for (int row = 0; row < commands.size(); ++row) {
@@ -705,78 +986,7 @@ void MainWindow::populateCommandsTable() {
                 clientNames.insert(command.clientId, clientName);
             }
 
-            // Create and populate items
-            QTableWidgetItem *idItem = new QTableWidgetItem(QString::number(command.commandId));
-            QTableWidgetItem *clientItem = new QTableWidgetItem(clientName);
-            QTableWidgetItem *dateItem = new QTableWidgetItem(command.commandDate.toString("yyyy-MM-dd hh:mm"));
-            QTableWidgetItem *totalItem = new QTableWidgetItem(QString("$%1").arg(command.total));
-            QTableWidgetItem *paymentItem = new QTableWidgetItem(command.paymentMethod);
-
-            // Set data alignment
-            idItem->setData(Qt::TextAlignmentRole, QVariant(Qt::AlignRight | Qt::AlignVCenter));
-            totalItem->setData(Qt::TextAlignmentRole, QVariant(Qt::AlignRight | Qt::AlignVCenter));
-
-            // Shorten delivery address for display
-            QString shortAddress = command.deliveryAddress;
-            if (shortAddress.length() > 50) {
-                shortAddress = shortAddress.left(47) + "...";
-            }
-            QTableWidgetItem *addressItem = new QTableWidgetItem(shortAddress);
-
-            // Add items to table
-            commandsTable->setItem(row, 0, idItem);
-            commandsTable->setItem(row, 1, clientItem);
-            commandsTable->setItem(row, 2, dateItem);
-            commandsTable->setItem(row, 3, totalItem);
-            commandsTable->setItem(row, 4, paymentItem);
-            commandsTable->setItem(row, 5, addressItem);
-
-            // Create action buttons widget
-            QWidget *actionWidget = new QWidget();
-            QHBoxLayout *layout = new QHBoxLayout(actionWidget);
-            layout->setContentsMargins(5, 2, 5, 2);
-            layout->setSpacing(5);
-
-            // Edit button - FIXED: Store command ID properly
-            QPushButton *editBtn = new QPushButton("✏️");
-            editBtn->setObjectName("editBtn");
-            editBtn->setProperty("class", "table-action-btn");
-            editBtn->setToolTip("Edit command");
-            editBtn->setCursor(Qt::PointingHandCursor);
-
-            // CRITICAL FIX: Use QSignalMapper or store the command ID directly
-            editBtn->setProperty("commandId", command.commandId);
-
-            // Connect using a more reliable approach
-            connect(editBtn, &QPushButton::clicked, this, [this, editBtn]() {
-                int commandId = editBtn->property("commandId").toInt();
-                qDebug() << "Edit button clicked for command ID:" << commandId;
-                this->editCommandById(commandId);
-            });
-
-            // Delete button - FIXED: Same approach
-            QPushButton *deleteBtn = new QPushButton("🗑️");
-            deleteBtn->setObjectName("deleteBtn");
-            deleteBtn->setProperty("class", "table-action-btn");
-            deleteBtn->setToolTip("Delete command");
-            deleteBtn->setCursor(Qt::PointingHandCursor);
-
-            // Store command ID in button property
-            deleteBtn->setProperty("commandId", command.commandId);
-
-            // Connect using property-based approach
-            connect(deleteBtn, &QPushButton::clicked, this, [this, deleteBtn]() {
-                int commandId = deleteBtn->property("commandId").toInt();
-                qDebug() << "Delete button clicked for command ID:" << commandId;
-                this->deleteCommandById(commandId);
-            });
-
-            layout->addWidget(editBtn);
-            layout->addWidget(deleteBtn);
-            layout->addStretch();
-            actionWidget->setLayout(layout);
-
-            commandsTable->setCellWidget(row, 6, actionWidget);
+            setCommandRow(row, command, clientName);
         }
     } catch (const std::exception &e) {
         qCritical() << "Error populating commands table:" << e.what();
@@ -796,33 +1006,246 @@ void MainWindow::populateCommandsTable() {
     qDebug() << "Commands table populated successfully";
 }
 
+void MainWindow::setCommandRow(int row, const Command &command, const QString &clientName)
+{
+    // Create and populate items
+    QTableWidgetItem *idItem = new QTableWidgetItem(QString::number(command.commandId));
+    QTableWidgetItem *clientItem = new QTableWidgetItem(clientName);
+    QTableWidgetItem *dateItem = new QTableWidgetItem(command.commandDate().toString("yyyy-MM-dd hh:mm"));
+    QTableWidgetItem *totalItem = new QTableWidgetItem(QString("$%1").arg(command.total.toString()));
+    QTableWidgetItem *paymentItem = new QTableWidgetItem(command.paymentMethod);
+
+    // Set data alignment
+    idItem->setData(Qt::TextAlignmentRole, QVariant(Qt::AlignRight | Qt::AlignVCenter));
+    totalItem->setData(Qt::TextAlignmentRole, QVariant(Qt::AlignRight | Qt::AlignVCenter));
+
+    // Shorten delivery address for display
+    QString shortAddress = command.deliveryAddress;
+    if (shortAddress.length() > 50) {
+        shortAddress = shortAddress.left(47) + "...";
+    }
+    QTableWidgetItem *addressItem = new QTableWidgetItem(shortAddress);
+
+    // Add items to table
+    commandsTable->setItem(row, 0, idItem);
+    commandsTable->setItem(row, 1, clientItem);
+    commandsTable->setItem(row, 2, dateItem);
+    commandsTable->setItem(row, 3, totalItem);
+    commandsTable->setItem(row, 4, paymentItem);
+    commandsTable->setItem(row, 5, addressItem);
+
+    // Create action buttons widget
+    QWidget *actionWidget = new QWidget();
+    QHBoxLayout *layout = new QHBoxLayout(actionWidget);
+    layout->setContentsMargins(5, 2, 5, 2);
+    layout->setSpacing(5);
+
+    // Edit button - FIXED: Store command ID properly
+    QPushButton *editBtn = new QPushButton("✏️");
+    editBtn->setObjectName("editBtn");
+    editBtn->setProperty("class", "table-action-btn");
+    editBtn->setToolTip("Edit command");
+    editBtn->setCursor(Qt::PointingHandCursor);
+
+    // CRITICAL FIX: Use QSignalMapper or store the command ID directly
+    editBtn->setProperty("commandId", command.commandId);
+
+    // Connect using a more reliable approach
+    connect(editBtn, &QPushButton::clicked, this, [this, editBtn]() {
+        int commandId = editBtn->property("commandId").toInt();
+        qDebug() << "Edit button clicked for command ID:" << commandId;
+        this->editCommandById(commandId);
+    });
+
+    // Delete button - FIXED: Same approach
+    QPushButton *deleteBtn = new QPushButton("🗑️");
+    deleteBtn->setObjectName("deleteBtn");
+    deleteBtn->setProperty("class", "table-action-btn");
+    deleteBtn->setToolTip("Delete command");
+    deleteBtn->setCursor(Qt::PointingHandCursor);
+
+    // Store command ID in button property
+    deleteBtn->setProperty("commandId", command.commandId);
+
+    // Connect using property-based approach
+    connect(deleteBtn, &QPushButton::clicked, this, [this, deleteBtn]() {
+        int commandId = deleteBtn->property("commandId").toInt();
+        qDebug() << "Delete button clicked for command ID:" << commandId;
+        this->deleteCommandById(commandId);
+    });
+
+    layout->addWidget(editBtn);
+    layout->addWidget(deleteBtn);
+    layout->addStretch();
+    actionWidget->setLayout(layout);
+
+    commandsTable->setCellWidget(row, 6, actionWidget);
+}
+
+int MainWindow::findTableRow(QTableWidget *table, int id) const
+{
+    for (int row = 0; row < table->rowCount(); ++row) {
+        QTableWidgetItem *idItem = table->item(row, 0);
+        if (idItem && idItem->text().toInt() == id && table->columnSpan(row, 0) == 1) {
+            return row;
+        }
+    }
+    return -1;
+}
+
+void MainWindow::upsertClientRow(int viewId, const Client &client)
+{
+    clientsTable->setSortingEnabled(false);
+
+    int row = findTableRow(clientsTable, viewId);
+    if (row < 0) {
+        row = clientsTable->rowCount();
+        clientsTable->insertRow(row);
+    }
+    setClientRow(row, client);
+
+    clientsTable->setSortingEnabled(true);
+}
+
+void MainWindow::upsertCommandRow(int viewId, const Command &command)
+{
+    commandsTable->setSortingEnabled(false);
+
+    // Drop the "No commands found" placeholder
+    if (commandsTable->rowCount() == 1 && commandsTable->columnSpan(0, 0) > 1) {
+        commandsTable->clearSpans();
+        commandsTable->setRowCount(0);
+    }
+
+    int row = findTableRow(commandsTable, viewId);
+    if (row < 0) {
+        row = commandsTable->rowCount();
+        commandsTable->insertRow(row);
+    }
+    setCommandRow(row, command, clientNameFor(command.clientId));
+
+    commandsTable->setSortingEnabled(true);
+}
+
+void MainWindow::removeTableRow(QTableWidget *table, int id)
+{
+    int row = findTableRow(table, id);
+    if (row >= 0) {
+        table->removeRow(row);
+    }
+}
+
+QString MainWindow::clientNameFor(int clientId)
+{
+    // The clients table already holds every name, no need to query
+    int row = findTableRow(clientsTable, clientId);
+    if (row >= 0 && clientsTable->item(row, 1)) {
+        return clientsTable->item(row, 1)->text();
+    }
+
+    Client client = clientManager->getClient(clientId);
+    return (client.id > 0) ? client.name : "Unknown";
+}
+
+void MainWindow::onClientWriteApplied(const Client &client)
+{
+    upsertClientRow(client.id, client);
+}
+
+void MainWindow::onClientWriteCommitted(int viewId, const Client &client)
+{
+    upsertClientRow(viewId, client);
+    updateClientStatistics();
+}
+
+void MainWindow::onClientWriteReverted(const Client &attempted, const Client &previous, const QString &error)
+{
+    if (previous.id > 0) {
+        upsertClientRow(attempted.id, previous);
+    } else {
+        removeTableRow(clientsTable, attempted.id);
+    }
+
+    QMessageBox::warning(this, "Save Failed",
+                         QString("Could not save client %1:\n%2").arg(attempted.name, error));
+}
+
+void MainWindow::onCommandWriteApplied(const Command &command)
+{
+    upsertCommandRow(command.commandId, command);
+}
+
+void MainWindow::onCommandWriteCommitted(int viewId, const Command &command)
+{
+    upsertCommandRow(viewId, command);
+    updateCommandStatistics();
+}
+
+void MainWindow::onCommandWriteReverted(const Command &attempted, const Command &previous, const QString &error)
+{
+    if (previous.commandId > 0) {
+        upsertCommandRow(attempted.commandId, previous);
+    } else {
+        removeTableRow(commandsTable, attempted.commandId);
+    }
+
+    QMessageBox::warning(this, "Save Failed",
+                         QString("Could not save command:\n%1").arg(error));
+}
+
+void MainWindow::onPendingWritesChanged(int count)
+{
+    if (count > 0) {
+        statusBar()->showMessage(QString("Saving %1 change(s)...").arg(count));
+    } else {
+        statusBar()->showMessage("All changes saved", 2000);
+    }
+}
+
 void MainWindow::updateClientStatistics()
 {
+    UI_SCOPE("MainWindow::updateClientStatistics");
     if (!clientManager || !totalClientsLabel) return;
 
-    int totalClients = clientManager->getDAO()->getClientCount();
+    int totalClients = statisticsCache->snapshot().totalClients;
     totalClientsLabel->setText(QString::number(totalClients));
 
-    // Mock data for now - you can implement actual calculations
+    // Mock data for now - clients have no creation date to count from
     if (newClientsLabel) newClientsLabel->setText("32");
-    if (activeCitiesLabel) activeCitiesLabel->setText("15");
+    if (activeCitiesLabel) activeCitiesLabel->setText(QString::number(commandStore->cityCount()));
 }
 
 void MainWindow::updateCommandStatistics()
 {
+    UI_SCOPE("MainWindow::updateCommandStatistics");
     if (!commandManager) return;
 
-    int totalOrders = commandManager->getDAO()->getCommandCount();
-    double totalSales = commandManager->getDAO()->getTotalSales();
+    int totalOrders = 0;
+    Money totalSales;
+    if (commandStore->isReady()) {
+        // One scan of the in-memory columns instead of two queries
+        CommandColumnStore::Totals all = commandStore->totals();
+        totalOrders = all.orders;
+        totalSales = all.sales;
+
+        QDate monthStart(QDate::currentDate().year(), QDate::currentDate().month(), 1);
+        Money thisMonth = commandStore->totals(monthStart.startOfDay().toMSecsSinceEpoch(),
+                                               monthStart.addMonths(1).startOfDay().toMSecsSinceEpoch()).sales;
+        if (monthlyRevenueLabel) monthlyRevenueLabel->setText(formatCurrency(thisMonth));
+    } else {
+        CommandStatistics::Statistics stats = statisticsCache->snapshot();
+        totalOrders = stats.totalCommands;
+        totalSales = stats.totalSales;
+        if (monthlyRevenueLabel) monthlyRevenueLabel->setText(formatCurrency(totalSales));
+    }
 
     if (totalOrdersLabel) totalOrdersLabel->setText(QString::number(totalOrders));
-    if (monthlyRevenueLabel) monthlyRevenueLabel->setText(formatCurrency(totalSales));
 
     // Mock data for pending orders - implement actual calculation
     if (pendingOrdersLabel) pendingOrdersLabel->setText("89");
 
     // Calculate average order value
-    double avgValue = (totalOrders > 0) ? (totalSales / totalOrders) : 0.0;
+    Money avgValue = totalSales.dividedBy(totalOrders);
     if (avgOrderValueLabel) avgOrderValueLabel->setText(formatCurrency(avgValue));
 }
 
@@ -831,6 +1254,11 @@ QString MainWindow::formatCurrency(double amount)
     return QString("$%1").arg(amount, 0, 'f', 2);
 }
 
+QString MainWindow::formatCurrency(const Money &amount)
+{
+    return QString("$%1").arg(amount.toString());
+}
+
 void MainWindow::animateStatCards()
 {
     QList<QFrame*> statCards = findChildren<QFrame*>("statCard");
@@ -871,6 +1299,7 @@ void MainWindow::animateWidget(QWidget *widget, int duration)
 // Slot implementations
 void MainWindow::onTabChanged(int index)
 {
+    UI_SCOPE("MainWindow::onTabChanged");
     // Refresh data when switching tabs
     if (index == 0) {
         loadClientsData();
@@ -881,23 +1310,22 @@ void MainWindow::onTabChanged(int index)
 
 void MainWindow::onRefreshClicked()
 {
-    loadClientsData();
-    loadCommandsData();
+    UI_SCOPE("MainWindow::onRefreshClicked");
+    reloadAllData();
     QMessageBox::information(this, "Refresh", "Data refreshed successfully!");
 }
 
 void MainWindow::onAddClientClicked()
 {
+    TRACE_SCOPE("ui", "MainWindow::onAddClientClicked");
     ClientsWindow *dialog = new ClientsWindow(this, ClientsWindow::AddMode);
-    connect(dialog, &ClientsWindow::finished, this, [this](int result) {
-        if (result == QDialog::Accepted) {
-            loadClientsData();
-        }
-    });
+    dialog->setWriteQueue(writeQueue);
+    dialog->setDuplicateDetector(duplicateDetector);
     dialog->exec();
 }
 
 void MainWindow::onAddCommandClicked() {
+    TRACE_SCOPE("ui", "MainWindow::onAddCommandClicked");
     // Get the first client as default (or handle empty case)
     QList<Client> clients = clientManager->getAllClients();
     if (clients.isEmpty()) {
@@ -907,27 +1335,74 @@ void MainWindow::onAddCommandClicked() {
 
     Command newCommand;
     newCommand.clientId = clients.first().id; // Default to first client
-    newCommand.commandDate = QDateTime::currentDateTime();
-    newCommand.total = "0.00"; // Default total
+    newCommand.setCommandDate(QDateTime::currentDateTime());
+    newCommand.total = Money(); // Default total
     newCommand.paymentMethod = "Cash"; // Default payment method
 
     CommandsWindow *dialog = new CommandsWindow(commandManager, clientManager, newCommand, CommandsWindow::AddMode, this);
-    connect(dialog, &CommandsWindow::finished, this, [this](int result) {
-        if (result == QDialog::Accepted) {
-            loadCommandsData();
-        }
-    });
+    dialog->setWriteQueue(writeQueue);
     dialog->exec();
 }
 
 void MainWindow::onSearchClients()
 {
+    UI_SCOPE("MainWindow::onSearchClients");
     QString searchText = clientSearchEdit->text();
     if (searchText.isEmpty()) {
         populateClientsTable();
         return;
     }
 
+    // Name, email and city are looked up in the search index; the ID,
+    // postal code and address columns are not indexed and compared directly
+    if (clientIndex->isReady()) {
+        QSet<int> matches;
+        for (int field = 0; field < ClientSearchIndex::FieldCount; ++field) {
+            for (int id : clientIndex->searchIds(ClientSearchIndex::Field(field), searchText)) {
+                matches.insert(id);
+            }
+        }
+
+        QString text = searchText.trimmed();
+        QVector<bool> directMatch(clientsTable->rowCount(), false);
+        bool anyDirectMatch = false;
+        for (int row = 0; row < clientsTable->rowCount(); ++row) {
+            for (int col : {0, 4, 5}) {
+                QTableWidgetItem *item = clientsTable->item(row, col);
+                if (item && item->text().contains(text, Qt::CaseInsensitive)) {
+                    directMatch[row] = true;
+                    anyDirectMatch = true;
+                    break;
+                }
+            }
+        }
+
+        // Nothing contains the text: show the closest spellings instead
+        if (matches.isEmpty() && !anyDirectMatch) {
+            QStringList spellings;
+            for (ClientSearchIndex::Field field : {ClientSearchIndex::NameField, ClientSearchIndex::CityField}) {
+                for (const BKTree::Match &match : clientIndex->suggest(field, searchText, 3)) {
+                    Client first = clientIndex->client(match.ids.first());
+                    spellings << (field == ClientSearchIndex::NameField ? first.name : first.city);
+                    for (int id : match.ids) {
+                        matches.insert(id);
+                    }
+                }
+            }
+            if (!spellings.isEmpty()) {
+                statusBar()->showMessage(QString("No exact match for '%1'. Did you mean: %2?")
+                                             .arg(searchText.trimmed(), spellings.join(", ")), 5000);
+            }
+        }
+
+        for (int row = 0; row < clientsTable->rowCount(); ++row) {
+            QTableWidgetItem *item = clientsTable->item(row, 0);
+            bool match = directMatch.at(row) || (item && matches.contains(item->text().toInt()));
+            clientsTable->setRowHidden(row, !match);
+        }
+        return;
+    }
+
     // Simple search implementation
     for (int row = 0; row < clientsTable->rowCount(); ++row) {
         bool match = false;
@@ -944,13 +1419,15 @@ void MainWindow::onSearchClients()
 
 void MainWindow::onSearchCommands()
 {
+    UI_SCOPE("MainWindow::onSearchCommands");
     QString searchText = commandSearchEdit->text();
     if (searchText.isEmpty()) {
         populateCommandsTable();
         return;
     }
 
-    // Simple search implementation
+    // A complete substring filter over every column; the ranked, prefix
+    // matched top results belong to the omnibox
     for (int row = 0; row < commandsTable->rowCount(); ++row) {
         bool match = false;
         for (int col = 0; col < commandsTable->columnCount(); ++col) {
@@ -964,8 +1441,112 @@ void MainWindow::onSearchCommands()
     }
 }
 
+void MainWindow::onOmniboxEdited(const QString &text)
+{
+    UI_SCOPE("MainWindow::onOmniboxEdited");
+    omniboxModel->clear();
+    if (text.trimmed().isEmpty()) {
+        return;
+    }
+
+    for (const OmniboxIndex::Result &result : omniboxIndex->search(text, 10)) {
+        QString icon = result.type == OmniboxIndex::ClientDoc ? "👤" : "🛒";
+        QStandardItem *item = new QStandardItem(QString("%1 %2 — %3").arg(icon, result.title, result.detail));
+        item->setData(result.title, Qt::EditRole);
+        item->setData(int(result.type), Qt::UserRole);
+        item->setData(result.id, Qt::UserRole + 1);
+        omniboxModel->appendRow(item);
+    }
+    omniboxCompleter->complete();
+}
+
+void MainWindow::openOmniboxResult(const QModelIndex &index)
+{
+    bool isClient = index.data(Qt::UserRole).toInt() == OmniboxIndex::ClientDoc;
+    int id = index.data(Qt::UserRole + 1).toInt();
+
+    QTableWidget *table = isClient ? clientsTable : commandsTable;
+    QLineEdit *filter = isClient ? clientSearchEdit : commandSearchEdit;
+    mainTabWidget->setCurrentWidget(isClient ? clientsTab : commandsTab);
+
+    // Drop the tab's own filter without reloading the table
+    {
+        QSignalBlocker blocker(filter);
+        filter->clear();
+    }
+    for (int row = 0; row < table->rowCount(); ++row) {
+        table->setRowHidden(row, false);
+    }
+
+    int row = findTableRow(table, id);
+    if (row >= 0) {
+        table->selectRow(row);
+        table->scrollToItem(table->item(row, 0), QAbstractItemView::PositionAtCenter);
+    }
+    QTimer::singleShot(0, omniboxEdit, &QLineEdit::clear);
+}
+
+void MainWindow::onFindDuplicatesClicked()
+{
+    UI_SCOPE("MainWindow::onFindDuplicatesClicked");
+    // Read on the GUI thread (its connection), score the copy on the pool
+    QList<Client> clients = clientManager->getAllClients();
+    statusBar()->showMessage(QString("Scanning %1 clients for duplicates...").arg(clients.size()));
+
+    QFutureWatcher<DuplicateDetector::Scan> *watcher = new QFutureWatcher<DuplicateDetector::Scan>(this);
+    connect(watcher, &QFutureWatcher<DuplicateDetector::Scan>::finished, this, [this, watcher, clients]() {
+        DuplicateDetector::Scan scan = watcher->result();
+        const QList<DuplicateDetector::Match>& pairs = scan.pairs;
+        watcher->deleteLater();
+        statusBar()->clearMessage();
+
+        QString unchecked;
+        if (scan.uncheckedClients > 0) {
+            unchecked = QString("%1 clients share their name, address and postal code with more than %2 "
+                                "others and were not compared.")
+                            .arg(scan.uncheckedClients).arg(DuplicateDetector::MaxBucketSize);
+        }
+
+        if (pairs.isEmpty()) {
+            QMessageBox::information(this, "Find Duplicates", "No likely duplicate clients found."
+                                     + (unchecked.isEmpty() ? QString() : "\n" + unchecked));
+            return;
+        }
+
+        QHash<int, Client> byId;
+        for (const Client &client : clients) {
+            byId.insert(client.id, client);
+        }
+
+        const int maxShown = 25;
+        QStringList lines;
+        for (int i = 0; i < pairs.size() && i < maxShown; ++i) {
+            const Client a = byId.value(pairs.at(i).clientId);
+            const Client b = byId.value(pairs.at(i).otherId);
+            lines << QString("%1%  #%2 %3 (%4)  ↔  #%5 %6 (%7)")
+                         .arg(QString::number(qRound(pairs.at(i).similarity * 100)),
+                              QString::number(a.id), a.name, a.email,
+                              QString::number(b.id), b.name, b.email);
+        }
+        if (pairs.size() > maxShown) {
+            lines << QString("... and %1 more").arg(pairs.size() - maxShown);
+        }
+
+        QMessageBox box(QMessageBox::Information, "Find Duplicates",
+                        QString("%1 likely duplicate pairs found.").arg(pairs.size())
+                            + (unchecked.isEmpty() ? QString() : "\n" + unchecked),
+                        QMessageBox::Ok, this);
+        box.setDetailedText(lines.join("\n"));
+        box.exec();
+    });
+    watcher->setFuture(QtConcurrent::run([clients]() {
+        return DuplicateDetector::findAllPairs(clients);
+    }));
+}
+
 void MainWindow::refreshStatistics()
 {
+    UI_SCOPE("MainWindow::refreshStatistics");
     updateClientStatistics();
     updateCommandStatistics();
 }
@@ -1004,8 +1585,14 @@ void MainWindow::editCommand(int row)
 
 void MainWindow::editCommandById(int commandId)
 {
+    TRACE_SCOPE("ui", "MainWindow::editCommandById");
     qDebug() << "Editing command ID:" << commandId;
 
+    if (commandId <= 0) {
+        statusBar()->showMessage("This command is still being saved, try again in a moment", 3000);
+        return;
+    }
+
     Command command = commandManager->getCommand(commandId);
 
     // Add debug output to check if command is loaded correctly
@@ -1014,12 +1601,7 @@ void MainWindow::editCommandById(int commandId)
     if (command.commandId > 0) {
         CommandsWindow *dialog = new CommandsWindow(commandManager, clientManager,
                                                     command, CommandsWindow::EditMode, this);
-        connect(dialog, &CommandsWindow::finished, this, [this](int result) {
-            if (result == QDialog::Accepted) {
-                qDebug() << "Command edited, refreshing data...";
-                loadCommandsData();
-            }
-        });
+        dialog->setWriteQueue(writeQueue);
         dialog->exec();
     } else {
         qDebug() << "Command not found or invalid ID:" << commandId;
@@ -1029,8 +1611,14 @@ void MainWindow::editCommandById(int commandId)
 
 void MainWindow::deleteCommandById(int commandId)
 {
+    TRACE_SCOPE("ui", "MainWindow::deleteCommandById");
     qDebug() << "Deleting command ID:" << commandId;
 
+    if (commandId <= 0) {
+        statusBar()->showMessage("This command is still being saved, try again in a moment", 3000);
+        return;
+    }
+
     // Get client name for confirmation message
     Command command = commandManager->getCommand(commandId);
     QString clientName = "Unknown";
@@ -1062,6 +1650,7 @@ void MainWindow::deleteCommandById(int commandId)
 //pdf
 void MainWindow::generateClientsCommandsPDF()
 {
+    TRACE_SCOPE("ui", "MainWindow::generateClientsCommandsPDF");
     // Ask user for save location
     QString fileName = QFileDialog::getSaveFileName(this, "Save PDF",
                                                     QDir::homePath() + "/clients_commands_report.pdf",
@@ -1079,99 +1668,9 @@ void MainWindow::generateClientsCommandsPDF()
     printer.setPageOrientation(QPageLayout::Portrait);
 
     // Create HTML content for the PDF
-    QString htmlContent;
-
-    // HTML header with styling
-    htmlContent = R"(
-    <!DOCTYPE html>
-    <html>
-    <head>
-    <style>
-        body { font-family: Arial, sans-serif; margin: 20px; }
-        h1 { color: #2c3e50; text-align: center; border-bottom: 2px solid #3498db; padding-bottom: 10px; }
-        h2 { color: #34495e; border-bottom: 1px solid #bdc3c7; padding-bottom: 5px; margin-top: 30px; }
-        table { width: 100%; border-collapse: collapse; margin-bottom: 20px; }
-        th { background-color: #3498db; color: white; padding: 10px; text-align: left; }
-        td { padding: 8px; border-bottom: 1px solid #ddd; }
-        tr:nth-child(even) { background-color: #f2f2f2; }
-        .client-header { background-color: #ecf0f1; padding: 10px; margin-top: 20px; border-radius: 5px; }
-        .no-commands { color: #7f8c8d; font-style: italic; }
-        .total-row { font-weight: bold; background-color: #eaf2f8; }
-        .timestamp { text-align: right; color: #7f8c8d; font-size: 12px; }
-    </style>
-    </head>
-    <body>
-    )";
-
-    // Report title and timestamp
-    htmlContent += QString("<h1>Clients and Commands Report</h1>");
-    htmlContent += QString("<p class='timestamp'>Generated on: %1</p>").arg(QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss"));
-
-    // Get all clients
-    QList<Client> clients = clientManager->getAllClients();
-
-    if (clients.isEmpty()) {
-        htmlContent += "<p>No clients found in the database.</p>";
-    } else {
-        htmlContent += QString("<p>Total clients: %1</p>").arg(clients.size());
-
-        // Process each client
-        for (const Client &client : clients) {
-            htmlContent += QString("<div class='client-header'>");
-            htmlContent += QString("<h2>Client: %1 (ID: %2)</h2>").arg(client.name).arg(client.id);
-            htmlContent += QString("<p><strong>Email:</strong> %1</p>").arg(client.email);
-            htmlContent += QString("<p><strong>Address:</strong> %1, %2 %3</p>").arg(client.address).arg(client.city).arg(client.postal);
-            htmlContent += "</div>";
-
-            // Get commands for this client
-            QList<Command> commands = commandManager->getClientCommands(client.id);
-
-            if (commands.isEmpty()) {
-                htmlContent += "<p class='no-commands'>No commands found for this client.</p>";
-            } else {
-                htmlContent += "<table>";
-                htmlContent += "<tr><th>Command ID</th><th>Date</th><th>Total</th><th>Payment Method</th><th>Delivery Address</th></tr>";
-
-                double clientTotal = 0.0;
-                for (const Command &command : commands) {
-                    htmlContent += QString("<tr>"
-                                           "<td>%1</td>"
-                                           "<td>%2</td>"
-                                           "<td>$%3</td>"
-                                           "<td>%4</td>"
-                                           "<td>%5</td>"
-                                           "</tr>")
-                                       .arg(command.commandId)
-                                       .arg(command.commandDate.toString("yyyy-MM-dd"))
-                                       .arg(command.total)
-                                       .arg(command.paymentMethod)
-                                       .arg(command.deliveryAddress);
-
-                    clientTotal += command.getTotalAmount();
-                }
-
-                // Add total row
-                htmlContent += QString("<tr class='total-row'>"
-                                       "<td colspan='2'><strong>Total for client:</strong></td>"
-                                       "<td><strong>$%1</strong></td>"
-                                       "<td colspan='2'></td>"
-                                       "</tr>").arg(QString::number(clientTotal, 'f', 2));
-
-                htmlContent += "</table>";
-            }
-        }
-    }
-
-    // Add overall statistics
-    htmlContent += "<h2>Overall Statistics</h2>";
-    htmlContent += "<table>";
-    htmlContent += QString("<tr><td>Total Clients:</td><td>%1</td></tr>").arg(clients.size());
-    htmlContent += QString("<tr><td>Total Commands:</td><td>%1</td></tr>").arg(commandManager->getDAO()->getCommandCount());
-    htmlContent += QString("<tr><td>Total Sales:</td><td>$%1</td></tr>").arg(QString::number(commandManager->getDAO()->getTotalSales(), 'f', 2));
-    htmlContent += "</table>";
-
-    // Close HTML
-    htmlContent += "</body></html>";
+    QString htmlContent = ReportBuilder::clientsCommandsHtml(clientManager->getAllClients(),
+                                                             commandManager->getAllCommands(),
+                                                             statisticsCache->snapshot());
 
     // Create document and print to PDF
     QTextDocument document;
@@ -1253,7 +1752,7 @@ void MainWindow::sendClientCommandsEmail(int clientId)
     }
 
     // Create email content
-    QString subject = QString("Your Order History - %1").arg(client.name);
+    QString subject = ReportBuilder::orderSummarySubject(client);
     QString body = createEmailContent(client, commands);
 
     // Open default email client with pre-filled content
@@ -1270,27 +1769,7 @@ void MainWindow::sendClientCommandsEmail(int clientId)
 
 QString MainWindow::createEmailContent(const Client &client, const QList<Command> &commands)
 {
-    QString content = QString("Dear %1,\n\n").arg(client.name);
-    content += "Here is your order summary:\n\n";
-
-    content += "ORDER HISTORY:\n";
-    content += "==========================================\n";
-
-    double total = 0.0;
-    for (const Command &command : commands) {
-        content += QString("Order #%1 - %2 - $%3\n")
-        .arg(command.commandId)
-            .arg(command.commandDate.toString("MMM d, yyyy"))
-            .arg(command.total);
-        total += command.getTotalAmount();
-    }
-
-    content += "==========================================\n";
-    content += QString("Total: $%1\n\n").arg(QString::number(total, 'f', 2));
-    content += "Thank you for your business!\n\n";
-    content += "Best regards,\nYour Company Team";
-
-    return content;
+    return ReportBuilder::orderSummaryText(client, commands);
 }
 Client MainWindow::findClientByEmail(const QString &email)
 {
@@ -1343,7 +1822,7 @@ Client MainWindow::findClientByEmail(const QString &email)
 void MainWindow::sendClientCommandsEmailByAddress(const Client &client, const QList<Command> &commands)
 {
     // Create email content
-    QString subject = QString("Your Order History - %1").arg(client.name);
+    QString subject = ReportBuilder::orderSummarySubject(client);
     QString body = createEmailContent(client, commands);
 
     // Open default email client with pre-filled content
@@ -1382,6 +1861,8 @@ void MainWindow::onChatbotClicked()
         if (clientManager && commandManager) {
             // Assuming clientManager is of type Client* and commandManager is of type Command*
             chatbotDialog->setManagers(clientManager, commandManager);
+            chatbotDialog->setColumnStore(commandStore);
+            chatbotDialog->setStatisticsCache(statisticsCache);
         }
     }
 
@@ -1396,11 +1877,11 @@ void MainWindow::setupEmailService()
     // No complex SMTP configuration needed
     qDebug() << "Email service setup complete - using system default email client";
 }
-double MainWindow::calculateTotalValue(const QList<Command> &commands)
+Money MainWindow::calculateTotalValue(const QList<Command> &commands)
 {
-    double total = 0.0;
+    Money total;
     for (const Command &command : commands) {
-        total += command.getTotalAmount();
+        total += command.total;
     }
     return total;
 }
@@ -39,6 +39,17 @@
 #include "commands.h"
 #include "clientswindow.h"       // Add this include
 #include "commandswindow.h"      // Add this include
+#include "writebehindqueue.h"
+#include "clientsearchindex.h"
+#include "omniboxindex.h"
+#include "duplicatedetector.h"
+#include "commandcolumnstore.h"
+#include "topkleaderboard.h"
+#include "statisticscache.h"
+#include "snapshotstore.h"
+#include "responsivenesshud.h"
+#include <QCompleter>
+#include <QStandardItemModel>
 #include <QDesktopServices>
 #include <QUrl>
 
@@ -75,6 +86,22 @@ private slots:
     void editCommand(int row);
     void onChatbotClicked();
 
+    // Write-behind queue updates
+    void onClientWriteApplied(const Client &client);
+    void onClientWriteCommitted(int viewId, const Client &client);
+    void onClientWriteReverted(const Client &attempted, const Client &previous, const QString &error);
+    void onCommandWriteApplied(const Command &command);
+    void onCommandWriteCommitted(int viewId, const Command &command);
+    void onCommandWriteReverted(const Command &attempted, const Command &previous, const QString &error);
+    void onPendingWritesChanged(int count);
+
+    // Omnibox
+    void onOmniboxEdited(const QString &text);
+    void openOmniboxResult(const QModelIndex &index);
+
+    // Batch duplicate scan
+    void onFindDuplicatesClicked();
+
 private:
     Ui::MainWindow *ui;
 
@@ -109,31 +136,59 @@ private:
     // Data managers
     ClientManager *clientManager;
     CommandManager *commandManager;
+    WriteBehindQueue *writeQueue;
+    ClientSearchIndex *clientIndex;
+    OmniboxIndex *omniboxIndex;
+    DuplicateDetector *duplicateDetector;
+    CommandColumnStore *commandStore;
+    TopKLeaderboard *leaderboard;
+    StatisticsCache *statisticsCache;
+    SnapshotStore *snapshotStore;
+    QLineEdit *omniboxEdit;
+    QCompleter *omniboxCompleter;
+    QStandardItemModel *omniboxModel;
 
     // Animation effects
     QPropertyAnimation *fadeAnimation;
     QTimer *refreshTimer;
+    ResponsivenessHud *responsivenessHud;
 
     // UI setup methods
     void setupUI();
     void setupStatisticsFrames();
     void setupTables();
+    void setupOmnibox();
     void applyModernStyling();
     void connectSignals();
 
     // Data methods
     void loadClientsData();
     void loadCommandsData();
+    void reloadAllData();    // Initial load and explicit refresh: tables and in-memory indexes
     void updateClientStatistics();
     void updateCommandStatistics();
-    void populateClientsTable();
-    void populateCommandsTable();
+    void populateClientsTable(bool rebuildIndexes = false);
+    void populateCommandsTable(bool rebuildIndexes = false);
+    // The indexes follow the DAO signals; rebuildIndexes reloads them from the list
+    void showClients(const QList<Client> &clients, const QHash<int, int> &orderCounts, bool rebuildIndexes);
+    void showCommands(const QList<Command> &commands, bool rebuildIndexes);
+    void showSnapshot();
+
+    // Single row updates used for optimistic saves
+    void setClientRow(int row, const Client &client);
+    void setCommandRow(int row, const Command &command, const QString &clientName);
+    int findTableRow(QTableWidget *table, int id) const;
+    void upsertClientRow(int viewId, const Client &client);
+    void upsertCommandRow(int viewId, const Command &command);
+    void removeTableRow(QTableWidget *table, int id);
+    QString clientNameFor(int clientId);
 
     // Utility methods
     QFrame* createStatCard(const QString &title, const QString &value, const QString &icon = "");
     void animateWidget(QWidget *widget, int duration = 300);
     void setCardHoverEffect(QFrame *card);
     QString formatCurrency(double amount);
+    QString formatCurrency(const Money &amount);
 
     // Command edit/delete methods - MOVED TO PRIVATE SECTION
     void editCommandById(int commandId);
@@ -151,7 +206,7 @@ private:
     // NEW METHODS - Add these:
     Client findClientByEmail(const QString &email);
     void sendClientCommandsEmailByAddress(const Client &client, const QList<Command> &commands);
-    double calculateTotalValue(const QList<Command> &commands);  // ADDED: Helper method
+    Money calculateTotalValue(const QList<Command> &commands);  // ADDED: Helper method
     ChatbotDialog *chatbotDialog;
 };
 
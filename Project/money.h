@@ -0,0 +1,144 @@
+// money.h
+#ifndef MONEY_H
+#define MONEY_H
+
+#include <QString>
+#include <QVariant>
+#include <QMetaType>
+#include <QtGlobal>
+#include <cmath>
+
+// Fixed-point amount stored as a whole number of cents.
+// Sums and comparisons are exact; doubles are only used at the UI edge.
+class Money
+{
+public:
+    Money() : cents(0) {}
+
+    static Money fromCents(qint64 cents) {
+        Money money;
+        money.cents = cents;
+        return money;
+    }
+
+    // Rounds to the nearest cent
+    static Money fromDouble(double amount) {
+        return fromCents(qint64(std::llround(amount * 100.0)));
+    }
+
+    // Accepts "12", "12.5", "-12.50", "$1,234.56"; a third decimal is rounded
+    static Money fromString(const QString& text, bool *ok = nullptr) {
+        qint64 whole = 0;
+        qint64 fraction = 0;
+        int fractionDigits = 0;
+        bool negative = false;
+        bool seenDigit = false;
+        bool seenPoint = false;
+        bool roundUp = false;
+        bool valid = true;
+
+        for (QChar ch : text) {
+            if (ch.isSpace() || ch == '$' || ch == ',') {
+                continue;
+            }
+            if (ch == '-' && !seenDigit && !seenPoint && !negative) {
+                negative = true;
+            } else if (ch == '.' && !seenPoint) {
+                seenPoint = true;
+            } else if (ch.isDigit()) {
+                int digit = ch.digitValue();
+                seenDigit = true;
+                if (!seenPoint) {
+                    whole = whole * 10 + digit;
+                } else if (fractionDigits < 2) {
+                    fraction = fraction * 10 + digit;
+                    fractionDigits++;
+                } else if (fractionDigits == 2) {
+                    roundUp = digit >= 5;
+                    fractionDigits++;
+                }
+            } else {
+                valid = false;
+                break;
+            }
+        }
+
+        valid = valid && seenDigit;
+        if (ok) {
+            *ok = valid;
+        }
+        if (!valid) {
+            return Money();
+        }
+
+        if (fractionDigits == 1) {
+            fraction *= 10;
+        }
+        qint64 total = whole * 100 + fraction + (roundUp ? 1 : 0);
+        return fromCents(negative ? -total : total);
+    }
+
+    // NUMBER columns arrive as a string, double or integer depending on the
+    // driver and the query's numerical precision policy
+    static Money fromVariant(const QVariant& value) {
+        if (value.isNull()) {
+            return Money();
+        }
+        switch (value.typeId()) {
+        case QMetaType::Int:
+        case QMetaType::LongLong:
+        case QMetaType::UInt:
+        case QMetaType::ULongLong:
+            return fromCents(value.toLongLong() * 100);
+        case QMetaType::Double:
+        case QMetaType::Float:
+            return fromDouble(value.toDouble());
+        default:
+            return fromString(value.toString());
+        }
+    }
+
+    qint64 toCents() const { return cents; }
+    double toDouble() const { return double(cents) / 100.0; }
+
+    // Plain decimal text, e.g. "1234.50"
+    QString toString() const {
+        qint64 absolute = cents < 0 ? -cents : cents;
+        return QString("%1%2.%3")
+            .arg(cents < 0 ? "-" : "")
+            .arg(absolute / 100)
+            .arg(absolute % 100, 2, 10, QChar('0'));
+    }
+
+    bool isZero() const { return cents == 0; }
+    bool isNegative() const { return cents < 0; }
+
+    // Average of count amounts, rounded half away from zero
+    Money dividedBy(qint64 count) const {
+        if (count == 0) {
+            return Money();
+        }
+        qint64 half = (cents < 0) == (count < 0) ? count / 2 : -count / 2;
+        return fromCents((cents + half) / count);
+    }
+
+    Money& operator+=(const Money& other) { cents += other.cents; return *this; }
+    Money& operator-=(const Money& other) { cents -= other.cents; return *this; }
+    Money operator+(const Money& other) const { return fromCents(cents + other.cents); }
+    Money operator-(const Money& other) const { return fromCents(cents - other.cents); }
+    Money operator*(qint64 factor) const { return fromCents(cents * factor); }
+
+    bool operator==(const Money& other) const { return cents == other.cents; }
+    bool operator!=(const Money& other) const { return cents != other.cents; }
+    bool operator<(const Money& other) const { return cents < other.cents; }
+    bool operator>(const Money& other) const { return cents > other.cents; }
+    bool operator<=(const Money& other) const { return cents <= other.cents; }
+    bool operator>=(const Money& other) const { return cents >= other.cents; }
+
+private:
+    qint64 cents;
+};
+
+Q_DECLARE_METATYPE(Money)
+
+#endif // MONEY_H
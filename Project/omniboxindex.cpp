@@ -0,0 +1,332 @@
+// omniboxindex.cpp
+#include "omniboxindex.h"
+#include "writebehindqueue.h"
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+const double K1 = 1.2;
+const double B = 0.75;
+}
+
+OmniboxIndex::OmniboxIndex(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void OmniboxIndex::rebuildClients(const QList<Client>& clients)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    Corpus& corpus = corpora[ClientDoc];
+    corpus.clear();
+    corpus.docs.reserve(clients.size());
+    for (const Client& client : clients) {
+        addClientDocument(client);
+    }
+    corpus.ready = true;
+
+    qDebug() << "Omnibox index: clients loaded," << corpus.liveDocs << "documents,"
+             << corpus.postings.size() << "terms in" << timer.elapsed() << "ms";
+}
+
+void OmniboxIndex::rebuildOrders(const QList<Command>& commands)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    Corpus& corpus = corpora[OrderDoc];
+    corpus.clear();
+    corpus.docs.reserve(commands.size());
+    for (const Command& command : commands) {
+        addOrderDocument(command);
+    }
+    corpus.ready = true;
+
+    qDebug() << "Omnibox index: orders loaded," << corpus.liveDocs << "documents,"
+             << corpus.postings.size() << "terms in" << timer.elapsed() << "ms";
+}
+
+void OmniboxIndex::attach(ClientDAO* dao)
+{
+    connect(dao, &ClientDAO::clientCreated, this, &OmniboxIndex::upsertClient);
+    connect(dao, &ClientDAO::clientUpdated, this, &OmniboxIndex::upsertClient);
+    connect(dao, &ClientDAO::clientDeleted, this, &OmniboxIndex::removeClient);
+}
+
+void OmniboxIndex::attach(CommandDAO* dao)
+{
+    connect(dao, &CommandDAO::commandCreated, this, &OmniboxIndex::upsertOrder);
+    connect(dao, &CommandDAO::commandUpdated, this, &OmniboxIndex::upsertOrder);
+    connect(dao, &CommandDAO::commandDeleted, this, &OmniboxIndex::removeOrder);
+}
+
+void OmniboxIndex::attach(WriteBehindQueue* queue)
+{
+    connect(queue, &WriteBehindQueue::clientCommitted, this, [this](int, const Client& client) {
+        upsertClient(client);
+    });
+    connect(queue, &WriteBehindQueue::commandCommitted, this, [this](int, const Command& command) {
+        upsertOrder(command);
+    });
+}
+
+void OmniboxIndex::upsertClient(const Client& client)
+{
+    if (client.id <= 0) {
+        return;
+    }
+    corpora[ClientDoc].remove(client.id);
+    addClientDocument(client);
+}
+
+void OmniboxIndex::removeClient(int clientId)
+{
+    corpora[ClientDoc].remove(clientId);
+}
+
+void OmniboxIndex::upsertOrder(const Command& command)
+{
+    if (command.commandId <= 0) {
+        return;
+    }
+    corpora[OrderDoc].remove(command.commandId);
+    addOrderDocument(command);
+}
+
+void OmniboxIndex::removeOrder(int commandId)
+{
+    corpora[OrderDoc].remove(commandId);
+}
+
+QList<OmniboxIndex::Result> OmniboxIndex::search(const QString& query, int k, int typeMask) const
+{
+    QList<Result> results;
+    QStringList words = tokenize(query);
+    if (words.isEmpty() || k <= 0) {
+        return results;
+    }
+
+    // A trailing space means the last word is complete
+    bool lastIsPrefix = !query.at(query.size() - 1).isSpace();
+
+    struct Hit {
+        double score;
+        int type;
+        int doc;
+    };
+    QVector<Hit> hits;
+
+    for (int type = ClientDoc; type <= OrderDoc; ++type) {
+        const Corpus& corpus = corpora[type];
+        if (!(typeMask & (1 << type)) || corpus.liveDocs == 0) {
+            continue;
+        }
+
+        QHash<int, double> scores;
+        for (int i = 0; i < words.size(); ++i) {
+            bool prefix = lastIsPrefix && i == words.size() - 1;
+            QHash<int, double> wordScores = corpus.scoreWord(words.at(i), prefix);
+
+            if (i == 0) {
+                scores = wordScores;
+            } else {
+                // Every word has to match
+                for (auto it = scores.begin(); it != scores.end();) {
+                    auto match = wordScores.constFind(it.key());
+                    if (match == wordScores.constEnd()) {
+                        it = scores.erase(it);
+                    } else {
+                        it.value() += match.value();
+                        ++it;
+                    }
+                }
+            }
+
+            if (scores.isEmpty()) {
+                break;
+            }
+        }
+
+        for (auto it = scores.constBegin(); it != scores.constEnd(); ++it) {
+            hits.append({it.value(), type, it.key()});
+        }
+    }
+
+    int count = qMin(k, int(hits.size()));
+    std::partial_sort(hits.begin(), hits.begin() + count, hits.end(), [this](const Hit& a, const Hit& b) {
+        if (a.score != b.score) return a.score > b.score;
+        if (a.type != b.type) return a.type < b.type;
+        return corpora[a.type].docs.at(a.doc).id < corpora[b.type].docs.at(b.doc).id;
+    });
+
+    for (int i = 0; i < count; ++i) {
+        const Hit& hit = hits.at(i);
+        const Document& doc = corpora[hit.type].docs.at(hit.doc);
+        results.append({DocType(hit.type), doc.id, hit.score, doc.title, doc.detail});
+    }
+    return results;
+}
+
+QStringList OmniboxIndex::tokenize(const QString& text)
+{
+    // Case folded runs of letters and digits: "j.doe@mail.com" -> j, doe, mail, com
+    QStringList tokens;
+    QString folded = text.toCaseFolded();
+    QString current;
+    for (QChar ch : folded) {
+        if (ch.isLetterOrNumber()) {
+            current.append(ch);
+        } else if (!current.isEmpty()) {
+            tokens << current;
+            current.clear();
+        }
+    }
+    if (!current.isEmpty()) {
+        tokens << current;
+    }
+    return tokens;
+}
+
+void OmniboxIndex::addClientDocument(const Client& client)
+{
+    corpora[ClientDoc].add(client.id,
+                           QStringList{client.name, client.email, client.city, client.postal}.join(' '),
+                           client.name,
+                           QString("%1 · %2 %3").arg(client.email, client.postal, client.city).trimmed());
+}
+
+void OmniboxIndex::addOrderDocument(const Command& command)
+{
+    corpora[OrderDoc].add(command.commandId,
+                          QStringList{QString::number(command.commandId), command.deliveryAddress,
+                                      command.paymentMethod}.join(' '),
+                          QString("Order #%1").arg(command.commandId),
+                          QString("$%1 · %2 · %3").arg(command.total.toString(), command.paymentMethod,
+                                                        command.deliveryAddress.simplified()));
+}
+
+// Corpus
+
+void OmniboxIndex::Corpus::clear()
+{
+    docs.clear();
+    freeDocs.clear();
+    docById.clear();
+    postings.clear();
+    totalLength = 0;
+    liveDocs = 0;
+    ready = false;
+}
+
+void OmniboxIndex::Corpus::add(int id, const QString& text, const QString& title, const QString& detail)
+{
+    QStringList tokens = tokenize(text);
+    QHash<QString, int> frequencies;
+    for (const QString& token : tokens) {
+        frequencies[token]++;
+    }
+
+    int docIndex;
+    if (!freeDocs.isEmpty()) {
+        docIndex = freeDocs.takeLast();
+    } else {
+        docIndex = docs.size();
+        docs.append(Document());
+    }
+
+    Document& doc = docs[docIndex];
+    doc.id = id;
+    doc.length = tokens.size();
+    doc.terms = frequencies.keys();
+    doc.positions.resize(doc.terms.size());
+    doc.title = title;
+    doc.detail = detail;
+
+    for (int term = 0; term < doc.terms.size(); ++term) {
+        QVector<Posting>& list = postings[doc.terms.at(term)];
+        doc.positions[term] = list.size();
+        list.append({docIndex, frequencies.value(doc.terms.at(term)), term});
+    }
+
+    docById.insert(id, docIndex);
+    totalLength += doc.length;
+    liveDocs++;
+}
+
+void OmniboxIndex::Corpus::remove(int id)
+{
+    auto found = docById.find(id);
+    if (found == docById.end()) {
+        return;
+    }
+
+    int docIndex = found.value();
+    docById.erase(found);
+
+    // Each posting knows its position, so removal moves the last posting
+    // of the list into the hole; scoring does not depend on list order
+    Document& doc = docs[docIndex];
+    for (int term = 0; term < doc.terms.size(); ++term) {
+        auto it = postings.find(doc.terms.at(term));
+        if (it == postings.end()) {
+            continue;
+        }
+        QVector<Posting>& list = it.value();
+        int position = doc.positions.at(term);
+        const Posting& last = list.last();
+        if (position != list.size() - 1) {
+            list[position] = last;
+            docs[last.doc].positions[last.term] = position;
+        }
+        list.removeLast();
+        if (list.isEmpty()) {
+            postings.erase(it);
+        }
+    }
+
+    totalLength -= doc.length;
+    liveDocs--;
+    doc = Document();
+    freeDocs.append(docIndex);
+}
+
+QHash<int, double> OmniboxIndex::Corpus::scoreWord(const QString& word, bool prefix) const
+{
+    QHash<int, double> scores;
+    double averageLength = liveDocs > 0 ? double(totalLength) / liveDocs : 1.0;
+
+    auto scoreTerm = [&](const QVector<Posting>& list) {
+        double df = list.size();
+        double idf = std::log(1.0 + (liveDocs - df + 0.5) / (df + 0.5));
+        for (const Posting& posting : list) {
+            double tf = posting.tf;
+            double length = docs.at(posting.doc).length;
+            double score = idf * tf * (K1 + 1.0) / (tf + K1 * (1.0 - B + B * length / averageLength));
+
+            // Several expansions of a prefix can hit one document; keep the best
+            double& current = scores[posting.doc];
+            current = qMax(current, score);
+        }
+    };
+
+    if (!prefix) {
+        auto it = postings.constFind(word);
+        if (it != postings.constEnd()) {
+            scoreTerm(it.value());
+        }
+        return scores;
+    }
+
+    int expanded = 0;
+    for (auto it = postings.lowerBound(word); it != postings.constEnd() && it.key().startsWith(word); ++it) {
+        scoreTerm(it.value());
+        if (++expanded == MaxPrefixTerms) {
+            break;
+        }
+    }
+    return scores;
+}
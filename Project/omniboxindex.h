@@ -0,0 +1,106 @@
+// omniboxindex.h
+#ifndef OMNIBOXINDEX_H
+#define OMNIBOXINDEX_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QVector>
+#include <QHash>
+#include <QMap>
+
+#include "clients.h"
+#include "commands.h"
+
+class WriteBehindQueue;
+
+// Inverted index behind the main window omnibox.
+//
+// Clients are indexed by name, email, city and postal code, orders by id,
+// delivery address and payment method. Results are ranked with BM25
+// (k1 = 1.2, b = 0.75) and every query word must match; the last word is
+// treated as a prefix so results follow the user while typing.
+//
+// Like ClientSearchIndex it lives on the GUI thread and follows the DAO
+// and write-behind queue signals once loaded.
+class OmniboxIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum DocType { ClientDoc = 0, OrderDoc = 1 };
+    enum TypeMask { Clients = 1, Orders = 2, AllTypes = Clients | Orders };
+
+    struct Result {
+        DocType type;
+        int id;
+        double score;
+        QString title;
+        QString detail;
+    };
+
+    explicit OmniboxIndex(QObject *parent = nullptr);
+
+    // Clients and orders are loaded separately, each replacing its own corpus
+    void rebuildClients(const QList<Client>& clients);
+    void rebuildOrders(const QList<Command>& commands);
+    void attach(ClientDAO* dao);
+    void attach(CommandDAO* dao);
+    void attach(WriteBehindQueue* queue);
+
+    bool isReady() const { return corpora[ClientDoc].ready || corpora[OrderDoc].ready; }
+    int documentCount() const { return corpora[ClientDoc].liveDocs + corpora[OrderDoc].liveDocs; }
+
+    QList<Result> search(const QString& query, int k = 10, int typeMask = AllTypes) const;
+
+public slots:
+    void upsertClient(const Client& client);
+    void removeClient(int clientId);
+    void upsertOrder(const Command& command);
+    void removeOrder(int commandId);
+
+private:
+    struct Posting {
+        int doc;
+        int tf;
+        int term;               // Index into the document's terms
+    };
+
+    struct Document {
+        int id = 0;
+        int length = 0;
+        QStringList terms;      // Distinct, for removal
+        QVector<int> positions; // Where each term's posting sits in its list
+        QString title;
+        QString detail;
+    };
+
+    // One per document type, with its own document frequencies and
+    // average length so short client records and long addresses are
+    // each normalised against their own kind
+    struct Corpus {
+        QVector<Document> docs;
+        QVector<int> freeDocs;
+        QHash<int, int> docById;
+        QMap<QString, QVector<Posting>> postings;   // Ordered for prefix ranges
+        qint64 totalLength = 0;
+        int liveDocs = 0;
+        bool ready = false;
+
+        void clear();
+        void add(int id, const QString& text, const QString& title, const QString& detail);
+        void remove(int id);
+        QHash<int, double> scoreWord(const QString& word, bool prefix) const;
+    };
+
+    Corpus corpora[2];
+
+    static const int MaxPrefixTerms = 64;
+
+    static QStringList tokenize(const QString& text);
+    void addClientDocument(const Client& client);
+    void addOrderDocument(const Command& command);
+};
+
+#endif // OMNIBOXINDEX_H
@@ -0,0 +1,301 @@
+// prefixtrie.cpp
+#include "prefixtrie.h"
+#include <queue>
+
+PrefixTrie::PrefixTrie()
+    : valueCount(0)
+{
+    clear();
+}
+
+void PrefixTrie::clear()
+{
+    arena.clear();
+    nodes.clear();
+    itemLists.clear();
+    nodes.append(Node());   // Root, empty label
+    valueCount = 0;
+}
+
+void PrefixTrie::insert(const QString& key, qint64 value, int score)
+{
+    int node = 0;
+    int pos = 0;
+
+    while (pos < key.size()) {
+        int child = findChild(node, key.at(pos));
+
+        if (child < 0) {
+            // New leaf holding the rest of the key
+            Node leaf;
+            leaf.labelOffset = arena.size();
+            leaf.labelLength = key.size() - pos;
+            arena.append(QStringView(key).mid(pos));
+            int leafIndex = nodes.size();
+            nodes.append(leaf);
+            addChild(node, leafIndex);
+            node = leafIndex;
+            pos = key.size();
+            break;
+        }
+
+        const Node& edge = nodes.at(child);
+        const QChar *label = arena.constData() + edge.labelOffset;
+        int common = 0;
+        while (common < edge.labelLength && pos + common < key.size()
+               && label[common] == key.at(pos + common)) {
+            common++;
+        }
+
+        if (common < edge.labelLength) {
+            // Split the edge: parent -> middle (shared part) -> child (rest)
+            Node middle;
+            middle.labelOffset = edge.labelOffset;
+            middle.labelLength = common;
+            middle.parent = node;
+            middle.maxScore = edge.maxScore;
+            int middleIndex = nodes.size();
+            nodes.append(middle);
+
+            replaceChild(node, child, middleIndex);
+            nodes[child].labelOffset += common;
+            nodes[child].labelLength -= common;
+            nodes[child].nextSibling = -1;
+            nodes[child].parent = -1;
+            addChild(middleIndex, child);
+            child = middleIndex;
+        }
+
+        node = child;
+        pos += common;
+    }
+
+    Node& target = nodes[node];
+    if (target.itemList < 0) {
+        target.itemList = itemLists.size();
+        itemLists.append(QVector<Item>());
+    }
+
+    QVector<Item>& items = itemLists[target.itemList];
+    for (Item& item : items) {
+        if (item.value == value) {
+            item.score = score;
+            refreshMaxScore(node);
+            return;
+        }
+    }
+
+    items.append({value, score});
+    valueCount++;
+    refreshMaxScore(node);
+}
+
+void PrefixTrie::remove(const QString& key, qint64 value)
+{
+    int node = findNode(key);
+    if (node < 0 || nodes.at(node).itemList < 0) {
+        return;
+    }
+
+    QVector<Item>& items = itemLists[nodes.at(node).itemList];
+    for (int i = 0; i < items.size(); ++i) {
+        if (items.at(i).value == value) {
+            items.remove(i);
+            valueCount--;
+            refreshMaxScore(node);
+            return;
+        }
+    }
+}
+
+void PrefixTrie::setScore(const QString& key, qint64 value, int score)
+{
+    int node = findNode(key);
+    if (node < 0 || nodes.at(node).itemList < 0) {
+        return;
+    }
+
+    for (Item& item : itemLists[nodes.at(node).itemList]) {
+        if (item.value == value) {
+            item.score = score;
+            refreshMaxScore(node);
+            return;
+        }
+    }
+}
+
+QList<PrefixTrie::Completion> PrefixTrie::complete(const QString& prefix, int k) const
+{
+    QList<Completion> results;
+    if (k <= 0) {
+        return results;
+    }
+
+    // Walk down; the prefix may end in the middle of an edge
+    int node = 0;
+    int pos = 0;
+    while (pos < prefix.size()) {
+        int child = findChild(node, prefix.at(pos));
+        if (child < 0) {
+            return results;
+        }
+        const Node& edge = nodes.at(child);
+        int length = qMin(edge.labelLength, int(prefix.size() - pos));
+        if (QStringView(arena).mid(edge.labelOffset, length) != QStringView(prefix).mid(pos, length)) {
+            return results;
+        }
+        node = child;
+        pos += length;
+    }
+
+    // Best-first over the subtree: a node enters with its best score, so
+    // an item popped before any node outranks everything still queued
+    struct Candidate {
+        int score;
+        int sequence;
+        int node;
+        int item;   // -1 for a node
+    };
+    auto lower = [](const Candidate& a, const Candidate& b) {
+        if (a.score != b.score) return a.score < b.score;
+        if ((a.item < 0) != (b.item < 0)) return a.item < 0;   // Items first
+        return a.sequence > b.sequence;
+    };
+    std::priority_queue<Candidate, std::vector<Candidate>, decltype(lower)> queue(lower);
+
+    int sequence = 0;
+    if (nodes.at(node).maxScore >= 0) {
+        queue.push({nodes.at(node).maxScore, sequence++, node, -1});
+    }
+
+    while (!queue.empty() && results.size() < k) {
+        Candidate top = queue.top();
+        queue.pop();
+
+        if (top.item >= 0) {
+            const Item& item = itemLists.at(nodes.at(top.node).itemList).at(top.item);
+            results.append({keyOf(top.node), item.value, item.score});
+            continue;
+        }
+
+        const Node& current = nodes.at(top.node);
+        if (current.itemList >= 0) {
+            const QVector<Item>& items = itemLists.at(current.itemList);
+            for (int i = 0; i < items.size(); ++i) {
+                queue.push({items.at(i).score, sequence++, top.node, i});
+            }
+        }
+        for (int child = current.firstChild; child >= 0; child = nodes.at(child).nextSibling) {
+            if (nodes.at(child).maxScore >= 0) {
+                queue.push({nodes.at(child).maxScore, sequence++, child, -1});
+            }
+        }
+    }
+
+    return results;
+}
+
+int PrefixTrie::findChild(int node, QChar first) const
+{
+    for (int child = nodes.at(node).firstChild; child >= 0; child = nodes.at(child).nextSibling) {
+        QChar label = arena.at(nodes.at(child).labelOffset);
+        if (label == first) {
+            return child;
+        }
+        if (label > first) {
+            break;   // Siblings are sorted
+        }
+    }
+    return -1;
+}
+
+int PrefixTrie::findNode(const QString& key) const
+{
+    int node = 0;
+    int pos = 0;
+    while (pos < key.size()) {
+        int child = findChild(node, key.at(pos));
+        if (child < 0) {
+            return -1;
+        }
+        const Node& edge = nodes.at(child);
+        if (pos + edge.labelLength > key.size()
+            || QStringView(arena).mid(edge.labelOffset, edge.labelLength) != QStringView(key).mid(pos, edge.labelLength)) {
+            return -1;
+        }
+        node = child;
+        pos += edge.labelLength;
+    }
+    return node;
+}
+
+void PrefixTrie::addChild(int parent, int child)
+{
+    nodes[child].parent = parent;
+    QChar first = arena.at(nodes.at(child).labelOffset);
+
+    int previous = -1;
+    int current = nodes.at(parent).firstChild;
+    while (current >= 0 && arena.at(nodes.at(current).labelOffset) < first) {
+        previous = current;
+        current = nodes.at(current).nextSibling;
+    }
+
+    nodes[child].nextSibling = current;
+    if (previous < 0) {
+        nodes[parent].firstChild = child;
+    } else {
+        nodes[previous].nextSibling = child;
+    }
+}
+
+void PrefixTrie::replaceChild(int parent, int oldChild, int newChild)
+{
+    nodes[newChild].nextSibling = nodes.at(oldChild).nextSibling;
+    if (nodes.at(parent).firstChild == oldChild) {
+        nodes[parent].firstChild = newChild;
+        return;
+    }
+    for (int child = nodes.at(parent).firstChild; child >= 0; child = nodes.at(child).nextSibling) {
+        if (nodes.at(child).nextSibling == oldChild) {
+            nodes[child].nextSibling = newChild;
+            return;
+        }
+    }
+}
+
+void PrefixTrie::refreshMaxScore(int node)
+{
+    // Recompute upwards until a node's best score does not change
+    for (int current = node; current >= 0; current = nodes.at(current).parent) {
+        int best = -1;
+        if (nodes.at(current).itemList >= 0) {
+            for (const Item& item : itemLists.at(nodes.at(current).itemList)) {
+                best = qMax(best, item.score);
+            }
+        }
+        for (int child = nodes.at(current).firstChild; child >= 0; child = nodes.at(child).nextSibling) {
+            best = qMax(best, nodes.at(child).maxScore);
+        }
+
+        if (best == nodes.at(current).maxScore && current != node) {
+            break;
+        }
+        nodes[current].maxScore = best;
+    }
+}
+
+QString PrefixTrie::keyOf(int node) const
+{
+    QVector<int> path;
+    for (int current = node; current > 0; current = nodes.at(current).parent) {
+        path.append(current);
+    }
+
+    QString key;
+    for (int i = path.size() - 1; i >= 0; --i) {
+        const Node& edge = nodes.at(path.at(i));
+        key.append(QStringView(arena).mid(edge.labelOffset, edge.labelLength));
+    }
+    return key;
+}
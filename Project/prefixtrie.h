@@ -0,0 +1,69 @@
+// prefixtrie.h
+#ifndef PREFIXTRIE_H
+#define PREFIXTRIE_H
+
+#include <QString>
+#include <QList>
+#include <QVector>
+
+// Compressed (radix) prefix trie returning the best scored keys for a prefix.
+//
+// Runs of single-child nodes are merged into one edge whose label is a
+// slice of a shared text arena, and children hang off sibling links, so a
+// node costs a few integers. Every node also records the best score in its
+// subtree: a completion walks down to the prefix, then expands nodes
+// best-first and stops after k values, whatever the size of the subtree.
+//
+// A key can carry several values (e.g. two clients in the same city).
+// Removing the last value leaves the node behind until the next clear().
+class PrefixTrie
+{
+public:
+    struct Completion {
+        QString key;
+        qint64 value;
+        int score;
+    };
+
+    PrefixTrie();
+
+    void clear();
+    void insert(const QString& key, qint64 value, int score);
+    void remove(const QString& key, qint64 value);
+    void setScore(const QString& key, qint64 value, int score);
+
+    // Highest scores first; equal scores come out in trie order
+    QList<Completion> complete(const QString& prefix, int k) const;
+
+    int size() const { return valueCount; }
+
+private:
+    struct Item {
+        qint64 value;
+        int score;
+    };
+
+    struct Node {
+        int labelOffset = 0;
+        int labelLength = 0;
+        int parent = -1;
+        int firstChild = -1;
+        int nextSibling = -1;
+        int itemList = -1;      // index into itemLists
+        int maxScore = -1;      // best score below this node, -1 when empty
+    };
+
+    QString arena;
+    QVector<Node> nodes;
+    QVector<QVector<Item>> itemLists;
+    int valueCount;
+
+    int findChild(int node, QChar first) const;
+    int findNode(const QString& key) const;
+    void addChild(int parent, int child);
+    void replaceChild(int parent, int oldChild, int newChild);
+    void refreshMaxScore(int node);
+    QString keyOf(int node) const;
+};
+
+#endif // PREFIXTRIE_H
@@ -0,0 +1,198 @@
+// querycache.cpp
+#include "querycache.h"
+#include "unitofwork.h"
+#include <QMutexLocker>
+#include <QDateTime>
+#include <QDebug>
+
+QueryCache::QueryCache()
+    : clock(1), maxAgeMs(30 * 1000)
+{
+    entries.setMaxCost(8 * 1024 * 1024);
+}
+
+QueryCache& QueryCache::instance()
+{
+    static QueryCache cache;
+    return cache;
+}
+
+void QueryCache::invalidate(const QStringList& tables)
+{
+    QMutexLocker locker(&mutex);
+    ++clock;
+    for (const QString& table : tables) {
+        invalidatedAt.insert(table, clock);
+        for (const QString& key : keysByTable.take(table)) {
+            entries.remove(key);
+        }
+    }
+}
+
+void QueryCache::clear()
+{
+    QMutexLocker locker(&mutex);
+    ++clock;
+    entries.clear();
+    keysByTable.clear();
+    for (auto it = invalidatedAt.begin(); it != invalidatedAt.end(); ++it) {
+        it.value() = clock;
+    }
+}
+
+void QueryCache::setBudget(qint64 bytes)
+{
+    QMutexLocker locker(&mutex);
+    entries.setMaxCost(bytes);
+}
+
+void QueryCache::setMaxAge(int ms)
+{
+    QMutexLocker locker(&mutex);
+    maxAgeMs = ms;
+}
+
+qint64 QueryCache::bytesUsed() const
+{
+    QMutexLocker locker(&mutex);
+    return entries.totalCost();
+}
+
+QMap<QString, QueryCache::OperationStats> QueryCache::stats() const
+{
+    QMutexLocker locker(&mutex);
+    QMap<QString, OperationStats> result;
+    for (auto it = operations.constBegin(); it != operations.constEnd(); ++it) {
+        result.insert(it.key(), it.value());
+    }
+    return result;
+}
+
+QString QueryCache::report() const
+{
+    QStringList lines;
+    const QMap<QString, OperationStats> all = stats();
+    for (auto it = all.constBegin(); it != all.constEnd(); ++it) {
+        lines << QString("%1: %2/%3 hits (%4%)")
+                     .arg(it.key())
+                     .arg(it.value().hits)
+                     .arg(it.value().hits + it.value().misses)
+                     .arg(it.value().hitRatio() * 100, 0, 'f', 1);
+    }
+    lines << QString("Cache size: %1 KB").arg(bytesUsed() / 1024);
+    return lines.join('\n');
+}
+
+QString QueryCache::makeKey(const QString& sql, const QVariantList& binds)
+{
+    // Unit separator between parts, and the type so 1 and "1" differ
+    QString key = sql;
+    for (const QVariant& value : binds) {
+        key += QChar(0x1f);
+        key += QString::number(value.typeId());
+        key += ':';
+        key += value.typeId() == QMetaType::QDateTime
+                   ? QString::number(value.toDateTime().toMSecsSinceEpoch())
+                   : value.toString();
+    }
+    return key;
+}
+
+bool QueryCache::lookup(const QString& operation, const QString& key, std::any *value, quint64 *stamp)
+{
+    // Inside a unit of work the connection can see its own uncommitted rows
+    bool bypass = UnitOfWork::isActive();
+
+    QMutexLocker locker(&mutex);
+    OperationStats& counters = operations[operation];
+    *stamp = bypass ? 0 : clock;
+
+    if (!bypass) {
+        Entry *entry = entries.object(key);
+        if (entry && entry->age.elapsed() < maxAgeMs) {
+            counters.hits++;
+            *value = entry->value;
+            return true;
+        }
+        if (entry) {
+            entries.remove(key);
+        }
+    }
+
+    counters.misses++;
+    return false;
+}
+
+void QueryCache::store(const QString& key, std::any value, qint64 bytes, const QStringList& tables, quint64 stamp)
+{
+    if (stamp == 0) {
+        return;
+    }
+
+    QMutexLocker locker(&mutex);
+
+    // A write committed while the query ran; its result may predate it
+    for (const QString& table : tables) {
+        if (invalidatedAt.value(table) > stamp) {
+            return;
+        }
+    }
+
+    Entry *entry = new Entry;
+    entry->value = std::move(value);
+    entry->age.start();
+    if (!entries.insert(key, entry, bytes)) {
+        return;     // Larger than the whole budget; QCache deleted it
+    }
+
+    for (const QString& table : tables) {
+        QSet<QString>& keys = keysByTable[table];
+        keys.insert(key);
+
+        // Evicted entries leave their keys behind; drop them now and then
+        if (keys.size() > 2 * entries.count() + 64) {
+            for (auto it = keys.begin(); it != keys.end();) {
+                it = entries.contains(*it) ? std::next(it) : keys.erase(it);
+            }
+        }
+    }
+}
+
+qint64 QueryCache::sizeOf(const QStringList& list)
+{
+    qint64 bytes = sizeof(QStringList);
+    for (const QString& text : list) {
+        bytes += sizeOf(text);
+    }
+    return bytes;
+}
+
+qint64 QueryCache::sizeOf(const Client& client)
+{
+    return sizeof(Client) + 2 * (client.name.size() + client.email.size() + client.city.size()
+                                 + client.postal.size() + client.address.size());
+}
+
+qint64 QueryCache::sizeOf(const Command& command)
+{
+    return sizeof(Command) + 2 * (command.paymentMethod.size() + command.deliveryAddress.size()
+                                  + command.clientName.size() + command.clientEmail.size());
+}
+
+qint64 QueryCache::sizeOf(const QList<Client>& clients)
+{
+    qint64 bytes = sizeof(QList<Client>);
+    for (const Client& client : clients) {
+        bytes += sizeOf(client);
+    }
+    return bytes;
+}
+
+qint64 QueryCache::sizeOf(const QList<Command>& commands)
+{
+    qint64 bytes = sizeof(QList<Command>);
+    for (const Command& command : commands) {
+        bytes += sizeOf(command);
+    }
+    return bytes;
+}
@@ -0,0 +1,114 @@
+// querycache.h
+#ifndef QUERYCACHE_H
+#define QUERYCACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVariantList>
+#include <QList>
+#include <QHash>
+#include <QSet>
+#include <QMap>
+#include <QCache>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <functional>
+#include <any>
+
+#include "clients.h"
+#include "commands.h"
+
+// Result cache for repeated DAO reads.
+//
+// Results are keyed by the SQL text plus the bound values and tagged with
+// the tables the query reads. Entries are kept least recently used first
+// within a byte budget and also expire after maxAgeMs, which bounds how
+// stale a result gets after writes made by another program. DAO writes
+// call invalidate() with the table they changed once their transaction has
+// committed (or rolled back), which drops every entry tagged with it.
+//
+//     return QueryCache::instance().fetch<int>("Get Client Count", sql, {}, {"CLIENTS"},
+//         [&](int& count) { ...run the query...; return ok; });
+//
+// The loader returns false when the query failed; failures are not cached.
+// Reads inside an open UnitOfWork bypass the cache, since they can see
+// rows that are not committed yet. Safe to use from any thread.
+class QueryCache
+{
+public:
+    struct OperationStats {
+        quint64 hits = 0;
+        quint64 misses = 0;
+
+        double hitRatio() const { return hits + misses ? double(hits) / (hits + misses) : 0.0; }
+    };
+
+    static QueryCache& instance();
+
+    template <typename T>
+    T fetch(const QString& operation, const QString& sql, const QVariantList& binds,
+            const QStringList& tables, const std::function<bool(T&)>& load);
+
+    void invalidate(const QStringList& tables);
+    void clear();
+
+    void setBudget(qint64 bytes);
+    void setMaxAge(int ms);
+    qint64 bytesUsed() const;
+
+    // Per-operation hit counts since start, keyed by the DAO operation name
+    QMap<QString, OperationStats> stats() const;
+    QString report() const;
+
+    // Rough heap footprint of a cached result, used for the byte budget
+    static qint64 sizeOf(int) { return sizeof(int); }
+    static qint64 sizeOf(bool) { return sizeof(bool); }
+    static qint64 sizeOf(const Money&) { return sizeof(Money); }
+    static qint64 sizeOf(const QString& text) { return sizeof(QString) + text.size() * 2; }
+    static qint64 sizeOf(const QStringList& list);
+    static qint64 sizeOf(const Client& client);
+    static qint64 sizeOf(const Command& command);
+    static qint64 sizeOf(const QList<Client>& clients);
+    static qint64 sizeOf(const QList<Command>& commands);
+
+private:
+    struct Entry {
+        std::any value;
+        QElapsedTimer age;
+    };
+
+    QueryCache();
+
+    mutable QMutex mutex;
+    QCache<QString, Entry> entries;             // Cost is the entry's size in bytes
+    QHash<QString, QSet<QString>> keysByTable;
+    QHash<QString, quint64> invalidatedAt;      // Table -> clock value of its last write
+    QHash<QString, OperationStats> operations;
+    quint64 clock;
+    int maxAgeMs;
+
+    static QString makeKey(const QString& sql, const QVariantList& binds);
+    bool lookup(const QString& operation, const QString& key, std::any *value, quint64 *stamp);
+    void store(const QString& key, std::any value, qint64 bytes, const QStringList& tables, quint64 stamp);
+};
+
+template <typename T>
+T QueryCache::fetch(const QString& operation, const QString& sql, const QVariantList& binds,
+                    const QStringList& tables, const std::function<bool(T&)>& load)
+{
+    QString key = makeKey(sql, binds);
+    std::any cached;
+    quint64 stamp = 0;
+    if (lookup(operation, key, &cached, &stamp)) {
+        return std::any_cast<T>(cached);
+    }
+
+    T value{};
+    if (load(value)) {
+        store(key, value, sizeOf(value) + key.size() * 2, tables, stamp);
+    }
+    return value;
+}
+
+#endif // QUERYCACHE_H
@@ -0,0 +1,136 @@
+// reportbuilder.cpp
+#include "reportbuilder.h"
+#include <QHash>
+#include <QDateTime>
+
+QString ReportBuilder::clientsCommandsHtml(const QList<Client>& clients, const QList<Command>& commands,
+                                           const CommandStatistics::Statistics& stats)
+{
+    QString htmlContent;
+
+    // HTML header with styling
+    htmlContent = R"(
+    <!DOCTYPE html>
+    <html>
+    <head>
+    <style>
+        body { font-family: Arial, sans-serif; margin: 20px; }
+        h1 { color: #2c3e50; text-align: center; border-bottom: 2px solid #3498db; padding-bottom: 10px; }
+        h2 { color: #34495e; border-bottom: 1px solid #bdc3c7; padding-bottom: 5px; margin-top: 30px; }
+        table { width: 100%; border-collapse: collapse; margin-bottom: 20px; }
+        th { background-color: #3498db; color: white; padding: 10px; text-align: left; }
+        td { padding: 8px; border-bottom: 1px solid #ddd; }
+        tr:nth-child(even) { background-color: #f2f2f2; }
+        .client-header { background-color: #ecf0f1; padding: 10px; margin-top: 20px; border-radius: 5px; }
+        .no-commands { color: #7f8c8d; font-style: italic; }
+        .total-row { font-weight: bold; background-color: #eaf2f8; }
+        .timestamp { text-align: right; color: #7f8c8d; font-size: 12px; }
+    </style>
+    </head>
+    <body>
+    )";
+
+    // Report title and timestamp
+    htmlContent += QString("<h1>Clients and Commands Report</h1>");
+    htmlContent += QString("<p class='timestamp'>Generated on: %1</p>").arg(QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss"));
+
+    // One pass over the orders instead of a query per client; the input
+    // order (newest first) is kept within each client
+    QHash<int, QList<Command>> commandsByClient;
+    for (const Command &command : commands) {
+        commandsByClient[command.clientId].append(command);
+    }
+
+    if (clients.isEmpty()) {
+        htmlContent += "<p>No clients found in the database.</p>";
+    } else {
+        htmlContent += QString("<p>Total clients: %1</p>").arg(clients.size());
+
+        // Process each client
+        for (const Client &client : clients) {
+            htmlContent += QString("<div class='client-header'>");
+            htmlContent += QString("<h2>Client: %1 (ID: %2)</h2>").arg(client.name).arg(client.id);
+            htmlContent += QString("<p><strong>Email:</strong> %1</p>").arg(client.email);
+            htmlContent += QString("<p><strong>Address:</strong> %1, %2 %3</p>").arg(client.address).arg(client.city).arg(client.postal);
+            htmlContent += "</div>";
+
+            const QList<Command> clientCommands = commandsByClient.value(client.id);
+
+            if (clientCommands.isEmpty()) {
+                htmlContent += "<p class='no-commands'>No commands found for this client.</p>";
+            } else {
+                htmlContent += "<table>";
+                htmlContent += "<tr><th>Command ID</th><th>Date</th><th>Total</th><th>Payment Method</th><th>Delivery Address</th></tr>";
+
+                Money clientTotal;
+                for (const Command &command : clientCommands) {
+                    htmlContent += QString("<tr>"
+                                           "<td>%1</td>"
+                                           "<td>%2</td>"
+                                           "<td>$%3</td>"
+                                           "<td>%4</td>"
+                                           "<td>%5</td>"
+                                           "</tr>")
+                                       .arg(command.commandId)
+                                       .arg(command.commandDate().toString("yyyy-MM-dd"))
+                                       .arg(command.total.toString())
+                                       .arg(command.paymentMethod)
+                                       .arg(command.deliveryAddress);
+
+                    clientTotal += command.total;
+                }
+
+                // Add total row
+                htmlContent += QString("<tr class='total-row'>"
+                                       "<td colspan='2'><strong>Total for client:</strong></td>"
+                                       "<td><strong>$%1</strong></td>"
+                                       "<td colspan='2'></td>"
+                                       "</tr>").arg(clientTotal.toString());
+
+                htmlContent += "</table>";
+            }
+        }
+    }
+
+    // Add overall statistics
+    htmlContent += "<h2>Overall Statistics</h2>";
+    htmlContent += "<table>";
+    htmlContent += QString("<tr><td>Total Clients:</td><td>%1</td></tr>").arg(clients.size());
+    htmlContent += QString("<tr><td>Total Commands:</td><td>%1</td></tr>").arg(stats.totalCommands);
+    htmlContent += QString("<tr><td>Total Sales:</td><td>$%1</td></tr>").arg(stats.totalSales.toString());
+    htmlContent += "</table>";
+
+    // Close HTML
+    htmlContent += "</body></html>";
+    return htmlContent;
+}
+
+QString ReportBuilder::orderSummarySubject(const Client& client)
+{
+    return QString("Your Order History - %1").arg(client.name);
+}
+
+QString ReportBuilder::orderSummaryText(const Client& client, const QList<Command>& commands)
+{
+    QString content = QString("Dear %1,\n\n").arg(client.name);
+    content += "Here is your order summary:\n\n";
+
+    content += "ORDER HISTORY:\n";
+    content += "==========================================\n";
+
+    Money total;
+    for (const Command &command : commands) {
+        content += QString("Order #%1 - %2 - $%3\n")
+        .arg(command.commandId)
+            .arg(command.commandDate().toString("MMM d, yyyy"))
+            .arg(command.total.toString());
+        total += command.total;
+    }
+
+    content += "==========================================\n";
+    content += QString("Total: $%1\n\n").arg(total.toString());
+    content += "Thank you for your business!\n\n";
+    content += "Best regards,\nYour Company Team";
+
+    return content;
+}
@@ -0,0 +1,26 @@
+// reportbuilder.h
+#ifndef REPORTBUILDER_H
+#define REPORTBUILDER_H
+
+#include <QString>
+#include <QList>
+#include "clients.h"
+#include "commands.h"
+
+// Report and email text shared by the desktop application (which prints
+// the HTML to PDF and opens the emails in the mail client) and the batch
+// runner (which writes the HTML to a file and sends the emails over SMTP).
+class ReportBuilder
+{
+public:
+    // Every client with their orders, then the overall totals. The orders
+    // are grouped by client here, so callers pass them all in one list.
+    static QString clientsCommandsHtml(const QList<Client>& clients, const QList<Command>& commands,
+                                       const CommandStatistics::Statistics& stats);
+
+    // Plain-text order history sent to one client
+    static QString orderSummarySubject(const Client& client);
+    static QString orderSummaryText(const Client& client, const QList<Command>& commands);
+};
+
+#endif // REPORTBUILDER_H
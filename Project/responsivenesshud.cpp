@@ -0,0 +1,364 @@
+// responsivenesshud.cpp
+#include "responsivenesshud.h"
+#include <QCoreApplication>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QFontDatabase>
+#include <QFontMetrics>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+ResponsivenessHud *ResponsivenessHud::activeHud = nullptr;
+
+namespace {
+
+const int LagIntervalMs = 50;
+const qint64 LagBlameNs = 16 * 1000000;        // Lag worth charging to a slot, one 60 Hz frame
+const qint64 InputTimeoutNs = 2000 * 1000000LL; // An input that painted nothing by then is dropped
+const int MarginPx = 12;
+const int SlotsShown = 6;
+
+double toMs(qint64 ns)
+{
+    return ns / 1e6;
+}
+
+QString displayName(const QString& slot)
+{
+    return slot.startsWith("MainWindow::") ? slot.mid(12) : slot;
+}
+
+QString seriesLine(const QString& label, double p50, double p95, double p99, double max)
+{
+    return QString("%1 %2 %3 %4 %5")
+        .arg(label, -18)
+        .arg(p50, 7, 'f', 1).arg(p95, 7, 'f', 1).arg(p99, 7, 'f', 1).arg(max, 7, 'f', 1);
+}
+
+} // namespace
+
+void ResponsivenessHud::Series::add(double ms)
+{
+    if (samples.size() < Capacity) {
+        samples.append(float(ms));
+    } else {
+        samples[next] = float(ms);
+    }
+    next = (next + 1) % Capacity;
+}
+
+void ResponsivenessHud::Series::clear()
+{
+    samples.clear();
+    next = 0;
+}
+
+double ResponsivenessHud::Series::percentile(double p) const
+{
+    if (samples.isEmpty()) {
+        return 0.0;
+    }
+    // Nearest rank on a copy; at most Capacity floats
+    QVector<float> sorted = samples;
+    int rank = qBound(0, int(std::ceil(p * sorted.size())) - 1, int(sorted.size()) - 1);
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+}
+
+double ResponsivenessHud::Series::max() const
+{
+    return samples.isEmpty() ? 0.0 : *std::max_element(samples.cbegin(), samples.cend());
+}
+
+void ResponsivenessHud::Heaviest::offer(const char *slot, qint64 duration)
+{
+    if (duration > ns) {
+        name = slot;
+        ns = duration;
+    }
+}
+
+ResponsivenessHud::Activity::Activity(const char *name)
+    : name(name), startNs(activeHud ? activeHud->nowNs() : -1)
+{
+}
+
+ResponsivenessHud::Activity::~Activity()
+{
+    if (startNs >= 0 && activeHud) {
+        activeHud->slotFinished(name, activeHud->nowNs() - startNs);
+    }
+}
+
+ResponsivenessHud::ResponsivenessHud(QWidget *host)
+    : QWidget(host)
+{
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setFocusPolicy(Qt::NoFocus);
+    setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    hide();
+
+    clock.start();
+
+    lagTimer.setTimerType(Qt::PreciseTimer);
+    lagTimer.setInterval(LagIntervalMs);
+    connect(&lagTimer, &QTimer::timeout, this, &ResponsivenessHud::onLagTick);
+
+    repaintTimer.setInterval(500);
+    connect(&repaintTimer, &QTimer::timeout, this, &ResponsivenessHud::refreshText);
+}
+
+ResponsivenessHud::~ResponsivenessHud()
+{
+    if (activeHud == this) {
+        activeHud = nullptr;
+        qApp->removeEventFilter(this);
+    }
+}
+
+void ResponsivenessHud::watchPaint(QWidget *widget, const QString& label)
+{
+    watchedLabels.insert(widget, label);
+    connect(widget, &QObject::destroyed, this, [this](QObject *object) {
+        watchedLabels.remove(object);
+    });
+}
+
+void ResponsivenessHud::setActive(bool enabled)
+{
+    if (enabled == active) {
+        return;
+    }
+    active = enabled;
+
+    if (active) {
+        // One HUD at a time collects slot timings
+        if (activeHud && activeHud != this) {
+            activeHud->setActive(false);
+        }
+        activeHud = this;
+        inputStartNs = -1;
+        frameDepth = 0;
+        lastTickNs = nowNs();
+        qApp->installEventFilter(this);
+        lagTimer.start();
+        repaintTimer.start();
+        refreshText();
+        show();
+        raise();
+    } else {
+        qApp->removeEventFilter(this);
+        lagTimer.stop();
+        repaintTimer.stop();
+        if (activeHud == this) {
+            activeHud = nullptr;
+        }
+        hide();
+        qDebug().noquote() << "Responsiveness:\n" + summary();
+    }
+}
+
+void ResponsivenessHud::clear()
+{
+    inputLatency.clear();
+    eventLoopLag.clear();
+    frameTime.clear();
+    paintTimes.clear();
+    slotStats.clear();
+    sinceInput = Heaviest();
+    sinceTick = Heaviest();
+}
+
+QString ResponsivenessHud::summary() const
+{
+    QStringList lines;
+    lines << QString("%1 %2 %3 %4 %5").arg("ms", -18).arg("p50", 7).arg("p95", 7).arg("p99", 7).arg("max", 7);
+
+    auto addSeries = [&lines](const QString& label, const Series& series) {
+        if (series.count() == 0) {
+            lines << QString("%1 %2").arg(label, -18).arg("-", 7);
+            return;
+        }
+        lines << seriesLine(label, series.percentile(0.50), series.percentile(0.95),
+                            series.percentile(0.99), series.max());
+    };
+    addSeries("input → paint", inputLatency);
+    addSeries("event-loop lag", eventLoopLag);
+    addSeries("frame", frameTime);
+    for (auto it = watchedLabels.cbegin(); it != watchedLabels.cend(); ++it) {
+        addSeries(it.value() + " paint", paintTimes.value(it.value()));
+    }
+
+    // Slowest slots first, with the latency and lag charged to them
+    QList<QPair<double, QString>> ranked;
+    for (auto it = slotStats.cbegin(); it != slotStats.cend(); ++it) {
+        ranked.append(qMakePair(it.value().duration.percentile(0.95), it.key()));
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const QPair<double, QString>& a, const QPair<double, QString>& b) {
+        return a.first > b.first;
+    });
+
+    if (!ranked.isEmpty()) {
+        lines << QString();
+        lines << QString("%1 %2 %3 %4 %5").arg("slot", -26).arg("n", 5).arg("p95", 7).arg("lat p95", 8).arg("lag p95", 8);
+    }
+    for (int i = 0; i < ranked.size() && i < SlotsShown; ++i) {
+        const SlotStats& stats = *slotStats.constFind(ranked[i].second);
+        auto p95 = [](const Series& series) {
+            return series.count() == 0 ? QString("-") : QString::number(series.percentile(0.95), 'f', 1);
+        };
+        lines << QString("%1 %2 %3 %4 %5")
+                     .arg(displayName(ranked[i].second).left(26), -26)
+                     .arg(stats.duration.count(), 5)
+                     .arg(ranked[i].first, 7, 'f', 1)
+                     .arg(p95(stats.latency), 8)
+                     .arg(p95(stats.lag), 8);
+    }
+    return lines.join('\n');
+}
+
+bool ResponsivenessHud::eventFilter(QObject *watched, QEvent *event)
+{
+    if (!active || redispatching.contains(event)) {
+        return false;
+    }
+
+    QWidget *host = parentWidget();
+    switch (event->type()) {
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonDblClick:
+    case QEvent::KeyPress:
+        // The window system delivers to the QWindow first; count the widget
+        if (inputStartNs < 0 && watched->isWidgetType()
+            && static_cast<QWidget*>(watched)->window() == host->window()) {
+            inputStartNs = nowNs();
+            sinceInput = Heaviest();
+        }
+        break;
+
+    case QEvent::UpdateRequest:
+        // One frame: the repaint manager paints the dirty widgets and flushes
+        if (watched == host->window()) {
+            framePainted = false;
+            ++frameDepth;
+            qint64 duration = dispatchTimed(watched, event);
+            --frameDepth;
+            frameTime.add(toMs(duration));
+            if (framePainted) {
+                finishInput(nowNs());
+            }
+            return true;
+        }
+        break;
+
+    case QEvent::Paint: {
+        if (watched == this) {
+            break;
+        }
+        if (frameDepth > 0) {
+            framePainted = true;
+        }
+        const QString label = watchedLabels.value(watched);
+        if (label.isEmpty()) {
+            break;
+        }
+        paintTimes[label].add(toMs(dispatchTimed(watched, event)));
+        if (frameDepth == 0) {
+            finishInput(nowNs());
+        }
+        return true;
+    }
+
+    case QEvent::Resize:
+        if (watched == host) {
+            placeInCorner();
+        }
+        break;
+
+    default:
+        break;
+    }
+    return false;
+}
+
+void ResponsivenessHud::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(QColor(20, 24, 31, 215));
+    painter.drawRoundedRect(rect(), 6, 6);
+
+    painter.setPen(QColor(230, 237, 243));
+    painter.drawText(rect().adjusted(8, 6, -8, -6), Qt::AlignLeft | Qt::AlignTop, shownText);
+}
+
+void ResponsivenessHud::onLagTick()
+{
+    qint64 now = nowNs();
+    qint64 lateNs = qMax<qint64>(0, now - lastTickNs - qint64(LagIntervalMs) * 1000000);
+    lastTickNs = now;
+
+    eventLoopLag.add(toMs(lateNs));
+    if (lateNs > LagBlameNs) {
+        statsFor(sinceTick.name).lag.add(toMs(lateNs));
+    }
+    sinceTick = Heaviest();
+
+    if (inputStartNs >= 0 && now - inputStartNs > InputTimeoutNs) {
+        inputStartNs = -1;
+    }
+}
+
+void ResponsivenessHud::refreshText()
+{
+    shownText = summary();
+    QRect textRect = QFontMetrics(font()).boundingRect(QRect(0, 0, 2000, 2000),
+                                                      Qt::AlignLeft | Qt::AlignTop, shownText);
+    resize(textRect.size() + QSize(16, 12));
+    placeInCorner();
+    update();
+}
+
+qint64 ResponsivenessHud::dispatchTimed(QObject *watched, QEvent *event)
+{
+    // Deliver the event ourselves so its handling can be timed; the guard
+    // lets it pass this filter the second time
+    qint64 startNs = nowNs();
+    redispatching.append(event);
+    QCoreApplication::sendEvent(watched, event);
+    redispatching.removeLast();
+    return nowNs() - startNs;
+}
+
+void ResponsivenessHud::finishInput(qint64 endNs)
+{
+    if (inputStartNs < 0) {
+        return;
+    }
+    double latency = toMs(endNs - inputStartNs);
+    inputStartNs = -1;
+    inputLatency.add(latency);
+    statsFor(sinceInput.name).latency.add(latency);
+}
+
+void ResponsivenessHud::slotFinished(const char *name, qint64 durationNs)
+{
+    statsFor(name).duration.add(toMs(durationNs));
+    sinceInput.offer(name, durationNs);
+    sinceTick.offer(name, durationNs);
+}
+
+ResponsivenessHud::SlotStats& ResponsivenessHud::statsFor(const char *name)
+{
+    return slotStats[name ? QString::fromLatin1(name) : QString("(no slot)")];
+}
+
+void ResponsivenessHud::placeInCorner()
+{
+    QWidget *host = parentWidget();
+    move(host->width() - width() - MarginPx, MarginPx);
+    raise();
+}
@@ -0,0 +1,138 @@
+// responsivenesshud.h
+#ifndef RESPONSIVENESSHUD_H
+#define RESPONSIVENESSHUD_H
+
+#include <QWidget>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QHash>
+#include <QVector>
+#include <QPointer>
+
+#include "trace.h"
+
+// Overlay in the corner of a window that shows how responsive it is:
+//
+//   input → paint   press or key to the end of the next frame
+//   event-loop lag  how late a 50 ms precise timer fires
+//   frame           one backing-store flush (UpdateRequest)
+//   <table> paint   one paint of a watched viewport
+//
+// Each line shows p50/p95/p99/max over the last 512 samples. Below them are
+// the slowest slots by p95 duration; a latency sample counts against the
+// slowest slot that ran between the input and the paint, a lag sample over
+// 16 ms against the slowest slot that ran in that tick.
+//
+// Slots report themselves with UI_SCOPE("MainWindow::onSearchClients"),
+// which is also their trace span. Paints and frames are timed by
+// re-sending the event from an application event filter, installed only
+// while the HUD is on; when off, UI_SCOPE costs one pointer test.
+// GUI thread only.
+class ResponsivenessHud : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ResponsivenessHud(QWidget *host);
+    ~ResponsivenessHud();
+
+    // Time every paint of this widget, shown as "<label> paint"
+    void watchPaint(QWidget *widget, const QString& label);
+
+    void setActive(bool enabled);
+    bool isActive() const { return active; }
+    void clear();
+
+    // The HUD lines as plain text
+    QString summary() const;
+
+    class Activity
+    {
+    public:
+        explicit Activity(const char *name);
+        ~Activity();
+
+    private:
+        Q_DISABLE_COPY(Activity)
+        const char *name;
+        qint64 startNs;
+    };
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+
+private slots:
+    void onLagTick();
+    void refreshText();
+
+private:
+    // Last Capacity samples in milliseconds
+    class Series
+    {
+    public:
+        static const int Capacity = 512;
+        void add(double ms);
+        void clear();
+        int count() const { return samples.size(); }
+        double percentile(double p) const;
+        double max() const;
+
+    private:
+        QVector<float> samples;
+        int next = 0;
+    };
+
+    struct SlotStats {
+        Series duration;
+        Series latency;
+        Series lag;
+    };
+
+    struct Heaviest {
+        const char *name = nullptr;
+        qint64 ns = 0;
+        void offer(const char *slot, qint64 duration);
+    };
+
+    qint64 nowNs() const { return clock.nsecsElapsed(); }
+    qint64 dispatchTimed(QObject *watched, QEvent *event);
+    void finishInput(qint64 endNs);
+    void slotFinished(const char *name, qint64 durationNs);
+    SlotStats& statsFor(const char *name);
+    void placeInCorner();
+
+    static ResponsivenessHud *activeHud;
+
+    bool active = false;
+    QElapsedTimer clock;
+    QTimer lagTimer;
+    QTimer repaintTimer;
+    qint64 lastTickNs = 0;
+
+    qint64 inputStartNs = -1;  // Pending press or key, -1 when none
+    int frameDepth = 0;
+    bool framePainted = false; // The frame repainted more than the HUD
+    QVector<QEvent*> redispatching;
+
+    Series inputLatency;
+    Series eventLoopLag;
+    Series frameTime;
+    QHash<QObject*, QString> watchedLabels;
+    QHash<QString, Series> paintTimes;
+    QHash<QString, SlotStats> slotStats;
+    QString shownText;
+    Heaviest sinceInput;
+    Heaviest sinceTick;
+};
+
+#define HUD_CONCAT_(a, b) a##b
+#define HUD_CONCAT(a, b) HUD_CONCAT_(a, b)
+
+// A UI slot: its trace span, and the slot the HUD charges latency to.
+// Slots that open a modal dialog keep TRACE_SCOPE, as their time is the user's
+#define UI_SCOPE(name) \
+    TRACE_SCOPE("ui", name); \
+    ResponsivenessHud::Activity HUD_CONCAT(hudActivity_, __LINE__)(name)
+
+#endif // RESPONSIVENESSHUD_H
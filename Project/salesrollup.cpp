@@ -0,0 +1,421 @@
+// salesrollup.cpp
+#include "salesrollup.h"
+#include "trace.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QElapsedTimer>
+#include <QDebug>
+
+const QString SalesRollup::MissingKey = "-";
+
+SalesRollup::SalesRollup(const QSqlDatabase& database)
+    : db(database), dialect(Connection::dialectOf(database))
+{
+}
+
+bool SalesRollup::addCommand(const Command& command, QString& error)
+{
+    return applyDelta(command, 1, error);
+}
+
+bool SalesRollup::removeCommand(const Command& command, QString& error)
+{
+    return applyDelta(command, -1, error);
+}
+
+bool SalesRollup::lockState(QString& error)
+{
+    // SQLite already lets one write transaction run at a time
+    if (dialect != Connection::OracleDialect) {
+        return true;
+    }
+
+    QSqlQuery query(db);
+    if (!TRACE_EXEC_SQL(query, "SELECT COVERED_UNTIL FROM SALES_ROLLUP_STATE WHERE ID = 1 FOR UPDATE")) {
+        error = "Could not lock rollup state: " + query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool SalesRollup::applyDelta(const Command& command, int sign, QString& error)
+{
+    if (!command.hasCommandDate()) {
+        return true;
+    }
+
+    // The city is stored on the order when it is added, so removing it
+    // later takes it out of the same bucket even if the client moved
+    QString city;
+    if (sign > 0) {
+        city = keyOf(clientCity(command.clientId));
+        if (!storeCity(command.commandId, city, error)) {
+            return false;
+        }
+    } else {
+        city = rolledUpCity(command);
+    }
+
+    // The source row only exists while the day is covered, so rows after
+    // the boundary are left to the next backfill
+    QDate day = command.commandDate().date();
+    QDate covered = coveredUntil();
+    if (!covered.isValid() || day >= covered) {
+        return true;
+    }
+
+    QString payment = keyOf(command.paymentMethod);
+    const struct { const char* table; const char* column; QDate period; } targets[] = {
+        {"SALES_DAILY", "BUCKET_DAY", day},
+        {"SALES_MONTHLY", "BUCKET_MONTH", monthStart(day)}
+    };
+
+    for (const auto& target : targets) {
+        QSqlQuery query(db);
+        if (dialect == Connection::OracleDialect) {
+            query.prepare(QString(
+                "MERGE INTO %1 r "
+                "USING (SELECT CAST(? AS DATE) AS PERIOD, CAST(? AS VARCHAR2(50)) AS PAYMENT_METHOD, "
+                "CAST(? AS VARCHAR2(100)) AS CITY FROM DUAL) s "
+                "ON (r.%2 = s.PERIOD AND r.PAYMENT_METHOD = s.PAYMENT_METHOD AND r.CITY = s.CITY) "
+                "WHEN MATCHED THEN UPDATE SET r.ORDER_COUNT = r.ORDER_COUNT + ?, r.TOTAL = r.TOTAL + ? / 100.0 "
+                "WHEN NOT MATCHED THEN INSERT (%2, PAYMENT_METHOD, CITY, ORDER_COUNT, TOTAL) "
+                "VALUES (s.PERIOD, s.PAYMENT_METHOD, s.CITY, ?, ? / 100.0)").arg(target.table, target.column));
+            query.addBindValue(target.period);
+            query.addBindValue(payment);
+            query.addBindValue(city);
+            query.addBindValue(sign);
+            query.addBindValue((command.total * sign).toCents());
+            query.addBindValue(sign);
+            query.addBindValue((command.total * sign).toCents());
+        } else {
+            query.prepare(QString(
+                "INSERT INTO %1 (%2, PAYMENT_METHOD, CITY, ORDER_COUNT, TOTAL) VALUES (?, ?, ?, ?, ? / 100.0) "
+                "ON CONFLICT (%2, PAYMENT_METHOD, CITY) DO UPDATE SET "
+                "ORDER_COUNT = ORDER_COUNT + excluded.ORDER_COUNT, TOTAL = TOTAL + excluded.TOTAL")
+                              .arg(target.table, target.column));
+            query.addBindValue(target.period);
+            query.addBindValue(payment);
+            query.addBindValue(city);
+            query.addBindValue(sign);
+            query.addBindValue((command.total * sign).toCents());
+        }
+
+        if (!TRACE_EXEC(query)) {
+            error = QString("Sales rollup update failed: %1").arg(query.lastError().text());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool SalesRollup::storeCity(int commandId, const QString& city, QString& error)
+{
+    QSqlQuery query(db);
+    query.prepare("UPDATE COMMANDS SET ROLLUP_CITY = ? WHERE COMMAND_ID = ?");
+    query.addBindValue(city);
+    query.addBindValue(commandId);
+    if (!TRACE_EXEC(query)) {
+        error = "Could not store rollup city: " + query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+QString SalesRollup::rolledUpCity(const Command& command)
+{
+    QSqlQuery query(db);
+    query.prepare("SELECT ROLLUP_CITY FROM COMMANDS WHERE COMMAND_ID = ?");
+    query.addBindValue(command.commandId);
+    if (TRACE_EXEC(query) && query.next() && !query.value(0).isNull()) {
+        return query.value(0).toString();
+    }
+    // Only rows the backfill has not reached yet have no city
+    return keyOf(clientCity(command.clientId));
+}
+
+bool SalesRollup::backfillUntil(const QDate& end, QString& error)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QDate cursor = coveredUntil();
+    if (!cursor.isValid()) {
+        // Nothing rolled up yet: start at the first order
+        QSqlQuery first(db);
+        if (!TRACE_EXEC_SQL(first, "SELECT MIN(COMMAND_DATE) FROM COMMANDS")) {
+            error = "Could not read first order date: " + first.lastError().text();
+            return false;
+        }
+        cursor = first.next() && !first.value(0).isNull() ? first.value(0).toDate() : end;
+    }
+
+    int months = 0;
+    while (cursor < end) {
+        QDate chunkEnd = qMin(monthStart(cursor).addMonths(1), end);
+
+        // One month per transaction; the boundary moves with the data. The
+        // state row lock keeps DAO writes out until the boundary has moved,
+        // so each order is counted by either the chunk or its own delta
+        db.transaction();
+        if (!lockState(error) || !rollupRange(cursor, chunkEnd, error) || !setCoveredUntil(chunkEnd, error)) {
+            db.rollback();
+            return false;
+        }
+        if (!db.commit()) {
+            error = "Commit failed: " + db.lastError().text();
+            return false;
+        }
+
+        cursor = chunkEnd;
+        months++;
+    }
+
+    // An empty table still records that everything before 'end' is covered
+    if (months == 0 && !coveredUntil().isValid() && !setCoveredUntil(end, error)) {
+        return false;
+    }
+
+    qDebug() << "Sales rollups backfilled" << months << "month(s) up to" << end.toString(Qt::ISODate)
+             << "in" << timer.elapsed() << "ms";
+    return true;
+}
+
+bool SalesRollup::rebuild(const QDate& from, const QDate& to, QString& error)
+{
+    db.transaction();
+    if (!lockState(error) || !rollupRange(from, to, error)) {
+        db.rollback();
+        return false;
+    }
+    if (!db.commit()) {
+        error = "Commit failed: " + db.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool SalesRollup::rollupRange(const QDate& from, const QDate& to, QString& error)
+{
+    QString day = dayExpression("c.COMMAND_DATE");
+    QString payment = "COALESCE(NULLIF(TRIM(c.PAYMENT_METHOD), ''), '-')";
+
+    QDate firstMonth = monthStart(from);
+    QDate endMonth = monthStart(to.addDays(-1)).addMonths(1);
+
+    struct Statement {
+        QString sql;
+        QList<QVariant> values;
+    };
+    QList<Statement> statements = {
+        // Orders written outside the DAO get their city the first time they are rolled up
+        {"UPDATE COMMANDS SET ROLLUP_CITY = COALESCE(NULLIF(TRIM("
+         "(SELECT cl.CITY FROM CLIENTS cl WHERE cl.ID = COMMANDS.CLIENT_ID)), ''), '-') "
+         "WHERE ROLLUP_CITY IS NULL AND COMMAND_DATE >= ? AND COMMAND_DATE < ?",
+         {from.startOfDay(), to.startOfDay()}},
+        {"DELETE FROM SALES_DAILY WHERE BUCKET_DAY >= ? AND BUCKET_DAY < ?", {from, to}},
+        {QString("INSERT INTO SALES_DAILY (BUCKET_DAY, PAYMENT_METHOD, CITY, ORDER_COUNT, TOTAL) "
+                 "SELECT %1, %2, c.ROLLUP_CITY, COUNT(*), SUM(c.TOTAL) "
+                 "FROM COMMANDS c "
+                 "WHERE c.COMMAND_DATE >= ? AND c.COMMAND_DATE < ? "
+                 "GROUP BY %1, %2, c.ROLLUP_CITY").arg(day, payment),
+         {from.startOfDay(), to.startOfDay()}},
+        // Months are summed from the days so a partly covered month stays consistent
+        {"DELETE FROM SALES_MONTHLY WHERE BUCKET_MONTH >= ? AND BUCKET_MONTH < ?", {firstMonth, endMonth}},
+        {QString("INSERT INTO SALES_MONTHLY (BUCKET_MONTH, PAYMENT_METHOD, CITY, ORDER_COUNT, TOTAL) "
+                 "SELECT %1, PAYMENT_METHOD, CITY, SUM(ORDER_COUNT), SUM(TOTAL) "
+                 "FROM SALES_DAILY WHERE BUCKET_DAY >= ? AND BUCKET_DAY < ? "
+                 "GROUP BY %1, PAYMENT_METHOD, CITY").arg(monthExpression("BUCKET_DAY")),
+         {firstMonth, endMonth}}
+    };
+
+    for (const Statement& statement : statements) {
+        QSqlQuery query(db);
+        query.prepare(statement.sql);
+        for (const QVariant& value : statement.values) {
+            query.addBindValue(value);
+        }
+        if (!TRACE_EXEC(query)) {
+            error = QString("%1\n   %2").arg(statement.sql, query.lastError().text());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool SalesRollup::setCoveredUntil(const QDate& day, QString& error)
+{
+    QSqlQuery update(db);
+    update.prepare("UPDATE SALES_ROLLUP_STATE SET COVERED_UNTIL = ? WHERE ID = 1");
+    update.addBindValue(day);
+    if (!TRACE_EXEC(update)) {
+        error = "Could not update rollup state: " + update.lastError().text();
+        return false;
+    }
+    if (update.numRowsAffected() > 0) {
+        return true;
+    }
+
+    QSqlQuery insert(db);
+    insert.prepare("INSERT INTO SALES_ROLLUP_STATE (ID, COVERED_UNTIL) VALUES (1, ?)");
+    insert.addBindValue(day);
+    if (!TRACE_EXEC(insert)) {
+        error = "Could not create rollup state: " + insert.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+QDate SalesRollup::coveredUntil()
+{
+    QSqlQuery query(db);
+    if (TRACE_EXEC_SQL(query, "SELECT COVERED_UNTIL FROM SALES_ROLLUP_STATE WHERE ID = 1") && query.next()) {
+        return query.value(0).toDate();
+    }
+    return QDate();
+}
+
+QList<SalesRollup::Bucket> SalesRollup::sales(Grain grain, const QDate& from, const QDate& to, Breakdown breakdown)
+{
+    QMap<QPair<QDate, QString>, Bucket> buckets;
+
+    QDate start = grain == Monthly ? monthStart(from) : from;
+    QDate end = grain == Monthly ? monthStart(to).addMonths(1) : to.addDays(1);
+    if (!start.isValid() || !end.isValid() || end <= start) {
+        return buckets.values();
+    }
+
+    // [start, rolledEnd) comes from the rollups, [rolledEnd, end) from COMMANDS
+    QDate covered = coveredUntil();
+    QDate rolledEnd = covered.isValid() ? qBound(start, covered, end) : start;
+
+    if (grain == Monthly) {
+        // Whole months from SALES_MONTHLY, the covered days of a partly covered month from SALES_DAILY
+        QDate fullMonthsEnd = qBound(start, monthStart(rolledEnd), rolledEnd);
+        readRollup("SALES_MONTHLY", "BUCKET_MONTH", start, fullMonthsEnd, grain, breakdown, buckets);
+        readRollup("SALES_DAILY", "BUCKET_DAY", fullMonthsEnd, rolledEnd, grain, breakdown, buckets);
+    } else {
+        readRollup("SALES_DAILY", "BUCKET_DAY", start, rolledEnd, grain, breakdown, buckets);
+    }
+    readRaw(rolledEnd, end, grain, breakdown, buckets);
+
+    return buckets.values();
+}
+
+QMap<QDate, Money> SalesRollup::totals(Grain grain, const QDate& from, const QDate& to)
+{
+    QMap<QDate, Money> result;
+    for (const Bucket& bucket : sales(grain, from, to, Total)) {
+        result.insert(bucket.period, bucket.total);
+    }
+    return result;
+}
+
+void SalesRollup::readRollup(const QString& table, const QString& column, const QDate& from, const QDate& to,
+                             Grain grain, Breakdown breakdown, QMap<QPair<QDate, QString>, Bucket>& buckets)
+{
+    if (from >= to) {
+        return;
+    }
+
+    QString key = breakdown == ByPaymentMethod ? "PAYMENT_METHOD"
+                : breakdown == ByCity ? "CITY" : QString();
+    QString groupBy = key.isEmpty() ? column : column + ", " + key;
+
+    QSqlQuery query(db);
+    query.setNumericalPrecisionPolicy(QSql::HighPrecision);
+    query.setForwardOnly(true);
+    query.prepare(QString("SELECT %1, %2, SUM(ORDER_COUNT), SUM(TOTAL) FROM %3 "
+                          "WHERE %4 >= ? AND %4 < ? GROUP BY %5")
+                      .arg(column, key.isEmpty() ? "NULL" : key, table, column, groupBy));
+    query.addBindValue(from);
+    query.addBindValue(to);
+
+    if (!TRACE_EXEC(query)) {
+        qDebug() << "Sales rollup read failed:" << query.lastError().text();
+        return;
+    }
+
+    while (query.next()) {
+        QDate period = query.value(0).toDate();
+        if (grain == Monthly) {
+            period = monthStart(period);
+        }
+        Bucket& bucket = buckets[qMakePair(period, query.value(1).toString())];
+        bucket.period = period;
+        bucket.key = query.value(1).toString();
+        bucket.orders += query.value(2).toInt();
+        bucket.total = bucket.total + Money::fromVariant(query.value(3));
+    }
+}
+
+void SalesRollup::readRaw(const QDate& from, const QDate& to, Grain grain, Breakdown breakdown,
+                          QMap<QPair<QDate, QString>, Bucket>& buckets)
+{
+    if (from >= to) {
+        return;
+    }
+
+    QString day = dayExpression("c.COMMAND_DATE");
+    QString key = breakdown == ByPaymentMethod ? "COALESCE(NULLIF(TRIM(c.PAYMENT_METHOD), ''), '-')"
+                : breakdown == ByCity ? "COALESCE(c.ROLLUP_CITY, NULLIF(TRIM(cl.CITY), ''), '-')" : QString();
+    QString join = breakdown == ByCity ? "LEFT JOIN CLIENTS cl ON cl.ID = c.CLIENT_ID " : QString();
+    QString groupBy = key.isEmpty() ? day : day + ", " + key;
+
+    QSqlQuery query(db);
+    query.setNumericalPrecisionPolicy(QSql::HighPrecision);
+    query.setForwardOnly(true);
+    query.prepare(QString("SELECT %1, %2, COUNT(*), SUM(c.TOTAL) FROM COMMANDS c %3"
+                          "WHERE c.COMMAND_DATE >= ? AND c.COMMAND_DATE < ? GROUP BY %4")
+                      .arg(day, key.isEmpty() ? "NULL" : key, join, groupBy));
+    query.addBindValue(from.startOfDay());
+    query.addBindValue(to.startOfDay());
+
+    if (!TRACE_EXEC(query)) {
+        qDebug() << "Sales tail read failed:" << query.lastError().text();
+        return;
+    }
+
+    while (query.next()) {
+        QDate period = query.value(0).toDate();
+        if (grain == Monthly) {
+            period = monthStart(period);
+        }
+        Bucket& bucket = buckets[qMakePair(period, query.value(1).toString())];
+        bucket.period = period;
+        bucket.key = query.value(1).toString();
+        bucket.orders += query.value(2).toInt();
+        bucket.total = bucket.total + Money::fromVariant(query.value(3));
+    }
+}
+
+QString SalesRollup::clientCity(int clientId)
+{
+    QSqlQuery query(db);
+    query.prepare("SELECT CITY FROM CLIENTS WHERE ID = ?");
+    query.addBindValue(clientId);
+    if (TRACE_EXEC(query) && query.next()) {
+        return query.value(0).toString();
+    }
+    return QString();
+}
+
+QString SalesRollup::dayExpression(const QString& column) const
+{
+    return dialect == Connection::OracleDialect ? QString("TRUNC(%1)").arg(column)
+                                                : QString("DATE(%1)").arg(column);
+}
+
+QString SalesRollup::monthExpression(const QString& column) const
+{
+    return dialect == Connection::OracleDialect ? QString("TRUNC(%1, 'MM')").arg(column)
+                                                : QString("DATE(%1, 'start of month')").arg(column);
+}
+
+QString SalesRollup::keyOf(const QString& value)
+{
+    QString trimmed = value.trimmed();
+    return trimmed.isEmpty() ? MissingKey : trimmed;
+}
@@ -0,0 +1,89 @@
+// salesrollup.h
+#ifndef SALESROLLUP_H
+#define SALESROLLUP_H
+
+#include <QString>
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QDate>
+#include <QSqlDatabase>
+
+#include "connection.h"
+#include "commands.h"
+
+// Pre-aggregated sales per day (SALES_DAILY) and per month (SALES_MONTHLY),
+// broken down by payment method and client city.
+//
+// SALES_ROLLUP_STATE.COVERED_UNTIL is the first day the rollups do not
+// cover yet. The backfill job recomputes whole days from COMMANDS and moves
+// that boundary forward, one month per transaction so an interrupted run
+// keeps what it finished. CommandDAO writes apply a +1/-1 delta in their
+// own transaction, but only to covered days; newer rows stay in COMMANDS
+// until the next backfill. Range queries therefore read the rollups up to
+// the boundary and group the raw rows after it, normally just today's.
+//
+// On Oracle both paths lock the SALES_ROLLUP_STATE row first, so a DAO
+// write never lands inside a chunk the backfill is rolling up: it either
+// commits before the chunk reads COMMANDS, or waits and sees the new
+// boundary.
+//
+// Missing payment methods and cities are stored as "-". The city is the
+// client's city when the order was added, kept in COMMANDS.ROLLUP_CITY so
+// that removing the order later hits the same bucket.
+class SalesRollup
+{
+public:
+    enum Grain { Daily, Monthly };
+    enum Breakdown { Total, ByPaymentMethod, ByCity };
+
+    struct Bucket {
+        QDate period;       // Day, or first day of the month
+        QString key;        // Payment method or city, empty for Total
+        int orders = 0;
+        Money total;
+    };
+
+    explicit SalesRollup(const QSqlDatabase& database);
+
+    // Write path, called inside the caller's transaction. lockState() goes
+    // first, before the transaction touches COMMANDS
+    bool lockState(QString& error);
+    bool addCommand(const Command& command, QString& error);
+    bool removeCommand(const Command& command, QString& error);
+
+    // Batch job: roll up every day before 'end' that is not covered yet
+    bool backfillUntil(const QDate& end, QString& error);
+    // Recompute [from, to) again, e.g. after rows were changed outside the DAO
+    bool rebuild(const QDate& from, const QDate& to, QString& error);
+    QDate coveredUntil();
+
+    // Days or whole months from 'from' to 'to' inclusive, ordered by period then key
+    QList<Bucket> sales(Grain grain, const QDate& from, const QDate& to, Breakdown breakdown = Total);
+    QMap<QDate, Money> totals(Grain grain, const QDate& from, const QDate& to);
+
+    static const QString MissingKey;
+
+private:
+    QSqlDatabase db;
+    Connection::Dialect dialect;
+
+    bool applyDelta(const Command& command, int sign, QString& error);
+    bool storeCity(int commandId, const QString& city, QString& error);
+    QString rolledUpCity(const Command& command);
+    bool rollupRange(const QDate& from, const QDate& to, QString& error);
+    bool setCoveredUntil(const QDate& day, QString& error);
+    QString clientCity(int clientId);
+
+    void readRollup(const QString& table, const QString& column, const QDate& from, const QDate& to,
+                    Grain grain, Breakdown breakdown, QMap<QPair<QDate, QString>, Bucket>& buckets);
+    void readRaw(const QDate& from, const QDate& to, Grain grain, Breakdown breakdown,
+                 QMap<QPair<QDate, QString>, Bucket>& buckets);
+
+    QString dayExpression(const QString& column) const;
+    QString monthExpression(const QString& column) const;
+    static QString keyOf(const QString& value);
+    static QDate monthStart(const QDate& date) { return QDate(date.year(), date.month(), 1); }
+};
+
+#endif // SALESROLLUP_H
@@ -0,0 +1,461 @@
+// schemamigrator.cpp
+#include "schemamigrator.h"
+#include <QSqlQuery>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QDebug>
+
+SchemaMigrator::SchemaMigrator(const QSqlDatabase& database)
+    : db(database), dialect(Connection::dialectOf(database))
+{
+}
+
+QList<SchemaMigrator::Step> SchemaMigrator::steps() const
+{
+    QList<Step> list;
+
+    list.append({1, "Create CLIENTS and COMMANDS tables",
+                 {
+                     "CREATE TABLE CLIENTS ("
+                     "ID NUMBER PRIMARY KEY, "
+                     "NAME VARCHAR2(100) NOT NULL, "
+                     "EMAIL VARCHAR2(150) NOT NULL, "
+                     "CITY VARCHAR2(100), "
+                     "POSTAL VARCHAR2(20), "
+                     "ADDRESS VARCHAR2(255))",
+                     "CREATE TABLE COMMANDS ("
+                     "COMMAND_ID NUMBER PRIMARY KEY, "
+                     "CLIENT_ID NUMBER NOT NULL REFERENCES CLIENTS(ID), "
+                     "COMMAND_DATE DATE NOT NULL, "
+                     "TOTAL NUMBER(12,2) NOT NULL, "
+                     "PAYMENT_METHOD VARCHAR2(50), "
+                     "DELIVERY_ADDRESS VARCHAR2(255))",
+                     "CREATE SEQUENCE CLIENTS_SEQ START WITH 1 INCREMENT BY 1",
+                     "CREATE SEQUENCE COMMANDS_SEQ START WITH 1 INCREMENT BY 1"
+                 },
+                 {
+                     "CREATE TABLE IF NOT EXISTS CLIENTS ("
+                     "ID INTEGER PRIMARY KEY, "
+                     "NAME TEXT NOT NULL, "
+                     "EMAIL TEXT NOT NULL, "
+                     "CITY TEXT, "
+                     "POSTAL TEXT, "
+                     "ADDRESS TEXT)",
+                     "CREATE TABLE IF NOT EXISTS COMMANDS ("
+                     "COMMAND_ID INTEGER PRIMARY KEY, "
+                     "CLIENT_ID INTEGER NOT NULL REFERENCES CLIENTS(ID), "
+                     "COMMAND_DATE TIMESTAMP NOT NULL, "
+                     "TOTAL NUMERIC(12,2) NOT NULL, "
+                     "PAYMENT_METHOD TEXT, "
+                     "DELIVERY_ADDRESS TEXT)"
+                 },
+                 nullptr});
+
+    // Older databases stored totals as text; SQLite tables are created numeric
+    list.append({2, "Store COMMANDS.TOTAL as NUMBER(12,2)",
+                 {}, {},
+                 dialect == Connection::OracleDialect ? &SchemaMigrator::convertTotalToNumber : nullptr});
+
+    // Backs the client filter plus date range of the order queries, the
+    // case-insensitive client lookups and the total range filter
+    list.append({3, "Indexes for client lookups and order ranges",
+                 {
+                     "CREATE INDEX COMMANDS_CLIENT_DATE_IDX ON COMMANDS (CLIENT_ID, COMMAND_DATE)",
+                     "CREATE INDEX COMMANDS_DATE_IDX ON COMMANDS (COMMAND_DATE)",
+                     "CREATE INDEX COMMANDS_TOTAL_IDX ON COMMANDS (TOTAL)",
+                     "CREATE INDEX CLIENTS_UPPER_EMAIL_IDX ON CLIENTS (UPPER(EMAIL))",
+                     "CREATE INDEX CLIENTS_UPPER_NAME_IDX ON CLIENTS (UPPER(NAME))"
+                 },
+                 {
+                     "CREATE INDEX IF NOT EXISTS COMMANDS_CLIENT_DATE_IDX ON COMMANDS (CLIENT_ID, COMMAND_DATE)",
+                     "CREATE INDEX IF NOT EXISTS COMMANDS_DATE_IDX ON COMMANDS (COMMAND_DATE)",
+                     "CREATE INDEX IF NOT EXISTS COMMANDS_TOTAL_IDX ON COMMANDS (TOTAL)",
+                     "CREATE INDEX IF NOT EXISTS CLIENTS_UPPER_EMAIL_IDX ON CLIENTS (UPPER(EMAIL))",
+                     "CREATE INDEX IF NOT EXISTS CLIENTS_UPPER_NAME_IDX ON CLIENTS (UPPER(NAME))"
+                 },
+                 nullptr});
+
+    // Day and month sales rollups, see SalesRollup; filled by its backfill job
+    list.append({4, "Sales rollup tables",
+                 {
+                     "CREATE TABLE SALES_DAILY ("
+                     "BUCKET_DAY DATE NOT NULL, "
+                     "PAYMENT_METHOD VARCHAR2(50) NOT NULL, "
+                     "CITY VARCHAR2(100) NOT NULL, "
+                     "ORDER_COUNT NUMBER(12) NOT NULL, "
+                     "TOTAL NUMBER(16,2) NOT NULL, "
+                     "CONSTRAINT SALES_DAILY_PK PRIMARY KEY (BUCKET_DAY, PAYMENT_METHOD, CITY))",
+                     "CREATE TABLE SALES_MONTHLY ("
+                     "BUCKET_MONTH DATE NOT NULL, "
+                     "PAYMENT_METHOD VARCHAR2(50) NOT NULL, "
+                     "CITY VARCHAR2(100) NOT NULL, "
+                     "ORDER_COUNT NUMBER(12) NOT NULL, "
+                     "TOTAL NUMBER(16,2) NOT NULL, "
+                     "CONSTRAINT SALES_MONTHLY_PK PRIMARY KEY (BUCKET_MONTH, PAYMENT_METHOD, CITY))",
+                     "CREATE TABLE SALES_ROLLUP_STATE ("
+                     "ID NUMBER(1) PRIMARY KEY, "
+                     "COVERED_UNTIL DATE)"
+                 },
+                 {
+                     "CREATE TABLE IF NOT EXISTS SALES_DAILY ("
+                     "BUCKET_DAY TEXT NOT NULL, "
+                     "PAYMENT_METHOD TEXT NOT NULL, "
+                     "CITY TEXT NOT NULL, "
+                     "ORDER_COUNT INTEGER NOT NULL, "
+                     "TOTAL NUMERIC(16,2) NOT NULL, "
+                     "PRIMARY KEY (BUCKET_DAY, PAYMENT_METHOD, CITY))",
+                     "CREATE TABLE IF NOT EXISTS SALES_MONTHLY ("
+                     "BUCKET_MONTH TEXT NOT NULL, "
+                     "PAYMENT_METHOD TEXT NOT NULL, "
+                     "CITY TEXT NOT NULL, "
+                     "ORDER_COUNT INTEGER NOT NULL, "
+                     "TOTAL NUMERIC(16,2) NOT NULL, "
+                     "PRIMARY KEY (BUCKET_MONTH, PAYMENT_METHOD, CITY))",
+                     "CREATE TABLE IF NOT EXISTS SALES_ROLLUP_STATE ("
+                     "ID INTEGER PRIMARY KEY, "
+                     "COVERED_UNTIL TEXT)"
+                 },
+                 nullptr});
+
+    // Change versions and delete tombstones read by LocalReplica. Every
+    // insert or update takes the next ROW_VERSION_SEQ value; the closing
+    // UPDATEs give rows that existed before this step a version of their own
+    list.append({5, "Row versions for replica sync",
+                 {
+                     "ALTER TABLE CLIENTS ADD (ROW_VERSION NUMBER(19) DEFAULT 0 NOT NULL)",
+                     "ALTER TABLE COMMANDS ADD (ROW_VERSION NUMBER(19) DEFAULT 0 NOT NULL)",
+                     "CREATE SEQUENCE ROW_VERSION_SEQ",
+                     "CREATE INDEX CLIENTS_ROW_VERSION_IDX ON CLIENTS (ROW_VERSION)",
+                     "CREATE INDEX COMMANDS_ROW_VERSION_IDX ON COMMANDS (ROW_VERSION)",
+                     "CREATE TABLE DELETED_ROWS ("
+                     "TABLE_NAME VARCHAR2(30) NOT NULL, "
+                     "ROW_ID NUMBER NOT NULL, "
+                     "ROW_VERSION NUMBER(19) NOT NULL, "
+                     "CONSTRAINT DELETED_ROWS_PK PRIMARY KEY (TABLE_NAME, ROW_ID))",
+                     "CREATE INDEX DELETED_ROWS_VERSION_IDX ON DELETED_ROWS (ROW_VERSION)",
+                     "CREATE OR REPLACE TRIGGER CLIENTS_ROW_VERSION "
+                     "BEFORE INSERT OR UPDATE ON CLIENTS FOR EACH ROW "
+                     "BEGIN :NEW.ROW_VERSION := ROW_VERSION_SEQ.NEXTVAL; END;",
+                     "CREATE OR REPLACE TRIGGER COMMANDS_ROW_VERSION "
+                     "BEFORE INSERT OR UPDATE ON COMMANDS FOR EACH ROW "
+                     "BEGIN :NEW.ROW_VERSION := ROW_VERSION_SEQ.NEXTVAL; END;",
+                     "CREATE OR REPLACE TRIGGER CLIENTS_TOMBSTONE "
+                     "AFTER DELETE ON CLIENTS FOR EACH ROW "
+                     "BEGIN INSERT INTO DELETED_ROWS (TABLE_NAME, ROW_ID, ROW_VERSION) "
+                     "VALUES ('CLIENTS', :OLD.ID, ROW_VERSION_SEQ.NEXTVAL); END;",
+                     "CREATE OR REPLACE TRIGGER COMMANDS_TOMBSTONE "
+                     "AFTER DELETE ON COMMANDS FOR EACH ROW "
+                     "BEGIN INSERT INTO DELETED_ROWS (TABLE_NAME, ROW_ID, ROW_VERSION) "
+                     "VALUES ('COMMANDS', :OLD.COMMAND_ID, ROW_VERSION_SEQ.NEXTVAL); END;",
+                     "UPDATE CLIENTS SET ROW_VERSION = 0 WHERE ROW_VERSION = 0",
+                     "UPDATE COMMANDS SET ROW_VERSION = 0 WHERE ROW_VERSION = 0"
+                 },
+                 {
+                     // SQLite has no sequences; a one-row table stands in
+                     "CREATE TABLE IF NOT EXISTS ROW_VERSION_SEQ (ID INTEGER PRIMARY KEY, LAST_VALUE INTEGER NOT NULL)",
+                     "INSERT OR IGNORE INTO ROW_VERSION_SEQ (ID, LAST_VALUE) VALUES (1, 0)",
+                     "ALTER TABLE CLIENTS ADD COLUMN ROW_VERSION INTEGER NOT NULL DEFAULT 0",
+                     "ALTER TABLE COMMANDS ADD COLUMN ROW_VERSION INTEGER NOT NULL DEFAULT 0",
+                     "CREATE INDEX IF NOT EXISTS CLIENTS_ROW_VERSION_IDX ON CLIENTS (ROW_VERSION)",
+                     "CREATE INDEX IF NOT EXISTS COMMANDS_ROW_VERSION_IDX ON COMMANDS (ROW_VERSION)",
+                     "CREATE TABLE IF NOT EXISTS DELETED_ROWS ("
+                     "TABLE_NAME TEXT NOT NULL, "
+                     "ROW_ID INTEGER NOT NULL, "
+                     "ROW_VERSION INTEGER NOT NULL, "
+                     "PRIMARY KEY (TABLE_NAME, ROW_ID))",
+                     "CREATE INDEX IF NOT EXISTS DELETED_ROWS_VERSION_IDX ON DELETED_ROWS (ROW_VERSION)",
+                     "CREATE TRIGGER IF NOT EXISTS CLIENTS_ROW_VERSION_INS AFTER INSERT ON CLIENTS BEGIN "
+                     "UPDATE ROW_VERSION_SEQ SET LAST_VALUE = LAST_VALUE + 1 WHERE ID = 1; "
+                     "UPDATE CLIENTS SET ROW_VERSION = (SELECT LAST_VALUE FROM ROW_VERSION_SEQ WHERE ID = 1) "
+                     "WHERE ID = NEW.ID; END",
+                     "CREATE TRIGGER IF NOT EXISTS CLIENTS_ROW_VERSION_UPD "
+                     "AFTER UPDATE OF NAME, EMAIL, CITY, POSTAL, ADDRESS ON CLIENTS BEGIN "
+                     "UPDATE ROW_VERSION_SEQ SET LAST_VALUE = LAST_VALUE + 1 WHERE ID = 1; "
+                     "UPDATE CLIENTS SET ROW_VERSION = (SELECT LAST_VALUE FROM ROW_VERSION_SEQ WHERE ID = 1) "
+                     "WHERE ID = NEW.ID; END",
+                     "CREATE TRIGGER IF NOT EXISTS COMMANDS_ROW_VERSION_INS AFTER INSERT ON COMMANDS BEGIN "
+                     "UPDATE ROW_VERSION_SEQ SET LAST_VALUE = LAST_VALUE + 1 WHERE ID = 1; "
+                     "UPDATE COMMANDS SET ROW_VERSION = (SELECT LAST_VALUE FROM ROW_VERSION_SEQ WHERE ID = 1) "
+                     "WHERE COMMAND_ID = NEW.COMMAND_ID; END",
+                     "CREATE TRIGGER IF NOT EXISTS COMMANDS_ROW_VERSION_UPD "
+                     "AFTER UPDATE OF CLIENT_ID, COMMAND_DATE, TOTAL, PAYMENT_METHOD, DELIVERY_ADDRESS ON COMMANDS BEGIN "
+                     "UPDATE ROW_VERSION_SEQ SET LAST_VALUE = LAST_VALUE + 1 WHERE ID = 1; "
+                     "UPDATE COMMANDS SET ROW_VERSION = (SELECT LAST_VALUE FROM ROW_VERSION_SEQ WHERE ID = 1) "
+                     "WHERE COMMAND_ID = NEW.COMMAND_ID; END",
+                     "CREATE TRIGGER IF NOT EXISTS CLIENTS_TOMBSTONE AFTER DELETE ON CLIENTS BEGIN "
+                     "UPDATE ROW_VERSION_SEQ SET LAST_VALUE = LAST_VALUE + 1 WHERE ID = 1; "
+                     "INSERT OR REPLACE INTO DELETED_ROWS (TABLE_NAME, ROW_ID, ROW_VERSION) "
+                     "SELECT 'CLIENTS', OLD.ID, LAST_VALUE FROM ROW_VERSION_SEQ WHERE ID = 1; END",
+                     "CREATE TRIGGER IF NOT EXISTS COMMANDS_TOMBSTONE AFTER DELETE ON COMMANDS BEGIN "
+                     "UPDATE ROW_VERSION_SEQ SET LAST_VALUE = LAST_VALUE + 1 WHERE ID = 1; "
+                     "INSERT OR REPLACE INTO DELETED_ROWS (TABLE_NAME, ROW_ID, ROW_VERSION) "
+                     "SELECT 'COMMANDS', OLD.COMMAND_ID, LAST_VALUE FROM ROW_VERSION_SEQ WHERE ID = 1; END",
+                     "UPDATE CLIENTS SET NAME = NAME WHERE ROW_VERSION = 0",
+                     "UPDATE COMMANDS SET TOTAL = TOTAL WHERE ROW_VERSION = 0"
+                 },
+                 nullptr});
+
+    // The city each order was rolled up under. The rollup state is reset so
+    // the next backfill rebuilds every bucket from it, and the row always
+    // exists for SalesRollup::lockState(); the Oracle version trigger skips
+    // the new column so a backfill does not make the replica pull every order
+    list.append({6, "Store the rollup city on COMMANDS",
+                 {
+                     "ALTER TABLE COMMANDS ADD (ROLLUP_CITY VARCHAR2(100))",
+                     "CREATE OR REPLACE TRIGGER COMMANDS_ROW_VERSION "
+                     "BEFORE INSERT OR UPDATE OF CLIENT_ID, COMMAND_DATE, TOTAL, PAYMENT_METHOD, DELIVERY_ADDRESS "
+                     "ON COMMANDS FOR EACH ROW "
+                     "BEGIN :NEW.ROW_VERSION := ROW_VERSION_SEQ.NEXTVAL; END;",
+                     "DELETE FROM SALES_ROLLUP_STATE",
+                     "INSERT INTO SALES_ROLLUP_STATE (ID, COVERED_UNTIL) VALUES (1, NULL)"
+                 },
+                 {
+                     "ALTER TABLE COMMANDS ADD COLUMN ROLLUP_CITY TEXT",
+                     "DELETE FROM SALES_ROLLUP_STATE",
+                     "INSERT INTO SALES_ROLLUP_STATE (ID, COVERED_UNTIL) VALUES (1, NULL)"
+                 },
+                 nullptr});
+
+    return list;
+}
+
+bool SchemaMigrator::migrate()
+{
+    stepResults.clear();
+
+    QString error;
+    if (!ensureVersionTable(error)) {
+        qDebug() << "✗ Schema migration: could not create SCHEMA_VERSION:" << error;
+        StepResult result;
+        result.description = "Create SCHEMA_VERSION";
+        result.error = error;
+        stepResults.append(result);
+        return false;
+    }
+
+    int version = currentVersion();
+    qDebug() << "Schema version" << version << "of" << latestVersion();
+
+    for (const Step& step : steps()) {
+        if (step.version <= version) {
+            continue;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        error.clear();
+
+        bool success = runStep(step, error);
+        qint64 elapsed = timer.elapsed();
+        if (success) {
+            success = recordVersion(step, elapsed, error);
+        }
+
+        StepResult result;
+        result.version = step.version;
+        result.description = step.description;
+        result.elapsedMs = elapsed;
+        result.success = success;
+        result.error = error;
+        stepResults.append(result);
+
+        if (!success) {
+            qDebug() << QString("✗ Migration %1 (%2) failed after %3 ms: %4")
+                            .arg(step.version).arg(step.description).arg(elapsed).arg(error);
+            return false;
+        }
+
+        qDebug() << QString("✓ Migration %1 (%2) applied in %3 ms")
+                        .arg(step.version).arg(step.description).arg(elapsed);
+    }
+
+    return true;
+}
+
+int SchemaMigrator::currentVersion()
+{
+    QSqlQuery query(db);
+    if (query.exec("SELECT MAX(VERSION) FROM SCHEMA_VERSION") && query.next()) {
+        return query.value(0).toInt();
+    }
+    return 0;
+}
+
+int SchemaMigrator::latestVersion() const
+{
+    QList<Step> list = steps();
+    return list.isEmpty() ? 0 : list.last().version;
+}
+
+QString SchemaMigrator::report() const
+{
+    if (stepResults.isEmpty()) {
+        return "Schema is up to date.";
+    }
+
+    QStringList lines;
+    for (const StepResult& result : stepResults) {
+        QString line = QString("%1 Migration %2: %3 (%4 ms)")
+                           .arg(result.success ? "✓" : "✗")
+                           .arg(result.version)
+                           .arg(result.description)
+                           .arg(result.elapsedMs);
+        if (!result.success) {
+            line += "\n   " + result.error;
+        }
+        lines << line;
+    }
+    return lines.join("\n");
+}
+
+bool SchemaMigrator::ensureVersionTable(QString& error)
+{
+    if (dialect == Connection::SQLiteDialect) {
+        return execute("CREATE TABLE IF NOT EXISTS SCHEMA_VERSION ("
+                       "VERSION INTEGER PRIMARY KEY, "
+                       "DESCRIPTION TEXT, "
+                       "APPLIED_AT TIMESTAMP DEFAULT CURRENT_TIMESTAMP, "
+                       "DURATION_MS INTEGER)", error);
+    }
+
+    return execute("CREATE TABLE SCHEMA_VERSION ("
+                   "VERSION NUMBER(6) PRIMARY KEY, "
+                   "DESCRIPTION VARCHAR2(200), "
+                   "APPLIED_AT DATE DEFAULT SYSDATE, "
+                   "DURATION_MS NUMBER(12))", error);
+}
+
+bool SchemaMigrator::runStep(const Step& step, QString& error)
+{
+    // SQLite DDL is transactional; Oracle commits every DDL statement itself
+    bool transactional = dialect == Connection::SQLiteDialect && db.transaction();
+
+    const QStringList& statements = dialect == Connection::SQLiteDialect ? step.sqlite : step.oracle;
+    bool success = true;
+
+    for (const QString& statement : statements) {
+        if (!execute(statement, error)) {
+            success = false;
+            break;
+        }
+    }
+
+    if (success && step.custom) {
+        success = step.custom(db, error);
+    }
+
+    if (transactional) {
+        if (success) {
+            success = db.commit();
+            if (!success) {
+                error = db.lastError().text();
+            }
+        } else {
+            db.rollback();
+        }
+    }
+
+    return success;
+}
+
+bool SchemaMigrator::execute(const QString& statement, QString& error)
+{
+    QSqlQuery query(db);
+    if (query.exec(statement)) {
+        return true;
+    }
+
+    if (isAlreadyApplied(query.lastError())) {
+        qDebug() << "  already applied:" << statement.left(60);
+        return true;
+    }
+
+    error = QString("%1\n   %2").arg(statement, query.lastError().text());
+    return false;
+}
+
+bool SchemaMigrator::recordVersion(const Step& step, qint64 elapsedMs, QString& error)
+{
+    QSqlQuery query(db);
+    query.prepare("INSERT INTO SCHEMA_VERSION (VERSION, DESCRIPTION, DURATION_MS) VALUES (?, ?, ?)");
+    query.addBindValue(step.version);
+    query.addBindValue(step.description);
+    query.addBindValue(elapsedMs);
+
+    if (!query.exec()) {
+        error = "Could not record version: " + query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool SchemaMigrator::isAlreadyApplied(const QSqlError& error)
+{
+    // ORA-00955 name already used, ORA-01408 column list already indexed,
+    // ORA-01430 column already exists, ORA-02260/02275 constraint already there
+    static const QList<int> codes = {955, 1408, 1430, 2260, 2275};
+
+    QRegularExpression oraCode("ORA-(\\d{5})");
+    QRegularExpressionMatch match = oraCode.match(error.text());
+    int code = match.hasMatch() ? match.captured(1).toInt() : error.nativeErrorCode().toInt();
+    return codes.contains(code);
+}
+
+bool SchemaMigrator::convertTotalToNumber(QSqlDatabase& database, QString& error)
+{
+    QSqlQuery query(database);
+    if (!query.exec("SELECT COLUMN_NAME, DATA_TYPE FROM USER_TAB_COLUMNS "
+                    "WHERE TABLE_NAME = 'COMMANDS' AND COLUMN_NAME IN ('TOTAL', 'TOTAL_NUM')")) {
+        error = "Could not read COMMANDS columns: " + query.lastError().text();
+        return false;
+    }
+
+    QString totalType;
+    bool hasTotalNum = false;
+    while (query.next()) {
+        if (query.value(0).toString() == "TOTAL") {
+            totalType = query.value(1).toString().toUpper();
+        } else {
+            hasTotalNum = true;
+        }
+    }
+
+    if (totalType == "NUMBER" && !hasTotalNum) {
+        return true;
+    }
+
+    // TOTAL already converted: TOTAL_NUM is a leftover copy
+    if (totalType == "NUMBER") {
+        QSqlQuery ddl(database);
+        if (!ddl.exec("ALTER TABLE COMMANDS DROP COLUMN TOTAL_NUM")) {
+            error = "Could not drop TOTAL_NUM: " + ddl.lastError().text();
+            return false;
+        }
+        return true;
+    }
+
+    // Oracle cannot change the type of a filled column, so the values are
+    // copied through TOTAL_NUM; each part is skipped if an earlier, interrupted
+    // run already did it
+    QStringList statements;
+    if (!totalType.isEmpty()) {
+        if (!hasTotalNum) {
+            statements << "ALTER TABLE COMMANDS ADD (TOTAL_NUM NUMBER(12,2))";
+        }
+        statements << "UPDATE COMMANDS SET TOTAL_NUM = TO_NUMBER(TRIM(TOTAL))"
+                   << "ALTER TABLE COMMANDS DROP COLUMN TOTAL";
+    }
+    if (hasTotalNum || !totalType.isEmpty()) {
+        statements << "ALTER TABLE COMMANDS RENAME COLUMN TOTAL_NUM TO TOTAL";
+    }
+
+    for (const QString& statement : statements) {
+        QSqlQuery ddl(database);
+        if (!ddl.exec(statement)) {
+            error = QString("%1\n   %2").arg(statement, ddl.lastError().text());
+            return false;
+        }
+    }
+
+    return true;
+}
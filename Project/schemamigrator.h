@@ -0,0 +1,68 @@
+// schemamigrator.h
+#ifndef SCHEMAMIGRATOR_H
+#define SCHEMAMIGRATOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <functional>
+
+#include "connection.h"
+
+// Versioned schema migrations.
+//
+// Steps are numbered and applied in order; the highest applied version is
+// recorded in SCHEMA_VERSION so each step runs once per database. Every
+// statement is also safe to repeat ("already exists" errors are ignored),
+// so a run interrupted half way through a step can simply be restarted.
+class SchemaMigrator
+{
+public:
+    struct StepResult {
+        int version;
+        QString description;
+        qint64 elapsedMs;
+        bool success;
+        QString error;
+
+        StepResult() : version(0), elapsedMs(0), success(false) {}
+    };
+
+    explicit SchemaMigrator(const QSqlDatabase& database);
+
+    // Apply all pending steps; stops at the first failure
+    bool migrate();
+
+    int currentVersion();
+    int latestVersion() const;
+    QList<StepResult> results() const { return stepResults; }
+    QString report() const;
+
+private:
+    struct Step {
+        int version;
+        QString description;
+        QStringList oracle;
+        QStringList sqlite;
+        // Extra work that plain DDL cannot express, runs after the statements
+        std::function<bool(QSqlDatabase&, QString&)> custom;
+    };
+
+    QSqlDatabase db;
+    Connection::Dialect dialect;
+    QList<StepResult> stepResults;
+
+    QList<Step> steps() const;
+    bool ensureVersionTable(QString& error);
+    bool runStep(const Step& step, QString& error);
+    bool execute(const QString& statement, QString& error);
+    bool recordVersion(const Step& step, qint64 elapsedMs, QString& error);
+    static bool isAlreadyApplied(const QSqlError& error);
+
+    // Custom steps
+    static bool convertTotalToNumber(QSqlDatabase& database, QString& error);
+};
+
+#endif // SCHEMAMIGRATOR_H
@@ -0,0 +1,667 @@
+// snapshotstore.cpp
+#include "snapshotstore.h"
+#include "connection.h"
+#include "localreplica.h"
+#include "datecodec.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QtConcurrent>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char Magic[4] = {'C', 'M', 'S', 'S'};
+const quint32 FormatVersion = 1;
+const quint32 ByteOrderMark = 0x01020304;
+
+const quint32 FlagVersioned = 0x1;
+const quint32 FlagStatistics = 0x2;
+
+// Sequence values can commit out of order; a delta re-reads this many
+// versions below the last one seen so a late commit is not skipped
+const qint64 VersionOverlap = 1000;
+
+struct Header {
+    char magic[4];
+    quint32 formatVersion;
+    quint32 byteOrder;
+    quint32 flags;
+    qint64 savedAtMs;
+    qint64 clientsVersion;
+    qint64 commandsVersion;
+    qint64 tombstoneVersion;
+    quint32 clientCount;
+    quint32 commandCount;
+    quint32 clientsOffset;
+    quint32 commandsOffset;
+    quint32 statisticsOffset;
+    quint32 stringsOffset;
+    quint32 stringsSize;
+    quint32 reserved;
+};
+
+struct ClientRecord {
+    qint32 id;
+    quint32 name;           // String table offsets
+    quint32 email;
+    quint32 city;
+    quint32 postal;
+    quint32 address;
+};
+
+struct CommandRecord {
+    qint32 commandId;
+    qint32 clientId;
+    qint64 dateMs;
+    qint64 totalCents;
+    quint32 paymentMethod;
+    quint32 deliveryAddress;
+};
+
+struct StatisticsRecord {
+    qint32 totalCommands;
+    qint32 topClientId;
+    qint64 totalSalesCents;
+    qint64 averageCents;
+    qint64 firstOrderDay;   // Julian days
+    qint64 lastOrderDay;
+    qint32 totalClients;
+    quint32 topClientName;
+    quint32 mostUsedPaymentMethod;
+    quint32 reserved;
+};
+
+static_assert(sizeof(Header) == 80, "snapshot header layout changed");
+static_assert(sizeof(ClientRecord) == 24, "snapshot client layout changed");
+static_assert(sizeof(CommandRecord) == 32, "snapshot order layout changed");
+static_assert(sizeof(StatisticsRecord) == 56, "snapshot statistics layout changed");
+
+class StringTableWriter
+{
+public:
+    StringTableWriter() { add(QString()); }
+
+    quint32 add(const QString& text)
+    {
+        auto it = offsets.constFind(text);
+        if (it != offsets.constEnd()) {
+            return it.value();
+        }
+
+        quint32 offset = quint32(bytes.size());
+        QByteArray utf8 = text.toUtf8();
+        quint32 length = quint32(utf8.size());
+        bytes.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        bytes.append(utf8);
+        offsets.insert(text, offset);
+        return offset;
+    }
+
+    QByteArray bytes;
+
+private:
+    QHash<QString, quint32> offsets;
+};
+
+quint32 alignTo8(qint64 offset)
+{
+    return quint32((offset + 7) & ~qint64(7));
+}
+
+template <typename T>
+void put(QByteArray& buffer, quint32 offset, const T& value)
+{
+    std::memcpy(buffer.data() + offset, &value, sizeof(T));
+}
+
+template <typename T>
+T get(const uchar *base, quint64 offset)
+{
+    T value;
+    std::memcpy(&value, base + offset, sizeof(T));
+    return value;
+}
+
+} // namespace
+
+SnapshotStore::SnapshotStore(const QString& filePath, QObject *parent)
+    : QObject(parent), path(filePath), loaded(false), saveTimer(nullptr)
+{
+    connect(&watcher, &QFutureWatcher<Result>::finished, this, &SnapshotStore::onRefreshFinished);
+}
+
+SnapshotStore::~SnapshotStore()
+{
+    watcher.waitForFinished();
+}
+
+bool SnapshotStore::loadCached()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QString error;
+    Data data;
+    if (!read(path, &data, error)) {
+        qDebug() << "No usable snapshot:" << error;
+        return false;
+    }
+
+    current = data;
+    loaded = true;
+    qDebug() << QString("Snapshot loaded in %1 ms: %2 clients, %3 orders (%4 KB in memory), saved %5")
+                    .arg(timer.elapsed()).arg(current.clients.size()).arg(current.commands.size())
+                    .arg((current.clients.memoryUsage() + current.commands.memoryUsage()) / 1024)
+                    .arg(QDateTime::fromMSecsSinceEpoch(current.savedAtMs).toString("yyyy-MM-dd hh:mm"));
+    return true;
+}
+
+void SnapshotStore::refresh()
+{
+    if (watcher.isRunning()) {
+        return;
+    }
+
+    QString filePath = path;
+    Data data = current;
+    bool fromScratch = !loaded;
+    watcher.setFuture(QtConcurrent::run([filePath, data, fromScratch]() {
+        Result result = update(fromScratch ? Data() : data);
+        QString error;
+        if (result.changed && !write(filePath, result.data, error)) {
+            qDebug() << "⚠ Snapshot not saved:" << error;
+        }
+
+        Connection& conn = Connection::getInstance();
+        conn.releaseThreadDatabase();
+        if (conn.replica()) {
+            conn.replica()->releaseThreadDatabase();
+        }
+        return result;
+    }));
+}
+
+void SnapshotStore::startPeriodicSave(int intervalMs)
+{
+    if (!saveTimer) {
+        saveTimer = new QTimer(this);
+        connect(saveTimer, &QTimer::timeout, this, &SnapshotStore::refresh);
+    }
+    saveTimer->start(intervalMs);
+}
+
+void SnapshotStore::saveNow()
+{
+    // A refresh that finished but was not delivered yet is still newer
+    watcher.waitForFinished();
+    if (watcher.future().resultCount() > 0 && watcher.result().data.savedAtMs > current.savedAtMs) {
+        current = watcher.result().data;
+    }
+
+    Result result = update(loaded ? current : Data());
+    if (result.data.savedAtMs == 0) {
+        return;     // Never fetched anything; keep the file we have
+    }
+
+    QString error;
+    if (result.changed && !write(path, result.data, error)) {
+        qDebug() << "⚠ Snapshot not saved:" << error;
+        return;
+    }
+    current = result.data;
+    loaded = true;
+}
+
+void SnapshotStore::onRefreshFinished()
+{
+    Result result = watcher.result();
+    if (result.data.savedAtMs == 0) {
+        return;     // Nothing could be fetched
+    }
+
+    current = result.data;
+    loaded = true;
+    emit refreshed(result.changed);
+}
+
+// Fetching
+
+static bool readClients(QSqlDatabase& db, const QString& sql, const QVariantList& binds, bool withVersion,
+                        ClientStore *clients, qint64 *maxVersion, QString& error)
+{
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.setNumericalPrecisionPolicy(QSql::HighPrecision);
+    query.prepare(sql);
+    for (const QVariant& value : binds) {
+        query.addBindValue(value);
+    }
+    if (!query.exec()) {
+        error = "Reading clients failed: " + query.lastError().text();
+        return false;
+    }
+
+    while (query.next()) {
+        clients->upsert(Client(query.value(0).toInt(), query.value(1).toString(), query.value(2).toString(),
+                               query.value(3).toString(), query.value(4).toString(), query.value(5).toString()));
+        if (withVersion) {
+            *maxVersion = qMax(*maxVersion, query.value(6).toLongLong());
+        }
+    }
+    return true;
+}
+
+static bool readCommands(QSqlDatabase& db, const QString& sql, const QVariantList& binds, bool withVersion,
+                         CommandStore *commands, qint64 *maxVersion, QString& error)
+{
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.setNumericalPrecisionPolicy(QSql::HighPrecision);
+    query.prepare(sql);
+    for (const QVariant& value : binds) {
+        query.addBindValue(value);
+    }
+    if (!query.exec()) {
+        error = "Reading orders failed: " + query.lastError().text();
+        return false;
+    }
+
+    while (query.next()) {
+        Command command;
+        command.commandId = query.value(0).toInt();
+        command.clientId = query.value(1).toInt();
+        if (!DateCodec::decode(query.value(2), &command.commandDateMs)) {
+            command.commandDateMs = Command::NoDate;
+        }
+        command.total = Money::fromVariant(query.value(3));
+        command.paymentMethod = query.value(4).toString();
+        command.deliveryAddress = query.value(5).toString();
+        commands->upsert(command);
+        if (withVersion) {
+            *maxVersion = qMax(*maxVersion, query.value(6).toLongLong());
+        }
+    }
+    return true;
+}
+
+static const char *ClientColumns = "ID, NAME, EMAIL, CITY, POSTAL, ADDRESS";
+static const char *CommandColumns = "COMMAND_ID, CLIENT_ID, COMMAND_DATE, TOTAL, PAYMENT_METHOD, DELIVERY_ADDRESS";
+
+bool SnapshotStore::fetchAll(Data* data, QString& error)
+{
+    Connection& conn = Connection::getInstance();
+    if (!conn.ensureDataConnection()) {
+        error = "Database not connected";
+        return false;
+    }
+    QSqlDatabase db = conn.getDataDatabase();
+
+    // Versions only count when the tombstones can be read as well
+    QSqlQuery tombstones(db);
+    data->versioned = tombstones.exec("SELECT MAX(ROW_VERSION) FROM DELETED_ROWS") && tombstones.next();
+    data->tombstoneVersion = data->versioned && !tombstones.value(0).isNull() ? tombstones.value(0).toLongLong() : -1;
+
+    if (data->versioned) {
+        data->versioned =
+            readClients(db, QString("SELECT %1, ROW_VERSION FROM CLIENTS").arg(ClientColumns), {}, true,
+                        &data->clients, &data->clientsVersion, error)
+            && readCommands(db, QString("SELECT %1, ROW_VERSION FROM COMMANDS").arg(CommandColumns), {}, true,
+                            &data->commands, &data->commandsVersion, error);
+    }
+
+    if (!data->versioned) {
+        data->clients.clear();
+        data->commands.clear();
+        data->clientsVersion = data->commandsVersion = data->tombstoneVersion = -1;
+        if (!readClients(db, QString("SELECT %1 FROM CLIENTS").arg(ClientColumns), {}, false,
+                         &data->clients, nullptr, error)
+            || !readCommands(db, QString("SELECT %1 FROM COMMANDS").arg(CommandColumns), {}, false,
+                             &data->commands, nullptr, error)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool sameClient(const Client& a, const Client& b)
+{
+    return a.id == b.id && a.name == b.name && a.email == b.email && a.city == b.city
+           && a.postal == b.postal && a.address == b.address;
+}
+
+static bool sameCommand(const Command& a, const Command& b)
+{
+    return a.commandId == b.commandId && a.clientId == b.clientId && a.commandDateMs == b.commandDateMs
+           && a.total == b.total && a.paymentMethod == b.paymentMethod && a.deliveryAddress == b.deliveryAddress;
+}
+
+bool SnapshotStore::fetchDelta(Data* data, bool* changed, QString& error)
+{
+    Connection& conn = Connection::getInstance();
+    if (!conn.ensureDataConnection()) {
+        error = "Database not connected";
+        return false;
+    }
+    QSqlDatabase db = conn.getDataDatabase();
+
+    ClientStore clients;
+    CommandStore commands;
+    qint64 clientsVersion = data->clientsVersion;
+    qint64 commandsVersion = data->commandsVersion;
+    if (!readClients(db, QString("SELECT %1, ROW_VERSION FROM CLIENTS WHERE ROW_VERSION > ?").arg(ClientColumns),
+                     {data->clientsVersion - VersionOverlap}, true, &clients, &clientsVersion, error)
+        || !readCommands(db, QString("SELECT %1, ROW_VERSION FROM COMMANDS WHERE ROW_VERSION > ?").arg(CommandColumns),
+                         {data->commandsVersion - VersionOverlap}, true, &commands, &commandsVersion, error)) {
+        return false;
+    }
+
+    QSqlQuery tombstones(db);
+    tombstones.setForwardOnly(true);
+    tombstones.setNumericalPrecisionPolicy(QSql::HighPrecision);
+    tombstones.prepare("SELECT TABLE_NAME, ROW_ID, ROW_VERSION FROM DELETED_ROWS WHERE ROW_VERSION > ?");
+    tombstones.addBindValue(data->tombstoneVersion - VersionOverlap);
+    if (!tombstones.exec()) {
+        error = "Reading deletes failed: " + tombstones.lastError().text();
+        return false;
+    }
+    QSet<int> deletedClients;
+    QSet<int> deletedCommands;
+    qint64 tombstoneVersion = data->tombstoneVersion;
+    while (tombstones.next()) {
+        QString table = tombstones.value(0).toString();
+        (table == "CLIENTS" ? deletedClients : deletedCommands).insert(tombstones.value(1).toInt());
+        tombstoneVersion = qMax(tombstoneVersion, tombstones.value(2).toLongLong());
+    }
+
+    // Merge by id; the overlap brings back rows we already have, unchanged
+    *changed = false;
+    for (int row = 0; row < clients.size(); ++row) {
+        Client client = clients.clientAt(row);
+        if (!data->clients.contains(client.id) || !sameClient(data->clients.client(client.id), client)) {
+            data->clients.upsert(client);
+            *changed = true;
+        }
+    }
+    for (int row = 0; row < commands.size(); ++row) {
+        Command command = commands.commandAt(row);
+        if (!data->commands.contains(command.commandId)
+            || !sameCommand(data->commands.command(command.commandId), command)) {
+            data->commands.upsert(command);
+            *changed = true;
+        }
+    }
+
+    // Ids come from sequences and are never reused, so a tombstone is final
+    for (int id : deletedClients) {
+        *changed = data->clients.remove(id) || *changed;
+    }
+    for (int id : deletedCommands) {
+        *changed = data->commands.remove(id) || *changed;
+    }
+
+    data->clientsVersion = clientsVersion;
+    data->commandsVersion = commandsVersion;
+    data->tombstoneVersion = tombstoneVersion;
+    return true;
+}
+
+static bool sameClients(const ClientStore& a, const ClientStore& b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (int row = 0; row < a.size(); ++row) {
+        int id = a.idAt(row);
+        if (!b.contains(id) || !sameClient(a.clientAt(row), b.client(id))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool sameCommands(const CommandStore& a, const CommandStore& b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (int row = 0; row < a.size(); ++row) {
+        int id = a.idAt(row);
+        if (!b.contains(id) || !sameCommand(a.commandAt(row), b.command(id))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QList<Client> SnapshotStore::Data::clientList() const
+{
+    QList<Client> list = clients.toList();
+    std::stable_sort(list.begin(), list.end(), [](const Client& a, const Client& b) {
+        return a.name < b.name;
+    });
+    return list;
+}
+
+QList<Command> SnapshotStore::Data::commandList() const
+{
+    QList<Command> list = commands.toList(&clients);
+    std::stable_sort(list.begin(), list.end(), [](const Command& a, const Command& b) {
+        return a.commandDateMs > b.commandDateMs;
+    });
+    return list;
+}
+
+SnapshotStore::Result SnapshotStore::update(Data data)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    Result result;
+    QString error;
+    bool ok = data.versioned && fetchDelta(&data, &result.changed, error);
+    if (!ok) {
+        if (data.versioned) {
+            qDebug() << "Snapshot delta failed, reading everything:" << error;
+        }
+        Data fresh;
+        if (fetchAll(&fresh, error)) {
+            result.changed = data.savedAtMs == 0
+                             || !sameClients(fresh.clients, data.clients)
+                             || !sameCommands(fresh.commands, data.commands);
+            fresh.statistics = data.statistics;
+            fresh.hasStatistics = data.hasStatistics;
+            data = fresh;
+            ok = true;
+        } else {
+            qDebug() << "Snapshot refresh failed:" << error;
+        }
+    }
+
+    if (ok) {
+        if (result.changed || !data.hasStatistics) {
+            // A failed statistics read is not saved; the next refresh tries again
+            data.statistics = CommandStatistics(nullptr).getOverallStatistics();
+            data.hasStatistics = data.statistics.valid;
+            result.changed = true;
+        }
+        data.savedAtMs = QDateTime::currentMSecsSinceEpoch();
+        qDebug() << QString("Snapshot refreshed in %1 ms (%2)")
+                        .arg(timer.elapsed()).arg(result.changed ? "changed" : "unchanged");
+    }
+
+    result.data = data;
+    return result;
+}
+
+// File format
+
+bool SnapshotStore::write(const QString& filePath, const Data& data, QString& error)
+{
+    StringTableWriter strings;
+
+    Header header;
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.formatVersion = FormatVersion;
+    header.byteOrder = ByteOrderMark;
+    header.flags = (data.versioned ? FlagVersioned : 0) | (data.hasStatistics ? FlagStatistics : 0);
+    header.savedAtMs = data.savedAtMs;
+    header.clientsVersion = data.clientsVersion;
+    header.commandsVersion = data.commandsVersion;
+    header.tombstoneVersion = data.tombstoneVersion;
+    header.clientCount = quint32(data.clients.size());
+    header.commandCount = quint32(data.commands.size());
+    header.clientsOffset = alignTo8(sizeof(Header));
+    header.commandsOffset = alignTo8(header.clientsOffset + qint64(header.clientCount) * sizeof(ClientRecord));
+    header.statisticsOffset = alignTo8(header.commandsOffset + qint64(header.commandCount) * sizeof(CommandRecord));
+    header.stringsOffset = alignTo8(header.statisticsOffset + sizeof(StatisticsRecord));
+    header.reserved = 0;
+
+    QByteArray buffer(header.stringsOffset, '\0');
+
+    for (int i = 0; i < data.clients.size(); ++i) {
+        Client client = data.clients.clientAt(i);
+        ClientRecord record = {client.id, strings.add(client.name), strings.add(client.email),
+                               strings.add(client.city), strings.add(client.postal), strings.add(client.address)};
+        put(buffer, header.clientsOffset + i * quint32(sizeof(ClientRecord)), record);
+    }
+
+    for (int i = 0; i < data.commands.size(); ++i) {
+        Command command = data.commands.commandAt(i);
+        CommandRecord record = {command.commandId, command.clientId, command.commandDateMs, command.total.toCents(),
+                                strings.add(command.paymentMethod), strings.add(command.deliveryAddress)};
+        put(buffer, header.commandsOffset + i * quint32(sizeof(CommandRecord)), record);
+    }
+
+    const CommandStatistics::Statistics& stats = data.statistics;
+    StatisticsRecord statistics = {stats.totalCommands, stats.topClientId,
+                                   stats.totalSales.toCents(), stats.averageOrderValue.toCents(),
+                                   stats.firstOrderDate.toJulianDay(), stats.lastOrderDate.toJulianDay(),
+                                   stats.totalClients, strings.add(stats.topClientName),
+                                   strings.add(stats.mostUsedPaymentMethod), 0};
+    put(buffer, header.statisticsOffset, statistics);
+
+    header.stringsSize = quint32(strings.bytes.size());
+    put(buffer, 0, header);
+    buffer.append(strings.bytes);
+
+    QDir().mkpath(QFileInfo(filePath).absolutePath());
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        error = file.errorString();
+        return false;
+    }
+    file.write(buffer);
+    if (!file.commit()) {
+        error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool SnapshotStore::read(const QString& filePath, Data* data, QString& error)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = file.errorString();
+        return false;
+    }
+
+    quint64 size = quint64(file.size());
+    if (size < sizeof(Header)) {
+        error = "file too short";
+        return false;
+    }
+
+    uchar *base = file.map(0, qint64(size));
+    if (!base) {
+        error = "map failed: " + file.errorString();
+        return false;
+    }
+
+    Header header = get<Header>(base, 0);
+    bool valid = std::memcmp(header.magic, Magic, sizeof(Magic)) == 0
+                 && header.formatVersion == FormatVersion
+                 && header.byteOrder == ByteOrderMark
+                 && quint64(header.clientsOffset) + quint64(header.clientCount) * sizeof(ClientRecord) <= size
+                 && quint64(header.commandsOffset) + quint64(header.commandCount) * sizeof(CommandRecord) <= size
+                 && quint64(header.statisticsOffset) + sizeof(StatisticsRecord) <= size
+                 && quint64(header.stringsOffset) + header.stringsSize <= size;
+    if (!valid) {
+        file.unmap(base);
+        error = "unknown format or truncated file";
+        return false;
+    }
+
+    const uchar *stringTable = base + header.stringsOffset;
+    bool stringsValid = true;
+    auto stringAt = [&](quint32 offset) {
+        if (quint64(offset) + sizeof(quint32) > header.stringsSize) {
+            stringsValid = false;
+            return QString();
+        }
+        quint32 length = get<quint32>(stringTable, offset);
+        if (quint64(offset) + sizeof(quint32) + length > header.stringsSize) {
+            stringsValid = false;
+            return QString();
+        }
+        return QString::fromUtf8(reinterpret_cast<const char*>(stringTable + offset + sizeof(quint32)), length);
+    };
+
+    data->clients.reserve(header.clientCount);
+    for (quint32 i = 0; i < header.clientCount; ++i) {
+        ClientRecord record = get<ClientRecord>(base, header.clientsOffset + quint64(i) * sizeof(ClientRecord));
+        data->clients.upsert(Client(record.id, stringAt(record.name), stringAt(record.email),
+                                    stringAt(record.city), stringAt(record.postal), stringAt(record.address)));
+    }
+
+    data->commands.reserve(header.commandCount);
+    for (quint32 i = 0; i < header.commandCount; ++i) {
+        CommandRecord record = get<CommandRecord>(base, header.commandsOffset + quint64(i) * sizeof(CommandRecord));
+        Command command;
+        command.commandId = record.commandId;
+        command.clientId = record.clientId;
+        command.commandDateMs = record.dateMs;
+        command.total = Money::fromCents(record.totalCents);
+        command.paymentMethod = stringAt(record.paymentMethod);
+        command.deliveryAddress = stringAt(record.deliveryAddress);
+        data->commands.upsert(command);
+    }
+
+    StatisticsRecord statistics = get<StatisticsRecord>(base, header.statisticsOffset);
+    data->statistics.totalCommands = statistics.totalCommands;
+    data->statistics.topClientId = statistics.topClientId;
+    data->statistics.totalSales = Money::fromCents(statistics.totalSalesCents);
+    data->statistics.averageOrderValue = Money::fromCents(statistics.averageCents);
+    data->statistics.firstOrderDate = QDate::fromJulianDay(statistics.firstOrderDay);
+    data->statistics.lastOrderDate = QDate::fromJulianDay(statistics.lastOrderDay);
+    data->statistics.totalClients = statistics.totalClients;
+    data->statistics.topClientName = stringAt(statistics.topClientName);
+    data->statistics.mostUsedPaymentMethod = stringAt(statistics.mostUsedPaymentMethod);
+
+    data->hasStatistics = header.flags & FlagStatistics;
+    data->statistics.valid = data->hasStatistics;
+    data->versioned = header.flags & FlagVersioned;
+    data->clientsVersion = header.clientsVersion;
+    data->commandsVersion = header.commandsVersion;
+    data->tombstoneVersion = header.tombstoneVersion;
+    data->savedAtMs = header.savedAtMs;
+
+    file.unmap(base);
+
+    if (!stringsValid) {
+        *data = Data();
+        error = "string offset out of range";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,92 @@
+// snapshotstore.h
+#ifndef SNAPSHOTSTORE_H
+#define SNAPSHOTSTORE_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QTimer>
+#include <QFutureWatcher>
+
+#include "clients.h"
+#include "commands.h"
+#include "clientstore.h"
+
+// Binary snapshot of the clients, orders and overall statistics, so the
+// window can show last session's data before the database answers.
+//
+// The file is read through QFile::map(). A fixed header gives the offsets
+// of three fixed-size record arrays (clients, orders, statistics) and of a
+// string table; records refer to strings by their offset in that table.
+// Each distinct string is stored once, as a 32-bit byte length followed by
+// its UTF-8 bytes. Offset 0 holds the empty string. All numbers are in
+// host byte order, and a file written by another format version, or on a
+// machine with a different byte order, is ignored.
+//
+// refresh() brings the data current on a worker thread. It only asks for
+// rows whose ROW_VERSION is newer than the snapshot's, plus the tombstones
+// in DELETED_ROWS (schema version 5). Without those it fetches everything.
+// It then writes the file again, through QSaveFile so a crash never leaves
+// half a snapshot behind.
+class SnapshotStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Data {
+        ClientStore clients;
+        CommandStore commands;
+        CommandStatistics::Statistics statistics;
+        bool hasStatistics = false;
+        bool versioned = false;     // Versions below are usable for a delta
+        qint64 clientsVersion = -1;
+        qint64 commandsVersion = -1;
+        qint64 tombstoneVersion = -1;
+        qint64 savedAtMs = 0;
+
+        // Same order as readAllClients() and readAllCommands()
+        QList<Client> clientList() const;
+        QList<Command> commandList() const;
+    };
+
+    explicit SnapshotStore(const QString& path, QObject *parent = nullptr);
+    ~SnapshotStore();
+
+    // Map and decode the file; false when missing or unreadable
+    bool loadCached();
+    bool isLoaded() const { return loaded; }
+    const Data& data() const { return current; }
+
+    // Background delta fetch and save; a call while one runs is dropped
+    void refresh();
+    void startPeriodicSave(int intervalMs);
+    // Blocking refresh and save, for shutdown
+    void saveNow();
+
+    static bool read(const QString& path, Data* data, QString& error);
+    static bool write(const QString& path, const Data& data, QString& error);
+
+signals:
+    // 'changed' is false when the database had nothing newer
+    void refreshed(bool changed);
+
+private:
+    struct Result {
+        Data data;
+        bool changed = false;
+    };
+
+    QString path;
+    Data current;
+    bool loaded;
+    QTimer *saveTimer;
+    QFutureWatcher<Result> watcher;
+
+    static Result update(Data data);
+    static bool fetchAll(Data* data, QString& error);
+    static bool fetchDelta(Data* data, bool* changed, QString& error);
+
+    void onRefreshFinished();
+};
+
+#endif // SNAPSHOTSTORE_H
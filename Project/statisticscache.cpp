@@ -0,0 +1,64 @@
+// statisticscache.cpp
+#include "statisticscache.h"
+#include "writebehindqueue.h"
+#include <QDebug>
+
+StatisticsCache::StatisticsCache(CommandDAO* dao, int ttlMs, QObject *parent)
+    : QObject(parent), statistics(new CommandStatistics(dao, this)), ttl(ttlMs)
+{
+}
+
+void StatisticsCache::attach(ClientDAO* dao)
+{
+    // Client count and the top client's name are part of the snapshot
+    connect(dao, &ClientDAO::clientCreated, this, &StatisticsCache::invalidate);
+    connect(dao, &ClientDAO::clientUpdated, this, &StatisticsCache::invalidate);
+    connect(dao, &ClientDAO::clientDeleted, this, &StatisticsCache::invalidate);
+}
+
+void StatisticsCache::attach(CommandDAO* dao)
+{
+    connect(dao, &CommandDAO::commandCreated, this, &StatisticsCache::invalidate);
+    connect(dao, &CommandDAO::commandUpdated, this, &StatisticsCache::invalidate);
+    connect(dao, &CommandDAO::commandDeleted, this, &StatisticsCache::invalidate);
+}
+
+void StatisticsCache::attach(WriteBehindQueue* queue)
+{
+    connect(queue, &WriteBehindQueue::clientCommitted, this, &StatisticsCache::invalidate);
+    connect(queue, &WriteBehindQueue::commandCommitted, this, &StatisticsCache::invalidate);
+}
+
+CommandStatistics::Statistics StatisticsCache::snapshot()
+{
+    if (!isFresh()) {
+        QElapsedTimer timer;
+        timer.start();
+        CommandStatistics::Statistics fresh = statistics->getOverallStatistics();
+        if (!fresh.valid) {
+            // Keep the last good figures and try again on the next call
+            qDebug() << "Statistics snapshot refresh failed after" << timer.elapsed() << "ms";
+            return cached;
+        }
+        cached = fresh;
+        age.start();
+        qDebug() << "Statistics snapshot refreshed in" << timer.elapsed() << "ms";
+    }
+    return cached;
+}
+
+void StatisticsCache::prime(const CommandStatistics::Statistics& stats)
+{
+    cached = stats;
+    age.start();
+}
+
+bool StatisticsCache::isFresh() const
+{
+    return age.isValid() && age.elapsed() < ttl;
+}
+
+void StatisticsCache::invalidate()
+{
+    age.invalidate();
+}
@@ -0,0 +1,52 @@
+// statisticscache.h
+#ifndef STATISTICSCACHE_H
+#define STATISTICSCACHE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+
+#include "clients.h"
+#include "commands.h"
+
+class WriteBehindQueue;
+
+// Shared snapshot of CommandStatistics::getOverallStatistics().
+//
+// The snapshot is fetched with one query and reused until it is older than
+// the TTL, so the dashboard cards, the sales report and the chatbot can all
+// ask for statistics without touching the database again. Writes seen
+// through the DAO and write-behind queue signals drop the snapshot early;
+// the TTL bounds how stale it gets after writes made elsewhere.
+class StatisticsCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit StatisticsCache(CommandDAO* dao, int ttlMs = 60 * 1000, QObject *parent = nullptr);
+
+    void attach(ClientDAO* dao);
+    void attach(CommandDAO* dao);
+    void attach(WriteBehindQueue* queue);
+
+    void setTtl(int ttlMs) { ttl = ttlMs; }
+    int ttlMs() const { return ttl; }
+
+    // Cached snapshot, refreshed first when missing or expired
+    CommandStatistics::Statistics snapshot();
+    bool isFresh() const;
+
+    // Seed with figures computed elsewhere, e.g. the saved snapshot;
+    // they count as fresh for one TTL
+    void prime(const CommandStatistics::Statistics& stats);
+
+public slots:
+    void invalidate();
+
+private:
+    CommandStatistics *statistics;
+    CommandStatistics::Statistics cached;
+    QElapsedTimer age;      // Invalid until the first refresh
+    int ttl;
+};
+
+#endif // STATISTICSCACHE_H
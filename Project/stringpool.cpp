@@ -0,0 +1,94 @@
+// stringpool.cpp
+#include "stringpool.h"
+#include <QtGlobal>
+#include <algorithm>
+
+StringDictionary::StringDictionary()
+{
+    clear();
+}
+
+void StringDictionary::clear()
+{
+    values.clear();
+    codes.clear();
+    values.append(QString());
+    codes.insert(QString(), 0);
+}
+
+quint32 StringDictionary::intern(const QString& text)
+{
+    auto it = codes.constFind(text);
+    if (it != codes.constEnd()) {
+        return it.value();
+    }
+
+    quint32 newCode = quint32(values.size());
+    values.append(text);
+    codes.insert(text, newCode);
+    return newCode;
+}
+
+quint32 StringDictionary::code(const QString& text) const
+{
+    return codes.value(text, NotFound);
+}
+
+qint64 StringDictionary::memoryUsage() const
+{
+    // Each value is held twice by reference (list and hash) but its text once
+    qint64 bytes = values.capacity() * qint64(sizeof(QString)) + codes.capacity() * qint64(sizeof(QString) + 8);
+    for (const QString& value : values) {
+        bytes += value.capacity() * 2;
+    }
+    return bytes;
+}
+
+void TextArena::clear()
+{
+    blocks.clear();
+    used = 0;
+    wasted = 0;
+}
+
+TextArena::Ref TextArena::add(QStringView text)
+{
+    Ref ref;
+    if (text.isEmpty()) {
+        return ref;
+    }
+
+    quint32 length = quint32(text.size());
+    if (blocks.isEmpty() || blocks.last().size() + qsizetype(length) > qsizetype(BlockChars)) {
+        Q_ASSERT(blocks.size() < MaxBlocks);
+        blocks.append(QVector<char16_t>());
+        blocks.last().reserve(qMax(BlockChars, length));
+    }
+
+    QVector<char16_t>& block = blocks.last();
+    ref.location = (quint32(blocks.size() - 1) << OffsetBits) | quint32(block.size());
+    ref.length = length;
+    qsizetype start = block.size();
+    block.resize(start + qsizetype(length));     // Within the reserved capacity
+    std::copy_n(reinterpret_cast<const char16_t*>(text.utf16()), length, block.data() + start);
+    used += length;
+    return ref;
+}
+
+QStringView TextArena::view(Ref ref) const
+{
+    if (ref.length == 0) {
+        return QStringView();
+    }
+    const QVector<char16_t>& block = blocks.at(int(ref.location >> OffsetBits));
+    return QStringView(block.constData() + (ref.location & (BlockChars - 1)), qsizetype(ref.length));
+}
+
+qint64 TextArena::memoryUsage() const
+{
+    qint64 bytes = blocks.capacity() * qint64(sizeof(QVector<char16_t>));
+    for (const QVector<char16_t>& block : blocks) {
+        bytes += block.capacity() * 2;
+    }
+    return bytes;
+}
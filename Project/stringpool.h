@@ -0,0 +1,69 @@
+// stringpool.h
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <QString>
+#include <QStringView>
+#include <QVector>
+#include <QHash>
+
+// Interned strings for low-cardinality columns (city, postal code,
+// payment method). Each distinct value is stored once and rows keep its
+// 32-bit code. Code 0 is the empty string. Codes are never reused, so the
+// dictionary only grows.
+class StringDictionary
+{
+public:
+    static const quint32 NotFound = 0xffffffffu;
+
+    StringDictionary();
+
+    void clear();
+    quint32 intern(const QString& text);
+    quint32 code(const QString& text) const;
+    const QString& value(quint32 code) const { return values.at(int(code)); }
+
+    int size() const { return values.size(); }
+    qint64 memoryUsage() const;
+
+private:
+    QVector<QString> values;
+    QHash<QString, quint32> codes;
+};
+
+// Append-only UTF-16 storage for longer text (names, emails, addresses).
+//
+// Text is copied into 1M-character blocks and addressed by a Ref: 12 bits
+// of block number and 20 bits of offset, plus the length. Text longer than
+// a block gets a block of its own. Nothing is freed in place: release()
+// only counts the characters as wasted, and the owner rebuilds the arena
+// when too much of it is dead.
+class TextArena
+{
+public:
+    struct Ref {
+        quint32 location = 0;
+        quint32 length = 0;
+    };
+
+    void clear();
+    Ref add(QStringView text);
+    QStringView view(Ref ref) const;
+    QString text(Ref ref) const { return view(ref).toString(); }
+    void release(Ref ref) { wasted += ref.length; }
+
+    qint64 usedChars() const { return used; }
+    qint64 wastedChars() const { return wasted; }
+    qint64 memoryUsage() const;
+
+private:
+    static const int OffsetBits = 20;
+    static const quint32 BlockChars = 1u << OffsetBits;
+    static const int MaxBlocks = 1 << (32 - OffsetBits);
+
+    QVector<QVector<char16_t>> blocks;
+    qint64 used = 0;
+    qint64 wasted = 0;
+};
+
+#endif // STRINGPOOL_H
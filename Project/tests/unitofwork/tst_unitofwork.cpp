@@ -0,0 +1,122 @@
+// tst_unitofwork.cpp
+//
+// A unit of work whose transaction cannot begin must not let its DAO
+// writes run in autocommit. SQLite refuses a nested BEGIN, so opening a
+// transaction by hand first makes db.transaction() fail; the test then
+// counts the rows the connection itself can see, committed or not.
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+
+#include "connection.h"
+#include "schemamigrator.h"
+#include "querycache.h"
+#include "unitofwork.h"
+#include "clients.h"
+
+class UnitOfWorkTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+
+    void commitsAllWrites();
+    void failedBeginWritesNothing();
+    void failedBeginFailsImport();
+
+private:
+    QTemporaryDir workDir;
+
+    static int clientCount();
+    static bool execRaw(const QString& sql);
+    static QList<Client> someClients();
+};
+
+void UnitOfWorkTest::initTestCase()
+{
+    QVERIFY2(QSqlDatabase::isDriverAvailable("QSQLITE"), "QSQLITE driver not available");
+    QVERIFY(workDir.isValid());
+
+    Connection& conn = Connection::getInstance();
+    QVERIFY(conn.openDatabase("QSQLITE", workDir.filePath("unitofwork.sqlite")));
+
+    SchemaMigrator migrator(conn.getDatabase());
+    QVERIFY2(migrator.migrate(), qPrintable(migrator.report()));
+}
+
+void UnitOfWorkTest::cleanupTestCase()
+{
+    Connection::getInstance().closeConnection();
+}
+
+void UnitOfWorkTest::init()
+{
+    QVERIFY(execRaw("DELETE FROM CLIENTS"));
+    QueryCache::instance().clear();
+}
+
+void UnitOfWorkTest::commitsAllWrites()
+{
+    ClientManager manager;
+    QVERIFY(manager.addNewClients(someClients()));
+    QCOMPARE(clientCount(), 2);
+}
+
+void UnitOfWorkTest::failedBeginWritesNothing()
+{
+    QVERIFY(execRaw("BEGIN"));
+    {
+        ClientDAO dao;
+        UnitOfWork unitOfWork;
+        QVERIFY(unitOfWork.hasFailed());
+        QVERIFY(!dao.createClient(someClients().first()));
+        QCOMPARE(clientCount(), 0);
+        QVERIFY(!unitOfWork.commit());
+    }
+    // The unit must leave the transaction it did not open alone
+    QCOMPARE(clientCount(), 0);
+    QVERIFY(execRaw("ROLLBACK"));
+}
+
+void UnitOfWorkTest::failedBeginFailsImport()
+{
+    QVERIFY(execRaw("BEGIN"));
+    ClientManager manager;
+    QVERIFY(!manager.addNewClients(someClients()));
+    QCOMPARE(clientCount(), 0);
+    QVERIFY(execRaw("ROLLBACK"));
+}
+
+int UnitOfWorkTest::clientCount()
+{
+    QSqlQuery query(Connection::getInstance().getDatabase());
+    if (!query.exec("SELECT COUNT(*) FROM CLIENTS") || !query.next()) {
+        qWarning() << "Count failed:" << query.lastError().text();
+        return -1;
+    }
+    return query.value(0).toInt();
+}
+
+bool UnitOfWorkTest::execRaw(const QString& sql)
+{
+    QSqlQuery query(Connection::getInstance().getDatabase());
+    if (!query.exec(sql)) {
+        qWarning() << sql << "failed:" << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+QList<Client> UnitOfWorkTest::someClients()
+{
+    return {Client("Amira Ben Salah", "amira@example.com", "Tunis", "1000", "1 Rue du Lac"),
+            Client("Karim Trabelsi", "karim@example.com", "Sfax", "3000", "12 Avenue Habib Bourguiba")};
+}
+
+QTEST_GUILESS_MAIN(UnitOfWorkTest)
+#include "tst_unitofwork.moc"
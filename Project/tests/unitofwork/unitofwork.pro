@@ -0,0 +1,20 @@
+# unitofwork.pro - UnitOfWork and DAO transaction tests on a SQLite stand-in
+#
+# Built with the rest of Project.pro (it links the data layer library);
+# run ./tst_unitofwork or make check from its build directory.
+
+QT = core sql concurrent testlib
+
+CONFIG += c++17 console testcase exceptions
+CONFIG -= app_bundle
+
+TARGET = tst_unitofwork
+TEMPLATE = app
+
+include(../../datalayer.pri)
+
+SOURCES += \
+    tst_unitofwork.cpp
+
+OBJECTS_DIR = build/obj
+MOC_DIR = build/moc
@@ -0,0 +1,27 @@
+# loadgen.pro - open-loop load generator for the manager layer
+#
+# Built with the rest of Project.pro (it links the data layer library):
+#   ./loadgen --backend sqlite:load.db --seed-clients 10000 --seed-orders 100000 \
+#             --threads 8 --rate 500 --duration 120 --output load.json
+#
+# Run ./loadgen --help for the operation mix and the other options.
+
+QT = core sql concurrent
+
+CONFIG += c++17 console exceptions
+CONFIG -= app_bundle
+
+TARGET = loadgen
+TEMPLATE = app
+
+include(../../datalayer.pri)
+
+SOURCES += \
+    main.cpp \
+    loadgenerator.cpp
+
+HEADERS += \
+    loadgenerator.h
+
+OBJECTS_DIR = build/obj
+MOC_DIR = build/moc
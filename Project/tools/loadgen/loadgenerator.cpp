@@ -0,0 +1,504 @@
+// loadgenerator.cpp
+#include "loadgenerator.h"
+#include "connection.h"
+#include "clients.h"
+#include "commands.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QTextStream>
+#include <QDateTime>
+#include <QCoreApplication>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const char *const SearchFragments[] = {"ar", "el", "on", "ma", "in", "ou", "le", "ra"};
+const char *const Cities[] = {"Tunis", "Sfax", "Sousse", "Bizerte", "Gabes", "Nabeul"};
+const char *const PaymentMethods[] = {"Cash", "Credit Card", "Debit Card", "PayPal",
+                                      "Bank Transfer", "Check", "Mobile Payment"};
+
+template <typename T, int N>
+const T& pick(const T (&items)[N], QRandomGenerator& rng)
+{
+    return items[rng.bounded(N)];
+}
+
+double percentileMs(const QVector<qint64>& sorted, double p)
+{
+    if (sorted.isEmpty()) {
+        return 0.0;
+    }
+    int index = qBound(0, int(std::ceil(p * sorted.size())) - 1, int(sorted.size()) - 1);
+    return sorted.at(index) / 1e6;
+}
+
+QJsonObject latencyJson(QVector<qint64> latencies)
+{
+    std::sort(latencies.begin(), latencies.end());
+    QJsonObject json;
+    json["p50Ms"] = percentileMs(latencies, 0.50);
+    json["p90Ms"] = percentileMs(latencies, 0.90);
+    json["p99Ms"] = percentileMs(latencies, 0.99);
+    json["maxMs"] = latencies.isEmpty() ? 0.0 : latencies.last() / 1e6;
+    return json;
+}
+
+} // namespace
+
+LoadGenerator::LoadGenerator(const Config& cfg, QObject *parent)
+    : QObject(parent)
+    , config(cfg)
+    , stopping(false)
+    , reportTimer(new QTimer(this))
+    , windowStartNs(0)
+    , insertCounter(0)
+    , runTag(QString::number(QDateTime::currentMSecsSinceEpoch(), 36))
+{
+    connect(reportTimer, &QTimer::timeout, this, &LoadGenerator::closeWindow);
+}
+
+LoadGenerator::~LoadGenerator()
+{
+    stopping = true;
+    queueNotEmpty.wakeAll();
+    for (QThread *thread : threads) {
+        thread->wait();
+        delete thread;
+    }
+}
+
+QString LoadGenerator::operationName(Operation op)
+{
+    switch (op) {
+    case Read:   return "read";
+    case Search: return "search";
+    case Insert: return "insert";
+    case Update: return "update";
+    case Stats:  return "stats";
+    default:     return QString();
+    }
+}
+
+bool LoadGenerator::parseMix(const QString& text, double *mix, QString& error)
+{
+    double weights[OperationCount] = {};
+    for (const QString& part : text.split(',', Qt::SkipEmptyParts)) {
+        QStringList pair = part.split('=');
+        bool ok = false;
+        double weight = pair.size() == 2 ? pair.at(1).trimmed().toDouble(&ok) : 0.0;
+        int op = 0;
+        while (op < OperationCount && operationName(Operation(op)) != pair.at(0).trimmed().toLower()) {
+            ++op;
+        }
+        if (!ok || weight < 0 || op == OperationCount) {
+            error = "Bad mix entry: " + part;
+            return false;
+        }
+        weights[op] = weight;
+    }
+
+    double sum = 0;
+    for (double weight : weights) {
+        sum += weight;
+    }
+    if (sum <= 0) {
+        error = "The mix has no weight";
+        return false;
+    }
+    std::copy(weights, weights + OperationCount, mix);
+    return true;
+}
+
+bool LoadGenerator::seed(int clients, int orders, QString& error)
+{
+    QSqlDatabase db = Connection::getInstance().getDataDatabase();
+    auto count = [&db](const QString& table) {
+        QSqlQuery query(db);
+        return query.exec("SELECT COUNT(*) FROM " + table) && query.next() ? query.value(0).toInt() : -1;
+    };
+
+    QRandomGenerator rng(7);
+    int existing = count("CLIENTS");
+    if (existing < 0) {
+        error = "Cannot count CLIENTS";
+        return false;
+    }
+    ClientManager clientManager;
+    QObject::connect(&clientManager, &ClientManager::validationError, [&error](const QString& message) {
+        error = message;
+    });
+    for (int next = existing; next < clients;) {
+        QList<Client> batch;
+        for (; next < clients && batch.size() < 500; ++next) {
+            batch.append(Client(QString("Seed Client %1").arg(next + 1), QString("seed%1@example.com").arg(next + 1),
+                                pick(Cities, rng), QString::number(1000 + rng.bounded(9000)),
+                                QString("%1 Rue de Marseille").arg(next % 200 + 1)));
+        }
+        if (!clientManager.addNewClients(batch)) {
+            return false;
+        }
+    }
+
+    QVector<int> ids;
+    QSqlQuery idQuery(db);
+    idQuery.setForwardOnly(true);
+    if (!idQuery.exec("SELECT ID FROM CLIENTS")) {
+        error = idQuery.lastError().text();
+        return false;
+    }
+    while (idQuery.next()) {
+        ids.append(idQuery.value(0).toInt());
+    }
+
+    existing = count("COMMANDS");
+    if (existing < 0) {
+        error = "Cannot count COMMANDS";
+        return false;
+    }
+    CommandManager commandManager;
+    QObject::connect(&commandManager, &CommandManager::validationError, [&error](const QString& message) {
+        error = message;
+    });
+    for (int next = existing; next < orders && !ids.isEmpty();) {
+        QList<Command> batch;
+        for (; next < orders && batch.size() < 500; ++next) {
+            batch.append(Command(ids.at(rng.bounded(int(ids.size()))), Money::fromCents(100 + rng.bounded(200000)),
+                                 pick(PaymentMethods, rng), "Seed delivery address"));
+        }
+        if (!commandManager.addNewCommands(batch)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LoadGenerator::prepare(QString& error)
+{
+    QSqlDatabase db = Connection::getInstance().getDataDatabase();
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+
+    if (!query.exec("SELECT ID FROM CLIENTS")) {
+        error = query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        clientIds.append(query.value(0).toInt());
+    }
+
+    if (!query.exec("SELECT COMMAND_ID FROM COMMANDS")) {
+        error = query.lastError().text();
+        return false;
+    }
+    while (query.next()) {
+        commandIds.append(query.value(0).toInt());
+    }
+
+    if (clientIds.isEmpty()) {
+        error = "No clients to run against; seed some first";
+        return false;
+    }
+    return true;
+}
+
+void LoadGenerator::start()
+{
+    clock.start();
+    windowStartNs = 0;
+
+    for (int i = 0; i < config.threads; ++i) {
+        threads.append(QThread::create([this, i]() { work(i); }));
+    }
+    threads.append(QThread::create([this]() { dispatch(); }));
+    for (QThread *thread : threads) {
+        thread->start();
+    }
+
+    reportTimer->start(config.reportSecs * 1000);
+    QTimer::singleShot(config.durationSecs * 1000, this, &LoadGenerator::stop);
+}
+
+void LoadGenerator::stop()
+{
+    stopping = true;
+    queueNotEmpty.wakeAll();
+    for (QThread *thread : threads) {
+        thread->wait();
+    }
+    reportTimer->stop();
+    closeWindow();
+    emit finished();
+}
+
+void LoadGenerator::dispatch()
+{
+    QRandomGenerator rng(QRandomGenerator::global()->generate());
+    double weightSum = 0;
+    for (double weight : config.mix) {
+        weightSum += weight;
+    }
+
+    const double intervalNs = 1e9 / config.rate;
+    const qint64 endNs = qint64(config.durationSecs) * 1000000000LL;
+    double nextNs = 0;
+
+    while (!stopping) {
+        // Exponential gaps give Poisson arrivals
+        nextNs += config.poisson ? -std::log(1.0 - rng.generateDouble()) * intervalNs : intervalNs;
+        if (nextNs >= endNs) {
+            break;
+        }
+        qint64 waitNs = qint64(nextNs) - clock.nsecsElapsed();
+        if (waitNs > 200000) {
+            QThread::usleep(quint64(waitNs / 1000));
+        }
+
+        double draw = rng.generateDouble() * weightSum;
+        int op = 0;
+        while (op < OperationCount - 1 && draw >= config.mix[op]) {
+            draw -= config.mix[op];
+            ++op;
+        }
+
+        bool dropped = false;
+        {
+            QMutexLocker locker(&queueMutex);
+            if (backlog.size() >= config.maxBacklog) {
+                dropped = true;
+            } else {
+                backlog.enqueue({Operation(op), qint64(nextNs)});
+                queueNotEmpty.wakeOne();
+            }
+        }
+
+        QMutexLocker locker(&statsMutex);
+        window.arrivals++;
+        if (dropped) {
+            window.dropped++;
+        }
+    }
+}
+
+void LoadGenerator::work(int index)
+{
+    // Managers made here use this thread's connection clone
+    ClientManager clients;
+    CommandManager commands;
+    int failures = 0;
+    connect(&clients, &ClientManager::validationError, [&failures]() { ++failures; });
+    connect(&commands, &CommandManager::validationError, [&failures]() { ++failures; });
+    QRandomGenerator rng(QRandomGenerator::global()->generate() + quint32(index));
+
+    while (true) {
+        Arrival arrival;
+        {
+            QMutexLocker locker(&queueMutex);
+            while (backlog.isEmpty() && !stopping) {
+                queueNotEmpty.wait(&queueMutex, 100);
+            }
+            if (stopping) {
+                break;
+            }
+            arrival = backlog.dequeue();
+        }
+
+        int failuresBefore = failures;
+        bool ok = execute(arrival.op, clients, commands, rng) && failures == failuresBefore;
+        record(arrival.op, clock.nsecsElapsed() - arrival.dueNs, ok);
+    }
+
+    Connection::getInstance().releaseThreadDatabase();
+}
+
+bool LoadGenerator::execute(Operation op, ClientManager& clients, CommandManager& commands, QRandomGenerator& rng)
+{
+    bool onClients = rng.bounded(2) == 0;
+
+    switch (op) {
+    case Read:
+        if (onClients) {
+            int id = pickId(clientIds, rng);
+            return clients.getClient(id).id == id;
+        } else {
+            int id = pickId(commandIds, rng);
+            return id > 0 && commands.getCommand(id).commandId == id;
+        }
+
+    case Search:
+        if (onClients) {
+            clients.getDAO()->searchClientsByName(pick(SearchFragments, rng));
+        } else {
+            commands.getRecentCommands(7);
+        }
+        return true;
+
+    case Insert: {
+        int id = 0;
+        int n = ++insertCounter;
+        if (rng.bounded(10) < 3) {
+            Client client(QString("Load Client %1").arg(n), QString("load.%1.%2@example.com").arg(runTag).arg(n),
+                          pick(Cities, rng), "1000", "Load test street");
+            if (!clients.addNewClient(client, &id)) {
+                return false;
+            }
+            addId(clientIds, id);
+        } else {
+            Command command(pickId(clientIds, rng), Money::fromCents(100 + rng.bounded(100000)),
+                            pick(PaymentMethods, rng), "Load test delivery address");
+            if (!commands.addNewCommand(command, &id)) {
+                return false;
+            }
+            addId(commandIds, id);
+        }
+        return true;
+    }
+
+    case Update:
+        if (onClients || commandIds.isEmpty()) {
+            Client client = clients.getClient(pickId(clientIds, rng));
+            if (client.id <= 0) {
+                return false;
+            }
+            client.city = pick(Cities, rng);
+            return clients.modifyClient(client);
+        } else {
+            Command command = commands.getCommand(pickId(commandIds, rng));
+            if (command.commandId <= 0) {
+                return false;
+            }
+            command.total = Money::fromCents(100 + rng.bounded(100000));
+            return commands.modifyCommand(command);
+        }
+
+    case Stats:
+        if (onClients) {
+            CommandStatistics(commands.getDAO()).getOverallStatistics();
+        } else {
+            commands.getTopCommands(10);
+        }
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+int LoadGenerator::pickId(const QVector<int>& ids, QRandomGenerator& rng)
+{
+    QReadLocker locker(&idsLock);
+    return ids.isEmpty() ? 0 : ids.at(rng.bounded(int(ids.size())));
+}
+
+void LoadGenerator::addId(QVector<int>& ids, int id)
+{
+    QWriteLocker locker(&idsLock);
+    ids.append(id);
+}
+
+void LoadGenerator::record(Operation op, qint64 latencyNs, bool ok)
+{
+    QMutexLocker locker(&statsMutex);
+    window.completed[op]++;
+    if (!ok) {
+        window.errors[op]++;
+    }
+    window.latenciesNs[op].append(latencyNs);
+}
+
+void LoadGenerator::closeWindow()
+{
+    qint64 nowNs = clock.nsecsElapsed();
+    int waiting;
+    {
+        QMutexLocker locker(&queueMutex);
+        waiting = backlog.size();
+    }
+
+    QMutexLocker locker(&statsMutex);
+    double seconds = qMax(1e-9, (nowNs - windowStartNs) / 1e9);
+    QJsonObject json = window.toJson(seconds);
+    json["t"] = nowNs / 1e9;
+    json["backlog"] = waiting;
+    windows.append(json);
+
+    QJsonObject latency = json["latency"].toObject();
+    QTextStream(stdout) << QString("t=%1s  offered %2/s  achieved %3/s  p50 %4 ms  p99 %5 ms  errors %6  "
+                                   "dropped %7  backlog %8\n")
+                               .arg(nowNs / 1e9, 6, 'f', 1)
+                               .arg(json["offeredPerSec"].toDouble(), 0, 'f', 1)
+                               .arg(json["throughputPerSec"].toDouble(), 0, 'f', 1)
+                               .arg(latency["p50Ms"].toDouble(), 0, 'f', 2)
+                               .arg(latency["p99Ms"].toDouble(), 0, 'f', 2)
+                               .arg(json["errors"].toInt())
+                               .arg(json["dropped"].toInt())
+                               .arg(waiting);
+
+    total.merge(window);
+    window = Counters();
+    windowStartNs = nowNs;
+}
+
+QJsonObject LoadGenerator::report() const
+{
+    QJsonObject configJson;
+    configJson["threads"] = config.threads;
+    configJson["rate"] = config.rate;
+    configJson["arrivals"] = config.poisson ? "poisson" : "uniform";
+    configJson["durationSecs"] = config.durationSecs;
+    configJson["maxBacklog"] = config.maxBacklog;
+    QJsonObject mix;
+    for (int op = 0; op < OperationCount; ++op) {
+        mix[operationName(Operation(op))] = config.mix[op];
+    }
+    configJson["mix"] = mix;
+
+    QMutexLocker locker(&statsMutex);
+    QJsonObject json;
+    json["config"] = configJson;
+    json["windows"] = windows;
+    json["total"] = total.toJson(qMax(1e-9, clock.nsecsElapsed() / 1e9));
+    return json;
+}
+
+void LoadGenerator::Counters::merge(const Counters& other)
+{
+    arrivals += other.arrivals;
+    dropped += other.dropped;
+    for (int op = 0; op < OperationCount; ++op) {
+        completed[op] += other.completed[op];
+        errors[op] += other.errors[op];
+        latenciesNs[op] += other.latenciesNs[op];
+    }
+}
+
+QJsonObject LoadGenerator::Counters::toJson(double seconds) const
+{
+    qint64 allCompleted = 0;
+    qint64 allErrors = 0;
+    QVector<qint64> allLatencies;
+    QJsonObject operations;
+    for (int op = 0; op < OperationCount; ++op) {
+        allCompleted += completed[op];
+        allErrors += errors[op];
+        allLatencies += latenciesNs[op];
+
+        QJsonObject entry;
+        entry["completed"] = completed[op];
+        entry["errors"] = errors[op];
+        entry["latency"] = latencyJson(latenciesNs[op]);
+        operations[operationName(Operation(op))] = entry;
+    }
+
+    QJsonObject json;
+    json["seconds"] = seconds;
+    json["arrivals"] = arrivals;
+    json["dropped"] = dropped;
+    json["completed"] = allCompleted;
+    json["errors"] = allErrors;
+    json["offeredPerSec"] = arrivals / seconds;
+    json["throughputPerSec"] = allCompleted / seconds;
+    json["latency"] = latencyJson(allLatencies);
+    json["operations"] = operations;
+    return json;
+}
@@ -0,0 +1,123 @@
+// loadgenerator.h
+#ifndef LOADGENERATOR_H
+#define LOADGENERATOR_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QReadWriteLock>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QTimer>
+#include <QThread>
+#include <QRandomGenerator>
+#include <atomic>
+
+class ClientManager;
+class CommandManager;
+
+// Open-loop load against ClientManager and CommandManager.
+//
+// A dispatcher thread schedules arrivals at the configured rate (Poisson or
+// evenly spaced) whether or not earlier requests have finished, and queues
+// them for N worker threads. Each worker has its own managers and thus its
+// own database connection clone. Latency runs from the arrival's scheduled
+// time to completion, so time spent waiting in the backlog counts: when
+// the backend falls behind, latency grows instead of the offered rate
+// quietly dropping. Arrivals beyond maxBacklog are dropped and counted.
+//
+// Every reportSecs a line goes to stdout with the achieved throughput,
+// latency percentiles and errors for that window; report() returns the
+// windows and the whole-run totals as JSON.
+class LoadGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Operation { Read, Search, Insert, Update, Stats, OperationCount };
+
+    struct Config {
+        int threads = 4;
+        double rate = 100.0;        // Arrivals per second, all workers together
+        bool poisson = true;
+        int durationSecs = 60;
+        int reportSecs = 5;
+        int maxBacklog = 100000;
+        double mix[OperationCount] = {50, 20, 10, 10, 10};
+    };
+
+    explicit LoadGenerator(const Config& config, QObject *parent = nullptr);
+    ~LoadGenerator();
+
+    // Make sure there is data to read, then load the ids to pick from
+    static bool seed(int clients, int orders, QString& error);
+    bool prepare(QString& error);
+
+    void start();
+    QJsonObject report() const;
+
+    static QString operationName(Operation op);
+    // "read=50,search=20,insert=10,update=10,stats=10"
+    static bool parseMix(const QString& text, double *mix, QString& error);
+
+signals:
+    void finished();
+
+private:
+    struct Arrival {
+        Operation op;
+        qint64 dueNs;
+    };
+
+    struct Counters {
+        qint64 arrivals = 0;
+        qint64 dropped = 0;
+        qint64 completed[OperationCount] = {};
+        qint64 errors[OperationCount] = {};
+        QVector<qint64> latenciesNs[OperationCount];
+
+        void merge(const Counters& other);
+        QJsonObject toJson(double seconds) const;
+    };
+
+    Config config;
+    QElapsedTimer clock;
+    std::atomic<bool> stopping;
+    QList<QThread*> threads;
+    QTimer *reportTimer;
+
+    // Arrivals waiting for a worker
+    QMutex queueMutex;
+    QWaitCondition queueNotEmpty;
+    QQueue<Arrival> backlog;
+
+    // Current window, and everything since start
+    mutable QMutex statsMutex;
+    Counters window;
+    Counters total;
+    QJsonArray windows;
+    qint64 windowStartNs;
+
+    // Rows the workers pick from; inserts add to them
+    QReadWriteLock idsLock;
+    QVector<int> clientIds;
+    QVector<int> commandIds;
+    std::atomic<int> insertCounter;
+    QString runTag;
+
+    void dispatch();
+    void work(int index);
+    bool execute(Operation op, ClientManager& clients, CommandManager& commands, QRandomGenerator& rng);
+    int pickId(const QVector<int>& ids, QRandomGenerator& rng);
+    void addId(QVector<int>& ids, int id);
+    void record(Operation op, qint64 latencyNs, bool ok);
+    void closeWindow();
+    void stop();
+};
+
+#endif // LOADGENERATOR_H
@@ -0,0 +1,137 @@
+// main.cpp - command-line driver for LoadGenerator
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+
+#include "loadgenerator.h"
+#include "connection.h"
+#include "schemamigrator.h"
+#include "querycache.h"
+
+static int fail(const QString& message)
+{
+    QTextStream(stderr) << "loadgen: " << message << "\n";
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("loadgen");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Open-loop load against the client and order managers");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"backend", "sqlite:<file> or oracle (default sqlite:loadgen.db).", "backend", "sqlite:loadgen.db"},
+        {"threads", "Worker threads (default 4).", "n", "4"},
+        {"rate", "Arrivals per second across all workers (default 100).", "per-second", "100"},
+        {"uniform", "Evenly spaced arrivals instead of Poisson."},
+        {"duration", "Run time in seconds (default 60).", "seconds", "60"},
+        {"interval", "Report window in seconds (default 5).", "seconds", "5"},
+        {"mix", "Operation weights (default read=50,search=20,insert=10,update=10,stats=10).", "mix",
+         "read=50,search=20,insert=10,update=10,stats=10"},
+        {"seed-clients", "Top the client table up to this many rows first.", "n", "0"},
+        {"seed-orders", "Top the order table up to this many rows first.", "n", "0"},
+        {"no-cache", "Turn the query cache off so every read reaches the database."},
+        {"output", "Write the full report as JSON to this file.", "file"},
+    });
+    parser.process(app);
+
+    LoadGenerator::Config config;
+    config.threads = qMax(1, parser.value("threads").toInt());
+    config.rate = parser.value("rate").toDouble();
+    config.poisson = !parser.isSet("uniform");
+    config.durationSecs = qMax(1, parser.value("duration").toInt());
+    config.reportSecs = qMax(1, parser.value("interval").toInt());
+    if (config.rate <= 0) {
+        return fail("--rate must be positive");
+    }
+
+    QString error;
+    if (!LoadGenerator::parseMix(parser.value("mix"), config.mix, error)) {
+        return fail(error);
+    }
+
+    Connection& conn = Connection::getInstance();
+    QString backend = parser.value("backend");
+    if (backend.startsWith("sqlite:")) {
+        if (!conn.openDatabase("QSQLITE", backend.mid(7))) {
+            return fail(conn.lastError());
+        }
+    } else if (backend == "oracle") {
+        if (!conn.createConnection()) {
+            return fail(conn.lastError());
+        }
+    } else {
+        return fail("Unknown backend " + backend);
+    }
+
+    SchemaMigrator migrator(conn.getDatabase());
+    if (!migrator.migrate()) {
+        return fail("Schema migration failed:\n" + migrator.report());
+    }
+
+    if (parser.isSet("no-cache")) {
+        QueryCache::instance().setBudget(0);
+    }
+
+    if (!LoadGenerator::seed(parser.value("seed-clients").toInt(), parser.value("seed-orders").toInt(), error)) {
+        return fail("Seeding failed: " + error);
+    }
+
+    LoadGenerator generator(config);
+    if (!generator.prepare(error)) {
+        return fail(error);
+    }
+
+    QObject::connect(&generator, &LoadGenerator::finished, &app, [&]() {
+        QJsonObject report = generator.report();
+        QJsonObject total = report["total"].toObject();
+        QJsonObject latency = total["latency"].toObject();
+        QJsonArray windows = report["windows"].toArray();
+        int unserved = windows.isEmpty() ? 0 : windows.last().toObject()["backlog"].toInt();
+
+        QTextStream out(stdout);
+        out << QString("\n%1 arrivals, %2 completed (%3/s), %4 errors, %5 dropped, %6 unserved\n")
+                   .arg(total["arrivals"].toInt())
+                   .arg(total["completed"].toInt())
+                   .arg(total["throughputPerSec"].toDouble(), 0, 'f', 1)
+                   .arg(total["errors"].toInt())
+                   .arg(total["dropped"].toInt())
+                   .arg(unserved);
+        out << QString("latency p50 %1 ms  p90 %2 ms  p99 %3 ms  max %4 ms\n")
+                   .arg(latency["p50Ms"].toDouble(), 0, 'f', 2)
+                   .arg(latency["p90Ms"].toDouble(), 0, 'f', 2)
+                   .arg(latency["p99Ms"].toDouble(), 0, 'f', 2)
+                   .arg(latency["maxMs"].toDouble(), 0, 'f', 2);
+
+        QJsonObject operations = total["operations"].toObject();
+        for (int op = 0; op < LoadGenerator::OperationCount; ++op) {
+            QString name = LoadGenerator::operationName(LoadGenerator::Operation(op));
+            QJsonObject entry = operations[name].toObject();
+            out << QString("  %1 %2 done, %3 errors, p99 %4 ms\n")
+                       .arg(name, -7)
+                       .arg(entry["completed"].toInt(), 8)
+                       .arg(entry["errors"].toInt())
+                       .arg(entry["latency"].toObject()["p99Ms"].toDouble(), 0, 'f', 2);
+        }
+
+        if (parser.isSet("output")) {
+            QFile file(parser.value("output"));
+            if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                file.write(QJsonDocument(report).toJson());
+            } else {
+                qDebug() << "Cannot write report to" << file.fileName();
+            }
+        }
+        app.quit();
+    });
+
+    generator.start();
+    return app.exec();
+}
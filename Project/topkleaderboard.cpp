@@ -0,0 +1,345 @@
+// topkleaderboard.cpp
+#include "topkleaderboard.h"
+#include "writebehindqueue.h"
+#include "connection.h"
+#include "localreplica.h"
+#include "trace.h"
+#include <QSqlQuery>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <queue>
+
+TopKLeaderboard::TopKLeaderboard(QObject *parent)
+    : QObject(parent), rebuildTimer(nullptr), ready(false)
+{
+    connect(&rebuildWatcher, &QFutureWatcher<OrderRows>::finished, this, &TopKLeaderboard::onRebuildFinished);
+}
+
+void TopKLeaderboard::rebuild(const QList<Command>& commands)
+{
+    QHash<int, Order> orderRows;
+    orderRows.reserve(commands.size());
+    for (const Command& command : commands) {
+        orderRows.insert(command.commandId, {command.clientId, command.total.toCents()});
+    }
+    loadBoards(orderRows);
+}
+
+void TopKLeaderboard::rebuildFromDatabase()
+{
+    if (rebuildWatcher.isRunning()) {
+        return;
+    }
+    changesDuringRebuild.clear();
+    rebuildWatcher.setFuture(QtConcurrent::run(&TopKLeaderboard::readOrderRows));
+}
+
+TopKLeaderboard::OrderRows TopKLeaderboard::readOrderRows()
+{
+    OrderRows result;
+    Connection& conn = Connection::getInstance();
+    if (conn.ensureDataConnection()) {
+        // Only the three columns the boards need
+        QSqlQuery query(conn.getDataDatabase());
+        query.setForwardOnly(true);
+        query.setNumericalPrecisionPolicy(QSql::HighPrecision);
+        if (TRACE_EXEC_SQL(query, "SELECT COMMAND_ID, CLIENT_ID, TOTAL FROM COMMANDS")) {
+            while (query.next()) {
+                result.rows.insert(query.value(0).toInt(),
+                                   {query.value(1).toInt(), Money::fromVariant(query.value(2)).toCents()});
+            }
+            result.ok = true;
+        } else {
+            qDebug() << "Leaderboard rebuild failed:" << query.lastError().text();
+        }
+    }
+
+    conn.releaseThreadDatabase();
+    if (conn.replica()) {
+        conn.replica()->releaseThreadDatabase();
+    }
+    return result;
+}
+
+void TopKLeaderboard::onRebuildFinished()
+{
+    OrderRows result = rebuildWatcher.result();
+    QList<Change> changes;
+    changes.swap(changesDuringRebuild);
+    if (!result.ok) {
+        return;
+    }
+
+    // The read may have missed these; upserts and removals are idempotent,
+    // so replaying ones it already saw is harmless
+    loadBoards(result.rows);
+    for (const Change& change : changes) {
+        if (change.removed) {
+            takeOrder(change.commandId);
+        } else {
+            upsertOrder(change.command);
+        }
+    }
+}
+
+void TopKLeaderboard::startPeriodicRebuild(int intervalMs)
+{
+    if (!rebuildTimer) {
+        rebuildTimer = new QTimer(this);
+        connect(rebuildTimer, &QTimer::timeout, this, &TopKLeaderboard::rebuildFromDatabase);
+    }
+    rebuildTimer->start(intervalMs);
+}
+
+void TopKLeaderboard::attach(CommandDAO* dao)
+{
+    connect(dao, &CommandDAO::commandCreated, this, &TopKLeaderboard::upsertOrder);
+    connect(dao, &CommandDAO::commandUpdated, this, &TopKLeaderboard::upsertOrder);
+    connect(dao, &CommandDAO::commandDeleted, this, &TopKLeaderboard::removeOrder);
+}
+
+void TopKLeaderboard::attach(WriteBehindQueue* queue)
+{
+    connect(queue, &WriteBehindQueue::commandCommitted, this, [this](int, const Command& command) {
+        upsertOrder(command);
+    });
+}
+
+QList<QPair<int, Money>> TopKLeaderboard::topClients(int k) const
+{
+    QList<QPair<int, Money>> result;
+    for (const QPair<int, qint64>& entry : clients.top(k)) {
+        result.append(qMakePair(entry.first, Money::fromCents(entry.second)));
+    }
+    return result;
+}
+
+QList<QPair<int, Money>> TopKLeaderboard::topOrders(int k) const
+{
+    QList<QPair<int, Money>> result;
+    for (const QPair<int, qint64>& entry : orders.top(k)) {
+        result.append(qMakePair(entry.first, Money::fromCents(entry.second)));
+    }
+    return result;
+}
+
+void TopKLeaderboard::upsertOrder(const Command& command)
+{
+    if (command.commandId <= 0) {
+        return;
+    }
+    if (rebuildWatcher.isRunning()) {
+        changesDuringRebuild.append({command.commandId, false, command});
+    }
+    // An update moves the old amount off its old client first
+    takeOrder(command.commandId);
+    addOrder(command.commandId, command.clientId, command.total.toCents());
+}
+
+void TopKLeaderboard::removeOrder(int commandId)
+{
+    if (rebuildWatcher.isRunning()) {
+        changesDuringRebuild.append({commandId, true, Command()});
+    }
+    takeOrder(commandId);
+}
+
+void TopKLeaderboard::addOrder(int commandId, int clientId, qint64 cents)
+{
+    orderIndex.insert(commandId, {clientId, cents});
+    orders.set(commandId, cents);
+    clients.add(clientId, cents);
+    clientOrderCounts[clientId]++;
+}
+
+void TopKLeaderboard::takeOrder(int commandId)
+{
+    auto it = orderIndex.find(commandId);
+    if (it == orderIndex.end()) {
+        return;
+    }
+
+    Order order = it.value();
+    orderIndex.erase(it);
+    orders.remove(commandId);
+
+    if (--clientOrderCounts[order.clientId] <= 0) {
+        clientOrderCounts.remove(order.clientId);
+        clients.remove(order.clientId);
+    } else {
+        clients.add(order.clientId, -order.cents);
+    }
+}
+
+void TopKLeaderboard::loadBoards(const QHash<int, Order>& orderRows)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QHash<int, qint64> orderScores;
+    QHash<int, qint64> clientScores;
+    orderScores.reserve(orderRows.size());
+    clientOrderCounts.clear();
+
+    for (auto it = orderRows.constBegin(); it != orderRows.constEnd(); ++it) {
+        orderScores.insert(it.key(), it.value().cents);
+        clientScores[it.value().clientId] += it.value().cents;
+        clientOrderCounts[it.value().clientId]++;
+    }
+
+    orderIndex = orderRows;
+    orders.load(orderScores);
+    clients.load(clientScores);
+    ready = true;
+
+    qDebug() << "Leaderboards rebuilt:" << orders.size() << "orders," << clients.size()
+             << "clients in" << timer.elapsed() << "ms";
+}
+
+// Heap
+
+void TopKLeaderboard::Heap::clear()
+{
+    entries.clear();
+    slots.clear();
+}
+
+void TopKLeaderboard::Heap::load(const QHash<int, qint64>& scores)
+{
+    clear();
+    entries.reserve(scores.size());
+    slots.reserve(scores.size());
+    for (auto it = scores.constBegin(); it != scores.constEnd(); ++it) {
+        entries.append({it.key(), it.value()});
+    }
+
+    for (int slot = 0; slot < entries.size(); ++slot) {
+        slots.insert(entries.at(slot).id, slot);
+    }
+
+    // Floyd's bottom-up heap construction
+    for (int slot = entries.size() / 2 - 1; slot >= 0; --slot) {
+        siftDown(slot);
+    }
+}
+
+void TopKLeaderboard::Heap::set(int id, qint64 score)
+{
+    auto it = slots.constFind(id);
+    if (it == slots.constEnd()) {
+        int slot = entries.size();
+        entries.append({id, score});
+        slots.insert(id, slot);
+        siftUp(slot);
+        return;
+    }
+
+    int slot = it.value();
+    qint64 old = entries.at(slot).score;
+    entries[slot].score = score;
+    if (score > old) {
+        siftUp(slot);
+    } else {
+        siftDown(slot);
+    }
+}
+
+void TopKLeaderboard::Heap::add(int id, qint64 delta)
+{
+    set(id, score(id) + delta);
+}
+
+void TopKLeaderboard::Heap::remove(int id)
+{
+    auto it = slots.find(id);
+    if (it == slots.end()) {
+        return;
+    }
+
+    int slot = it.value();
+    slots.erase(it);
+
+    Entry last = entries.takeLast();
+    if (slot < entries.size()) {
+        // Refill the hole with the last entry and restore the order around it
+        place(slot, last);
+        siftUp(slot);
+        siftDown(slots.value(last.id));
+    }
+}
+
+qint64 TopKLeaderboard::Heap::score(int id) const
+{
+    auto it = slots.constFind(id);
+    return it == slots.constEnd() ? 0 : entries.at(it.value()).score;
+}
+
+QList<QPair<int, qint64>> TopKLeaderboard::Heap::top(int k) const
+{
+    QList<QPair<int, qint64>> result;
+    if (k <= 0 || entries.isEmpty()) {
+        return result;
+    }
+
+    // Best-first walk: a slot's children only become candidates once it is taken
+    auto worse = [this](int a, int b) { return before(entries.at(b), entries.at(a)); };
+    std::priority_queue<int, std::vector<int>, decltype(worse)> frontier(worse);
+    frontier.push(0);
+
+    while (!frontier.empty() && result.size() < k) {
+        int slot = frontier.top();
+        frontier.pop();
+        result.append(qMakePair(entries.at(slot).id, entries.at(slot).score));
+
+        int left = 2 * slot + 1;
+        if (left < entries.size()) frontier.push(left);
+        if (left + 1 < entries.size()) frontier.push(left + 1);
+    }
+    return result;
+}
+
+bool TopKLeaderboard::Heap::before(const Entry& a, const Entry& b)
+{
+    return a.score != b.score ? a.score > b.score : a.id < b.id;
+}
+
+void TopKLeaderboard::Heap::siftUp(int slot)
+{
+    Entry entry = entries.at(slot);
+    while (slot > 0) {
+        int parent = (slot - 1) / 2;
+        if (!before(entry, entries.at(parent))) {
+            break;
+        }
+        place(slot, entries.at(parent));
+        slot = parent;
+    }
+    place(slot, entry);
+}
+
+void TopKLeaderboard::Heap::siftDown(int slot)
+{
+    Entry entry = entries.at(slot);
+    int count = entries.size();
+    while (true) {
+        int child = 2 * slot + 1;
+        if (child >= count) {
+            break;
+        }
+        if (child + 1 < count && before(entries.at(child + 1), entries.at(child))) {
+            child++;
+        }
+        if (!before(entries.at(child), entry)) {
+            break;
+        }
+        place(slot, entries.at(child));
+        slot = child;
+    }
+    place(slot, entry);
+}
+
+void TopKLeaderboard::Heap::place(int slot, const Entry& entry)
+{
+    entries[slot] = entry;
+    slots[entry.id] = slot;
+}
@@ -0,0 +1,117 @@
+// topkleaderboard.h
+#ifndef TOPKLEADERBOARD_H
+#define TOPKLEADERBOARD_H
+
+#include <QObject>
+#include <QList>
+#include <QVector>
+#include <QHash>
+#include <QPair>
+#include <QTimer>
+#include <QFutureWatcher>
+
+#include "commands.h"
+
+class WriteBehindQueue;
+
+// Leaderboards of clients by lifetime value and of the largest orders.
+//
+// Each board is a max-heap over every entry with a hash from id to heap
+// slot, so a changed or deleted entry is fixed up in O(log n). Reading the
+// top k walks the heap best-first with a small frontier and touches O(k)
+// slots. Order totals and owners are kept too, so an update or delete can
+// take the old amount off the right client without asking the database.
+//
+// Command writes keep the boards current through the DAO and write-behind
+// queue signals; rebuild() resynchronises them with COMMANDS and can be
+// scheduled with startPeriodicRebuild() to catch writes made elsewhere.
+// rebuildFromDatabase() reads COMMANDS on a worker thread and swaps the new
+// boards in when it is done, replaying the changes seen in the meantime.
+class TopKLeaderboard : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TopKLeaderboard(QObject *parent = nullptr);
+
+    void rebuild(const QList<Command>& commands);
+    void rebuildFromDatabase();
+    void startPeriodicRebuild(int intervalMs);
+    void attach(CommandDAO* dao);
+    void attach(WriteBehindQueue* queue);
+
+    bool isReady() const { return ready; }
+
+    // Best first; ties go to the lower id
+    QList<QPair<int, Money>> topClients(int k) const;
+    QList<QPair<int, Money>> topOrders(int k) const;
+    Money clientTotal(int clientId) const { return Money::fromCents(clients.score(clientId)); }
+
+public slots:
+    void upsertOrder(const Command& command);
+    void removeOrder(int commandId);
+
+private:
+    // Max-heap of (id, score) with an id -> slot index
+    class Heap
+    {
+    public:
+        void clear();
+        void load(const QHash<int, qint64>& scores);   // Bulk build in O(n)
+        void set(int id, qint64 score);
+        void add(int id, qint64 delta);
+        void remove(int id);
+        qint64 score(int id) const;
+        QList<QPair<int, qint64>> top(int k) const;
+        int size() const { return entries.size(); }
+
+    private:
+        struct Entry {
+            int id;
+            qint64 score;
+        };
+
+        QVector<Entry> entries;
+        QHash<int, int> slots;
+
+        static bool before(const Entry& a, const Entry& b);
+        void siftUp(int slot);
+        void siftDown(int slot);
+        void place(int slot, const Entry& entry);
+    };
+
+    struct Order {
+        int clientId;
+        qint64 cents;
+    };
+
+    struct OrderRows {
+        bool ok = false;
+        QHash<int, Order> rows;
+    };
+
+    // A change that arrived while a rebuild was reading COMMANDS
+    struct Change {
+        int commandId;
+        bool removed;
+        Command command;
+    };
+
+    Heap clients;
+    Heap orders;
+    QHash<int, Order> orderIndex;
+    QHash<int, int> clientOrderCounts;   // A client leaves the board with its last order
+    QTimer *rebuildTimer;
+    QFutureWatcher<OrderRows> rebuildWatcher;
+    QList<Change> changesDuringRebuild;
+    bool ready;
+
+    static OrderRows readOrderRows();
+    void onRebuildFinished();
+
+    void addOrder(int commandId, int clientId, qint64 cents);
+    void takeOrder(int commandId);
+    void loadBoards(const QHash<int, Order>& orderRows);
+};
+
+#endif // TOPKLEADERBOARD_H
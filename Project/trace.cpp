@@ -0,0 +1,171 @@
+// trace.cpp
+#include "trace.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QList>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <chrono>
+#include <cstring>
+
+std::atomic<bool> Trace::enabledFlag(false);
+
+namespace {
+
+const int Capacity = 8192;      // Spans kept per thread, 1 MB
+const int DetailSize = 96;
+
+struct Event {
+    const char *category;
+    const char *name;
+    qint64 startNs;
+    qint64 endNs;
+    char detail[DetailSize];
+};
+
+// Only the owning thread writes events and 'written'; readers take the
+// newest Capacity spans behind 'written', and clear() just moves 'cleared'
+struct ThreadBuffer {
+    int tid = 0;
+    QString threadName;
+    std::atomic<quint64> written{0};
+    std::atomic<quint64> cleared{0};
+    Event events[Capacity];
+};
+
+const qint64 baseNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now().time_since_epoch()).count();
+
+QMutex registryMutex;
+QList<ThreadBuffer*> registry;  // Never freed, so a trace keeps the spans of finished threads
+thread_local ThreadBuffer *localBuffer = nullptr;
+
+ThreadBuffer* threadBuffer()
+{
+    if (!localBuffer) {
+        ThreadBuffer *buffer = new ThreadBuffer;
+        QThread *thread = QThread::currentThread();
+        QCoreApplication *app = QCoreApplication::instance();
+
+        QMutexLocker locker(&registryMutex);
+        buffer->tid = registry.size() + 1;
+        if (app && thread == app->thread()) {
+            buffer->threadName = "main";
+        } else {
+            QString name = thread->objectName().isEmpty() ? QString("thread") : thread->objectName();
+            buffer->threadName = QString("%1 #%2").arg(name).arg(buffer->tid);
+        }
+        registry.append(buffer);
+        localBuffer = buffer;
+    }
+    return localBuffer;
+}
+
+} // namespace
+
+void Trace::setEnabled(bool enabled)
+{
+    enabledFlag.store(enabled, std::memory_order_relaxed);
+}
+
+void Trace::clear()
+{
+    QMutexLocker locker(&registryMutex);
+    for (ThreadBuffer *buffer : registry) {
+        buffer->cleared.store(buffer->written.load(std::memory_order_acquire), std::memory_order_release);
+    }
+}
+
+qint64 Trace::nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::record(const char *category, const char *name, qint64 startNs, qint64 endNs, const QString& detail)
+{
+    ThreadBuffer *buffer = threadBuffer();
+    quint64 index = buffer->written.load(std::memory_order_relaxed);
+    Event& event = buffer->events[index % Capacity];
+    event.category = category;
+    event.name = name;
+    event.startNs = startNs;
+    event.endNs = endNs;
+
+    event.detail[0] = '\0';
+    if (!detail.isEmpty()) {
+        QByteArray text = detail.left(DetailSize * 2).simplified().toUtf8();
+        int length = qMin(int(text.size()), DetailSize - 1);
+        std::memcpy(event.detail, text.constData(), size_t(length));
+        event.detail[length] = '\0';
+    }
+
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+bool Trace::exec(QSqlQuery& query)
+{
+    if (!isEnabled()) {
+        return query.exec();
+    }
+    qint64 startNs = nowNs();
+    bool ok = query.exec();
+    record("sql", "exec", startNs, nowNs(), query.lastQuery());
+    return ok;
+}
+
+bool Trace::exec(QSqlQuery& query, const QString& sql)
+{
+    if (!isEnabled()) {
+        return query.exec(sql);
+    }
+    qint64 startNs = nowNs();
+    bool ok = query.exec(sql);
+    record("sql", "exec", startNs, nowNs(), sql);
+    return ok;
+}
+
+QByteArray Trace::toJson()
+{
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray events;
+
+    QMutexLocker locker(&registryMutex);
+    for (const ThreadBuffer *buffer : registry) {
+        events.append(QJsonObject{{"name", "thread_name"}, {"ph", "M"}, {"pid", pid}, {"tid", buffer->tid},
+                                  {"args", QJsonObject{{"name", buffer->threadName}}}});
+
+        quint64 end = buffer->written.load(std::memory_order_acquire);
+        quint64 begin = qMax(buffer->cleared.load(std::memory_order_acquire),
+                             end > quint64(Capacity) ? end - Capacity : quint64(0));
+        for (quint64 i = begin; i < end; ++i) {
+            const Event& event = buffer->events[i % Capacity];
+            // Chrome wants microseconds
+            QJsonObject json{{"name", event.name}, {"cat", event.category}, {"ph", "X"},
+                             {"ts", (event.startNs - baseNs) / 1000.0},
+                             {"dur", (event.endNs - event.startNs) / 1000.0},
+                             {"pid", pid}, {"tid", buffer->tid}};
+            if (event.detail[0]) {
+                json["args"] = QJsonObject{{"detail", QString::fromUtf8(event.detail)}};
+            }
+            events.append(json);
+        }
+    }
+
+    QJsonObject root{{"traceEvents", events}, {"displayTimeUnit", "ms"}};
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+bool Trace::writeJson(const QString& path, QString& error)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(toJson()) < 0 || !file.commit()) {
+        error = QString("Cannot write %1: %2").arg(path, file.errorString());
+        return false;
+    }
+    return true;
+}
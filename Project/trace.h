@@ -0,0 +1,82 @@
+// trace.h
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QSqlQuery>
+#include <atomic>
+
+// Scoped trace spans from UI slots down to individual SQL statements.
+//
+//     void MainWindow::onRefreshClicked()
+//     {
+//         TRACE_SCOPE("ui", "MainWindow::onRefreshClicked");
+//         ...
+//         if (!TRACE_EXEC(query)) {     // a "sql" span labelled with the statement
+//
+// Spans go into a fixed-size ring buffer owned by the recording thread, so
+// recording takes no lock (the first span on a thread registers its buffer
+// once). When a buffer wraps, the oldest spans are overwritten. toJson()
+// exports every buffer in the Chrome trace-event format, which
+// chrome://tracing and ui.perfetto.dev open; export while the traced work
+// is idle, since spans written during the export may come out torn.
+//
+// Recording is off until setEnabled(true); a disabled span costs one
+// relaxed atomic load. Builds without CONFIG+=tracing (which defines
+// CMS_TRACE) compile the macros away entirely: TRACE_SCOPE becomes nothing
+// and TRACE_EXEC a plain exec().
+class Trace
+{
+public:
+    static bool isEnabled() { return enabledFlag.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enabled);
+    static void clear();
+
+    static QByteArray toJson();
+    static bool writeJson(const QString& path, QString& error);
+
+    static qint64 nowNs();
+    static void record(const char *category, const char *name, qint64 startNs, qint64 endNs,
+                       const QString& detail = QString());
+
+    // exec() inside a "sql" span labelled with the statement text
+    static bool exec(QSqlQuery& query);
+    static bool exec(QSqlQuery& query, const QString& sql);
+
+    class Scope
+    {
+    public:
+        Scope(const char *category, const char *name)
+            : category(category), name(name), startNs(isEnabled() ? nowNs() : -1) {}
+        ~Scope()
+        {
+            if (startNs >= 0) {
+                record(category, name, startNs, nowNs());
+            }
+        }
+
+    private:
+        Q_DISABLE_COPY(Scope)
+        const char *category;
+        const char *name;
+        qint64 startNs;
+    };
+
+private:
+    static std::atomic<bool> enabledFlag;
+};
+
+#ifdef CMS_TRACE
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(category, name) Trace::Scope TRACE_CONCAT(traceScope_, __LINE__)(category, name)
+#define TRACE_EXEC(query) Trace::exec(query)
+#define TRACE_EXEC_SQL(query, sql) Trace::exec(query, sql)
+#else
+#define TRACE_SCOPE(category, name) do {} while (false)
+#define TRACE_EXEC(query) (query).exec()
+#define TRACE_EXEC_SQL(query, sql) (query).exec(sql)
+#endif
+
+#endif // TRACE_H
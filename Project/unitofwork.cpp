@@ -0,0 +1,260 @@
+// unitofwork.cpp
+#include "unitofwork.h"
+#include "connection.h"
+#include "querycache.h"
+#include <QSqlError>
+#include <QDebug>
+#include <stdexcept>
+
+// One active unit of work per thread, since each thread has its own connection
+static thread_local UnitOfWork* s_current = nullptr;
+
+UnitOfWork::UnitOfWork()
+    : outer(s_current), open(true), failed(false), inTransaction(false), operations(0)
+{
+    if (outer) {
+        // Join the unit of work that is already running on this thread
+        db = outer->db;
+        return;
+    }
+
+    s_current = this;
+
+    Connection& conn = Connection::getInstance();
+    if (!conn.ensureDataConnection()) {
+        failed = true;
+        errors << "Database connection error";
+        return;
+    }
+
+    db = conn.getDataDatabase();
+    if (!db.transaction()) {
+        failed = true;
+        errors << "Could not begin transaction: " + db.lastError().text();
+        return;
+    }
+    inTransaction = true;
+}
+
+UnitOfWork::~UnitOfWork()
+{
+    if (!open) {
+        return;
+    }
+
+    if (outer) {
+        // Leaving a joined scope without commit() aborts the whole unit
+        markFailed("Nested unit of work was not committed");
+        open = false;
+        return;
+    }
+
+    rollback();
+}
+
+bool UnitOfWork::commit()
+{
+    if (!open) {
+        return false;
+    }
+
+    if (outer) {
+        // The outermost unit owns the transaction
+        open = false;
+        return !root()->failed;
+    }
+
+    if (failed) {
+        qDebug() << "Unit of work failed, rolling back:" << errors.join("; ");
+        rollback();
+        return false;
+    }
+
+    if (!db.commit()) {
+        errors << "Commit failed: " + db.lastError().text();
+        failed = true;
+        rollback();
+        return false;
+    }
+
+    QList<DeferredAction> actions = deferred;
+    finish();
+
+    qDebug() << "✓ Unit of work committed:" << operations << "operations";
+
+    // Signals run after the unit is closed so their handlers may write again
+    for (const DeferredAction& deferredAction : actions) {
+        deferredAction.action();
+    }
+
+    return true;
+}
+
+void UnitOfWork::rollback()
+{
+    if (!open) {
+        return;
+    }
+
+    if (outer) {
+        markFailed("Rolled back by nested unit of work");
+        open = false;
+        return;
+    }
+
+    // A transaction that never began is not ours to roll back
+    if (inTransaction && db.isValid() && db.isOpen()) {
+        db.rollback();
+    }
+
+    qDebug() << "Unit of work rolled back," << deferred.size() << "deferred signals dropped";
+    finish();
+}
+
+bool UnitOfWork::isOpen() const
+{
+    return open;
+}
+
+bool UnitOfWork::hasFailed() const
+{
+    return outer ? outer->hasFailed() : failed;
+}
+
+QString UnitOfWork::lastError() const
+{
+    if (outer) {
+        return outer->lastError();
+    }
+    return errors.isEmpty() ? QString() : errors.last();
+}
+
+int UnitOfWork::operationCount() const
+{
+    return outer ? outer->operationCount() : operations;
+}
+
+UnitOfWork* UnitOfWork::current()
+{
+    return s_current;
+}
+
+bool UnitOfWork::isActive()
+{
+    return s_current != nullptr;
+}
+
+void UnitOfWork::defer(const std::function<void()>& action)
+{
+    deferOnce(QString(), action);
+}
+
+void UnitOfWork::deferOnce(const QString& key, const std::function<void()>& action)
+{
+    if (!s_current) {
+        action();
+        return;
+    }
+
+    if (!key.isEmpty()) {
+        for (const DeferredAction& existing : s_current->deferred) {
+            if (existing.key == key) {
+                return;
+            }
+        }
+    }
+
+    s_current->deferred.append({key, action});
+}
+
+void UnitOfWork::markFailed(const QString& error)
+{
+    if (!s_current) {
+        return;
+    }
+
+    s_current->failed = true;
+    s_current->errors << error;
+}
+
+void UnitOfWork::recordOperation()
+{
+    if (s_current) {
+        s_current->operations++;
+    }
+}
+
+UnitOfWork* UnitOfWork::root()
+{
+    UnitOfWork* unit = this;
+    while (unit->outer) {
+        unit = unit->outer;
+    }
+    return unit;
+}
+
+void UnitOfWork::finish()
+{
+    open = false;
+    deferred.clear();
+    if (s_current == this) {
+        s_current = nullptr;
+    }
+}
+
+// UnitOfWork::Write
+
+UnitOfWork::Write::Write(QSqlDatabase& db, const QString& table)
+    : db(db), table(table), ownsTransaction(false), joined(false)
+{
+}
+
+void UnitOfWork::Write::begin()
+{
+    // Inside a unit of work the transaction belongs to the caller
+    if (isActive()) {
+        joined = true;
+        UnitOfWork* unit = current()->root();
+        if (unit->failed || !unit->inTransaction) {
+            QString reason = unit->errors.isEmpty() ? QString("no transaction") : unit->errors.last();
+            throw std::runtime_error("Unit of work failed: " + reason.toStdString());
+        }
+        return;
+    }
+
+    if (!db.transaction()) {
+        throw std::runtime_error("Could not begin transaction: " + db.lastError().text().toStdString());
+    }
+    ownsTransaction = true;
+}
+
+void UnitOfWork::Write::finish()
+{
+    if (ownsTransaction) {
+        if (!db.commit()) {
+            throw std::runtime_error("Commit failed: " + db.lastError().text().toStdString());
+        }
+        ownsTransaction = false;
+        QueryCache::instance().invalidate({table});
+    } else if (joined) {
+        recordOperation();
+        QString cachedTable = table;
+        deferOnce("QueryCache:" + table, [cachedTable]() {
+            QueryCache::instance().invalidate({cachedTable});
+        });
+    }
+}
+
+void UnitOfWork::Write::fail(const QString& error)
+{
+    if (ownsTransaction) {
+        db.rollback();
+        ownsTransaction = false;
+        // Reads made inside the transaction may have cached rows that are gone now
+        QueryCache::instance().invalidate({table});
+    } else if (joined) {
+        markFailed(error);
+    }
+
+    qDebug() << "Database error:" << error;
+}
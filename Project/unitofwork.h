@@ -0,0 +1,118 @@
+// unitofwork.h
+#ifndef UNITOFWORK_H
+#define UNITOFWORK_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QSqlDatabase>
+#include <QPointer>
+#include <functional>
+
+// Scoped unit of work grouping several DAO writes into one transaction.
+//
+//     UnitOfWork uow;
+//     for (const Client& c : imported) clientManager->addNewClient(c);
+//     if (!uow.commit()) qDebug() << uow.lastError();
+//
+// While a unit of work is open on the current thread the DAOs neither begin
+// nor commit their own transactions, and their change signals are queued
+// until commit. If any database write fails, or the object goes out of scope without
+// commit(), everything is rolled back and the queued signals are dropped.
+// Opening a second UnitOfWork while one is active joins the outer one.
+class UnitOfWork
+{
+public:
+    UnitOfWork();
+    ~UnitOfWork();
+
+    UnitOfWork(const UnitOfWork&) = delete;
+    UnitOfWork& operator=(const UnitOfWork&) = delete;
+
+    // Commit the transaction and fire the deferred signals
+    bool commit();
+    void rollback();
+
+    bool isOpen() const;
+    bool hasFailed() const;
+    QString lastError() const;
+    int operationCount() const;
+
+    // Static helpers used by the DAOs
+    static UnitOfWork* current();
+    static bool isActive();
+
+    // Run now when no unit of work is active, otherwise after commit
+    static void defer(const std::function<void()>& action);
+    // Same, but actions sharing a key only run once (e.g. table refreshes)
+    static void deferOnce(const QString& key, const std::function<void()>& action);
+
+    // Record a failed write; the outer commit() will roll back
+    static void markFailed(const QString& error);
+    static void recordOperation();
+
+    // One dao->refreshTableModel() per unit of work instead of one per row
+    template <typename Dao>
+    static void deferRefresh(Dao* dao);
+
+    // One DAO write on one table. Without an active unit of work it runs
+    // in its own transaction and drops the table's QueryCache entries when
+    // that ends; inside one it joins the caller's transaction.
+    //
+    //     UnitOfWork::Write write(db, "CLIENTS");
+    //     try {
+    //         write.begin();
+    //         ... throw std::runtime_error on a failed statement ...
+    //         write.finish();
+    //     } catch (const std::exception& e) {
+    //         write.fail(QString::fromStdString(e.what()));
+    //     }
+    class Write
+    {
+    public:
+        Write(QSqlDatabase& db, const QString& table);
+
+        // Both throw std::runtime_error when the transaction cannot begin or
+        // commit; begin() also throws inside a unit of work that has failed
+        // or never opened its transaction, so nothing runs in autocommit
+        void begin();
+        void finish();
+        // Roll back, or fail the active unit of work
+        void fail(const QString& error);
+
+    private:
+        QSqlDatabase& db;
+        QString table;
+        bool ownsTransaction;
+        bool joined;
+    };
+
+private:
+    struct DeferredAction {
+        QString key;
+        std::function<void()> action;
+    };
+
+    QSqlDatabase db;
+    UnitOfWork* outer;      // Non-null when this object joined an active unit
+    bool open;
+    bool failed;
+    bool inTransaction;     // db.transaction() succeeded; false for joined units
+    int operations;
+    QStringList errors;
+    QList<DeferredAction> deferred;
+
+    UnitOfWork* root();
+    void finish();
+};
+
+template <typename Dao>
+void UnitOfWork::deferRefresh(Dao* dao)
+{
+    QPointer<Dao> self(dao);
+    deferOnce(QString("refresh:%1").arg(quintptr(dao)), [self]() {
+        if (self) self->refreshTableModel();
+    });
+}
+
+#endif // UNITOFWORK_H
@@ -0,0 +1,212 @@
+// validationengine.cpp
+#include "validationengine.h"
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <cstring>
+
+// Below this many rows a batch is checked on the calling thread
+static const int ParallelThreshold = 512;
+
+static void markRange(quint8 *table, char first, char last, quint8 mask)
+{
+    for (int c = first; c <= last; ++c) {
+        table[c] |= mask;
+    }
+}
+
+static void markChars(quint8 *table, const char *chars, quint8 mask)
+{
+    for (; *chars; ++chars) {
+        table[int(*chars)] |= mask;
+    }
+}
+
+ValidationEngine::ValidationEngine()
+{
+    std::memset(asciiClass, 0, sizeof(asciiClass));
+
+    markRange(asciiClass, 'a', 'z', EmailLocal | EmailDomain | Letter);
+    markRange(asciiClass, 'A', 'Z', EmailLocal | EmailDomain | Letter);
+    markRange(asciiClass, '0', '9', EmailLocal | EmailDomain);
+    markChars(asciiClass, "._%+-", EmailLocal);
+    markChars(asciiClass, ".-", EmailDomain);
+    markChars(asciiClass, "<>\"'%;()&+", Unsafe);
+
+    paymentMethodList << "Cash" << "Credit Card" << "Debit Card" << "PayPal"
+                      << "Bank Transfer" << "Check" << "Mobile Payment";
+    for (const QString& method : paymentMethodList) {
+        paymentMethodKeys.insert(method.toCaseFolded());
+    }
+}
+
+const ValidationEngine& ValidationEngine::instance()
+{
+    static const ValidationEngine engine;
+    return engine;
+}
+
+bool ValidationEngine::isValidEmail(QStringView email) const
+{
+    email = email.trimmed();
+    if (email.isEmpty() || email.size() > 255) {
+        return false;
+    }
+
+    // Local part up to the '@', which neither part may contain
+    qsizetype at = 0;
+    while (at < email.size() && hasClass(email[at], EmailLocal)) {
+        ++at;
+    }
+    if (at == 0 || at == email.size() || email[at] != QLatin1Char('@')) {
+        return false;
+    }
+
+    // Domain: allowed characters throughout, the last dot followed by
+    // two or more letters and preceded by at least one character
+    qsizetype domainStart = at + 1;
+    qsizetype lastDot = -1;
+    for (qsizetype i = domainStart; i < email.size(); ++i) {
+        QChar c = email[i];
+        if (!hasClass(c, EmailDomain)) {
+            return false;
+        }
+        if (c == QLatin1Char('.')) {
+            lastDot = i;
+        }
+    }
+    if (lastDot <= domainStart || email.size() - lastDot - 1 < 2) {
+        return false;
+    }
+    for (qsizetype i = lastDot + 1; i < email.size(); ++i) {
+        if (!hasClass(email[i], Letter)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ValidationEngine::isValidName(QStringView name) const
+{
+    qsizetype length = name.trimmed().size();
+    return length >= 2 && length <= 100;
+}
+
+bool ValidationEngine::isValidPaymentMethod(const QString& paymentMethod) const
+{
+    QString trimmed = paymentMethod.trimmed();
+    if (trimmed.isEmpty()) {
+        return false;
+    }
+    return paymentMethodKeys.isEmpty() || paymentMethodKeys.contains(trimmed.toCaseFolded());
+}
+
+QString ValidationEngine::stripUnsafe(const QString& input) const
+{
+    QStringView trimmed = QStringView(input).trimmed();
+    QString result;
+    result.reserve(trimmed.size());
+    for (QChar c : trimmed) {
+        if (!hasClass(c, Unsafe)) {
+            result.append(c);
+        }
+    }
+    return result;
+}
+
+QList<ValidationEngine::FieldError> ValidationEngine::validate(const Client& client) const
+{
+    QList<FieldError> errors;
+    if (!isValidName(client.name)) {
+        errors.append({Name, "Name is required and must be at least 2 characters long"});
+    }
+    if (!isValidEmail(client.email)) {
+        errors.append({Email, "Valid email address is required"});
+    }
+    return errors;
+}
+
+QList<ValidationEngine::FieldError> ValidationEngine::validate(const Command& command) const
+{
+    QList<FieldError> errors;
+    if (command.clientId <= 0) {
+        errors.append({ClientId, "Invalid client ID"});
+    }
+    if (command.total.isNegative()) {
+        errors.append({Total, "Invalid total amount"});
+    }
+    if (QStringView(command.paymentMethod).trimmed().isEmpty()) {
+        errors.append({PaymentMethod, "Payment method cannot be empty"});
+    }
+    if (QStringView(command.deliveryAddress).trimmed().isEmpty()) {
+        errors.append({DeliveryAddress, "Delivery address cannot be empty"});
+    }
+    if (!command.hasCommandDate()) {
+        errors.append({CommandDate, "Invalid command date"});
+    }
+    return errors;
+}
+
+template <typename Row>
+static QList<ValidationEngine::RowReport> validateRows(const ValidationEngine& engine, const QList<Row>& rows)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    auto check = [&engine](const Row& row) { return engine.validate(row); };
+    QList<QList<ValidationEngine::FieldError>> results;
+    if (rows.size() < ParallelThreshold) {
+        results.reserve(rows.size());
+        for (const Row& row : rows) {
+            results.append(check(row));
+        }
+    } else {
+        results = QtConcurrent::blockingMapped<QList<QList<ValidationEngine::FieldError>>>(rows, check);
+    }
+
+    QList<ValidationEngine::RowReport> reports;
+    for (int i = 0; i < results.size(); ++i) {
+        if (!results.at(i).isEmpty()) {
+            reports.append({i, results.at(i)});
+        }
+    }
+
+    if (rows.size() >= ParallelThreshold) {
+        qDebug() << "Validated" << rows.size() << "rows in" << timer.elapsed() << "ms,"
+                 << reports.size() << "rejected";
+    }
+    return reports;
+}
+
+QList<ValidationEngine::RowReport> ValidationEngine::validateAll(const QList<Client>& clients) const
+{
+    return validateRows(*this, clients);
+}
+
+QList<ValidationEngine::RowReport> ValidationEngine::validateAll(const QList<Command>& commands) const
+{
+    return validateRows(*this, commands);
+}
+
+QString ValidationEngine::fieldName(Field field)
+{
+    switch (field) {
+    case Name:            return "Name";
+    case Email:           return "Email";
+    case ClientId:        return "Client";
+    case Total:           return "Total";
+    case PaymentMethod:   return "Payment method";
+    case DeliveryAddress: return "Delivery address";
+    case CommandDate:     return "Date";
+    }
+    return QString();
+}
+
+QString ValidationEngine::describe(const RowReport& report)
+{
+    QStringList parts;
+    for (const FieldError& error : report.errors) {
+        parts << QString("%1: %2").arg(fieldName(error.field), error.message);
+    }
+    return QString("Row %1, %2").arg(report.row + 1).arg(parts.join("; "));
+}
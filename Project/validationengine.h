@@ -0,0 +1,90 @@
+// validationengine.h
+#ifndef VALIDATIONENGINE_H
+#define VALIDATIONENGINE_H
+
+#include <QString>
+#include <QStringView>
+#include <QStringList>
+#include <QList>
+#include <QSet>
+
+#include "clients.h"
+#include "commands.h"
+
+// Field rules for clients and orders, built once and shared.
+//
+// The email check is a hand-written scanner equivalent to
+// ^[a-zA-Z0-9._%+-]+@[a-zA-Z0-9.-]+\.[a-zA-Z]{2,}$ on the trimmed text,
+// character classes are lookup tables and payment methods are a hashed,
+// case-folded set, so a check costs no allocation beyond the trim. The
+// engine is immutable after construction and safe to use from any thread.
+//
+// validate() reports every failing field of one row; validateAll() runs
+// the same rules over a batch with QtConcurrent and returns only the rows
+// that failed, each with its index in the batch.
+class ValidationEngine
+{
+public:
+    enum Field {
+        Name,
+        Email,
+        ClientId,
+        Total,
+        PaymentMethod,
+        DeliveryAddress,
+        CommandDate
+    };
+
+    struct FieldError {
+        Field field;
+        QString message;
+    };
+
+    struct RowReport {
+        int row = -1;
+        QList<FieldError> errors;
+    };
+
+    static const ValidationEngine& instance();
+
+    QList<FieldError> validate(const Client& client) const;
+    QList<FieldError> validate(const Command& command) const;
+
+    QList<RowReport> validateAll(const QList<Client>& clients) const;
+    QList<RowReport> validateAll(const QList<Command>& commands) const;
+
+    bool isValidEmail(QStringView email) const;
+    bool isValidName(QStringView name) const;
+    bool isValidPaymentMethod(const QString& paymentMethod) const;
+
+    // Trim and drop the characters < > " ' % ; ( ) & +
+    QString stripUnsafe(const QString& input) const;
+
+    const QStringList& paymentMethods() const { return paymentMethodList; }
+
+    static QString fieldName(Field field);
+    // "Row 3, Email: Valid email address is required"; rows count from 1
+    static QString describe(const RowReport& report);
+
+private:
+    ValidationEngine();
+    Q_DISABLE_COPY(ValidationEngine)
+
+    enum CharClass : quint8 {
+        EmailLocal  = 0x1,
+        EmailDomain = 0x2,
+        Letter      = 0x4,
+        Unsafe      = 0x8
+    };
+
+    quint8 asciiClass[128];
+    QStringList paymentMethodList;
+    QSet<QString> paymentMethodKeys;   // Case-folded
+
+    bool hasClass(QChar c, quint8 mask) const
+    {
+        return c.unicode() < 128 && (asciiClass[c.unicode()] & mask);
+    }
+};
+
+#endif // VALIDATIONENGINE_H
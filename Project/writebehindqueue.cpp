@@ -0,0 +1,420 @@
+// writebehindqueue.cpp
+#include "writebehindqueue.h"
+#include "connection.h"
+#include "unitofwork.h"
+#include <QDebug>
+
+WriteBehindQueue::WriteBehindQueue(QObject *parent)
+    : QObject(parent)
+    , inFlight(0)
+    , nextTemporaryId(-1)
+    , maxBatchSize(50)
+    , flushTimer(new QTimer(this))
+    , workerThread(new QThread(this))
+    , worker(new QObject)
+    , workerClients(nullptr)
+    , workerCommands(nullptr)
+{
+    // Edits arriving within the interval are sent together
+    flushTimer->setSingleShot(true);
+    flushTimer->setInterval(250);
+    connect(flushTimer, &QTimer::timeout, this, &WriteBehindQueue::sendBatch);
+
+    worker->moveToThread(workerThread);
+    workerThread->setObjectName("WriteBehindWorker");
+    workerThread->start();
+}
+
+WriteBehindQueue::~WriteBehindQueue()
+{
+    flushTimer->stop();
+
+    // Let the batch in flight finish and take its results first, so the
+    // writes queued behind its inserts get their database ids
+    QMetaObject::invokeMethod(worker, []() {}, Qt::BlockingQueuedConnection);
+    deliverResults();
+    flushTimer->stop();
+
+    // Write whatever is still queued before the thread goes away
+    QList<WriteResult> rejected;
+    QList<PendingWrite> remaining = takeBatch(pending.size(), rejected);
+    for (const WriteResult& result : rejected) {
+        qDebug() << "Write-behind: dropping write on shutdown:" << result.error;
+    }
+
+    QMetaObject::invokeMethod(worker, [this, remaining]() {
+        if (!remaining.isEmpty()) {
+            writeBatch(remaining);
+        }
+        shutdownWorker();
+    }, Qt::BlockingQueuedConnection);
+
+    workerThread->quit();
+    workerThread->wait();
+    delete worker;
+}
+
+int WriteBehindQueue::enqueueClientInsert(const Client& client)
+{
+    PendingWrite write;
+    write.entity = ClientEntity;
+    write.isInsert = true;
+    write.viewId = nextTemporaryId--;
+    write.client = client;
+    write.client.id = write.viewId;
+    return enqueue(write);
+}
+
+int WriteBehindQueue::enqueueClientUpdate(const Client& client, const Client& previous)
+{
+    PendingWrite write;
+    write.entity = ClientEntity;
+    write.viewId = client.id;
+    write.client = client;
+    write.previousClient = previous;
+    return enqueue(write);
+}
+
+int WriteBehindQueue::enqueueCommandInsert(const Command& command)
+{
+    PendingWrite write;
+    write.entity = CommandEntity;
+    write.isInsert = true;
+    write.viewId = nextTemporaryId--;
+    write.command = command;
+    write.command.commandId = write.viewId;
+    return enqueue(write);
+}
+
+int WriteBehindQueue::enqueueCommandUpdate(const Command& command, const Command& previous)
+{
+    PendingWrite write;
+    write.entity = CommandEntity;
+    write.viewId = command.commandId;
+    write.command = command;
+    write.previousCommand = previous;
+    return enqueue(write);
+}
+
+int WriteBehindQueue::pendingCount() const
+{
+    return pending.size() + inFlight;
+}
+
+void WriteBehindQueue::setFlushInterval(int msec)
+{
+    flushTimer->setInterval(msec);
+}
+
+void WriteBehindQueue::setMaxBatchSize(int size)
+{
+    maxBatchSize = qMax(1, size);
+}
+
+void WriteBehindQueue::flush()
+{
+    flushTimer->stop();
+    sendBatch();
+}
+
+int WriteBehindQueue::enqueue(const PendingWrite& write)
+{
+    QString key = keyFor(write.entity, write.viewId);
+
+    if (!write.isInsert && pendingIndex.contains(key)) {
+        // Merge into the write that is still waiting; it keeps its original
+        // previous values so a failure reverts to the row as it was before
+        PendingWrite& queued = pending[pendingIndex.value(key)];
+        queued.client = write.client;
+        queued.command = write.command;
+    } else {
+        pendingIndex.insert(key, pending.size());
+        pending.append(write);
+    }
+
+    if (write.entity == ClientEntity) {
+        emit clientApplied(write.client);
+    } else {
+        emit commandApplied(write.command);
+    }
+    emit pendingCountChanged(pendingCount());
+
+    if (pending.size() >= maxBatchSize) {
+        flush();
+    } else if (!flushTimer->isActive()) {
+        flushTimer->start();
+    }
+
+    return write.viewId;
+}
+
+QString WriteBehindQueue::keyFor(Entity entity, int id)
+{
+    return QString("%1:%2").arg(entity == ClientEntity ? "client" : "command").arg(id);
+}
+
+void WriteBehindQueue::sendBatch()
+{
+    // One batch at a time keeps the writes in order
+    if (inFlight > 0 || pending.isEmpty()) {
+        return;
+    }
+
+    QList<WriteResult> rejected;
+    QList<PendingWrite> batch = takeBatch(qMin(maxBatchSize, int(pending.size())), rejected);
+
+    for (const WriteResult& result : rejected) {
+        reportResult(result);
+    }
+
+    if (batch.isEmpty()) {
+        emit pendingCountChanged(pendingCount());
+        if (!pending.isEmpty()) {
+            flushTimer->start();
+        }
+        return;
+    }
+
+    inFlight = batch.size();
+    qDebug() << "Write-behind: sending" << batch.size() << "writes," << pending.size() << "still queued";
+
+    QMetaObject::invokeMethod(worker, [this, batch]() {
+        QList<WriteResult> results = writeBatch(batch);
+        {
+            QMutexLocker locker(&resultsMutex);
+            finishedResults += results;
+        }
+        QMetaObject::invokeMethod(this, &WriteBehindQueue::deliverResults, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+QList<WriteBehindQueue::PendingWrite> WriteBehindQueue::takeBatch(int count, QList<WriteResult>& rejected)
+{
+    QList<PendingWrite> batch;
+    QSet<int> batchInserts;
+
+    for (int i = 0; i < count; ++i) {
+        PendingWrite write = pending.at(i);
+        WriteResult result;
+        if (resolveIds(write, committedClientIds, committedCommandIds, batchInserts, result.error)) {
+            if (write.isInsert) {
+                batchInserts.insert(write.viewId);
+            }
+            batch.append(write);
+        } else {
+            result.write = write;
+            rejected.append(result);
+        }
+    }
+
+    pending.erase(pending.begin(), pending.begin() + count);
+    pendingIndex.clear();
+    for (int i = 0; i < pending.size(); ++i) {
+        pendingIndex.insert(keyFor(pending.at(i).entity, pending.at(i).viewId), i);
+    }
+    return batch;
+}
+
+bool WriteBehindQueue::resolveIds(PendingWrite& write, const QHash<int, int>& clientIds,
+                                  const QHash<int, int>& commandIds, const QSet<int>& batchInserts,
+                                  QString& error)
+{
+    // Rows created through the queue are known by their temporary id until
+    // the insert commits; later writes are sent with the database id. An
+    // insert earlier in the same batch keeps the temporary id, and the
+    // worker swaps in the new id once it has written that row
+    if (write.entity == ClientEntity) {
+        if (!write.isInsert && write.viewId < 0 && !batchInserts.contains(write.viewId)) {
+            if (!clientIds.contains(write.viewId)) {
+                error = "The client was never saved";
+                return false;
+            }
+            write.viewId = clientIds.value(write.viewId);
+            write.client.id = write.viewId;
+        }
+        return true;
+    }
+
+    if (!write.isInsert && write.viewId < 0 && !batchInserts.contains(write.viewId)) {
+        if (!commandIds.contains(write.viewId)) {
+            error = "The command was never saved";
+            return false;
+        }
+        write.viewId = commandIds.value(write.viewId);
+        write.command.commandId = write.viewId;
+    }
+
+    if (write.command.clientId < 0 && !batchInserts.contains(write.command.clientId)) {
+        if (!clientIds.contains(write.command.clientId)) {
+            error = "The client of this command was never saved";
+            return false;
+        }
+        write.command.clientId = clientIds.value(write.command.clientId);
+    }
+
+    return true;
+}
+
+void WriteBehindQueue::deliverResults()
+{
+    QList<WriteResult> results;
+    {
+        QMutexLocker locker(&resultsMutex);
+        results.swap(finishedResults);
+    }
+    if (!results.isEmpty()) {
+        applyResults(results);
+    }
+}
+
+void WriteBehindQueue::applyResults(const QList<WriteResult>& results)
+{
+    inFlight = 0;
+
+    for (const WriteResult& result : results) {
+        reportResult(result);
+    }
+
+    emit pendingCountChanged(pendingCount());
+
+    if (!pending.isEmpty() && !flushTimer->isActive()) {
+        flushTimer->start();
+    }
+}
+
+void WriteBehindQueue::reportResult(const WriteResult& result)
+{
+    const PendingWrite& write = result.write;
+
+    if (write.entity == ClientEntity) {
+        Client client = write.client;
+        if (result.success) {
+            if (write.isInsert) {
+                committedClientIds.insert(write.viewId, result.newId);
+                client.id = result.newId;
+            }
+            emit clientCommitted(write.viewId, client);
+        } else {
+            qDebug() << "Write-behind: client write failed:" << result.error;
+            client.id = write.viewId;
+            emit clientReverted(client, write.previousClient, result.error);
+        }
+        return;
+    }
+
+    Command command = write.command;
+    if (result.success) {
+        if (write.isInsert) {
+            committedCommandIds.insert(write.viewId, result.newId);
+            command.commandId = result.newId;
+        }
+        emit commandCommitted(write.viewId, command);
+    } else {
+        qDebug() << "Write-behind: command write failed:" << result.error;
+        command.commandId = write.viewId;
+        emit commandReverted(command, write.previousCommand, result.error);
+    }
+}
+
+QList<WriteBehindQueue::WriteResult> WriteBehindQueue::writeBatch(const QList<PendingWrite>& batch)
+{
+    if (!workerClients) {
+        // Created on the worker thread so they use its own connection
+        workerClients = new ClientManager(worker);
+        workerCommands = new CommandManager(worker);
+        connect(workerClients, &ClientManager::validationError, worker, [this](const QString& error) {
+            workerError = error;
+        });
+        connect(workerCommands, &CommandManager::validationError, worker, [this](const QString& error) {
+            workerError = error;
+        });
+    }
+
+    QList<WriteResult> results;
+
+    {
+        UnitOfWork unitOfWork;
+        bool allWritten = true;
+
+        QHash<int, int> batchIds;
+        for (const PendingWrite& write : batch) {
+            WriteResult result = writeInBatch(write, batchIds);
+            results.append(result);
+            if (!result.success) {
+                allWritten = false;
+                break;
+            }
+        }
+
+        if (allWritten && unitOfWork.commit()) {
+            return results;
+        }
+    }
+
+    if (batch.size() == 1) {
+        return results;
+    }
+
+    // Something in the batch failed and everything was rolled back;
+    // write the rows one by one so only the bad ones are reverted
+    qDebug() << "Write-behind: batch failed, retrying" << batch.size() << "writes individually";
+    results.clear();
+    QHash<int, int> batchIds;
+    for (const PendingWrite& write : batch) {
+        results.append(writeInBatch(write, batchIds));
+    }
+
+    return results;
+}
+
+WriteBehindQueue::WriteResult WriteBehindQueue::writeInBatch(PendingWrite write, QHash<int, int>& batchIds)
+{
+    // Temporary ids are unique across clients and commands, so one map of
+    // this batch's inserts serves both
+    WriteResult result;
+    if (resolveIds(write, batchIds, batchIds, QSet<int>(), result.error)) {
+        result.success = writeOne(write, &result.newId, result.error);
+        if (result.success && write.isInsert) {
+            batchIds.insert(write.viewId, result.newId);
+        }
+    }
+    result.write = write;
+    return result;
+}
+
+bool WriteBehindQueue::writeOne(const PendingWrite& write, int *newId, QString& error)
+{
+    workerError.clear();
+    bool success = false;
+
+    if (write.entity == ClientEntity) {
+        if (write.isInsert) {
+            success = workerClients->addNewClient(write.client, newId);
+        } else {
+            success = workerClients->modifyClient(write.client);
+            *newId = write.client.id;
+        }
+    } else {
+        if (write.isInsert) {
+            success = workerCommands->addNewCommand(write.command, newId);
+        } else {
+            success = workerCommands->modifyCommand(write.command);
+            *newId = write.command.commandId;
+        }
+    }
+
+    if (!success) {
+        error = workerError.isEmpty() ? QString("Database write failed") : workerError;
+    }
+    return success;
+}
+
+void WriteBehindQueue::shutdownWorker()
+{
+    delete workerClients;
+    delete workerCommands;
+    workerClients = nullptr;
+    workerCommands = nullptr;
+
+    Connection::getInstance().releaseThreadDatabase();
+}
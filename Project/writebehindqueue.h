@@ -0,0 +1,128 @@
+// writebehindqueue.h
+#ifndef WRITEBEHINDQUEUE_H
+#define WRITEBEHINDQUEUE_H
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QTimer>
+#include <QThread>
+#include <QSet>
+#include <QMutex>
+
+#include "clients.h"
+#include "commands.h"
+
+// Write-behind queue for the client and command dialogs.
+//
+// enqueue*() returns immediately: the change is announced through the
+// *Applied signals so the view can show it right away, then written on a
+// background thread. Consecutive edits of the same row that have not been
+// sent yet are merged into one write, and pending writes are flushed in
+// batches, each batch inside one UnitOfWork.
+//
+// New rows get a temporary negative id until their insert commits
+// (*Committed carries the temporary and the real id); a write in the same
+// batch that refers to it gets the real id from the worker as soon as the
+// insert is written. When a write fails
+// the *Reverted signal carries the previous row; previous.id == 0 means the
+// row was an insert and should be removed from the view.
+class WriteBehindQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WriteBehindQueue(QObject *parent = nullptr);
+    ~WriteBehindQueue();
+
+    // Returns the id the view should use for the row
+    int enqueueClientInsert(const Client& client);
+    int enqueueClientUpdate(const Client& client, const Client& previous);
+    int enqueueCommandInsert(const Command& command);
+    int enqueueCommandUpdate(const Command& command, const Command& previous);
+
+    int pendingCount() const;
+    void setFlushInterval(int msec);
+    void setMaxBatchSize(int size);
+
+    // Send pending writes without waiting for the flush timer
+    void flush();
+
+signals:
+    void clientApplied(const Client& client);
+    void clientCommitted(int viewId, const Client& client);
+    void clientReverted(const Client& attempted, const Client& previous, const QString& error);
+
+    void commandApplied(const Command& command);
+    void commandCommitted(int viewId, const Command& command);
+    void commandReverted(const Command& attempted, const Command& previous, const QString& error);
+
+    void pendingCountChanged(int count);
+
+private:
+    enum Entity {
+        ClientEntity,
+        CommandEntity
+    };
+
+    struct PendingWrite {
+        Entity entity;
+        bool isInsert;
+        int viewId;              // Id of the row in the view (negative until inserted)
+        Client client;
+        Client previousClient;
+        Command command;
+        Command previousCommand;
+
+        PendingWrite() : entity(ClientEntity), isInsert(false), viewId(0) {}
+    };
+
+    struct WriteResult {
+        PendingWrite write;
+        bool success;
+        int newId;
+        QString error;
+
+        WriteResult() : success(false), newId(0) {}
+    };
+
+    // Main thread state
+    QList<PendingWrite> pending;
+    QHash<QString, int> pendingIndex;    // "client:12" -> index in pending
+    QHash<int, int> committedClientIds;  // Temporary id -> database id
+    QHash<int, int> committedCommandIds;
+    int inFlight;
+    int nextTemporaryId;
+    int maxBatchSize;
+    QTimer *flushTimer;
+
+    // Results of finished batches, handed over from the worker
+    QMutex resultsMutex;
+    QList<WriteResult> finishedResults;
+
+    // Worker thread state, only touched from workerThread
+    QThread *workerThread;
+    QObject *worker;
+    ClientManager *workerClients;
+    CommandManager *workerCommands;
+    QString workerError;
+
+    int enqueue(const PendingWrite& write);
+    static QString keyFor(Entity entity, int id);
+    void sendBatch();
+    QList<PendingWrite> takeBatch(int count, QList<WriteResult>& rejected);
+    static bool resolveIds(PendingWrite& write, const QHash<int, int>& clientIds,
+                           const QHash<int, int>& commandIds, const QSet<int>& batchInserts,
+                           QString& error);
+    void deliverResults();
+    void applyResults(const QList<WriteResult>& results);
+    void reportResult(const WriteResult& result);
+
+    // Run on the worker thread
+    QList<WriteResult> writeBatch(const QList<PendingWrite>& batch);
+    WriteResult writeInBatch(PendingWrite write, QHash<int, int>& batchIds);
+    bool writeOne(const PendingWrite& write, int *newId, QString& error);
+    void shutdownWorker();
+};
+
+#endif // WRITEBEHINDQUEUE_H